@@ -66,9 +66,11 @@ check_include_file(sys/mman.h HAVE_SYS_MMAN_H)
 check_include_file(sys/ndir.h HAVE_SYS_NDIR_H)
 check_include_file(sys/param.h HAVE_SYS_PARAM_H)
 check_include_file(sys/resource.h HAVE_SYS_RESOURCE_H)
+check_include_file(sys/socket.h HAVE_SYS_SOCKET_H)
 check_include_file(sys/stat.h HAVE_SYS_STAT_H)
 check_include_file(sys/time.h HAVE_SYS_TIME_H)
 check_include_file(sys/types.h HAVE_SYS_TYPES_H)
+check_include_file(sys/un.h HAVE_SYS_UN_H)
 check_include_file(sys/wait.h HAVE_SYS_WAIT_H)
 check_include_file(termios.h HAVE_TERMIOS_H)
 check_include_file(time.h HAVE_TIME_H)
@@ -88,6 +90,12 @@ ELSE (HAVE_LIBDL)
     SET(LIBDL "")
 ENDIF (HAVE_LIBDL)
 
+IF (HAVE_LIBPTHREAD)
+    SET(LIBPTHREAD "pthread")
+ELSE (HAVE_LIBPTHREAD)
+    SET(LIBPTHREAD "")
+ENDIF (HAVE_LIBPTHREAD)
+
 # function checks
 INCLUDE(CheckSymbolExists)
 INCLUDE(CheckFunctionExists)
@@ -117,8 +125,10 @@ check_symbol_exists(malloc_zone_statistics malloc/malloc.h
 check_symbol_exists(mkdtemp "stdlib.h;unistd.h" HAVE_MKDTEMP)
 check_symbol_exists(mkstemp "stdlib.h;unistd.h" HAVE_MKSTEMP)
 check_symbol_exists(mktemp "stdlib.h;unistd.h" HAVE_MKTEMP)
+check_symbol_exists(posix_fallocate fcntl.h HAVE_POSIX_FALLOCATE)
 if( NOT LLVM_ON_WIN32 )
   check_symbol_exists(pthread_mutex_lock pthread.h HAVE_PTHREAD_MUTEX_LOCK)
+  check_symbol_exists(pthread_getspecific pthread.h HAVE_PTHREAD_GETSPECIFIC)
 endif()
 check_symbol_exists(sbrk unistd.h HAVE_SBRK)
 check_symbol_exists(strdup string.h HAVE_STRDUP)
@@ -138,6 +148,7 @@ check_type_size("unsigned long long" UNSIGNED_LONG_LONG)
 IF (HAVE_LONG_LONG AND HAVE_UNSIGNED_LONG_LONG)
     SET(YASM_HAVE_LONG_LONG 1)
 ENDIF (HAVE_LONG_LONG AND HAVE_UNSIGNED_LONG_LONG)
+check_type_size("__int128" INT128)
 
 set(headers "")
 if (HAVE_SYS_TYPES_H)
@@ -214,18 +225,18 @@ endif( MSVC )
 # FIXME: Signal handler return type, currently hardcoded to 'void'
 set(RETSIGTYPE void)
 
-#if( LLVM_ENABLE_THREADS )
-#  if( HAVE_PTHREAD_H OR WIN32 )
-#    set(ENABLE_THREADS 1)
-#  endif( HAVE_PTHREAD_H OR WIN32 )
-#endif( LLVM_ENABLE_THREADS )
-#
-#if( ENABLE_THREADS )
-#  message(STATUS "Threads enabled.")
-#else( ENABLE_THREADS )
-#  message(STATUS "Threads disabled.")
-#endif( ENABLE_THREADS )
-set(LLVM_MULTITHREADED 0)
+# Threads are used for parallel optimization (yasm -j).
+if( HAVE_PTHREAD_H OR WIN32 )
+  set(ENABLE_THREADS 1)
+endif( HAVE_PTHREAD_H OR WIN32 )
+
+if( ENABLE_THREADS )
+  message(STATUS "Threads enabled.")
+  set(LLVM_MULTITHREADED 1)
+else( ENABLE_THREADS )
+  message(STATUS "Threads disabled.")
+  set(LLVM_MULTITHREADED 0)
+endif( ENABLE_THREADS )
 
 if(WIN32)
   if(CYGWIN)
@@ -412,13 +423,6 @@ if (CMAKE_COMPILER_IS_GNUCXX)
    macro_ensure_version("4.3.0" "${_gcc_version}" GCC_IS_NEWER_THAN_4_3)
    macro_ensure_version("4.4.0" "${_gcc_version}" GCC_IS_NEWER_THAN_4_4)
 
-   # save a little by making local statics not threadsafe
-   # ### do not enable it for older compilers, see
-   # ### http://gcc.gnu.org/bugzilla/show_bug.cgi?id=31806
-   if (GCC_IS_NEWER_THAN_4_3)
-       set (CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -fno-threadsafe-statics")
-   endif (GCC_IS_NEWER_THAN_4_3)
-
    set(_GCC_COMPILED_WITH_BAD_ALLOCATOR FALSE)
    if (GCC_IS_NEWER_THAN_4_1)
       exec_program(${CMAKE_C_COMPILER} ARGS -v OUTPUT_VARIABLE _gcc_alloc_info)
@@ -0,0 +1,395 @@
+//
+// Persistent cache of assembled object files
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#include "frontends/AssemblyCache.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "llvm/Config/config.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/System/Path.h"
+#include "yasmx/Basic/FileManager.h"
+#include "yasmx/Basic/SourceManager.h"
+#include "yasmx/Parse/HeaderSearch.h"
+#include "yasmx/Object.h"
+
+#if defined(LLVM_ON_WIN32)
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+
+using namespace yasm;
+
+/// First line of every entry; bump the version when the format changes.
+static const char ENTRY_MAGIC[] = "yasm-cache 2\n";
+
+/// Environment variables that can change the assembler's output.
+static const char* const KEY_ENVIRONMENT[] =
+{
+    "YASM_TEST_SUITE",  // zeroes the COFF time stamp
+};
+
+static std::string
+DigestHex(MD5& md5)
+{
+    static const char hexdig[] = "0123456789abcdef";
+    unsigned char digest[16];
+    md5.Final(digest);
+    std::string hex;
+    hex.reserve(32);
+    for (int i=0; i<16; ++i)
+    {
+        hex += hexdig[digest[i] >> 4];
+        hex += hexdig[digest[i] & 0xf];
+    }
+    return hex;
+}
+
+static std::string
+DigestBuffer(const llvm::MemoryBuffer& buf)
+{
+    MD5 md5;
+    md5.Update(reinterpret_cast<const unsigned char*>(buf.getBufferStart()),
+               static_cast<unsigned long>(buf.getBufferSize()));
+    return DigestHex(md5);
+}
+
+/// Compute the digest of a file's current contents.
+/// @return False if the file could not be read.
+static bool
+DigestFile(llvm::StringRef filename, std::string* hex)
+{
+    llvm::OwningPtr<llvm::MemoryBuffer> buf(
+        llvm::MemoryBuffer::getFile(filename));
+    if (!buf)
+        return false;
+    *hex = DigestBuffer(*buf);
+    return true;
+}
+
+namespace {
+/// Exclusive lock on a cache entry, held while the entry is written.
+/// Taking the lock never blocks; if another process holds it, isLocked()
+/// is false and the caller should leave the entry to that process.
+///
+/// The lock is an advisory lock on a lock file rather than the file's
+/// existence, so the system releases it if the holder dies, and a lock
+/// file left behind by a crash is simply locked again.
+class EntryLock
+{
+public:
+    explicit EntryLock(const std::string& entry_path);
+    ~EntryLock();
+
+    bool isLocked() const { return m_locked; }
+
+private:
+    EntryLock(const EntryLock&);                    // not implemented
+    const EntryLock& operator=(const EntryLock&);   // not implemented
+
+    std::string m_path;
+    int m_fd;
+    bool m_locked;
+};
+} // anonymous namespace
+
+EntryLock::EntryLock(const std::string& entry_path)
+    : m_path(entry_path + ".lock"), m_fd(-1), m_locked(false)
+{
+    m_fd = ::open(m_path.c_str(), O_WRONLY | O_CREAT, 0666);
+    if (m_fd < 0)
+        return;
+#if defined(LLVM_ON_WIN32)
+    HANDLE file = reinterpret_cast<HANDLE>(_get_osfhandle(m_fd));
+    OVERLAPPED overlapped;
+    std::memset(&overlapped, 0, sizeof(overlapped));
+    m_locked = LockFileEx(file,
+                          LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY,
+                          0, 1, 0, &overlapped) != 0;
+#else
+    if (::flock(m_fd, LOCK_EX | LOCK_NB) != 0)
+        return;
+
+    // The previous holder removes the lock file before releasing it.  If
+    // that happened between our open() and flock(), we hold a lock on a
+    // file nobody else will open, so don't count it.
+    struct stat fd_st, path_st;
+    if (::fstat(m_fd, &fd_st) != 0 || ::stat(m_path.c_str(), &path_st) != 0 ||
+        fd_st.st_dev != path_st.st_dev || fd_st.st_ino != path_st.st_ino)
+        return;
+    m_locked = true;
+#endif
+}
+
+EntryLock::~EntryLock()
+{
+    if (m_fd < 0)
+        return;
+    // Remove the lock file while still holding the lock (see above).  On
+    // Windows this fails while others have it open, which is harmless.
+    if (m_locked)
+        ::unlink(m_path.c_str());
+    ::close(m_fd);
+}
+
+AssemblyCache::AssemblyCache(llvm::StringRef dir)
+    : m_dir(dir)
+{
+    AddKey(ENTRY_MAGIC);
+}
+
+AssemblyCache::~AssemblyCache()
+{
+}
+
+void
+AssemblyCache::AddKey(llvm::StringRef data)
+{
+    m_key.Update(reinterpret_cast<const unsigned char*>(data.data()),
+                 static_cast<unsigned long>(data.size()));
+    // separate from the next piece of data
+    static const unsigned char sep = 0;
+    m_key.Update(&sep, 1);
+}
+
+void
+AssemblyCache::AddCommandLine(int argc, char* argv[], void* main_addr)
+{
+    AddKey(GetExecutableKey(argv[0], main_addr));
+    AddKey(llvm::sys::Path::GetCurrentDirectory().str());
+    for (unsigned int i=0;
+         i<sizeof(KEY_ENVIRONMENT)/sizeof(KEY_ENVIRONMENT[0]); ++i)
+    {
+        // Distinguish unset from set to an empty string.
+        const char* value = std::getenv(KEY_ENVIRONMENT[i]);
+        AddKey(KEY_ENVIRONMENT[i]);
+        AddKey(value ? std::string("=") + value : std::string());
+    }
+    for (int i=0; i<argc; ++i)
+        AddKey(argv[i]);
+}
+
+bool
+AssemblyCache::Lookup(const llvm::MemoryBuffer& main, llvm::StringRef* object)
+{
+    MD5 key = m_key;
+    key.Update(reinterpret_cast<const unsigned char*>(main.getBufferStart()),
+               static_cast<unsigned long>(main.getBufferSize()));
+    m_entry_path = m_dir + '/' + DigestHex(key);
+
+    m_entry.reset(llvm::MemoryBuffer::getFile(m_entry_path));
+    if (!m_entry)
+        return false;
+
+    llvm::StringRef data = m_entry->getBuffer();
+    if (!data.startswith(ENTRY_MAGIC))
+        return false;
+    data = data.substr(std::strlen(ENTRY_MAGIC));
+
+    // Header lines:
+    //   dep <digest> <filename>
+    //   absent <filename>
+    //   object <size>
+    // followed by the object file contents.
+    for (;;)
+    {
+        std::pair<llvm::StringRef, llvm::StringRef> line = data.split('\n');
+        data = line.second;
+        if (line.first.startswith("dep "))
+        {
+            llvm::StringRef digest = line.first.substr(4, 32);
+            llvm::StringRef filename = line.first.substr(4+32+1);
+            std::string cur;
+            if (!DigestFile(filename, &cur) || digest != cur)
+                return false;
+        }
+        else if (line.first.startswith("absent "))
+        {
+            // A new file here would be found by an include search first.
+            if (llvm::sys::Path(line.first.substr(7)).exists())
+                return false;
+        }
+        else if (line.first.startswith("object "))
+        {
+            unsigned long long size;
+            if (line.first.substr(7).getAsInteger(10, size) ||
+                size != data.size())
+                return false;
+            *object = data;
+            return true;
+        }
+        else
+            return false;
+    }
+}
+
+void
+AssemblyCache::WatchHeaderSearch(HeaderSearch& headers)
+{
+    headers.setMissedFileList(&m_missing);
+}
+
+bool
+AssemblyCache::Store(SourceManager& sm,
+                     const Object& obj,
+                     llvm::StringRef obj_filename,
+                     std::string* err)
+{
+    assert(!m_entry_path.empty() && "Lookup() must be called first");
+
+    // Gather dependencies, in a stable order.
+    typedef std::vector<std::pair<std::string, std::string> > Deps;
+    Deps deps;
+    for (SourceManager::fileinfo_iterator i=sm.fileinfo_begin(),
+         end=sm.fileinfo_end(); i != end; ++i)
+    {
+        const FileEntry* file = i->first;
+        if (!file)
+            continue;
+        bool invalid = false;
+        const llvm::MemoryBuffer* buf =
+            sm.getMemoryBufferForFile(file, &invalid);
+        if (!buf || invalid)
+        {
+            *err = std::string("cannot read '") + file->getName() + "'";
+            return true;
+        }
+        deps.push_back(std::make_pair(file->getName(), DigestBuffer(*buf)));
+    }
+    const std::vector<std::string>& objdeps = obj.getDependencies();
+    for (std::vector<std::string>::const_iterator i=objdeps.begin(),
+         end=objdeps.end(); i != end; ++i)
+    {
+        std::string digest;
+        if (!DigestFile(*i, &digest))
+        {
+            *err = "cannot read '" + *i + "'";
+            return true;
+        }
+        deps.push_back(std::make_pair(*i, digest));
+    }
+    std::sort(deps.begin(), deps.end());
+    deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+
+    std::vector<std::string> missing(m_missing);
+    std::sort(missing.begin(), missing.end());
+    missing.erase(std::unique(missing.begin(), missing.end()), missing.end());
+
+    for (Deps::const_iterator i=deps.begin(), end=deps.end(); i != end; ++i)
+    {
+        if (i->first.find('\n') != std::string::npos)
+        {
+            *err = "unsupported file name '" + i->first + "'";
+            return true;
+        }
+    }
+    for (std::vector<std::string>::const_iterator i=missing.begin(),
+         end=missing.end(); i != end; ++i)
+    {
+        if (i->find('\n') != std::string::npos)
+        {
+            *err = "unsupported file name '" + *i + "'";
+            return true;
+        }
+    }
+
+    llvm::OwningPtr<llvm::MemoryBuffer> objbuf(
+        llvm::MemoryBuffer::getFile(obj_filename, err));
+    if (!objbuf)
+        return true;
+
+    llvm::sys::Path dir(m_dir);
+    if (dir.createDirectoryOnDisk(true, err))
+        return true;
+
+    EntryLock lock(m_entry_path);
+    if (!lock.isLocked())
+        return false;   // someone else is storing this entry
+
+    // Write to a temporary file, then atomically move it into place.
+    llvm::sys::Path tmp(m_entry_path + ".tmp");
+    if (tmp.makeUnique(false, err))
+        return true;
+    {
+        llvm::raw_fd_ostream os(tmp.c_str(), *err,
+                                llvm::raw_fd_ostream::F_Binary);
+        if (!err->empty())
+            return true;
+        os << ENTRY_MAGIC;
+        for (Deps::const_iterator i=deps.begin(), end=deps.end(); i != end;
+             ++i)
+            os << "dep " << i->second << ' ' << i->first << '\n';
+        for (std::vector<std::string>::const_iterator i=missing.begin(),
+             end=missing.end(); i != end; ++i)
+            os << "absent " << *i << '\n';
+        os << "object " << objbuf->getBufferSize() << '\n';
+        os.write(objbuf->getBufferStart(), objbuf->getBufferSize());
+        os.close();
+        if (os.has_error())
+        {
+            os.clear_error();
+            tmp.eraseFromDisk();
+            *err = "write error";
+            return true;
+        }
+    }
+
+    if (tmp.renamePathOnDisk(llvm::sys::Path(m_entry_path), err))
+    {
+        tmp.eraseFromDisk();
+        return true;
+    }
+    return false;
+}
+
+std::string
+yasm::GetExecutableKey(const char* argv0, void* main_addr)
+{
+    std::string exe =
+        llvm::sys::Path::GetMainExecutable(argv0, main_addr).str();
+    std::string buf;
+    llvm::raw_string_ostream oss(buf);
+    oss << exe;
+    struct stat st;
+    if (!exe.empty() && ::stat(exe.c_str(), &st) == 0)
+        oss << ' ' << static_cast<unsigned long>(st.st_size) << ' '
+            << static_cast<unsigned long>(st.st_mtime);
+    return oss.str();
+}
@@ -0,0 +1,124 @@
+//
+// Persistent cache of assembled object files
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifndef YASM_ASSEMBLYCACHE_H
+#define YASM_ASSEMBLYCACHE_H
+
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringRef.h"
+#include "yasmx/Support/MD5.h"
+
+namespace llvm { class MemoryBuffer; }
+
+namespace yasm
+{
+
+class HeaderSearch;
+class Object;
+class SourceManager;
+
+/// Directory of assembled object files, keyed by the contents of the main
+/// source file and everything else that can affect the output (command
+/// line, environment, assembler version).  Each entry also lists the
+/// included files and their contents' digests, and the paths an include
+/// search tried without finding anything; an entry is used only if all of
+/// the files are unchanged and none of the missing ones has appeared.
+///
+/// Entries are written to a temporary file and renamed into place, so
+/// concurrent processes sharing a cache directory never see partial
+/// entries.  A lock file keeps two processes from writing the same entry
+/// at once; the loser simply doesn't store its result.
+class AssemblyCache
+{
+public:
+    /// Constructor.
+    /// @param dir      cache directory; created on first Store()
+    explicit AssemblyCache(llvm::StringRef dir);
+
+    /// Destructor.
+    ~AssemblyCache();
+
+    /// Add data to the key.  Must be called before Lookup().
+    /// @param data     key data (e.g. a command line argument)
+    void AddKey(llvm::StringRef data);
+
+    /// Add the assembler executable (by file size and modification time),
+    /// the current directory, the environment variables the assembler
+    /// reads, and all command line arguments to the key.
+    /// @param argc     argument count
+    /// @param argv     arguments
+    /// @param main_addr address of a function in the main executable
+    void AddCommandLine(int argc, char* argv[], void* main_addr);
+
+    /// Look up the entry for a main source file.  Completes the key.
+    /// @param main     main source file contents
+    /// @param object   object file contents (output); valid until the
+    ///                 cache is destroyed
+    /// @return True if an up to date entry was found.
+    bool Lookup(const llvm::MemoryBuffer& main, llvm::StringRef* object);
+
+    /// Record the include file paths searched without success, so Store()
+    /// can list them.  The cache must outlive the header search.
+    /// @param headers  header search used to assemble the main file
+    void WatchHeaderSearch(HeaderSearch& headers);
+
+    /// Store an entry for the key completed by Lookup().
+    /// @param sm       source manager used to assemble the main file;
+    ///                 all of its files are recorded as dependencies
+    /// @param obj      assembled object (for its other dependencies)
+    /// @param obj_filename object file written by the assembler
+    /// @param err      error message (output)
+    /// @return True on error.
+    bool Store(SourceManager& sm,
+               const Object& obj,
+               llvm::StringRef obj_filename,
+               std::string* err);
+
+private:
+    AssemblyCache(const AssemblyCache&);                    // not impl
+    const AssemblyCache& operator=(const AssemblyCache&);   // not impl
+
+    std::string m_dir;
+    MD5 m_key;
+    std::string m_entry_path;   ///< entry file; set by Lookup()
+    llvm::OwningPtr<llvm::MemoryBuffer> m_entry;
+    std::vector<std::string> m_missing; ///< include paths not found
+};
+
+/// Get a string identifying the assembler executable: its path, file size
+/// and modification time.  Used as cache key data so rebuilding the
+/// assembler invalidates cached results.
+/// @param argv0        program name (argv[0])
+/// @param main_addr    address of a function in the main executable
+/// @return Identifying string.
+std::string GetExecutableKey(const char* argv0, void* main_addr);
+
+} // namespace yasm
+
+#endif
@@ -0,0 +1,448 @@
+//
+// Persistent assembler server
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#include "frontends/AssemblyServer.h"
+
+#include "config.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(HAVE_SYS_SOCKET_H) && defined(HAVE_SYS_UN_H)
+#define YASM_SERVER_SUPPORTED 1
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/System/Path.h"
+#include "yasmx/Basic/FileManager.h"
+
+
+using namespace yasm;
+
+/// First field of every request; bump the version when the protocol
+/// changes.
+static const char REQUEST_MAGIC[] = "yasm-server 1";
+
+/// Largest request accepted by the server.
+static const size_t MAX_REQUEST_SIZE = 1024*1024;
+
+/// Seconds a client may take to send its request or read the reply before
+/// the server drops the connection.  Requests are handled one at a time, so
+/// this keeps a stalled client from blocking all others.
+static const int CONNECTION_TIMEOUT = 10;
+
+FileContentCache::FileContentCache(size_t max_size)
+    : m_max_size(max_size)
+    , m_size(0)
+{
+}
+
+FileContentCache::~FileContentCache()
+{
+    for (EntryList::iterator i=m_entries.begin(), end=m_entries.end();
+         i != end; ++i)
+        delete i->buf;
+}
+
+void
+FileContentCache::Erase(EntryList::iterator i)
+{
+    m_size -= i->buf->getBufferSize();
+    delete i->buf;
+    m_index.erase(i->path);
+    m_entries.erase(i);
+}
+
+const llvm::MemoryBuffer*
+FileContentCache::getFileContents(const FileEntry* file)
+{
+    llvm::StringRef name(file->getName());
+    std::string path;
+    if (llvm::sys::Path::isAbsolute(name.data(), name.size()))
+        path = name;
+    else
+    {
+        llvm::sys::Path abs = llvm::sys::Path::GetCurrentDirectory();
+        abs.appendComponent(name);
+        path = abs.str();
+    }
+
+    llvm::StringMap<EntryList::iterator>::iterator found = m_index.find(path);
+    if (found != m_index.end())
+    {
+        EntryList::iterator i = found->second;
+        if (i->device == file->getDevice() && i->inode == file->getInode() &&
+            i->size == file->getSize() &&
+            i->mtime == file->getModificationTime() &&
+            i->buf->getBufferIdentifier() == name)
+        {
+            m_entries.splice(m_entries.begin(), m_entries, i);
+            return i->buf;
+        }
+
+        // The file has changed.  The old buffer can't be freed yet if it's
+        // in use, so just leave it at the end of the list for Prune().
+        m_index.erase(found);
+        i->path.clear();
+        m_entries.splice(m_entries.end(), m_entries, i);
+    }
+
+    // Read the file, making sure it still matches the file entry.  The
+    // contents are copied as a mapped file would change under us if it
+    // were modified in place.
+    std::string err;
+    struct stat st;
+    llvm::OwningPtr<llvm::MemoryBuffer>
+        mapped(llvm::MemoryBuffer::getFile(name, &err, file->getSize(), &st));
+    if (!mapped || st.st_size != file->getSize() ||
+        st.st_mtime != file->getModificationTime())
+        return 0;   // let the source manager diagnose it
+
+    Entry entry;
+    entry.path = path;
+    entry.device = file->getDevice();
+    entry.inode = file->getInode();
+    entry.size = file->getSize();
+    entry.mtime = file->getModificationTime();
+    entry.buf = llvm::MemoryBuffer::getMemBufferCopy(mapped->getBuffer(),
+                                                     name);
+    m_entries.push_front(entry);
+    m_index[path] = m_entries.begin();
+    m_size += entry.buf->getBufferSize();
+    return entry.buf;
+}
+
+void
+FileContentCache::Prune()
+{
+    while (!m_entries.empty() &&
+           (m_size > m_max_size || m_entries.back().path.empty()))
+        Erase(--m_entries.end());
+}
+
+#ifdef YASM_SERVER_SUPPORTED
+/// Fill in a socket address for a path.
+/// @return True on error (path too long).
+static bool
+MakeAddress(llvm::StringRef path, struct sockaddr_un* addr, std::string* err)
+{
+    std::memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr->sun_path))
+    {
+        *err = "socket path is too long";
+        return true;
+    }
+    std::memcpy(addr->sun_path, path.data(), path.size());
+    return false;
+}
+
+/// Read until end of file.
+/// @return True on error, including a receive timeout.
+static bool
+ReadAll(int fd, std::string* data, size_t max_size)
+{
+    char buf[4096];
+    for (;;)
+    {
+        ssize_t got = read(fd, buf, sizeof(buf));
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got < 0)
+            return true;
+        if (got == 0)
+            return false;
+        data->append(buf, got);
+        if (data->size() > max_size)
+            return true;
+    }
+}
+
+/// Set when the server has been asked to stop.
+static volatile sig_atomic_t stop_requested = 0;
+
+static void
+StopHandler(int)
+{
+    stop_requested = 1;
+}
+
+/// Write all of a buffer.
+/// @return True on error.
+static bool
+WriteAll(int fd, llvm::StringRef data)
+{
+    while (!data.empty())
+    {
+        ssize_t put = write(fd, data.data(), data.size());
+        if (put < 0 && errno == EINTR)
+            continue;
+        if (put <= 0)
+            return true;
+        data = data.substr(put);
+    }
+    return false;
+}
+#endif
+
+AssemblyServer::AssemblyServer(llvm::StringRef path)
+    : m_path(path)
+    , m_fd(-1)
+{
+}
+
+AssemblyServer::~AssemblyServer()
+{
+#ifdef YASM_SERVER_SUPPORTED
+    if (m_fd >= 0)
+    {
+        close(m_fd);
+        unlink(m_path.c_str());
+    }
+#endif
+}
+
+bool
+AssemblyServer::Listen(std::string* err)
+{
+#ifdef YASM_SERVER_SUPPORTED
+    // Requests change the current directory, so make the socket path
+    // absolute for removing it later.
+    if (!llvm::sys::Path::isAbsolute(m_path.data(), m_path.size()))
+    {
+        llvm::sys::Path abs = llvm::sys::Path::GetCurrentDirectory();
+        abs.appendComponent(m_path);
+        m_path = abs.str();
+    }
+
+    struct sockaddr_un addr;
+    if (MakeAddress(m_path, &addr, err))
+        return true;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        *err = std::strerror(errno);
+        return true;
+    }
+
+    // A socket nobody is listening on was left behind by a server that
+    // didn't exit cleanly; replace it.  Don't replace anything else.
+    struct stat st;
+    if (lstat(m_path.c_str(), &st) == 0)
+    {
+        if (!S_ISSOCK(st.st_mode))
+        {
+            close(fd);
+            *err = "file exists and is not a socket";
+            return true;
+        }
+        if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr),
+                    sizeof(addr)) == 0)
+        {
+            close(fd);
+            *err = "another server is already running";
+            return true;
+        }
+        unlink(m_path.c_str());
+    }
+
+    // Only the user running the server may connect to it.
+    mode_t old_mask = umask(077);
+    int bound = bind(fd, reinterpret_cast<struct sockaddr*>(&addr),
+                     sizeof(addr));
+    umask(old_mask);
+    if (bound != 0 || listen(fd, SOMAXCONN) != 0)
+    {
+        *err = std::strerror(errno);
+        close(fd);
+        return true;
+    }
+
+    m_fd = fd;
+    return false;
+#else
+    *err = "local sockets are not supported on this platform";
+    return true;
+#endif
+}
+
+bool
+AssemblyServer::Run(Handler handler, void* data, std::string* err)
+{
+#ifdef YASM_SERVER_SUPPORTED
+    // A client going away mid-reply shouldn't take the server with it.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // Stop between requests on termination signals so the destructor can
+    // remove the socket (llvm::sys::RemoveFileOnSignal only removes
+    // regular files).  No SA_RESTART, so accept() returns EINTR.
+    struct sigaction sa;
+    std::memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = StopHandler;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, 0);
+    sigaction(SIGTERM, &sa, 0);
+    sigaction(SIGHUP, &sa, 0);
+
+    while (!stop_requested)
+    {
+        int conn = accept(m_fd, 0, 0);
+        if (conn < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            *err = std::strerror(errno);
+            return true;
+        }
+        struct timeval timeout;
+        timeout.tv_sec = CONNECTION_TIMEOUT;
+        timeout.tv_usec = 0;
+        if (setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+                       sizeof(timeout)) == 0 &&
+            setsockopt(conn, SOL_SOCKET, SO_SNDTIMEO, &timeout,
+                       sizeof(timeout)) == 0)
+            HandleConnection(conn, handler, data);
+        close(conn);
+    }
+    return false;
+#else
+    *err = "local sockets are not supported on this platform";
+    return true;
+#endif
+}
+
+void
+AssemblyServer::HandleConnection(int fd, Handler handler, void* data)
+{
+#ifdef YASM_SERVER_SUPPORTED
+    // A request is a series of NUL-terminated fields: magic, working
+    // directory, and arguments.
+    std::string msg;
+    if (ReadAll(fd, &msg, MAX_REQUEST_SIZE) || msg.empty() ||
+        msg[msg.size()-1] != '\0')
+        return;
+
+    std::vector<std::string> fields;
+    for (std::string::size_type start = 0; start < msg.size(); )
+    {
+        std::string::size_type end = msg.find('\0', start);
+        fields.push_back(msg.substr(start, end-start));
+        start = end+1;
+    }
+    if (fields.size() < 2 || fields[0] != REQUEST_MAGIC)
+        return;
+
+    ServerRequest req;
+    req.cwd = fields[1];
+    req.args.assign(fields.begin()+2, fields.end());
+
+    // The reply is the exit status on a line by itself, followed by the
+    // diagnostic output.
+    std::string out;
+    llvm::raw_string_ostream os(out);
+    int status;
+    if (chdir(req.cwd.c_str()) != 0)
+    {
+        os << "yasm: cannot change to directory '" << req.cwd << "': "
+           << std::strerror(errno) << '\n';
+        status = EXIT_FAILURE;
+    }
+    else
+        status = handler(req, os, data);
+    os.flush();
+
+    WriteAll(fd, llvm::utostr(status) + '\n');
+    WriteAll(fd, out);
+#endif
+}
+
+bool
+yasm::SendServerRequest(llvm::StringRef path,
+                        const ServerRequest& req,
+                        llvm::raw_ostream& os,
+                        int* status,
+                        std::string* err)
+{
+#ifdef YASM_SERVER_SUPPORTED
+    struct sockaddr_un addr;
+    if (MakeAddress(path, &addr, err))
+        return true;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        *err = std::strerror(errno);
+        return true;
+    }
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr),
+                sizeof(addr)) != 0)
+    {
+        *err = std::strerror(errno);
+        close(fd);
+        return true;
+    }
+
+    std::string msg(REQUEST_MAGIC, sizeof(REQUEST_MAGIC));
+    msg += req.cwd;
+    msg += '\0';
+    for (std::vector<std::string>::const_iterator i=req.args.begin(),
+         end=req.args.end(); i != end; ++i)
+    {
+        msg += *i;
+        msg += '\0';
+    }
+
+    std::string reply;
+    bool failed = WriteAll(fd, msg) || shutdown(fd, SHUT_WR) != 0 ||
+                  ReadAll(fd, &reply, ~static_cast<size_t>(0));
+    close(fd);
+
+    llvm::StringRef status_str, output;
+    llvm::tie(status_str, output) = llvm::StringRef(reply).split('\n');
+    if (failed || status_str.empty() || status_str.getAsInteger(10, *status))
+    {
+        *err = "no reply from server";
+        return true;
+    }
+    os << output;
+    return false;
+#else
+    *err = "local sockets are not supported on this platform";
+    return true;
+#endif
+}
@@ -0,0 +1,167 @@
+//
+// Persistent assembler server
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifndef YASM_ASSEMBLYSERVER_H
+#define YASM_ASSEMBLYSERVER_H
+
+#include <ctime>
+#include <list>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "yasmx/Basic/SourceManager.h"
+
+namespace llvm { class MemoryBuffer; class raw_ostream; }
+
+namespace yasm
+{
+
+class FileEntry;
+
+/// Source file contents kept in memory between assemblies, so that files
+/// included by many sources are read from disk only once.  Files are
+/// identified by absolute path, and reread whenever the file at that path
+/// changes size, modification time, or inode.  Least recently
+/// used files are dropped once the total size exceeds the limit; as buffers
+/// must outlive the source managers using them, this only happens in
+/// Prune().
+class FileContentCache : public ExternalFileContentSource
+{
+public:
+    /// Constructor.
+    /// @param max_size maximum total size of cached files, in bytes
+    explicit FileContentCache(size_t max_size);
+
+    /// Destructor.
+    ~FileContentCache();
+
+    const llvm::MemoryBuffer* getFileContents(const FileEntry* file);
+
+    /// Drop least recently used files until under the size limit.  Must
+    /// not be called while a source manager is using the cache.
+    void Prune();
+
+    /// Get the total size of cached files.
+    size_t getSize() const { return m_size; }
+
+private:
+    FileContentCache(const FileContentCache&);                  // not impl
+    const FileContentCache& operator=(const FileContentCache&); // not impl
+
+    struct Entry
+    {
+        std::string path;   ///< absolute path (index key)
+        dev_t device;
+        ino_t inode;
+        off_t size;
+        time_t mtime;
+        const llvm::MemoryBuffer* buf;
+    };
+    typedef std::list<Entry> EntryList;
+
+    /// Remove an entry and free its buffer.
+    void Erase(EntryList::iterator i);
+
+    size_t m_max_size;
+    size_t m_size;
+    EntryList m_entries;    ///< most recently used first
+    llvm::StringMap<EntryList::iterator> m_index;
+};
+
+/// An assemble request sent by a client to the server.
+struct ServerRequest
+{
+    std::string cwd;                ///< client's working directory
+    std::vector<std::string> args;  ///< per-request arguments
+};
+
+/// Assembler server listening on a local (Unix domain) socket.  Requests
+/// are handled one at a time, each in the client's working directory.
+/// Connections that stall while sending a request or reading the reply
+/// are dropped after a timeout.
+class AssemblyServer
+{
+public:
+    /// Request handler.
+    /// @param req      request; the server has changed to req.cwd
+    /// @param os       output stream for diagnostics, sent to the client
+    /// @param data     data passed to Run()
+    /// @return Exit status for the client.
+    typedef int (*Handler)(const ServerRequest& req,
+                           llvm::raw_ostream& os,
+                           void* data);
+
+    /// Constructor.
+    /// @param path     socket path
+    explicit AssemblyServer(llvm::StringRef path);
+
+    /// Destructor.  Closes and removes the socket.
+    ~AssemblyServer();
+
+    /// Create the socket, replacing any stale one at the same path.
+    /// @param err      error message (output)
+    /// @return True on error.
+    bool Listen(std::string* err);
+
+    /// Handle requests until an error occurs or the server is interrupted
+    /// (SIGINT, SIGTERM, or SIGHUP).
+    /// @param handler  request handler
+    /// @param data     data passed to the handler
+    /// @param err      error message (output)
+    /// @return True on error.
+    bool Run(Handler handler, void* data, std::string* err);
+
+private:
+    AssemblyServer(const AssemblyServer&);                  // not impl
+    const AssemblyServer& operator=(const AssemblyServer&); // not impl
+
+    /// Read, handle, and answer a single request on a connection.
+    void HandleConnection(int fd, Handler handler, void* data);
+
+    std::string m_path;
+    int m_fd;
+};
+
+/// Send a request to a server and wait for the result.
+/// @param path     server socket path
+/// @param req      request
+/// @param os       output stream for diagnostics from the server
+/// @param status   exit status (output)
+/// @param err      error message (output)
+/// @return True on error (e.g. no server running).
+bool SendServerRequest(llvm::StringRef path,
+                       const ServerRequest& req,
+                       llvm::raw_ostream& os,
+                       int* status,
+                       std::string* err);
+
+} // namespace yasm
+
+#endif
@@ -0,0 +1,101 @@
+//
+// Assembler phase time and memory report
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include "frontends/TimeReport.h"
+
+#include <cstdlib>
+#include <new>
+
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/System/Atomic.h"
+
+
+// Number of operator new calls made since counting was enabled.  Counting
+// is off by default so normal runs don't pay for the atomic increment.
+static volatile llvm::sys::cas_flag alloc_count = 0;
+static bool count_allocs = false;
+
+static size_t
+GetAllocationCount()
+{
+    return alloc_count;
+}
+
+static void*
+CountedAlloc(std::size_t size)
+{
+    if (count_allocs)
+        llvm::sys::AtomicIncrement(&alloc_count);
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void*
+operator new(std::size_t size) throw(std::bad_alloc)
+{
+    return CountedAlloc(size);
+}
+
+void*
+operator new[](std::size_t size) throw(std::bad_alloc)
+{
+    return CountedAlloc(size);
+}
+
+void
+operator delete(void* p) throw()
+{
+    std::free(p);
+}
+
+void
+operator delete[](void* p) throw()
+{
+    std::free(p);
+}
+
+void
+yasm::EnableAllocationCounting()
+{
+    count_allocs = true;
+    llvm::EnableTimerMemoryTracking(&GetAllocationCount);
+}
+
+yasm::TimeReportPrinter::~TimeReportPrinter()
+{
+    if (!m_group)
+        return;
+    llvm::OwningPtr<llvm::raw_ostream> os(llvm::CreateInfoOutputFile());
+    if (m_format == TIME_REPORT_JSON)
+        m_group->printJSON(*os);
+    else
+        m_group->print(*os);
+}
@@ -0,0 +1,74 @@
+//
+// Assembler phase time and memory report
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#ifndef YASM_TIMEREPORT_H
+#define YASM_TIMEREPORT_H
+
+namespace llvm { class TimerGroup; }
+
+namespace yasm
+{
+
+/// Output format for --time-report.
+enum TimeReportFormat
+{
+    TIME_REPORT_TEXT = 0,   ///< table in the style of llvm::TimerGroup
+    TIME_REPORT_JSON        ///< machine-readable JSON object
+};
+
+/// Start counting heap allocations (operator new calls) and record heap
+/// usage and allocation counts in all timers.
+void EnableAllocationCounting();
+
+/// Print the timers in a group to the info output file (stderr unless
+/// -info-output-file is given) when destroyed.  The printer must be
+/// destroyed before the timers are; timers destroyed first print
+/// themselves as a plain text table.
+class TimeReportPrinter
+{
+public:
+    /// Constructor.
+    /// @param group    timer group; if NULL, nothing is printed
+    /// @param format   output format
+    TimeReportPrinter(llvm::TimerGroup* group, TimeReportFormat format)
+        : m_group(group), m_format(format)
+    {}
+
+    /// Destructor.  Prints and clears the timers.
+    ~TimeReportPrinter();
+
+private:
+    TimeReportPrinter(const TimeReportPrinter&);                // not impl
+    const TimeReportPrinter& operator=(const TimeReportPrinter&); // not impl
+
+    llvm::TimerGroup* m_group;
+    TimeReportFormat m_format;
+};
+
+} // namespace yasm
+
+#endif
@@ -26,37 +26,50 @@
 //
 #include "config.h"
 
+#include <cctype>
 #include <memory>
 
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/System/DataTypes.h"
+#include "llvm/System/Path.h"
 #include "yasmx/Basic/Diagnostic.h"
 #include "yasmx/Basic/FileManager.h"
 #include "yasmx/Basic/SourceManager.h"
 #include "yasmx/Parse/HeaderSearch.h"
 #include "yasmx/Parse/Parser.h"
+#include "yasmx/Parse/TokenCache.h"
+#include "yasmx/Support/parallel.h"
 #include "yasmx/Support/registry.h"
 #include "yasmx/System/plugin.h"
 #include "yasmx/Arch.h"
 #include "yasmx/Assembler.h"
 #include "yasmx/DebugFormat.h"
+#include "yasmx/Expr.h"
+#include "yasmx/IntNum.h"
 #include "yasmx/ListFormat.h"
 #include "yasmx/Module.h"
 #include "yasmx/Object.h"
 #include "yasmx/ObjectFormat.h"
+#include "yasmx/Symbol.h"
 
 #ifdef HAVE_LIBGEN_H
 #include <libgen.h>
 #endif
 
 #include "frontends/license.cpp"
+#include "frontends/AssemblyCache.h"
+#include "frontends/AssemblyServer.h"
 #include "frontends/DiagnosticOptions.h"
 #include "frontends/TextDiagnosticPrinter.h"
+#include "frontends/TimeReport.h"
 
 
 // Preprocess-only buffer size
@@ -103,9 +116,24 @@ static cl::alias arch_keyword_long("arch",
     cl::value_desc("arch"),
     cl::aliasopt(arch_keyword));
 
+// --batch
+static cl::opt<std::string> batch_filename("batch",
+    cl::desc("Assemble each input/output file pair listed in <file>"),
+    cl::value_desc("file"));
+
+// --cache-dir
+static cl::opt<std::string> cache_dir("cache-dir",
+    cl::desc("Reuse object files assembled earlier from identical inputs"),
+    cl::value_desc("dir"));
+
+// --connect
+static cl::opt<std::string> connect_path("connect",
+    cl::desc("Assemble using the server listening on <socket>"),
+    cl::value_desc("socket"));
+
 // -D, -d
 static cl::list<std::string> predefine_macros("D",
-    cl::desc("Pre-define a macro, optionally to value"),
+    cl::desc("Pre-define a symbol, optionally to an integer value"),
     cl::value_desc("macro[=value]"),
     cl::Prefix);
 static cl::alias predefine_macros_alias("d",
@@ -194,6 +222,17 @@ static cl::alias include_paths_alias("i",
     cl::aliasopt(include_paths),
     cl::Prefix);
 
+// -j, --jobs
+static cl::opt<unsigned int> jobs("j",
+    cl::desc("Use up to N threads to optimize (0 = one per processor)"),
+    cl::value_desc("N"),
+    cl::Prefix,
+    cl::init(1));
+static cl::alias jobs_long("jobs",
+    cl::desc("Alias for -j"),
+    cl::value_desc("N"),
+    cl::aliasopt(jobs));
+
 // -L, --lformat
 static cl::opt<std::string> listfmt_keyword("L",
     cl::desc("Select list format (list with -L help)"),
@@ -234,14 +273,13 @@ static cl::alias machine_name_long("machine",
     cl::value_desc("machine"),
     cl::aliasopt(machine_name));
 
-// -O, -Onnn
-static cl::opt<int> optimize_level("O",
-    cl::desc("Set optimization level (ignored)"),
+// -O, -Onnn, -Ox
+static cl::opt<std::string> optimize_level("O",
+    cl::desc("Set optimization level (0=none, 1=basic, x=full (default))"),
     cl::value_desc("level"),
     cl::ValueOptional,
     cl::ZeroOrMore,
-    cl::Prefix,
-    cl::Hidden);
+    cl::Prefix);
 
 // -N, --plugin
 #ifndef BUILD_STATIC
@@ -287,6 +325,31 @@ static cl::opt<bool> error_stdout("s",
     cl::desc("redirect error messages to stdout"),
     cl::ZeroOrMore);
 
+// --server, --server-cache-size
+static cl::opt<std::string> server_path("server",
+    cl::desc("Serve assemble requests from --connect clients on <socket>"),
+    cl::value_desc("socket"));
+static cl::opt<unsigned int> server_cache_size("server-cache-size",
+    cl::desc("Keep up to N megabytes of source files in memory (default 64)"),
+    cl::value_desc("N"),
+    cl::init(64));
+
+// --token-cache
+static cl::opt<std::string> token_cache_dir("token-cache",
+    cl::desc("Store included files pre-tokenized in <dir> and reuse them"),
+    cl::value_desc("dir"));
+
+// --time-report, --time-report-format
+static cl::opt<bool> time_report("time-report",
+    cl::desc("Report time and memory used by each assembler phase"));
+static cl::opt<yasm::TimeReportFormat> time_report_format("time-report-format",
+    cl::desc("Set --time-report output format:"),
+    cl::init(yasm::TIME_REPORT_TEXT),
+    cl::values(
+     clEnumValN(yasm::TIME_REPORT_TEXT, "text", "table (default)"),
+     clEnumValN(yasm::TIME_REPORT_JSON, "json", "JSON object"),
+     clEnumValEnd));
+
 // -U, -u
 static cl::list<std::string> undefine_macros("U",
     cl::desc("Undefine a macro"),
@@ -674,22 +737,112 @@ do_preproc_only(void)
     return EXIT_SUCCESS;
 }
 #endif
-static int
-do_assemble(yasm::SourceManager& source_mgr, yasm::Diagnostic& diags)
+
+// A file to assemble, with its per-file options.
+struct AssemblyJob
 {
-    // Apply warning settings
-    ApplyWarningSettings(diags);
+    std::string in_filename;
+    std::string obj_filename;           // empty to use the default
+    std::string list_filename;          // empty for no list file
+    std::vector<std::string> defines;   // name[=value]
+};
 
-    yasm::FileManager file_mgr;
-    yasm::Assembler assembler(arch_keyword, objfmt_keyword, diags, dump_object);
-    yasm::HeaderSearch headers(file_mgr);
+// Define each name[=value] as an absolute symbol.  The preprocessor can't
+// predefine macros yet, so integer equates are the closest equivalent.
+// The value defaults to 1.  Later definitions of a name override earlier
+// ones.
+static void
+PredefineSymbols(yasm::Object& object,
+                 const std::vector<std::string>& defines,
+                 yasm::Diagnostic& diags)
+{
+    for (std::vector<std::string>::const_reverse_iterator i=defines.rbegin(),
+         end=defines.rend(); i != end; ++i)
+    {
+        llvm::StringRef name, vstr;
+        llvm::tie(name, vstr) = llvm::StringRef(*i).split('=');
+        long long value = 1;
+        if (name.empty() || (!vstr.empty() && vstr.getAsInteger(0, value)))
+        {
+            diags.Report(yasm::diag::warn_bad_define) << *i;
+            continue;
+        }
+        yasm::SymbolRef sym = object.getSymbol(name);
+        if (!sym->isDefined())
+            sym->DefineEqu(yasm::Expr(yasm::IntNum(value)));
+    }
+}
 
-    if (diags.hasFatalErrorOccurred())
-        return EXIT_FAILURE;
+// Set up the object file cache for a job, if enabled.  Input from stdin
+// and object dumps can't be cached.
+static yasm::AssemblyCache*
+CreateCache(const AssemblyJob& job, int argc, char* argv[])
+{
+    if (cache_dir.empty() || job.in_filename == "-" ||
+        !job.list_filename.empty() ||
+        dump_object != yasm::Assembler::DUMP_NEVER)
+        return 0;
+
+    yasm::AssemblyCache* cache = new yasm::AssemblyCache(cache_dir);
+    cache->AddCommandLine(argc, argv,
+                          reinterpret_cast<void*>(
+                              reinterpret_cast<intptr_t>(&PrintVersion)));
+    cache->AddKey(job.in_filename);
+    cache->AddKey(job.obj_filename);
+    for (std::vector<std::string>::const_iterator i=job.defines.begin(),
+         end=job.defines.end(); i != end; ++i)
+        cache->AddKey(*i);
+    return cache;
+}
 
-    // Set object filename if specified.
-    if (!obj_filename.empty())
-        assembler.setObjectFilename(obj_filename);
+// Pre-tokenized include files; shared by all assemblies in this process.
+static llvm::OwningPtr<yasm::TokenCache> token_cache;
+
+// Set up the token cache, if enabled.
+static void
+CreateTokenCache(int argc, char* argv[])
+{
+    if (token_cache_dir.empty())
+        return;
+    token_cache.reset(new yasm::TokenCache(token_cache_dir));
+    token_cache->AddKey(yasm::GetExecutableKey(argv[0],
+        reinterpret_cast<void*>(reinterpret_cast<intptr_t>(&PrintVersion))));
+}
+
+// Apply the command line options that are the same for every file.
+static bool
+ConfigureAssembler(yasm::Assembler& assembler,
+                   bool listing,
+                   llvm::TimerGroup* timers,
+                   yasm::Diagnostic& diags)
+{
+    // Set number of optimizer threads.
+    assembler.setJobs(jobs == 0 ? yasm::getNumProcessors() : jobs);
+
+    // Set optimization level.  -O alone, -Ox, and any level above the
+    // highest one are all full optimization.
+    if (optimize_level.getNumOccurrences() > 0)
+    {
+        unsigned int level = yasm::Object::OPTIMIZE_FULL;
+        if (!optimize_level.empty() && optimize_level != "x" &&
+            optimize_level != "X")
+        {
+            if (llvm::StringRef(optimize_level).getAsInteger(10, level))
+            {
+                diags.Report(yasm::diag::warn_unknown_command_line_option)
+                    << ("-O" + optimize_level);
+                level = yasm::Object::OPTIMIZE_FULL;
+            }
+        }
+        assembler.setOptimizeLevel(level);
+    }
+
+    // Time assembler phases if requested.
+    if (timers)
+    {
+        yasm::EnableAllocationCounting();
+        assembler.setTimerGroup(timers);
+    }
 
     // Set parser.
     assembler.setParser(parser_keyword, diags);
@@ -699,34 +852,60 @@ do_assemble(yasm::SourceManager& source_mgr, yasm::Diagnostic& diags)
         assembler.setMachine(machine_name, diags);
 
     if (diags.hasFatalErrorOccurred())
-        return EXIT_FAILURE;
+        return false;
 
     // Set debug format if specified.
     if (!dbgfmt_keyword.empty())
         assembler.setDebugFormat(dbgfmt_keyword, diags);
 
+    // Set list format if a list file was requested.
+    if (listing)
+        assembler.setListFormat(listfmt_keyword, diags);
+
     if (diags.hasFatalErrorOccurred())
-        return EXIT_FAILURE;
+        return false;
 
 #if 0
     ApplyPreprocessorBuiltins(assembler.getPreprocessor());
     ApplyPreprocessorSavedOptions(assembler.getPreprocessor());
 #endif
 
-    assembler.getArch()->setVar("force_strict", force_strict);
+    assembler.setArchVar("force_strict", force_strict);
+    return true;
+}
+
+// Assemble one file with a configured assembler.  The assembler must be
+// Reset() before it is used for another file.
+static int
+AssembleJob(yasm::Assembler& assembler,
+            const AssemblyJob& job,
+            yasm::SourceManager& source_mgr,
+            yasm::FileManager& file_mgr,
+            yasm::Diagnostic& diags,
+            yasm::AssemblyCache* cache)
+{
+    yasm::HeaderSearch headers(file_mgr);
+    headers.setTokenCache(token_cache.get());
+    if (cache)
+        cache->WatchHeaderSearch(headers);
+    headers.AddUserSearchPaths(include_paths);
+
+    // Set object filename if specified.
+    if (!job.obj_filename.empty())
+        assembler.setObjectFilename(job.obj_filename);
 
     // open the input file or STDIN (for filename of "-")
-    if (in_filename == "-")
+    if (job.in_filename == "-")
     {
         source_mgr.createMainFileIDForMemBuffer(llvm::MemoryBuffer::getSTDIN());
     }
     else
     {
-        const yasm::FileEntry* in = file_mgr.getFile(in_filename);
+        const yasm::FileEntry* in = file_mgr.getFile(job.in_filename);
         if (!in)
         {
             diags.Report(yasm::SourceLocation(), yasm::diag::fatal_file_open)
-                << in_filename;
+                << job.in_filename;
             return EXIT_FAILURE;
         }
         source_mgr.createMainFileID(in, yasm::SourceLocation());
@@ -738,6 +917,30 @@ do_assemble(yasm::SourceManager& source_mgr, yasm::Diagnostic& diags)
 
     // Configure object per command line parameters.
     ConfigureObject(*assembler.getObject());
+    PredefineSymbols(*assembler.getObject(), job.defines, diags);
+
+    // Reuse the cached object file if none of the inputs have changed.
+    if (cache)
+    {
+        llvm::StringRef cached;
+        if (cache->Lookup(*source_mgr.getBuffer(source_mgr.getMainFileID()),
+                          &cached))
+        {
+            std::string err;
+            llvm::raw_fd_ostream out(
+                assembler.getObjectFilename().str().c_str(), err,
+                llvm::raw_fd_ostream::F_Binary);
+            if (!err.empty())
+            {
+                diags.Report(yasm::SourceLocation(),
+                             yasm::diag::err_cannot_open_file)
+                    << assembler.getObjectFilename() << err;
+                return EXIT_FAILURE;
+            }
+            out << cached;
+            return EXIT_SUCCESS;
+        }
+    }
 
     // assemble the input.
     if (!assembler.Assemble(source_mgr, file_mgr, diags, headers))
@@ -753,7 +956,7 @@ do_assemble(yasm::SourceManager& source_mgr, yasm::Diagnostic& diags)
     if (!err.empty())
     {
         diags.Report(yasm::SourceLocation(), yasm::diag::err_cannot_open_file)
-            << obj_filename << err;
+            << assembler.getObjectFilename() << err;
         return EXIT_FAILURE;
     }
 
@@ -769,26 +972,321 @@ do_assemble(yasm::SourceManager& source_mgr, yasm::Diagnostic& diags)
 
     // close object file
     out.close();
-#if 0
+
+    // Store the object file for later runs.  Diagnostics aren't replayed
+    // from the cache, so don't store anything that produced warnings.
+    if (cache && diags.getNumWarnings() == 0 &&
+        !assembler.getObject()->hasExtraOutput())
+    {
+        std::string cache_err;
+        if (cache->Store(source_mgr, *assembler.getObject(),
+                         assembler.getObjectFilename(), &cache_err))
+            diags.Report(yasm::SourceLocation(), yasm::diag::warn_cache_store)
+                << cache_err;
+    }
+
     // Open and write the list file
-    if (list_filename)
+    if (!job.list_filename.empty())
     {
-        FILE *list = open_file(list_filename, "wt");
-        if (!list)
+        llvm::raw_fd_ostream list(job.list_filename.c_str(), err);
+        if (!err.empty())
         {
-            PrintError(String::Compose(_("could not open file `%1'"), filename));
+            diags.Report(yasm::SourceLocation(),
+                         yasm::diag::err_cannot_open_file)
+                << job.list_filename << err;
             return EXIT_FAILURE;
         }
-        /* Initialize the list format */
-        cur_listfmt = yasm_listfmt_create(cur_listfmt_module, in_filename,
-                                          obj_filename);
-        yasm_listfmt_output(cur_listfmt, list, linemap, cur_arch);
-        fclose(list);
+        if (!assembler.OutputList(list, source_mgr, diags))
+            return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+static int
+do_assemble(const AssemblyJob& job,
+            yasm::SourceManager& source_mgr,
+            yasm::FileManager& file_mgr,
+            yasm::Diagnostic& diags,
+            yasm::AssemblyCache* cache)
+{
+    // Apply warning settings
+    ApplyWarningSettings(diags);
+
+    llvm::TimerGroup timers("Assembler Time Report");
+    yasm::Assembler assembler(arch_keyword, objfmt_keyword, diags, dump_object);
+    if (diags.hasFatalErrorOccurred())
+        return EXIT_FAILURE;
+
+    // The time report is printed when time_reporter goes out of scope
+    // (before the assembler does).
+    yasm::TimeReportPrinter time_reporter(time_report ? &timers : 0,
+                                          time_report_format);
+    if (!ConfigureAssembler(assembler, !job.list_filename.empty(),
+                            time_report ? &timers : 0, diags))
+        return EXIT_FAILURE;
+
+    return AssembleJob(assembler, job, source_mgr, file_mgr, diags, cache);
+}
+
+// Split a batch file line into words separated by whitespace.  Double
+// quotes may be used around (parts of) words containing whitespace.
+static void
+SplitBatchLine(llvm::StringRef line, std::vector<std::string>* words)
+{
+    size_t i = 0;
+    for (;;)
+    {
+        while (i < line.size() &&
+               isspace(static_cast<unsigned char>(line[i])))
+            ++i;
+        if (i == line.size())
+            return;
+
+        std::string word;
+        bool quoted = false;
+        for (; i < line.size() &&
+             (quoted || !isspace(static_cast<unsigned char>(line[i]))); ++i)
+        {
+            if (line[i] == '"')
+                quoted = !quoted;
+            else
+                word += line[i];
+        }
+        words->push_back(word);
+    }
+}
+
+// Parse the words of a batch file line or server request: an input file,
+// optionally an object file, and -Dname[=value] defines in any order.
+// Returns false if there are too many file names.
+static bool
+ParseJobWords(const std::vector<std::string>& words, AssemblyJob* job)
+{
+    for (std::vector<std::string>::const_iterator i=words.begin(),
+         end=words.end(); i != end; ++i)
+    {
+        llvm::StringRef word(*i);
+        if (word.startswith("-D") || word.startswith("-d"))
+            job->defines.push_back(word.substr(2));
+        else if (job->in_filename.empty())
+            job->in_filename = word;
+        else if (job->obj_filename.empty())
+            job->obj_filename = word;
+        else
+            return false;
+    }
+    return true;
+}
+
+// Assemble all jobs listed in the batch file.  Each line gives an input
+// file, an object file, and optionally -Dname[=value] defines for that
+// file; blank lines and lines starting with '#' are ignored.  All other
+// options come from the command line and apply to every job; -D on the
+// command line is ignored, as it is outside batch mode.  One assembler
+// (and so one set of modules) and the file manager with its stat cache are
+// shared between jobs.
+static int
+do_batch(yasm::DiagnosticClient& diag_client,
+         yasm::Diagnostic& diags,
+         int argc,
+         char* argv[])
+{
+    // Output file names are given per job.
+    if (!obj_filename.empty())
+        diags.Report(yasm::diag::fatal_batch_option) << "-o";
+    else if (!list_filename.empty())
+        diags.Report(yasm::diag::fatal_batch_option) << "-l";
+    if (diags.hasFatalErrorOccurred())
+        return EXIT_FAILURE;
+
+    llvm::OwningPtr<llvm::MemoryBuffer>
+        batch(llvm::MemoryBuffer::getFile(batch_filename));
+    if (!batch)
+    {
+        diags.Report(yasm::SourceLocation(), yasm::diag::fatal_file_open)
+            << batch_filename;
+        return EXIT_FAILURE;
+    }
+
+    ApplyWarningSettings(diags);
+    llvm::TimerGroup timers("Assembler Time Report");
+    yasm::Assembler assembler(arch_keyword, objfmt_keyword, diags, dump_object);
+    if (diags.hasFatalErrorOccurred())
+        return EXIT_FAILURE;
+    yasm::TimeReportPrinter time_reporter(time_report ? &timers : 0,
+                                          time_report_format);
+    if (!ConfigureAssembler(assembler, false, time_report ? &timers : 0,
+                            diags))
+        return EXIT_FAILURE;
+
+    yasm::FileManager file_mgr;
+    int result = EXIT_SUCCESS;
+    unsigned int line_num = 0;
+    llvm::StringRef rest = batch->getBuffer();
+    while (!rest.empty())
+    {
+        llvm::StringRef line;
+        llvm::tie(line, rest) = rest.split('\n');
+        ++line_num;
+
+        std::vector<std::string> words;
+        SplitBatchLine(line, &words);
+        if (words.empty() || words[0][0] == '#')
+            continue;
+
+        AssemblyJob job;
+        if (!ParseJobWords(words, &job) || job.obj_filename.empty())
+        {
+            diags.Report(yasm::diag::err_bad_batch_line)
+                << batch_filename << line_num;
+            result = EXIT_FAILURE;
+            continue;
+        }
+
+        // Each job gets its own diagnostics and source manager.
+        yasm::Diagnostic job_diags(&diag_client);
+        yasm::SourceManager source_mgr(job_diags);
+        job_diags.setSourceManager(&source_mgr);
+        ApplyWarningSettings(job_diags);
+        llvm::OwningPtr<yasm::AssemblyCache>
+            cache(CreateCache(job, argc, argv));
+        if (AssembleJob(assembler, job, source_mgr, file_mgr, job_diags,
+                        cache.get()) != EXIT_SUCCESS)
+            result = EXIT_FAILURE;
+        assembler.Reset();
+    }
+    return result;
+}
+
+// State shared by all server requests.
+struct ServerContext
+{
+    yasm::FileContentCache* contents;
+    const yasm::DiagnosticOptions* diag_opts;
+    int argc;
+    char** argv;
+};
+
+// Handle a --connect request.  The arguments are the client's input file,
+// object file (if given), and defines, in the same form as a batch file
+// line.  All other options come from the server's command line; -D there
+// is ignored, as it is in batch mode.
+static int
+HandleServerRequest(const yasm::ServerRequest& req,
+                    llvm::raw_ostream& os,
+                    void* data)
+{
+    ServerContext& ctx = *static_cast<ServerContext*>(data);
+    int result;
+    {
+        yasm::TextDiagnosticPrinter diag_printer(os, *ctx.diag_opts);
+        yasm::Diagnostic diags(&diag_printer);
+        yasm::SourceManager source_mgr(diags);
+        diags.setSourceManager(&source_mgr);
+        source_mgr.setExternalFileContentSource(ctx.contents);
+        diag_printer.setPrefix("yasm");
+
+        AssemblyJob job;
+        if (!ParseJobWords(req.args, &job) || job.in_filename.empty())
+        {
+            diags.Report(yasm::diag::fatal_no_input_files);
+            return EXIT_FAILURE;
+        }
+
+        // Use a new file manager so changes since the last request are
+        // seen; contents of unchanged files still come from memory.
+        yasm::FileManager file_mgr;
+        llvm::OwningPtr<yasm::AssemblyCache>
+            cache(CreateCache(job, ctx.argc, ctx.argv));
+        result = do_assemble(job, source_mgr, file_mgr, diags, cache.get());
+    }
+    ctx.contents->Prune();
+    return result;
+}
+
+// Serve assemble requests from --connect clients until interrupted.
+static int
+do_server(const yasm::DiagnosticOptions& diag_opts,
+          yasm::Diagnostic& diags,
+          int argc,
+          char* argv[])
+{
+    // Requests run in the client's directory.
+    if (!cache_dir.empty() &&
+        !llvm::sys::Path::isAbsolute(cache_dir.data(), cache_dir.size()))
+    {
+        llvm::sys::Path abs = llvm::sys::Path::GetCurrentDirectory();
+        abs.appendComponent(cache_dir);
+        cache_dir = abs.str();
+    }
+
+    yasm::FileContentCache contents(
+        static_cast<size_t>(server_cache_size) * 1024 * 1024);
+    ServerContext ctx = { &contents, &diag_opts, argc, argv };
+    yasm::AssemblyServer server(server_path);
+    std::string err;
+    if (server.Listen(&err) || server.Run(HandleServerRequest, &ctx, &err))
+    {
+        diags.Report(yasm::diag::fatal_server) << server_path << err;
+        return EXIT_FAILURE;
     }
-#endif
     return EXIT_SUCCESS;
 }
 
+// Options a --connect client handles itself or passes on to the server.
+static bool
+isConnectOption(const cl::Option* opt)
+{
+    return opt == &in_filename || opt == &obj_filename ||
+        opt == &obj_filename_long || opt == &predefine_macros ||
+        opt == &predefine_macros_alias || opt == &connect_path ||
+        opt == &error_filename || opt == &error_stdout ||
+        opt == &unknown_options;
+}
+
+// Have the server listening on connect_path assemble the input file.
+static int
+do_connect(yasm::Diagnostic& diags)
+{
+    if (in_filename == "-")
+    {
+        diags.Report(yasm::diag::fatal_server_stdin);
+        return EXIT_FAILURE;
+    }
+
+    // The server assembles with its own options, so refuse any the request
+    // can't carry rather than silently dropping them.  Options register
+    // themselves in a list, newest first; unknown_options is the last one
+    // declared in this file, so the walk sees all of the frontend's options.
+    for (const cl::Option* opt = &unknown_options; opt != 0;
+         opt = opt->getNextRegisteredOption())
+    {
+        if (opt->getNumOccurrences() > 0 && !isConnectOption(opt))
+        {
+            diags.Report(yasm::diag::fatal_server_option) << opt->ArgStr;
+            return EXIT_FAILURE;
+        }
+    }
+
+    yasm::ServerRequest req;
+    req.cwd = llvm::sys::Path::GetCurrentDirectory().str();
+    req.args.push_back(in_filename);
+    if (!obj_filename.empty())
+        req.args.push_back(obj_filename);
+    for (std::vector<std::string>::const_iterator i=predefine_macros.begin(),
+         end=predefine_macros.end(); i != end; ++i)
+        req.args.push_back("-D" + *i);
+
+    int status;
+    std::string err;
+    if (yasm::SendServerRequest(connect_path, req, *errfile, &status, &err))
+    {
+        diags.Report(yasm::diag::fatal_server) << connect_path << err;
+        return EXIT_FAILURE;
+    }
+    return status;
+}
+
 // main function
 int
 main(int argc, char* argv[])
@@ -904,14 +1402,19 @@ main(int argc, char* argv[])
         return EXIT_SUCCESS;
     }
 
-    // Require an input filename.  We don't use llvm::cl facilities for this
-    // as we want to allow e.g. "yasm --license".
-    if (in_filename.empty())
+    // Require an input filename (or a batch file, or server mode).  We
+    // don't use llvm::cl facilities for this as we want to allow e.g.
+    // "yasm --license".
+    if (in_filename.empty() && batch_filename.empty() && server_path.empty())
     {
         diags.Report(yasm::diag::fatal_no_input_files);
         return EXIT_FAILURE;
     }
 
+    // A server client leaves everything else to the server.
+    if (!connect_path.empty())
+        return do_connect(diags);
+
     // If not already specified, default to bin as the object format.
     if (objfmt_keyword.empty())
         objfmt_keyword = "bin";
@@ -933,6 +1436,21 @@ main(int argc, char* argv[])
             listfmt_keyword = "nasm";
     }
 
-    return do_assemble(source_mgr, diags);
+    CreateTokenCache(argc, argv);
+
+    if (!server_path.empty())
+        return do_server(diag_opts, diags, argc, argv);
+
+    if (!batch_filename.empty())
+        return do_batch(diag_printer, diags, argc, argv);
+
+    AssemblyJob job;
+    job.in_filename = in_filename;
+    job.obj_filename = obj_filename;
+    job.list_filename = list_filename;
+
+    yasm::FileManager file_mgr;
+    llvm::OwningPtr<yasm::AssemblyCache> cache(CreateCache(job, argc, argv));
+    return do_assemble(job, source_mgr, file_mgr, diags, cache.get());
 }
 
@@ -28,18 +28,23 @@
 
 #include <memory>
 
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/System/DataTypes.h"
 #include "yasmx/Basic/Diagnostic.h"
 #include "yasmx/Basic/FileManager.h"
 #include "yasmx/Basic/SourceManager.h"
 #include "yasmx/Parse/HeaderSearch.h"
 #include "yasmx/Parse/Parser.h"
+#include "yasmx/Parse/TokenCache.h"
+#include "yasmx/Support/parallel.h"
 #include "yasmx/Support/registry.h"
 #include "yasmx/System/plugin.h"
 #include "yasmx/Arch.h"
@@ -58,8 +63,10 @@
 #endif
 
 #include "frontends/license.cpp"
+#include "frontends/AssemblyCache.h"
 #include "frontends/DiagnosticOptions.h"
 #include "frontends/TextDiagnosticPrinter.h"
+#include "frontends/TimeReport.h"
 
 
 // Preprocess-only buffer size
@@ -103,6 +110,11 @@ static cl::list<bool> bits_32("32",
 static cl::list<bool> bits_64("64",
     cl::desc("set 64-bit output"));
 
+// --cache-dir
+static cl::opt<std::string> cache_dir("cache-dir",
+    cl::desc("Reuse object files assembled earlier from identical inputs"),
+    cl::value_desc("dir"));
+
 // -defsym
 static cl::list<std::string> defsym("defsym",
     cl::desc("define symbol"));
@@ -144,6 +156,12 @@ static cl::list<std::string> include_paths("I",
     cl::value_desc("path"),
     cl::Prefix);
 
+// --jobs
+static cl::opt<unsigned int> jobs("jobs",
+    cl::desc("Use up to N threads to optimize (0 = one per processor)"),
+    cl::value_desc("N"),
+    cl::init(1));
+
 // --license
 static cl::opt<bool> show_license("license",
     cl::desc("Show license text"));
@@ -155,6 +173,22 @@ static cl::list<std::string> plugin_names("plugin",
     cl::value_desc("plugin"));
 #endif
 
+// --token-cache
+static cl::opt<std::string> token_cache_dir("token-cache",
+    cl::desc("Store included files pre-tokenized in <dir> and reuse them"),
+    cl::value_desc("dir"));
+
+// --time-report, --time-report-format
+static cl::opt<bool> time_report("time-report",
+    cl::desc("Report time and memory used by each assembler phase"));
+static cl::opt<yasm::TimeReportFormat> time_report_format("time-report-format",
+    cl::desc("Set --time-report output format:"),
+    cl::init(yasm::TIME_REPORT_TEXT),
+    cl::values(
+     clEnumValN(yasm::TIME_REPORT_TEXT, "text", "table (default)"),
+     clEnumValN(yasm::TIME_REPORT_JSON, "json", "JSON object"),
+     clEnumValEnd));
+
 // -o
 static cl::opt<std::string> obj_filename("o",
     cl::desc("Name of object-file output"),
@@ -359,8 +393,24 @@ ConfigureObject(yasm::Object& object)
     }
 }
 
+// Pre-tokenized include files; shared by all assemblies in this process.
+static llvm::OwningPtr<yasm::TokenCache> token_cache;
+
+// Set up the token cache, if enabled.
+static void
+CreateTokenCache(int argc, char* argv[])
+{
+    if (token_cache_dir.empty())
+        return;
+    token_cache.reset(new yasm::TokenCache(token_cache_dir));
+    token_cache->AddKey(yasm::GetExecutableKey(argv[0],
+        reinterpret_cast<void*>(reinterpret_cast<intptr_t>(&PrintVersion))));
+}
+
 static int
-do_assemble(yasm::SourceManager& source_mgr, yasm::Diagnostic& diags)
+do_assemble(yasm::SourceManager& source_mgr,
+            yasm::Diagnostic& diags,
+            yasm::AssemblyCache* cache)
 {
     // Apply warning settings
     ApplyWarningSettings(diags);
@@ -368,10 +418,15 @@ do_assemble(yasm::SourceManager& source_mgr, yasm::Diagnostic& diags)
     // Determine objfmt_bits based on -32 and -64 options
     std::string objfmt_bits = GetBitsSetting();
 
+    llvm::TimerGroup timers("Assembler Time Report");
     yasm::FileManager file_mgr;
     yasm::Assembler assembler("x86", YGAS_OBJFMT_BASE + objfmt_bits, diags,
                               dump_object);
     yasm::HeaderSearch headers(file_mgr);
+    headers.setTokenCache(token_cache.get());
+    if (cache)
+        cache->WatchHeaderSearch(headers);
+    headers.AddUserSearchPaths(include_paths);
 
     if (diags.hasFatalErrorOccurred())
         return EXIT_FAILURE;
@@ -380,6 +435,19 @@ do_assemble(yasm::SourceManager& source_mgr, yasm::Diagnostic& diags)
     if (!obj_filename.empty())
         assembler.setObjectFilename(obj_filename);
 
+    // Set number of optimizer threads.
+    assembler.setJobs(jobs == 0 ? yasm::getNumProcessors() : jobs);
+
+    // Time assembler phases if requested.  The report is printed when
+    // time_reporter goes out of scope (before the assembler does).
+    if (time_report)
+    {
+        yasm::EnableAllocationCounting();
+        assembler.setTimerGroup(&timers);
+    }
+    yasm::TimeReportPrinter time_reporter(time_report ? &timers : 0,
+                                          time_report_format);
+
     // Set parser.
     assembler.setParser("gas", diags);
 
@@ -484,6 +552,29 @@ do_assemble(yasm::SourceManager& source_mgr, yasm::Diagnostic& diags)
     if (diags.hasFatalErrorOccurred())
         return EXIT_FAILURE;
 
+    // Reuse the cached object file if none of the inputs have changed.
+    if (cache)
+    {
+        llvm::StringRef cached;
+        if (cache->Lookup(*source_mgr.getBuffer(source_mgr.getMainFileID()),
+                          &cached))
+        {
+            std::string err;
+            llvm::raw_fd_ostream out(
+                assembler.getObjectFilename().str().c_str(), err,
+                llvm::raw_fd_ostream::F_Binary);
+            if (!err.empty())
+            {
+                diags.Report(yasm::SourceLocation(),
+                             yasm::diag::err_cannot_open_file)
+                    << obj_filename << err;
+                return EXIT_FAILURE;
+            }
+            out << cached;
+            return EXIT_SUCCESS;
+        }
+    }
+
     // Assemble the input.
     if (!assembler.Assemble(source_mgr, file_mgr, diags, headers))
     {
@@ -514,6 +605,18 @@ do_assemble(yasm::SourceManager& source_mgr, yasm::Diagnostic& diags)
 
     // close object file
     out.close();
+
+    // Store the object file for later runs.  Diagnostics aren't replayed
+    // from the cache, so don't store anything that produced warnings.
+    if (cache && diags.getNumWarnings() == 0 &&
+        !assembler.getObject()->hasExtraOutput())
+    {
+        std::string cache_err;
+        if (cache->Store(source_mgr, *assembler.getObject(),
+                         assembler.getObjectFilename(), &cache_err))
+            diags.Report(yasm::SourceLocation(), yasm::diag::warn_cache_store)
+                << cache_err;
+    }
     return EXIT_SUCCESS;
 }
 
@@ -570,6 +673,20 @@ main(int argc, char* argv[])
     if (in_filename.empty())
         in_filename = "-";
 
-    return do_assemble(source_mgr, diags);
+    CreateTokenCache(argc, argv);
+
+    // Set up the object file cache.  Input from stdin and object dumps
+    // can't be cached.
+    llvm::OwningPtr<yasm::AssemblyCache> cache;
+    if (!cache_dir.empty() && in_filename != "-" &&
+        dump_object == yasm::Assembler::DUMP_NEVER)
+    {
+        cache.reset(new yasm::AssemblyCache(cache_dir));
+        cache->AddCommandLine(argc, argv,
+                              reinterpret_cast<void*>(
+                                  reinterpret_cast<intptr_t>(&PrintVersion)));
+    }
+
+    return do_assemble(source_mgr, diags, cache.get());
 }
 
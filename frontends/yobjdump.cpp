@@ -26,12 +26,14 @@
 //
 #include "config.h"
 
+#include <algorithm>
 #include <cctype>
 #include <cstring>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Format.h"
@@ -41,6 +43,8 @@
 #include "yasmx/Basic/Diagnostic.h"
 #include "yasmx/Basic/FileManager.h"
 #include "yasmx/Basic/SourceManager.h"
+#include "yasmx/Config/functional.h"
+#include "yasmx/Support/parallel.h"
 #include "yasmx/Support/registry.h"
 #include "yasmx/System/plugin.h"
 #include "yasmx/Arch.h"
@@ -159,6 +163,17 @@ static cl::alias show_contents_long("full-contents",
     cl::desc("Alias for -s"),
     cl::aliasopt(show_contents));
 
+// -j, --jobs
+static cl::opt<unsigned int> jobs("j",
+    cl::desc("Dump up to N files at once (0 = one per processor)"),
+    cl::value_desc("N"),
+    cl::Prefix,
+    cl::init(1));
+static cl::alias jobs_long("jobs",
+    cl::desc("Alias for -j"),
+    cl::value_desc("N"),
+    cl::aliasopt(jobs));
+
 // -x, --all-headers
 static cl::opt<bool> show_all_headers("x",
     cl::desc("Display all available header information (-f -h -p -r -t)"),
@@ -187,9 +202,8 @@ list_module()
 }
 
 static void
-DumpSectionHeaders(const yasm::Object& object)
+DumpSectionHeaders(llvm::raw_ostream& os, const yasm::Object& object)
 {
-    llvm::raw_ostream& os = llvm::outs();
     os << "Sections:\n"
        << "Idx Name          Size      ";
     unsigned int bits = 64; // FIXME
@@ -218,9 +232,8 @@ DumpSectionHeaders(const yasm::Object& object)
 }
 
 static void
-DumpSymbols(const yasm::Object& object)
+DumpSymbols(llvm::raw_ostream& os, const yasm::Object& object)
 {
-    llvm::raw_ostream& os = llvm::outs();
     os << "SYMBOL TABLE:\n";
     unsigned int bits = 64; // FIXME
     for (yasm::Object::const_symbol_iterator sym=object.symbols_begin(),
@@ -254,9 +267,8 @@ DumpSymbols(const yasm::Object& object)
 }
 
 static void
-DumpRelocs(const yasm::Object& object)
+DumpRelocs(llvm::raw_ostream& os, const yasm::Object& object)
 {
-    llvm::raw_ostream& os = llvm::outs();
     unsigned int bits = 64; // FIXME
 
     for (yasm::Object::const_section_iterator sect=object.sections_begin(),
@@ -283,49 +295,201 @@ DumpRelocs(const yasm::Object& object)
     }
 }
 
-static void
-DumpContentsLine(const yasm::IntNum& addr,
-                 const unsigned char* data,
-                 int len,
-                 int addr_bits)
+namespace {
+/// Formats section contents in objdump -s style: an address followed by
+/// up to 16 bytes in hex and as ASCII on each line.  Lines are formatted
+/// directly into a preallocated buffer that is written to the output
+/// stream a block of lines at a time.
+class ContentsDumper
+{
+public:
+    /// Constructor.
+    /// @param os           output stream
+    /// @param addr         address of first byte
+    /// @param addr_bits    number of bits to pad addresses to
+    ContentsDumper(llvm::raw_ostream& os,
+                   const yasm::IntNum& addr,
+                   unsigned int addr_bits);
+    ~ContentsDumper();
+
+    /// Add bytes to the dump, outputting all lines that are completed.
+    /// @param data     data
+    /// @param size     number of bytes
+    void Dump(const unsigned char* data, unsigned long size);
+
+    /// Output any partial last line and flush the buffer to the stream.
+    void Finish();
+
+private:
+    enum
+    {
+        BYTES_PER_LINE = 16,
+        LINES_PER_BLOCK = 256
+    };
+
+    void FormatLine(const unsigned char* data, unsigned int len);
+    void Flush();
+
+    llvm::raw_ostream& m_os;
+
+    /// Address of the next line.  Kept as a native integer unless it may
+    /// not fit in one.
+    yasm::IntNum m_addr;
+    uint64_t m_addr64;
+    bool m_wide_addr;
+    unsigned int m_addr_bits;
+    unsigned int m_addr_digits;
+
+    unsigned char m_line[BYTES_PER_LINE];   ///< partial line
+    unsigned int m_line_len;
+
+    std::vector<char> m_buf;                ///< formatted lines
+    std::vector<char>::size_type m_buf_len; ///< used portion of m_buf
+};
+} // anonymous namespace
+
+static const char hex_digits[] = "0123456789abcdef";
+
+ContentsDumper::ContentsDumper(llvm::raw_ostream& os,
+                               const yasm::IntNum& addr,
+                               unsigned int addr_bits)
+    : m_os(os),
+      m_addr(addr),
+      m_addr64(0),
+      m_wide_addr(addr_bits > 64),
+      m_addr_bits(addr_bits),
+      m_addr_digits((addr_bits+3)/4),
+      m_line_len(0),
+      m_buf_len(0)
+{
+    if (!m_wide_addr)
+    {
+        m_addr64 = (static_cast<uint64_t>(addr.Extract(32, 32)) << 32)
+            | addr.Extract(32, 0);
+    }
+
+    // " ", address, 4x(" " + 8 hex digits), "  ", 16 chars, "\n"
+    std::vector<char>::size_type line_size =
+        1 + m_addr_digits + 4*9 + 2 + BYTES_PER_LINE + 1;
+    m_buf.resize(line_size * LINES_PER_BLOCK);
+}
+
+ContentsDumper::~ContentsDumper()
 {
-    llvm::raw_ostream& os = llvm::outs();
+}
+
+void
+ContentsDumper::FormatLine(const unsigned char* data, unsigned int len)
+{
+    if (m_buf.size() - m_buf_len < m_buf.size() / LINES_PER_BLOCK)
+        Flush();
+
+    char* start = &m_buf[m_buf_len];
+    char* p = start;
 
     // address
-    os << ' ';
-    addr.Print(os, 16, true, false, addr_bits);
+    *p++ = ' ';
+    if (m_wide_addr)
+    {
+        llvm::SmallString<64> s;
+        llvm::raw_svector_ostream ss(s);
+        m_addr.Print(ss, 16, true, false, m_addr_bits);
+        ss.flush();
+        std::memcpy(p, s.data(), s.size());
+        p += s.size();
+        m_addr += BYTES_PER_LINE;
+    }
+    else
+    {
+        for (unsigned int i=m_addr_digits; i>0; --i)
+            *p++ = hex_digits[(m_addr64 >> ((i-1)*4)) & 0xf];
+        m_addr64 += BYTES_PER_LINE;
+    }
 
     // hex dump
-    for (int i=0; i<16; ++i)
+    for (unsigned int i=0; i<BYTES_PER_LINE; ++i)
     {
         if ((i & 3) == 0)
-            os << ' ';
-        if (i<len)
-            os << llvm::format("%02x", static_cast<unsigned int>(data[i]));
+            *p++ = ' ';
+        if (i < len)
+        {
+            *p++ = hex_digits[data[i] >> 4];
+            *p++ = hex_digits[data[i] & 0xf];
+        }
         else
-            os << "  ";
+        {
+            *p++ = ' ';
+            *p++ = ' ';
+        }
     }
 
     // ascii dump
-    os << "  ";
-    for (int i=0; i<16; ++i)
+    *p++ = ' ';
+    *p++ = ' ';
+    for (unsigned int i=0; i<BYTES_PER_LINE; ++i)
     {
-        if (i>=len)
-            os << ' ';
+        if (i >= len)
+            *p++ = ' ';
         else if (!std::isprint(data[i]))
-            os << '.';
+            *p++ = '.';
         else
-            os << data[i];
+            *p++ = static_cast<char>(data[i]);
     }
 
-    os << '\n';
+    *p++ = '\n';
+    m_buf_len += p - start;
 }
 
-static void
-DumpContents(const yasm::Object& object)
+void
+ContentsDumper::Flush()
 {
-    llvm::raw_ostream& os = llvm::outs();
+    if (m_buf_len == 0)
+        return;
+    m_os.write(&m_buf[0], m_buf_len);
+    m_buf_len = 0;
+}
 
+void
+ContentsDumper::Dump(const unsigned char* data, unsigned long size)
+{
+    // finish any partial line first
+    if (m_line_len != 0)
+    {
+        unsigned long tocopy = BYTES_PER_LINE - m_line_len;
+        if (tocopy > size)
+            tocopy = size;
+        std::memcpy(&m_line[m_line_len], data, tocopy);
+        m_line_len += tocopy;
+        data += tocopy;
+        size -= tocopy;
+        if (m_line_len < BYTES_PER_LINE)
+            return;
+        FormatLine(m_line, BYTES_PER_LINE);
+        m_line_len = 0;
+    }
+
+    // whole lines are formatted straight from the data
+    for (; size >= BYTES_PER_LINE; data += BYTES_PER_LINE,
+         size -= BYTES_PER_LINE)
+        FormatLine(data, BYTES_PER_LINE);
+
+    // save the remainder
+    std::memcpy(m_line, data, size);
+    m_line_len = size;
+}
+
+void
+ContentsDumper::Finish()
+{
+    if (m_line_len != 0)
+        FormatLine(m_line, m_line_len);
+    m_line_len = 0;
+    Flush();
+}
+
+static void
+DumpContents(llvm::raw_ostream& os, const yasm::Object& object)
+{
     for (yasm::Object::const_section_iterator sect=object.sections_begin(),
          end=object.sections_end(); sect != end; ++sect)
     {
@@ -349,44 +513,24 @@ DumpContents(const yasm::Object& object)
 
         os << "Contents of section " << sect->getName() << ":\n";
 
-        unsigned char line[16];
-        int line_pos = 0;
-        yasm::IntNum addr = sect->getVMA();
-
+        ContentsDumper dumper(os, sect->getVMA(), addr_bits);
         for (yasm::Section::const_bc_iterator bc=sect->bytecodes_begin(),
              endbc=sect->bytecodes_end(); bc != endbc; ++bc)
         {
-            // XXX: only outputs fixed portions
+            // XXX: only outputs fixed portions and plain data tails
             const yasm::Bytes& fixed = bc->getFixed();
-            long fixed_pos = 0;
-            long fixed_size = fixed.size();
-            while (fixed_pos < fixed_size)
-            {
-                long tocopy = 16-line_pos;
-                if (tocopy > (fixed_size-fixed_pos))
-                    tocopy = fixed_size-fixed_pos;
-                std::memcpy(&line[line_pos], &fixed[fixed_pos], tocopy);
-                line_pos += tocopy;
-                fixed_pos += tocopy;
-
-                // when we've filled up a line, output it.
-                if (line_pos == 16)
-                {
-                    DumpContentsLine(addr, line, 16, addr_bits);
-                    addr += 16;
-                    line_pos = 0;
-                }
-            }
+            if (!fixed.empty())
+                dumper.Dump(&fixed[0], fixed.size());
+            if (const unsigned char* tail = bc->getTailData())
+                dumper.Dump(tail, bc->getTailLen());
         }
-
-        // output any remaining
-        if (line_pos != 0)
-            DumpContentsLine(addr, line, line_pos, addr_bits);
+        dumper.Finish();
     }
 }
 
 static int
 DoDump(const std::string& in_filename,
+       llvm::raw_ostream& os,
        yasm::SourceManager& source_mgr,
        yasm::Diagnostic& diags)
 {
@@ -404,6 +548,7 @@ DoDump(const std::string& in_filename,
         {
             diags.Report(yasm::SourceLocation(), yasm::diag::err_file_open)
                 << in_filename;
+            return EXIT_FAILURE;
         }
         source_mgr.createMainFileID(in, yasm::SourceLocation());
     }
@@ -418,7 +563,6 @@ DoDump(const std::string& in_filename,
 
     if (!objfmt_keyword.empty())
     {
-        objfmt_keyword = llvm::LowercaseString(objfmt_keyword);
         if (!yasm::isModule<yasm::ObjectFormatModule>(objfmt_keyword))
         {
             diags.Report(sloc, yasm::diag::err_unrecognized_object_format)
@@ -495,20 +639,65 @@ DoDump(const std::string& in_filename,
     if (!objfmt->Read(source_mgr, diags))
         return EXIT_FAILURE;
 
-    llvm::outs() << in_filename << ":     file format "
-                 << objfmt_module->getKeyword() << "\n\n";
+    os << in_filename << ":     file format "
+       << objfmt_module->getKeyword() << "\n\n";
 
     if (show_section_headers)
-        DumpSectionHeaders(object);
+        DumpSectionHeaders(os, object);
     if (show_symbols)
-        DumpSymbols(object);
+        DumpSymbols(os, object);
     if (show_relocs)
-        DumpRelocs(object);
+        DumpRelocs(os, object);
     if (show_contents)
-        DumpContents(object);
+        DumpContents(os, object);
     return EXIT_SUCCESS;
 }
 
+// Dump a single file, with its own source manager and diagnostics.
+static int
+DumpFile(const std::string& in_filename,
+         llvm::raw_ostream& os,
+         llvm::raw_ostream& err_os)
+{
+    yasm::OffsetDiagnosticPrinter diag_printer(err_os);
+    yasm::Diagnostic diags(&diag_printer);
+    yasm::SourceManager source_mgr(diags);
+    diags.setSourceManager(&source_mgr);
+    diag_printer.setPrefix("yobjdump");
+
+    try
+    {
+        return DoDump(in_filename, os, source_mgr, diags);
+    }
+    catch (std::out_of_range& err)
+    {
+        err_os << in_filename << ": "
+            << "out of range error while reading (corrupt file?)\n";
+        return EXIT_FAILURE;
+    }
+}
+
+namespace {
+/// Buffered result of dumping one file with -j.
+struct DumpResult
+{
+    std::string out;
+    std::string err;
+    int retval;
+};
+} // anonymous namespace
+
+static void
+ParallelDumpFile(std::vector<DumpResult>* results,
+                 unsigned long first,
+                 unsigned long i)
+{
+    DumpResult& result = (*results)[i];
+    llvm::raw_string_ostream os(result.out);
+    llvm::raw_string_ostream err_os(result.err);
+    result.retval = DumpFile(in_filenames[first+i], os, err_os);
+}
+
 int
 main(int argc, char* argv[])
 {
@@ -536,8 +725,6 @@ main(int argc, char* argv[])
 
     yasm::OffsetDiagnosticPrinter diag_printer(llvm::errs());
     yasm::Diagnostic diags(&diag_printer);
-    yasm::SourceManager source_mgr(diags);
-    diags.setSourceManager(&source_mgr);
     diag_printer.setPrefix("yobjdump");
 
     // Load standard modules
@@ -563,21 +750,50 @@ main(int argc, char* argv[])
         return EXIT_FAILURE;
     }
 
+    // Lowercase here, as files may be dumped from multiple threads.
+    objfmt_keyword = llvm::LowercaseString(objfmt_keyword);
+
     int retval = EXIT_SUCCESS;
+    unsigned int njobs = (jobs == 0 ? yasm::getNumProcessors() : jobs);
 
-    for (std::vector<std::string>::const_iterator i=in_filenames.begin(),
-         end=in_filenames.end(); i != end; ++i)
+    if (njobs <= 1 || in_filenames.size() <= 1)
     {
-        try
+        for (std::vector<std::string>::const_iterator i=in_filenames.begin(),
+             end=in_filenames.end(); i != end; ++i)
         {
-            if (DoDump(*i, source_mgr, diags) != EXIT_SUCCESS)
+            if (DumpFile(*i, llvm::outs(), llvm::errs()) != EXIT_SUCCESS)
                 retval = EXIT_FAILURE;
         }
-        catch (std::out_of_range& err)
+        return retval;
+    }
+
+    // Dump a window of files at a time, each into its own buffer, and
+    // write out the buffers in input order.  The window keeps all threads
+    // busy while bounding the amount of output held in memory.
+    unsigned long window = 4*njobs;
+    std::vector<DumpResult> results;
+    for (unsigned long first=0; first<in_filenames.size(); first+=window)
+    {
+        unsigned long count =
+            std::min(window, static_cast<unsigned long>(in_filenames.size())
+                             - first);
+        results.clear();
+        results.resize(count);
+        yasm::ParallelFor(count, njobs,
+                          yasm::TR1::bind(&ParallelDumpFile, &results, first,
+                                          yasm::_1));
+
+        for (std::vector<DumpResult>::const_iterator i=results.begin(),
+             end=results.end(); i != end; ++i)
         {
-            llvm::errs() << *i << ": "
-                << "out of range error while reading (corrupt file?)\n";
-            retval = EXIT_FAILURE;
+            llvm::outs() << i->out;
+            if (!i->err.empty())
+            {
+                llvm::outs().flush();
+                llvm::errs() << i->err;
+            }
+            if (i->retval != EXIT_SUCCESS)
+                retval = EXIT_FAILURE;
         }
     }
     return retval;
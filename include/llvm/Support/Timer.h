@@ -34,8 +34,10 @@ class TimeRecord {
   double UserTime;       // User time elapsed
   double SystemTime;     // System time elapsed
   ssize_t MemUsed;       // Memory allocated (in bytes)
+  ssize_t AllocCount;    // Number of allocations made
 public:
-  TimeRecord() : WallTime(0), UserTime(0), SystemTime(0), MemUsed(0) {}
+  TimeRecord()
+    : WallTime(0), UserTime(0), SystemTime(0), MemUsed(0), AllocCount(0) {}
   
   /// getCurrentTime - Get the current time and memory usage.  If Start is true
   /// we get the memory usage before the time, otherwise we get time before
@@ -48,6 +50,7 @@ public:
   double getSystemTime() const { return SystemTime; }
   double getWallTime() const { return WallTime; }
   ssize_t getMemUsed() const { return MemUsed; }
+  ssize_t getAllocCount() const { return AllocCount; }
   
   
   // operator< - Allow sorting.
@@ -61,18 +64,34 @@ public:
     UserTime   += RHS.UserTime;
     SystemTime += RHS.SystemTime;
     MemUsed    += RHS.MemUsed;
+    AllocCount += RHS.AllocCount;
   }
   void operator-=(const TimeRecord &RHS) {
     WallTime   -= RHS.WallTime;
     UserTime   -= RHS.UserTime;
     SystemTime -= RHS.SystemTime;
     MemUsed    -= RHS.MemUsed;
+    AllocCount -= RHS.AllocCount;
   }
   
   /// print - Print the current timer to standard error, and reset the "Started"
   /// flag.
   void print(const TimeRecord &Total, raw_ostream &OS) const;
+
+  /// printJSON - Print the fields of this record as JSON object members.
+  void printJSON(raw_ostream &OS) const;
 };
+
+/// EnableTimerMemoryTracking - Record heap usage in all timers, as if
+/// -track-memory were given.  If AllocCounter is non-null, it is called to
+/// get the number of allocations made so far by the process, and timers
+/// record the difference as well.
+YASM_LIB_EXPORT
+void EnableTimerMemoryTracking(size_t (*AllocCounter)() = 0);
+
+/// CreateInfoOutputFile - Return a file stream to print timer and statistic
+/// output on (per -info-output-file).  The caller owns the stream.
+YASM_LIB_EXPORT raw_ostream *CreateInfoOutputFile();
   
 /// Timer - This class is used to track the amount of time spent between
 /// invocations of its startTimer()/stopTimer() methods.  Given appropriate OS
@@ -179,7 +198,15 @@ public:
 
   /// print - Print any started timers in this group and zero them.
   void print(raw_ostream &OS);
+
+  /// printJSON - Like print, but print the timers as a JSON object.  The
+  /// process peak memory usage is included.
+  void printJSON(raw_ostream &OS);
   
+  /// takeRecords - Append the times of any started timers in this group to
+  /// Records and zero them, instead of printing them.
+  void takeRecords(std::vector<std::pair<TimeRecord, std::string> > &Records);
+
   /// printAll - This static method prints all timers and clears them all out.
   static void printAll(raw_ostream &OS);
   
@@ -187,6 +214,7 @@ private:
   friend class Timer;
   void addTimer(Timer &T);
   void removeTimer(Timer &T);
+  void PrepareToPrint();
   void PrintQueuedTimers(raw_ostream &OS);
 };
 
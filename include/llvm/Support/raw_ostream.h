@@ -378,6 +378,10 @@ public:
   /// positition to the offset specified from the beginning of the file.
   uint64_t seek(uint64_t off);
 
+  /// getFD - Return the underlying file descriptor.  Callers that write to
+  /// the descriptor directly must flush() first.
+  int getFD() const { return FD; }
+
   virtual raw_ostream &changeColor(enum Colors colors, bool bold=false,
                                    bool bg=false);
   virtual raw_ostream &resetColor();
@@ -50,6 +50,11 @@ namespace sys {
       /// that memory.
       static size_t GetTotalMemoryUsage();
 
+      /// This static function will return the peak resident set size of the
+      /// process in bytes, or 0 if it cannot be determined.
+      /// @brief Return peak resident memory usage.
+      static size_t GetPeakMemoryUsage();
+
       /// This static function will set \p user_time to the amount of CPU time
       /// spent in user (non-kernel) mode and \p sys_time to the amount of CPU
       /// time spent in system (kernel) mode.  If the operating system does not
@@ -25,7 +25,11 @@ namespace llvm {
     class YASM_LIB_EXPORT ThreadLocalImpl {
       void* data;
     public:
-      ThreadLocalImpl();
+      /// Destructor - Called with a thread's pointer when that thread exits,
+      /// if the pointer is non-null.  Only supported with pthreads.
+      typedef void (*Destructor)(void*);
+
+      explicit ThreadLocalImpl(Destructor dtor = 0);
       virtual ~ThreadLocalImpl();
       void setInstance(const void* d);
       const void* getInstance();
@@ -38,10 +42,14 @@ namespace llvm {
     class ThreadLocal : public ThreadLocalImpl {
     public:
       ThreadLocal() : ThreadLocalImpl() { }
+
+      /// ThreadLocal - Constructs a ThreadLocal whose per-thread objects are
+      /// passed to \p dtor when their thread exits.
+      explicit ThreadLocal(Destructor dtor) : ThreadLocalImpl(dtor) { }
       
       /// get - Fetches a pointer to the object associated with the current
       /// thread.  If no object has yet been associated, it returns NULL;
-      T* get() { return static_cast<T*>(getInstance()); }
+      T* get() { return static_cast<T*>(const_cast<void*>(getInstance())); }
       
       // set - Associates a pointer to an object with the current thread.
       void set(T* d) { setInstance(d); }
@@ -29,12 +29,22 @@
 /// POSSIBILITY OF SUCH DAMAGE.
 /// @endlicense
 ///
+#include <string>
+#include <utility>
+#include <vector>
 #include "llvm/ADT/StringRef.h"
 #include "yasmx/Config/export.h"
 #include "yasmx/Support/scoped_ptr.h"
 
 
-namespace llvm { class MemoryBuffer; class raw_fd_ostream; }
+namespace llvm
+{
+class MemoryBuffer;
+class raw_fd_ostream;
+class raw_ostream;
+class Timer;
+class TimerGroup;
+}
 
 /// Namespace for classes, functions, and templates related to the Yasm
 /// assembler.
@@ -97,6 +107,30 @@ public:
     /// @return False on error.
     bool setMachine(llvm::StringRef machine, Diagnostic& diags);
 
+    /// Set an architecture variable (see Arch::setVar()).  Unlike setting
+    /// it through getArch(), the setting is kept across Reset().
+    /// @param var              variable name
+    /// @param val              value
+    /// @return False if the variable is unknown.
+    bool setArchVar(llvm::StringRef var, unsigned long val);
+
+    /// Set the maximum number of threads to use for optimization.
+    /// Defaults to 1 (no additional threads).
+    /// @param jobs             number of threads
+    void setJobs(unsigned int jobs) { m_jobs = jobs; }
+
+    /// Set the optimization level (see Object::Options::OptimizeLevel).
+    /// Defaults to full optimization.
+    /// @param level            optimization level
+    void setOptimizeLevel(unsigned int level) { m_optimize_level = level; }
+
+    /// Time each assembly phase (initialization, parse, finalize, optimize,
+    /// debug information generation, and output).  Phases that run a
+    /// module are named after the module keyword.
+    /// @param group            timer group to add timers to; must outlive
+    ///                         the assembler
+    void setTimerGroup(llvm::TimerGroup* group);
+
     /// Set the parser.
     /// @param parser_keyword   parser keyword
     /// @param diags            diagnostic reporting
@@ -145,6 +179,22 @@ public:
     /// @return True on success, false on failure.
     bool Output(llvm::raw_fd_ostream& os, Diagnostic& diags);
 
+    /// Write the list file.  Fails if no list format was set or output
+    /// was not performed first.
+    /// @param os               output stream
+    /// @param source_mgr       source manager
+    /// @param diags            diagnostic reporting
+    /// @return True on success, false on failure.
+    bool OutputList(llvm::raw_ostream& os,
+                    SourceManager& source_mgr,
+                    Diagnostic& diags);
+
+    /// Prepare to assemble another file with the same modules and settings.
+    /// Discards the object and everything created for it, clears the object
+    /// filename, and returns the architecture to its configured state
+    /// (undoing e.g. BITS directives in the previous file).
+    void Reset();
+
     /// Get the object.  Returns 0 until after InitObject() is called.
     /// @return Object.
     Object* getObject() { return m_object.get(); }
@@ -161,6 +211,26 @@ private:
     Assembler(const Assembler&);                    // not implemented
     const Assembler& operator=(const Assembler&);   // not implemented
 
+    enum Phase
+    {
+        PHASE_INIT = 0,
+        PHASE_PARSE,
+        PHASE_FINALIZE,
+        PHASE_OPTIMIZE,
+        PHASE_DEBUG,
+        PHASE_OUTPUT,
+        NUM_PHASES
+    };
+
+    /// Get the timer for a phase.
+    /// @param phase            phase
+    /// @param name             timer name (used on first call only)
+    /// @return Timer, or NULL if timing is not enabled.
+    /*@null@*/ llvm::Timer* getTimer(Phase phase, llvm::StringRef name);
+
+    /// Create the architecture and apply the configured settings to it.
+    void CreateArch();
+
     util::scoped_ptr<ArchModule> m_arch_module;
     util::scoped_ptr<ParserModule> m_parser_module;
     util::scoped_ptr<ObjectFormatModule> m_objfmt_module;
@@ -177,7 +247,15 @@ private:
 
     std::string m_obj_filename;
     std::string m_machine;
+    /// Architecture variables set by setArchVar(), in order.
+    std::vector<std::pair<std::string, unsigned long> > m_arch_vars;
     Assembler::ObjectDumpTime m_dump_time;
+    unsigned int m_jobs;
+    unsigned int m_optimize_level;
+
+    /// Phase timers (NULL if timing is not enabled).
+    class Timers;
+    util::scoped_ptr<Timers> m_timers;
 };
 
 } // namespace yasm
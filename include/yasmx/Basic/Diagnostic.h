@@ -280,6 +280,11 @@ public:
   ~Diagnostic();
 
   void setSourceManager(SourceManager* smgr) { SrcMgr = smgr; }
+  bool hasSourceManager() const { return SrcMgr != 0; }
+  SourceManager &getSourceManager() const {
+    assert(SrcMgr && "SourceManager not set!");
+    return *SrcMgr;
+  }
 
   //===--------------------------------------------------------------------===//
   //  Diagnostic characterization methods, used by a client to customize how
@@ -298,6 +303,12 @@ public:
   /// stack.
   bool popMappings();
 
+  /// inheritMappings - Make this Diagnostic classify diagnostics the same way
+  /// as Other: copies Other's current mappings along with its warning,
+  /// extension, and error promotion settings.  Error limits, system header
+  /// suppression, and error state are not copied.
+  void inheritMappings(const Diagnostic &Other);
+
   /// \brief Set the diagnostic client associated with this diagnostic object.
   void setClient(DiagnosticClient* client) { Client = client; }
 
@@ -0,0 +1,85 @@
+//===--- DiagnosticBuffer.h - Buffer and replay diagnostics -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines a DiagnosticClient that records diagnostics so they can
+//  later be replayed into another Diagnostic, e.g. one owned by a different
+//  thread.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef YASM_DIAGNOSTICBUFFER_H
+#define YASM_DIAGNOSTICBUFFER_H
+
+#include "yasmx/Basic/Diagnostic.h"
+#include "yasmx/Config/export.h"
+#include <list>
+#include <string>
+#include <vector>
+
+namespace yasm {
+
+/// DiagnosticBuffer - Records every diagnostic reported to its Diagnostic.
+/// Unlike StoredDiagnostic, the diagnostic ID and arguments are kept, so
+/// replaying a recorded diagnostic runs it through the mapping, counting, and
+/// error limit logic of the destination Diagnostic exactly as if it had been
+/// reported there directly.
+///
+/// A Diagnostic using a DiagnosticBuffer never touches its SourceManager as
+/// long as system header warning suppression is off, so it may be used from a
+/// thread other than the one that owns the SourceManager.
+class YASM_LIB_EXPORT DiagnosticBuffer : public DiagnosticClient {
+public:
+  DiagnosticBuffer();
+  virtual ~DiagnosticBuffer();
+
+  virtual void HandleDiagnostic(Diagnostic::Level DiagLevel,
+                                const DiagnosticInfo &Info);
+
+  /// empty - Return true if no diagnostics have been recorded.
+  bool empty() const { return Groups.empty(); }
+
+  /// take - Move all diagnostics recorded by Other to the end of this
+  /// buffer, leaving Other empty.
+  void take(DiagnosticBuffer &Other);
+
+  /// Replay - Report all recorded diagnostics to Diags, sorted by source
+  /// location using the source manager of Diags, and clear this buffer.
+  /// Diagnostics at the same location (and those with no location, which
+  /// sort first) keep their recorded order.
+  /// Notes stay attached to the diagnostic they followed.
+  void Replay(Diagnostic &Diags);
+
+private:
+  struct Arg {
+    Diagnostic::ArgumentKind Kind;
+    intptr_t Val;
+    std::string Str;
+  };
+
+  struct Entry {
+    SourceLocation Loc;
+    unsigned DiagID;
+    Diagnostic::Level Level;
+    std::string CustomMessage;    // only for custom diagnostics
+    std::vector<Arg> Args;
+    std::vector<CharSourceRange> Ranges;
+    std::vector<FixItHint> FixIts;
+  };
+
+  /// A diagnostic followed by its notes.
+  typedef std::vector<Entry> Group;
+  typedef std::list<Group> Groups_t;
+  Groups_t Groups;
+
+  class LocationOrder;
+};
+
+}  // end namespace yasm
+
+#endif
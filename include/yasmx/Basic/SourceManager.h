@@ -304,6 +304,20 @@ public:
   /// \brief Read the source location entry with index ID.
   virtual void ReadSLocEntry(unsigned ID) = 0;
 };
+
+/// \brief External source of file contents, consulted before a file is read
+/// from disk.
+class YASM_LIB_EXPORT ExternalFileContentSource {
+public:
+  virtual ~ExternalFileContentSource();
+
+  /// \brief Get the contents of the given file.  The buffer must match the
+  /// size and modification time of the file entry, and is still owned by
+  /// the source (it must outlive any source manager it is given to).
+  ///
+  /// \returns the buffer, or null to read the file from disk as usual.
+  virtual const llvm::MemoryBuffer *getFileContents(const FileEntry *File) = 0;
+};
   
 
 /// IsBeforeInTranslationUnitCache - This class holds the cache used by
@@ -399,6 +413,9 @@ class YASM_LIB_EXPORT SourceManager {
   /// \brief An external source for source location entries.
   ExternalSLocEntrySource *ExternalSLocEntries;
 
+  /// \brief An external source for file contents.
+  ExternalFileContentSource *ExternalFileContents;
+
   /// LastFileIDLookup - This is a one-entry cache to speed up getFileID.
   /// LastFileIDLookup records the last FileID looked up or created, because it
   /// is very common to look up many tokens from the same file.
@@ -429,7 +446,8 @@ class YASM_LIB_EXPORT SourceManager {
   void operator=(const SourceManager&);
 public:
   SourceManager(Diagnostic &Diag)
-    : Diag(Diag), ExternalSLocEntries(0), LineTable(0), NumLinearScans(0),
+    : Diag(Diag), ExternalSLocEntries(0), ExternalFileContents(0),
+      LineTable(0), NumLinearScans(0),
       NumBinaryProbes(0) {
     clearIDTables();
   }
@@ -522,6 +540,18 @@ public:
                             const llvm::MemoryBuffer *Buffer,
                             bool DoNotFree = false);
 
+  /// \brief Set an external source to be asked for the contents of files
+  /// before they are read from disk.  Unlike overrideFileContents(), files
+  /// are only requested from the source when they are first needed.
+  void setExternalFileContentSource(ExternalFileContentSource *Source) {
+    ExternalFileContents = Source;
+  }
+
+  /// \brief Get the external source for file contents, if any.
+  ExternalFileContentSource *getExternalFileContentSource() const {
+    return ExternalFileContents;
+  }
+
   //===--------------------------------------------------------------------===//
   // FileID manipulation methods.
   //===--------------------------------------------------------------------===//
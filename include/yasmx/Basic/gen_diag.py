@@ -196,6 +196,18 @@ add_warning("warn_unknown_command_line_option",
             "unknown command line argument '%0'; try '-help'")
 add_fatal("fatal_bad_defsym",
           "bad defsym '%0'; format is --defsym name=value")
+add_warning("warn_cache_store", "could not store object in cache: %0")
+add_warning("warn_bad_define",
+            "ignoring define '%0'; only integer values are supported")
+add_fatal("fatal_batch_option",
+          "'%0' can't be used with --batch; give file names in the batch file")
+add_error("err_bad_batch_line",
+          "%0:%1: expected input and output file names")
+add_fatal("fatal_server", "assembler server '%0': %1")
+add_fatal("fatal_server_stdin",
+          "input from standard input can't be sent to the assembler server")
+add_fatal("fatal_server_option",
+          "'-%0' can't be used with --connect; give it to the server instead")
 
 # Source manager
 add_fatal("err_cannot_open_file", "cannot open file '%0': %1")
@@ -334,6 +346,10 @@ add_error("err_file_output_seek", "unable to seek on output file",
 add_error("err_file_output_position",
           "could not get file position on output file",
           mapping="FATAL")
+add_error("err_file_output_write", "unable to write output file",
+          mapping="FATAL")
+add_error("err_output_overflow",
+          "output exceeds the %0 bytes reserved for it")
 
 # Align
 add_error("err_align_not_integer", "alignment constraint is not an integer")
@@ -150,9 +150,9 @@ public:
         /// @param bc           bytecode
         /// @param bc_out       bytecode output interface
         /// @return False if an error occurred.
-        /// @note May result in non-reversible changes to the bytecode, but
-        ///       it's preferable if calling this function twice would result
-        ///       in the same output.
+        /// @note Must produce the same output each time it's called, as
+        ///       list formats output each bytecode again after the object
+        ///       format has; adjust copies of values rather than members.
         virtual bool Output(Bytecode& bc, BytecodeOutput& bc_out) = 0;
 
         /// Special bytecode classifications.  Most bytecode types should
@@ -170,6 +170,13 @@ public:
 
         virtual SpecialType getSpecial() const;
 
+        /// Get the tail of a bytecode whose tail is a plain block of bytes
+        /// stored outside of the bytecode, so it can be examined without
+        /// calling Output().  Most bytecode types should simply not override
+        /// this function (which returns NULL).
+        /// @return Tail data (Bytecode::getTailLen() bytes long), or NULL.
+        virtual /*@null@*/ const unsigned char* getTailData() const;
+
         /// Get the type name of the bytecode contents.
         /// Implementations should return a known unique identifying name.
         virtual llvm::StringRef getType() const = 0;
@@ -329,6 +336,10 @@ public:
 
     Contents::SpecialType getSpecial() const;
 
+    /// Get the tail data of the bytecode, if it is a plain block of bytes.
+    /// @return Tail data (getTailLen() bytes long), or NULL.
+    /*@null@*/ const unsigned char* getTailData() const;
+
     Bytes& getFixed() { return m_fixed; }
     const Bytes& getFixed() const { return m_fixed; }
 
@@ -416,6 +427,14 @@ Bytecode::getSpecial() const
     return m_contents->getSpecial();
 }
 
+inline const unsigned char*
+Bytecode::getTailData() const
+{
+    if (m_contents.get() == 0)
+        return 0;
+    return m_contents->getTailData();
+}
+
 /// Specialized swap for algorithms.
 inline void
 swap(Bytecode& left, Bytecode& right)
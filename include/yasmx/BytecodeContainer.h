@@ -35,10 +35,13 @@
 #include "yasmx/Config/export.h"
 #include "yasmx/Support/EndianState.h"
 #include "yasmx/Support/ptr_vector.h"
+#include "yasmx/Support/scoped_ptr.h"
 #include "yasmx/DebugDumper.h"
 #include "yasmx/Location.h"
 
 
+namespace llvm { class BumpPtrAllocator; }
+
 namespace yasm
 {
 
@@ -143,8 +146,15 @@ private:
     BytecodeContainer(const BytecodeContainer&);
     const BytecodeContainer& operator=(const BytecodeContainer&);
 
+    /// Adopt a bytecode into this container.
+    void Adopt(Bytecode* bc);
+
     /*@dependent@*/ Object* m_object;   ///< Pointer to parent object
 
+    /// Arena for the fixed portions of the bytecodes.  Declared before the
+    /// bytecodes so it is destroyed after them.
+    util::scoped_ptr<llvm::BumpPtrAllocator> m_fixed_arena;
+
     /// The bytecodes for the section's contents.
     stdx::ptr_vector<Bytecode> m_bcs;
     stdx::ptr_vector_owner<Bytecode> m_bcs_owner;
@@ -268,6 +278,21 @@ void AppendIncbin(BytecodeContainer& container,
                   /*@null@*/ std::auto_ptr<Expr> maxlen,
                   SourceLocation source);
 
+/// Append a block of data owned by someone else (e.g. the contents of a
+/// memory-mapped object file) to the end of a section without copying it.
+/// Unlike other bytecodes, the length of the new bytecode is known
+/// immediately.
+/// @param sect         section
+/// @param data         data; must remain valid for the life of the section
+/// @param len          length of data in bytes
+/// @param source       source location
+/// @return Reference to the data bytecode.
+YASM_LIB_EXPORT
+Bytecode& AppendBorrowedData(BytecodeContainer& container,
+                             const unsigned char* data,
+                             unsigned long len,
+                             SourceLocation source);
+
 /// Append an alignment constraint that aligns the following data to a boundary.
 /// @param sect         section
 /// @param boundary     byte alignment (must be a power of two)
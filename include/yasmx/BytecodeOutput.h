@@ -258,6 +258,55 @@ protected:
     llvm::raw_ostream& m_os;
 };
 
+/// Memory output specialization of BytecodeOutput.
+/// Writes directly into a caller-provided buffer (e.g. a memory-mapped
+/// slice of the output file) rather than through a stream.
+/// Handles gaps by converting to 0 and generating a warning.
+/// This does not implement ConvertValueToBytes(), so it's still a virtual
+/// base class.
+class YASM_LIB_EXPORT BytecodeMemoryOutput : public BytecodeOutput
+{
+public:
+    BytecodeMemoryOutput(Diagnostic& diags)
+        : BytecodeOutput(diags), m_pos(0), m_end(0), m_size(0),
+          m_overflow(false)
+    {}
+    ~BytecodeMemoryOutput();
+
+    /// Set the buffer to output into.  Output beyond the buffer size is
+    /// discarded and reported as an error (once per buffer).
+    /// @param buf      buffer
+    /// @param size     buffer size, in bytes
+    void setBuffer(unsigned char* buf, unsigned long size)
+    {
+        m_pos = buf;
+        m_end = buf + size;
+        m_size = size;
+        m_overflow = false;
+    }
+
+    /// Get the number of bytes remaining in the buffer.
+    /// @return Remaining bytes.
+    unsigned long getRemaining() const
+    { return static_cast<unsigned long>(m_end - m_pos); }
+
+protected:
+    void DoOutputGap(unsigned long size, SourceLocation source);
+    void DoOutputBytes(const Bytes& bytes, SourceLocation source);
+
+private:
+    /// Check there is room for more output, reporting an error if not.
+    /// @param size     output size, in bytes
+    /// @param source   source location
+    /// @return False if the output would overflow the buffer.
+    bool CheckRoom(unsigned long size, SourceLocation source);
+
+    unsigned char* m_pos;       ///< Current output position
+    unsigned char* m_end;       ///< End of buffer
+    unsigned long m_size;       ///< Buffer size
+    bool m_overflow;            ///< Overflow has been reported
+};
+
 } // namespace yasm
 
 #endif
@@ -29,62 +29,143 @@
 /// POSSIBILITY OF SUCH DAMAGE.
 /// @endlicense
 ///
-#include <vector>
+#include <cstddef>
+#include <cstdlib>
+#include <iterator>
+#include <limits>
 
 #include "yasmx/Config/export.h"
 #include "yasmx/Support/EndianState.h"
 #include "yasmx/DebugDumper.h"
 
 
-namespace llvm { class raw_ostream; }
+namespace llvm { class BumpPtrAllocator; class raw_ostream; }
 
 namespace yasm
 {
 
 /// A vector of bytes.
+/// Short contents (up to #INLINE_SIZE bytes, enough for any single machine
+/// instruction) are stored inline without any heap allocation.  Longer
+/// contents are allocated with malloc, or from an arena if one has been set
+/// with setArena().
 class YASM_LIB_EXPORT Bytes
-    : private std::vector<unsigned char>
-    , public EndianState
+    : public EndianState
     , public DebugDumper<Bytes>
 {
-    typedef std::vector<unsigned char> base_vector;
-
 public:
-    Bytes() {}
+    typedef unsigned char value_type;
+    typedef unsigned char& reference;
+    typedef const unsigned char& const_reference;
+    typedef unsigned char* pointer;
+    typedef const unsigned char* const_pointer;
+    typedef unsigned char* iterator;
+    typedef const unsigned char* const_iterator;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    /// Number of bytes that can be stored without allocating memory.
+    enum { INLINE_SIZE = 16 };
+
+    Bytes()
+        : m_begin(m_inline), m_size(0), m_capacity(INLINE_SIZE)
+        , m_arena(0), m_heap(false)
+    {}
+
+    template <class InputIterator>
+    Bytes(InputIterator first, InputIterator last)
+        : m_begin(m_inline), m_size(0), m_capacity(INLINE_SIZE)
+        , m_arena(0), m_heap(false)
+    {
+        insert(end(), first, last);
+    }
+
+    Bytes(const Bytes& oth);
+    Bytes& operator= (const Bytes& rhs);
+    ~Bytes();
+
+    /// Set the arena used to allocate storage that does not fit inline.
+    /// Memory allocated from the arena is never individually freed; it is
+    /// reclaimed when the arena is destroyed, so the arena must outlive
+    /// this object.  Existing contents are not moved.
+    /// @param arena    arena allocator (may be NULL to use malloc)
+    void setArena(/*@null@*/ llvm::BumpPtrAllocator* arena)
+    { m_arena = arena; }
+
+    iterator begin() { return m_begin; }
+    const_iterator begin() const { return m_begin; }
+    iterator end() { return m_begin + m_size; }
+    const_iterator end() const { return m_begin + m_size; }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const
+    { return const_reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const
+    { return const_reverse_iterator(begin()); }
+
+    size_type size() const { return m_size; }
+    size_type max_size() const { return ~static_cast<size_type>(0); }
+    size_type capacity() const { return m_capacity; }
+    bool empty() const { return m_size == 0; }
+
+    void reserve(size_type n) { if (n > m_capacity) Grow(n); }
+    void resize(size_type n, value_type v = 0);
+
+    reference operator[](size_type n) { return m_begin[n]; }
+    const_reference operator[](size_type n) const { return m_begin[n]; }
+    reference at(size_type n);
+    const_reference at(size_type n) const;
+    reference front() { return m_begin[0]; }
+    const_reference front() const { return m_begin[0]; }
+    reference back() { return m_begin[m_size-1]; }
+    const_reference back() const { return m_begin[m_size-1]; }
+
+    void assign(size_type n, value_type v)
+    {
+        clear();
+        insert(end(), n, v);
+    }
+
+    template <class InputIterator>
+    void assign(InputIterator first, InputIterator last)
+    {
+        clear();
+        insert(end(), first, last);
+    }
+
+    void push_back(value_type v)
+    {
+        if (m_size == m_capacity)
+            Grow(m_size+1);
+        m_begin[m_size++] = v;
+    }
+
+    void pop_back() { --m_size; }
+
+    iterator insert(iterator pos, value_type v)
+    {
+        size_type off = pos - m_begin;
+        InsertFill(off, 1, v);
+        return m_begin + off;
+    }
+
+    void insert(iterator pos, size_type n, value_type v)
+    {
+        InsertFill(pos - m_begin, n, v);
+    }
 
     template <class InputIterator>
-    Bytes(InputIterator first, InputIterator last) : base_vector(first, last) {}
-
-    typedef base_vector::reference reference;
-    typedef base_vector::const_reference const_reference;
-    typedef base_vector::iterator iterator;
-    typedef base_vector::const_iterator const_iterator;
-    typedef base_vector::size_type size_type;
-    typedef base_vector::difference_type difference_type;
-    typedef base_vector::value_type value_type;
-    typedef base_vector::reverse_iterator reverse_iterator;
-    typedef base_vector::const_reverse_iterator const_reverse_iterator;
-
-    using base_vector::begin;
-    using base_vector::end;
-    using base_vector::rbegin;
-    using base_vector::rend;
-    using base_vector::size;
-    using base_vector::max_size;
-    using base_vector::resize;
-    using base_vector::capacity;
-    using base_vector::empty;
-    using base_vector::reserve;
-    using base_vector::operator[];
-    using base_vector::at;
-    using base_vector::front;
-    using base_vector::back;
-    using base_vector::assign;
-    using base_vector::push_back;
-    using base_vector::pop_back;
-    using base_vector::insert;
-    using base_vector::erase;
-    using base_vector::clear;
+    void insert(iterator pos, InputIterator first, InputIterator last)
+    {
+        InsertDispatch(pos, first, last,
+            IsInteger<std::numeric_limits<InputIterator>::is_integer>());
+    }
+
+    iterator erase(iterator pos) { return erase(pos, pos+1); }
+    iterator erase(iterator first, iterator last);
+    void clear() { m_size = 0; }
 
     void swap(Bytes& oth);
 
@@ -104,6 +185,65 @@ public:
     /// @return Root node.
     pugi::xml_node Write(pugi::xml_node out) const;
 #endif // WITH_XML
+
+private:
+    template <bool B> struct IsInteger {};
+
+    template <class Integer>
+    void InsertDispatch(iterator pos, Integer n, Integer v, IsInteger<true>)
+    {
+        InsertFill(pos - m_begin, static_cast<size_type>(n),
+                   static_cast<value_type>(v));
+    }
+
+    template <class InputIterator>
+    void InsertDispatch(iterator pos,
+                        InputIterator first,
+                        InputIterator last,
+                        IsInteger<false>)
+    {
+        size_type n = static_cast<size_type>(std::distance(first, last));
+        unsigned char* old;
+        unsigned char* dest = InsertSpace(pos - m_begin, n, &old);
+        for (; first != last; ++first)
+            *dest++ = static_cast<value_type>(*first);
+        if (old)
+            std::free(old);
+    }
+
+    /// Insert n copies of v at offset off.
+    void InsertFill(size_type off, size_type n, value_type v);
+
+    /// Make room for n bytes at offset off.  If the storage is reallocated
+    /// and the old storage was allocated with malloc, it is not freed but
+    /// returned in old, so that the inserted range may alias it; the caller
+    /// must free it.
+    /// @param off      offset of inserted bytes
+    /// @param n        number of bytes to insert
+    /// @param old      old storage to free (returned; NULL if none)
+    /// @return Pointer to the (uninitialized) inserted bytes.
+    unsigned char* InsertSpace(size_type off,
+                               size_type n,
+                               /*@out@*/ unsigned char** old);
+
+    /// Reallocate storage to hold at least n bytes.
+    void Grow(size_type n);
+
+    /// Allocate n bytes of storage from the arena or the heap.
+    unsigned char* Allocate(size_type n, bool* heap);
+
+    unsigned char* m_begin;         ///< start of storage
+    size_type m_size;               ///< number of bytes used
+    size_type m_capacity;           ///< number of bytes allocated
+
+    /// Arena used for non-inline storage (NULL to use malloc).
+    /*@null@*/ llvm::BumpPtrAllocator* m_arena;
+
+    /// True if m_begin was allocated with malloc and must be freed.
+    bool m_heap;
+
+    /// Inline storage for short contents.
+    unsigned char m_inline[INLINE_SIZE];
 };
 
 inline void
@@ -112,6 +252,12 @@ Bytes::Write(const unsigned char* buf, size_type n)
     insert(end(), buf, buf+n);
 }
 
+inline void
+Bytes::Write(size_type n, unsigned char v)
+{
+    InsertFill(m_size, n, v);
+}
+
 /// Output the entire contents of a bytes container to an output stream.
 /// @param os    output stream
 /// @param bytes bytes
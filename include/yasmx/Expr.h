@@ -610,6 +610,10 @@ public:
     /// Clean up terms by removing all empty (ExprTerm::NONE) elements.
     void Cleanup();
 
+    /// Release any term storage beyond what the current terms need.
+    /// Intended for long-lived expressions after simplification.
+    void Compact();
+
 private:
     /// Terms of the expression.  The entire tree is stored here.
     ExprTerms m_terms;
@@ -73,12 +73,20 @@ struct YASM_LIB_EXPORT IntNumData
     typedef long SmallValue;
     typedef unsigned long USmallValue;
 #endif
+    /// Two's complement value of up to 128 bits, stored inline.
+    struct WideValue
+    {
+        uint64_t lo;            ///< low 64 bits
+        int64_t hi;             ///< high 64 bits (including sign)
+    };
+
     union
     {
         SmallValue sv;          ///< integer value (for integers <=long bits)
-        llvm::APInt* bv;        ///< big value (for integers >long bits)
+        WideValue wv;           ///< wide value (for integers <=128 bits)
+        llvm::APInt* bv;        ///< big value (for integers >128 bits)
     } m_val;
-    enum { INTNUM_SV, INTNUM_BV } m_type;
+    enum { INTNUM_SV, INTNUM_WV, INTNUM_BV } m_type;
 };
 
 /// Big integer number.
@@ -370,11 +378,19 @@ public:
 
     /// If intnum is a BV, returns its bitvector directly.
     /// If not, converts into passed bv and returns that instead.
-    /// @param bv       bitvector to use if intnum is not bitvector.
+    /// @param bv       bitvector to use if intnum is not bitvector;
+    ///                 must be BITVECT_NATIVE_SIZE bits wide.
     /// @return Passed bv or intnum internal bitvector.
     const llvm::APInt* getBV(llvm::APInt* bv) const;
     llvm::APInt* getBV(llvm::APInt* bv);
 
+    /// Get a scratch bitvector of BITVECT_NATIVE_SIZE bits to pass to
+    /// getBV().  Each thread has its own, so it's safe to use from parallel
+    /// assemblies, but it's shared by all callers on a thread: don't keep
+    /// using the result of getBV() across other calls that might use it.
+    /// @return Per-thread scratch bitvector.
+    static llvm::APInt* getScratchBV();
+
     /// Store a bitvector into intnum storage.
     /// If saved as a bitvector, clones the passed bitvector.
     /// Can modify the passed bitvector.
@@ -417,6 +433,14 @@ private:
                   SourceLocation source,
                   Diagnostic* diags);
 
+    /// Get the value as a wide value.  Must not be a BV.
+    /// @param wv       wide value (output)
+    void getWV(WideValue* wv) const;
+
+    /// Store a wide value into intnum storage, as a small value if it fits.
+    /// @param wv       wide value
+    void setWV(const WideValue& wv);
+
     /// Set an intnum to an unsigned integer.
     /// @param val      integer value
     void set(USmallValue val);
@@ -42,10 +42,11 @@ namespace llvm { class raw_ostream; }
 namespace yasm
 {
 
-class Arch;
+class Diagnostic;
 class Directives;
-class Linemap;
 class ListFormatModule;
+class Object;
+class SourceManager;
 
 /// List format interface.
 class YASM_LIB_EXPORT ListFormat
@@ -63,14 +64,18 @@ public:
     /// Add directive handlers.
     virtual void AddDirectives(Directives& dirs, llvm::StringRef parser);
 
-    /// Write out list to the list file.
+    /// Write out list to the list file.  Called after the object file has
+    /// been output.  The object records where the output of each statement
+    /// starts (see Section::getStatements()).
     /// This function may call all read-only yasm:: functions as necessary.
     /// @param os           output stream
-    /// @param linemap      line mapping repository
-    /// @param arch         architecture
+    /// @param object       object
+    /// @param smgr         source manager
+    /// @param diags        diagnostic reporting
     virtual void Output(llvm::raw_ostream& os,
-                        Linemap& linemap,
-                        Arch& arch) = 0;
+                        Object& object,
+                        SourceManager& smgr,
+                        Diagnostic& diags) = 0;
 
 private:
     ListFormat(const ListFormat&);                  // not implemented
@@ -31,6 +31,7 @@
 ///
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "llvm/ADT/StringRef.h"
 #include "yasmx/Config/export.h"
@@ -49,6 +50,7 @@ namespace yasm
 class Arch;
 class Diagnostic;
 class Section;
+class SourceLocation;
 class Symbol;
 
 /// An object.  This is the internal representation of an object file.
@@ -64,6 +66,25 @@ public:
         /// to be generated even if the symbol is in the same section as
         /// the value.  Defaults to false.
         bool DisableGlobalSubRelative;
+
+        /// Optimization level.  0 disables span optimization: bytecodes
+        /// that can pick their long form up front do so, and offsets are
+        /// assigned in a single pass.  1 resolves spans with a bounded
+        /// number of relaxation passes.  2 and above run the full
+        /// optimizer.  Defaults to OPTIMIZE_FULL.
+        unsigned int OptimizeLevel;
+
+        /// Record where the output of each statement starts (see
+        /// Section::getStatements()), e.g. for list files.  Defaults to
+        /// false.
+        bool RecordStatements;
+    };
+
+    enum
+    {
+        OPTIMIZE_NONE = 0,      ///< no span optimization (long forms)
+        OPTIMIZE_BASIC = 1,     ///< bounded relaxation
+        OPTIMIZE_FULL = 2       ///< full optimization
     };
 
     /// Generic object configuration.
@@ -112,12 +133,18 @@ public:
     llvm::StringRef getObjectFilename() const { return m_obj_filename; }
 
     Options& getOptions() { return m_options; }
+    const Options& getOptions() const { return m_options; }
     Config& getConfig() { return m_config; }
 
     /// Optimize an object.  Takes the unoptimized object and optimizes it.
     /// If successful, the object is ready for output to an object file.
+    /// The amount of optimization is set by Options::OptimizeLevel.
+    /// Independent sections may be optimized concurrently; diagnostics
+    /// are then reported in source order once each optimizer step has
+    /// completed for all sections.
     /// @param diags    diagnostic reporting
-    void Optimize(Diagnostic& diags);
+    /// @param jobs     maximum number of threads to use
+    void Optimize(Diagnostic& diags, unsigned int jobs = 1);
 
     /// Updates all bytecode offsets in object.
     /// @param diags    diagnostic reporting
@@ -241,9 +268,34 @@ public:
     void setCurSection(/*@null@*/ Section* section)
     { m_cur_section = section; }
 
+    /// Record the start of a statement in the current section.  Does
+    /// nothing unless Options::RecordStatements is set.  Parsers should
+    /// call this before parsing each statement.
+    /// @param source       statement source location
+    void AddStatement(SourceLocation source);
+
     Arch* getArch() { return m_arch; }
     const Arch* getArch() const { return m_arch; }
 
+    /// Record a file read during assembly without going through the
+    /// source manager (e.g. by incbin), for dependency tracking.
+    /// @param filename     file name
+    void AddDependency(llvm::StringRef filename)
+    { m_dependencies.push_back(filename); }
+
+    /// Get the files recorded by AddDependency().
+    /// @return File names, in the order added.
+    const std::vector<std::string>& getDependencies() const
+    { return m_dependencies; }
+
+    /// Record that output other than the object file (e.g. a map file)
+    /// has been written.
+    void setExtraOutput() { m_extra_output = true; }
+
+    /// Determine if output other than the object file has been written.
+    /// @return True if setExtraOutput() has been called.
+    bool hasExtraOutput() const { return m_extra_output; }
+
 #ifdef WITH_XML
     /// Write an XML representation.  For debugging purposes.
     /// @param out          XML node
@@ -255,6 +307,16 @@ private:
     Object(const Object&);                  // not implemented
     const Object& operator=(const Object&); // not implemented
 
+    /// Optimize sections concurrently.
+    /// @param diags    diagnostic reporting
+    /// @param jobs     maximum number of threads to use
+    void OptimizeParallel(Diagnostic& diags, unsigned int jobs);
+
+    /// Allocate a new symbol from the symbol pool.  The name is interned.
+    /// @param name     symbol name
+    /// @return Newly allocated symbol (not yet in any symbol table).
+    Symbol* NewSymbol(llvm::StringRef name);
+
     std::string m_src_filename;         ///< Source filename
     std::string m_obj_filename;         ///< Object filename
 
@@ -271,9 +333,17 @@ private:
     Sections m_sections;
     stdx::ptr_vector_owner<Section> m_sections_owner;
 
-    /// Symbols in the symbol table
+    /// Symbols in the symbol table.  Owned by the symbol pool in #m_impl.
     Symbols m_symbols;
-    stdx::ptr_vector_owner<Symbol> m_symbols_owner;
+
+    /// Files read outside of the source manager.
+    std::vector<std::string> m_dependencies;
+
+    /// Output other than the object file has been written.
+    bool m_extra_output;
+
+    /// Number of statements recorded by AddStatement().
+    unsigned long m_num_statements;
 
     /// Pimpl for symbol table hash trie.
     class Impl;
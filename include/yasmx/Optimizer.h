@@ -29,6 +29,9 @@
 /// POSSIBILITY OF SUCH DAMAGE.
 /// @endlicense
 ///
+#include <utility>
+#include <vector>
+
 #include "yasmx/Config/export.h"
 #include "yasmx/Support/scoped_ptr.h"
 #include "yasmx/DebugDumper.h"
@@ -38,6 +41,7 @@ namespace yasm
 {
 
 class Bytecode;
+class BytecodeContainer;
 class Diagnostic;
 class Value;
 
@@ -57,6 +61,28 @@ public:
     // Step1a: Set bytecode indexes, initial offsets, add spans and
     // offset setters using the above functions.
 
+    /// Split span values into bytecode distance terms.  This is normally
+    /// done as part of Step1b(), but may be done separately (once all
+    /// bytecode offsets are set by step 1a) to find out which containers
+    /// each span depends on.
+    /// @return False if an error occurred.
+    bool CreateTerms();
+
+    /// Pairs of (span bytecode container, distance term container).
+    typedef std::vector<std::pair<const BytecodeContainer*,
+                                  const BytecodeContainer*> > Links;
+
+    /// Get the containers that spans depend on, other than the container
+    /// of the span's own bytecode.  Only valid after CreateTerms().
+    /// @param links    vector to append (bytecode, term) container pairs to
+    void getLinks(Links* links) const;
+
+    /// Take over the spans and offset setters of another optimizer.  Both
+    /// must be between step 1a and step 1b, and the bytecodes of oth must
+    /// follow the bytecodes of this optimizer.
+    /// @param oth      other optimizer; left empty
+    void Merge(Optimizer& oth);
+
     void Step1b();
 
     // Step1c: update offsets
@@ -64,6 +90,18 @@ public:
     // @return True if an error occurred.
     bool Step1d();
 
+    /// Expand the bytecodes of all spans queued by Step1d(), without
+    /// propagating the expansions to dependent spans.  Spans that no longer
+    /// depend on anything are dropped.  Bytecode offsets must be updated
+    /// and Step1d() run again afterwards.  Used for pass-based relaxation
+    /// in place of steps 1e and 2.
+    void ExpandQueued();
+
+    /// Determine if there are any spans to optimize.
+    /// @return False if no span-dependent bytecodes were added (or all of
+    ///         them have been resolved).
+    bool hasSpans() const;
+
     void Step1e();
     void Step2();
 
@@ -33,6 +33,7 @@
 #include "yasmx/Config/export.h"
 #include "yasmx/Parse/DirectoryLookup.h"
 #include "llvm/ADT/StringMap.h"
+#include <string>
 #include <vector>
 
 namespace yasm
@@ -41,6 +42,7 @@ namespace yasm
 class FileEntry;
 class FileManager;
 class IdentifierInfo;
+class TokenCache;
 
 /// HeaderFileInfo - The preprocessor keeps track of this information for each
 /// file that is #included.
@@ -101,6 +103,14 @@ class YASM_LIB_EXPORT HeaderSearch
   /// query.
   llvm::StringMap<std::pair<unsigned, unsigned> > LookupFileCache;
 
+  /// TokCache - If non-null, pre-tokenized included files are read from and
+  /// stored to this cache.  Not owned.
+  TokenCache *TokCache;
+
+  /// MissedFiles - If non-null, the paths LookupFile() tried without finding
+  /// a file are appended here.  Not owned.
+  std::vector<std::string> *MissedFiles;
+
 #if 0
   /// \brief Entity used to resolve the identifier IDs of controlling
   /// macros into IdentifierInfo pointers, as needed.
@@ -121,6 +131,22 @@ public:
 
   FileManager &getFileMgr() const { return FileMgr; }
 
+  /// setTokenCache - Use the given token cache for included files, or no
+  /// cache if null.
+  void setTokenCache(TokenCache *TC) { TokCache = TC; }
+  TokenCache *getTokenCache() const { return TokCache; }
+
+  /// setMissedFileList - Append the paths that file lookups try without
+  /// finding a file to the given list, or stop recording if null.  A file
+  /// created later at one of these paths would change the lookup result.
+  void setMissedFileList(std::vector<std::string> *List) {
+    MissedFiles = List;
+  }
+
+  /// getFile - Look up a file by path for LookupFile(), recording the path
+  /// if it is not found.
+  const FileEntry *getFile(llvm::StringRef Path);
+
   /// SetSearchPaths - Interface for setting the file search paths.
   ///
   void SetSearchPaths(const std::vector<DirectoryLookup> &dirs,
@@ -131,6 +157,11 @@ public:
     //LookupFileCache.clear();
   }
 
+  /// AddUserSearchPaths - Append user include directories to the search path,
+  /// in order.  Directories that don't exist are skipped (and recorded as
+  /// missed files).
+  void AddUserSearchPaths(const std::vector<std::string> &Dirs);
+
   /// ClearFileInfo - Forget everything we know about headers so far.
   void ClearFileInfo() {
     FileInfo.clear();
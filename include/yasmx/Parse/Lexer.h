@@ -42,6 +42,7 @@ namespace yasm
 
 class DiagnosticBuilder;
 class Preprocessor;
+class TokenRecorder;
 
 class YASM_LIB_EXPORT Lexer
 {
@@ -230,6 +231,10 @@ protected:
     /// Note that in raw mode that the PP pointer may be null.
     bool m_lexing_raw_mode;
 
+    /// If non-null, tokens lexed from this file are being recorded for the
+    /// token cache.  Owned by the lexer; set by the preprocessor.
+    TokenRecorder* m_recorder;
+
     /// Character information.
     /// XXX: Make non-static.
     static unsigned char s_char_info[256];
@@ -110,10 +110,14 @@ public:
     /// tokens has a permanent owner somewhere, so they do not need to be copied.
     /// If it is true, it assumes the array of tokens is allocated with new[] and
     /// must be freed.
+    ///
+    /// The tokens are returned RepeatCount times in succession; the array is
+    /// replayed rather than copied, so memory use does not grow with the count.
     void EnterTokenStream(const Token* toks,
                           unsigned int num_toks,
                           bool disable_macro_expansion,
-                          bool owns_tokens);
+                          bool owns_tokens,
+                          unsigned long repeat_count = 1);
 
     /// Pop the current lexer/macro exp off the top of the
     /// lexer stack.  This should only be used in situations where the current
@@ -151,7 +155,12 @@ public:
     void Lex(Token* result)
     {
         if (m_cur_lexer.get() != 0)
-            m_cur_lexer->Lex(result);
+        {
+            if (m_cur_lexer->m_recorder == 0)
+                m_cur_lexer->Lex(result);
+            else
+                RecordingLex(result);
+        }
         else if (m_cur_token_lexer.get() != 0)
             m_cur_token_lexer->Lex(result);
         else
@@ -400,6 +409,11 @@ protected:
     virtual Lexer* CreateLexer(FileID fid,
                                const llvm::MemoryBuffer* input_buffer) = 0;
 
+    /// Name identifying the tokens produced by CreateLexer() in the token
+    /// cache.  Default implementation returns an empty name, which disables
+    /// the token cache.
+    virtual llvm::StringRef getTokenCacheName() const;
+
 #if 0
     /// Factory function to make a new raw lexer.
     virtual Lexer* CreateRawLexer
@@ -446,6 +460,9 @@ private:
         return IsFileLexer(m_cur_lexer.get());
     }
 
+    /// Lex from a lexer that is recording its tokens for the token cache.
+    void RecordingLex(Token* result);
+
     // Caching stuff.
     void CachingLex(Token* result);
     bool isInCachingLexMode() const
@@ -206,6 +206,12 @@ public:
         m_ptr_data = (void*)ptr;
     }
 
+    /// Return the internal representation of the flags.
+    ///
+    /// This is only intended for low-level operations such as writing tokens
+    /// to disk.
+    unsigned int getFlags() const { return m_flags; }
+
     /// Set the specified flag.
     void setFlag(TokenFlags flag) { m_flags |= flag; }
 
@@ -0,0 +1,211 @@
+#ifndef YASM_PARSE_TOKENCACHE_H
+#define YASM_PARSE_TOKENCACHE_H
+//
+// Pre-tokenized include file cache interface
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/System/DataTypes.h"
+#include "yasmx/Config/export.h"
+#include "yasmx/Parse/Lexer.h"
+#include "yasmx/Support/MD5.h"
+
+
+namespace llvm { class MemoryBuffer; }
+
+namespace yasm
+{
+
+class FileEntry;
+class IdentifierInfo;
+
+/// A pre-tokenized source file: the token stream produced by lexing the
+/// file, with identifiers stored as indexes into a table of names.
+/// Tokens are stored by offset into the source file, so the source buffer
+/// is still needed for literal spellings and diagnostics.
+class YASM_LIB_EXPORT TokenFile
+{
+public:
+    /// A token as stored in the file.
+    struct Entry
+    {
+        uint32_t offset;    ///< offset of token start in source file
+        uint32_t length;    ///< token length
+        uint16_t kind;      ///< token kind
+        uint8_t flags;      ///< Token::TokenFlags
+        uint8_t unused;
+        uint32_t ident;     ///< identifier index, or NO_IDENT
+    };
+
+    enum { NO_IDENT = 0xffffffffU };
+
+    /// Check and take ownership of the contents of a token file.
+    /// @param buf          token file contents
+    /// @param source_size  size of the source file
+    /// @return Null if buf is not a valid token file for the source
+    ///         (buf is deleted in that case).
+    static TokenFile* Create(llvm::MemoryBuffer* buf, uint64_t source_size);
+
+    ~TokenFile();
+
+    unsigned int getNumTokens() const { return m_num_tokens; }
+    const Entry& getToken(unsigned int i) const { return m_tokens[i]; }
+
+    unsigned int getNumIdentifiers() const { return m_num_idents; }
+    llvm::StringRef getIdentifier(unsigned int i) const;
+
+private:
+    TokenFile(llvm::MemoryBuffer* buf);
+    TokenFile(const TokenFile&);                    // not implemented
+    const TokenFile& operator=(const TokenFile&);   // not implemented
+
+    llvm::MemoryBuffer* m_buf;
+    const Entry* m_tokens;
+    const uint32_t* m_idents;   ///< (offset, length) pairs into m_names
+    const char* m_names;
+    unsigned int m_num_tokens;
+    unsigned int m_num_idents;
+};
+
+/// Collects the tokens lexed from a source file for the token cache.
+class YASM_LIB_EXPORT TokenRecorder
+{
+public:
+    /// @param path         token file to write
+    /// @param source_size  size of the source file
+    TokenRecorder(llvm::StringRef path, uint64_t source_size);
+    ~TokenRecorder();
+
+    /// Add a token lexed from the source file.
+    /// @param tok          token
+    /// @param file_loc     location of the start of the source file
+    void Record(const Token& tok, SourceLocation file_loc);
+
+    /// Don't write the token file.  Used when lexing reported a
+    /// diagnostic, as replaying the tokens would not report it again.
+    void Discard() { m_discarded = true; }
+
+    /// Write the token file.  Does nothing if Discard() was called.
+    /// The file is written to a temporary file and renamed into place, so
+    /// concurrent processes never see a partial file.
+    void Write();
+
+private:
+    TokenRecorder(const TokenRecorder&);                    // not impl
+    const TokenRecorder& operator=(const TokenRecorder&);   // not impl
+
+    std::string m_path;
+    uint64_t m_source_size;
+    bool m_discarded;
+    std::vector<TokenFile::Entry> m_tokens;
+    std::vector<const IdentifierInfo*> m_idents;
+    llvm::DenseMap<const IdentifierInfo*, uint32_t> m_ident_index;
+};
+
+/// Directory of pre-tokenized include files, similar in spirit to clang's
+/// PTH.  An include file is lexed normally the first time it is seen and
+/// its tokens are written to the cache; later inclusions (in this or any
+/// other process using the same directory) replay the tokens instead of
+/// lexing the file again.  Token files are keyed by lexer, absolute path,
+/// device, inode, size and modification time, so changed files are
+/// simply lexed and stored again.
+///
+/// Token files stay loaded for the lifetime of the cache, so a cache that
+/// outlives one assembly (e.g. in batch or server mode) also saves
+/// reading them again.
+class YASM_LIB_EXPORT TokenCache
+{
+public:
+    /// Constructor.
+    /// @param dir      cache directory; created on first store
+    explicit TokenCache(llvm::StringRef dir);
+
+    /// Destructor.
+    ~TokenCache();
+
+    /// Add data to the key of every token file (e.g. the assembler
+    /// version).  Must be called before any lookups.
+    /// @param data     key data
+    void AddKey(llvm::StringRef data);
+
+    /// Look up the token file for a source file.
+    /// @param file         source file
+    /// @param lexer        name of the lexer that produced the tokens
+    /// @return Token file, or null if there isn't an up to date one.
+    const TokenFile* Lookup(const FileEntry& file, llvm::StringRef lexer);
+
+    /// Start recording the tokens of a source file.  Call after a
+    /// failed Lookup().
+    /// @param file         source file
+    /// @param lexer        name of the lexer that produces the tokens
+    /// @return Newly allocated recorder.
+    TokenRecorder* StartRecording(const FileEntry& file,
+                                  llvm::StringRef lexer);
+
+private:
+    TokenCache(const TokenCache&);                  // not implemented
+    const TokenCache& operator=(const TokenCache&); // not implemented
+
+    /// Get the token file path for a source file.
+    std::string getPath(const FileEntry& file, llvm::StringRef lexer) const;
+
+    std::string m_dir;
+    MD5 m_key;
+    llvm::StringMap<TokenFile*> m_files;    ///< loaded files, by path
+};
+
+/// Lexer that replays the tokens of a token file.
+class YASM_LIB_EXPORT CachedLexer : public Lexer
+{
+public:
+    /// @param fid          source file
+    /// @param input_buffer source file contents
+    /// @param pp           preprocessor
+    /// @param toks         tokens of the source file
+    CachedLexer(FileID fid,
+                const llvm::MemoryBuffer* input_buffer,
+                Preprocessor& pp,
+                const TokenFile& toks);
+    ~CachedLexer();
+
+protected:
+    virtual void LexTokenInternal(Token* result);
+
+private:
+    const TokenFile& m_toks;
+    unsigned int m_next;
+
+    /// Identifier table entries, looked up on first use.
+    std::vector<IdentifierInfo*> m_idents;
+};
+
+} // namespace yasm
+
+#endif
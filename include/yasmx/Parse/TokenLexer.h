@@ -77,6 +77,11 @@ class YASM_LIB_EXPORT TokenLexer
     /// This is the next token that Lex will return.
     unsigned m_cur_token;
 
+    /// The number of times the Tokens array remains to be returned after
+    /// the current pass.  Used to replay a repeated token stream (e.g. a
+    /// repeat block) without materializing every copy.
+    unsigned long m_repeat_left;
+
     /// The source location range where this macro was instantiated.
     SourceLocation m_instantiate_loc_start, m_instantiate_loc_end;
 
@@ -118,21 +123,26 @@ public:
 #endif
     /// Create a TokenLexer for the specified token stream.  If 'OwnsTokens' is
     /// specified, this takes ownership of the tokens and delete[]'s them when
-    /// the token lexer is empty.
+    /// the token lexer is empty.  The stream is returned 'RepeatCount' times
+    /// in succession.
     TokenLexer(const Token* tok_array, unsigned num_toks,
-               bool disable_expansion, bool owns_tokens, Preprocessor& pp)
+               bool disable_expansion, bool owns_tokens, Preprocessor& pp,
+               unsigned long repeat_count = 1)
         : /*m_macro(0), m_actual_args(0),*/ m_pp(pp), m_owns_tokens(false)
     {
-        Init(tok_array, num_toks, disable_expansion, owns_tokens);
+        Init(tok_array, num_toks, disable_expansion, owns_tokens,
+             repeat_count);
     }
 
     /// Initialize this TokenLexer with the specified token stream.
     /// This does not take ownership of the specified token vector.
     ///
     /// DisableExpansion is true when macro expansion of tokens lexed from this
-    /// stream should be disabled.
+    /// stream should be disabled.  RepeatCount is the number of times the
+    /// stream is returned in succession; a count of 0 returns no tokens.
     void Init(const Token* tok_array, unsigned num_toks,
-              bool disable_macro_expansion, bool owns_tokens);
+              bool disable_macro_expansion, bool owns_tokens,
+              unsigned long repeat_count = 1);
 
     ~TokenLexer() { destroy(); }
 
@@ -151,7 +161,7 @@ private:
     /// include stack.
     bool isAtEnd() const
     {
-        return m_cur_token == m_num_tokens;
+        return m_cur_token == m_num_tokens && m_repeat_left == 0;
     }
 
 #if 0
@@ -31,9 +31,11 @@
 ///
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "llvm/ADT/StringRef.h"
 #include "yasmx/Config/export.h"
+#include "yasmx/Basic/SourceLocation.h"
 #include "yasmx/Support/ptr_vector.h"
 
 #include "yasmx/AssocData.h"
@@ -49,7 +51,6 @@ namespace yasm
 class Bytecode;
 class Object;
 class Reloc;
-class SourceLocation;
 
 /// A section.
 class YASM_LIB_EXPORT Section
@@ -117,6 +118,26 @@ public:
     reloc_iterator relocs_end() { return m_relocs.end(); }
     const_reloc_iterator relocs_end() const { return m_relocs.end(); }
 
+    /// The start of a statement's output, recorded while parsing if
+    /// Object::Options::RecordStatements is set.
+    struct Statement
+    {
+        Location loc;           ///< where the statement's output starts
+        SourceLocation source;  ///< statement source location
+        unsigned long index;    ///< statement number within the object
+    };
+    typedef std::vector<Statement> Statements;
+
+    /// Record the start of a statement at the current end of the section.
+    /// Generally Object::AddStatement() should be used instead.
+    /// @param source       statement source location
+    /// @param index        statement number within the object
+    void AddStatement(SourceLocation source, unsigned long index);
+
+    /// Get the recorded statements, in source order.
+    /// @return Statements.
+    const Statements& getStatements() const { return m_statements; }
+
     /// Get name of a section.
     /// @return Section name.
     llvm::StringRef getName() const { return m_name; }
@@ -196,6 +217,9 @@ private:
     /// The relocations for the section.
     Relocs m_relocs;
     stdx::ptr_vector_owner<Reloc> m_relocs_owner;
+
+    /// Recorded statements.
+    Statements m_statements;
 };
 
 } // namespace yasm
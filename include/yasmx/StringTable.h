@@ -29,8 +29,10 @@
 /// POSSIBILITY OF SUCH DAMAGE.
 /// @endlicense
 ///
+#include <utility>
 #include <vector>
 
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "yasmx/Config/export.h"
 
@@ -42,6 +44,10 @@ namespace yasm
 
 /// A string table of 0-terminated strings.  Always begins with a 0-length
 /// string (a single 0 byte) at offset 0.
+/// Strings added with getIndex() are hashed so that a duplicate string
+/// returns the index of its first occurrence.  Optionally, MergeTails() may
+/// be called once all strings have been added to share storage between
+/// strings that are tail substrings of other strings.
 class YASM_LIB_EXPORT StringTable
 {
 public:
@@ -63,12 +69,25 @@ public:
     /// Destructor.
     ~StringTable();
 
-    /// Get an index for a string.  If the asked-for string is a tail substring
-    /// of an existing string in the table, it may be reused.
+    /// Get an index for a string.  If the asked-for string has already been
+    /// added with getIndex(), the existing index is returned.  Strings
+    /// loaded with Read() or the iterator constructor are not reused.
     /// @param str      String
     /// @return String index.
     unsigned long getIndex(llvm::StringRef str);
 
+    /// Merge strings that are tail substrings of other strings in the table
+    /// (e.g. "text" into "rela.text"), compacting the table.  Indexes
+    /// returned by getIndex() before this call must be translated with
+    /// getMergedIndex(); subsequent getIndex() calls return merged indexes.
+    void MergeTails();
+
+    /// Translate an index returned by getIndex() prior to the last
+    /// MergeTails() call into an index into the merged table.
+    /// @param index    pre-merge string index
+    /// @return Merged string index.
+    unsigned long getMergedIndex(unsigned long index) const;
+
     /// Get the string corresponding to a particular index.  Due to legal use
     /// of substrings, no error checking is performed except for trying to read
     /// past the end of the string table.
@@ -94,6 +113,12 @@ public:
 private:
     std::vector<char> m_storage;
     unsigned long m_first_index;
+
+    /// Offsets (relative to m_first_index) of strings added by getIndex().
+    llvm::StringMap<unsigned long> m_offsets;
+
+    /// Old to new offset pairs (sorted by old offset) from MergeTails().
+    std::vector<std::pair<unsigned long, unsigned long> > m_remap;
 };
 
 } // namespace yasm
@@ -21,10 +21,20 @@ namespace yasm
 
 class YASM_LIB_EXPORT MD5
 {
+public:
     MD5();
 
+    /// Start a new message.  Called by the constructor.
     void Init();
+
+    /// Add bytes to the message.
+    /// @param buf      bytes
+    /// @param len      number of bytes
     void Update(const unsigned char* buf, unsigned long len);
+
+    /// Finish the message and get its digest.  Init() must be called
+    /// before the object is reused.
+    /// @param digest   16-byte digest (output)
     void Final(unsigned char digest[16]);
 
 private:
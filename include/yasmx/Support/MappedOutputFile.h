@@ -0,0 +1,84 @@
+#ifndef YASM_MAPPEDOUTPUTFILE_H
+#define YASM_MAPPEDOUTPUTFILE_H
+///
+/// @file
+/// @brief Memory-mapped output file.
+///
+/// @license
+///  Copyright (C) 2026  Peter Johnson
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///  - Redistributions of source code must retain the above copyright
+///    notice, this list of conditions and the following disclaimer.
+///  - Redistributions in binary form must reproduce the above copyright
+///    notice, this list of conditions and the following disclaimer in the
+///    documentation and/or other materials provided with the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+/// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+/// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+/// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+/// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+/// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+/// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+/// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+/// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+#include "yasmx/Config/export.h"
+
+
+namespace llvm { class raw_fd_ostream; }
+
+namespace yasm
+{
+
+/// Maps the file underlying an output stream into memory so its contents
+/// can be written in place.  The file is extended to its final size up
+/// front; untouched areas read back as zeros.  Mapping is only possible
+/// for regular files on platforms with memory mapping support; callers
+/// must fall back to writing through the stream if Map() fails.
+class YASM_LIB_EXPORT MappedOutputFile
+{
+public:
+    /// Constructor.
+    /// @param os       output stream; must not be written to while mapped
+    explicit MappedOutputFile(llvm::raw_fd_ostream& os);
+
+    /// Destructor.  Calls Unmap(), ignoring any error.
+    ~MappedOutputFile();
+
+    /// Set the file size and map it into memory.
+    /// @param size     final file size, in bytes
+    /// @return False if the file could not be mapped.
+    bool Map(unsigned long size);
+
+    /// Unmap the file, committing the written contents.  The stream is
+    /// positioned at the end of the file.
+    /// @return False if committing the contents failed.
+    bool Unmap();
+
+    /// Get the mapped file contents.
+    /// @return Start of the mapped contents (NULL if not mapped).
+    unsigned char* getData() { return m_data; }
+
+    /// Get the mapped size.
+    /// @return Size of the mapped contents, in bytes.
+    unsigned long getSize() const { return m_size; }
+
+private:
+    MappedOutputFile(const MappedOutputFile&);                  // not implemented
+    const MappedOutputFile& operator=(const MappedOutputFile&); // not implemented
+
+    llvm::raw_fd_ostream& m_os;
+    unsigned char* m_data;      ///< Mapped contents
+    unsigned long m_size;       ///< Size of mapped contents
+    bool m_mapped;              ///< True if currently mapped
+    void* m_handle;             ///< Platform mapping handle (Win32 only)
+};
+
+} // namespace yasm
+
+#endif
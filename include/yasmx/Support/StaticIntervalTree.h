@@ -0,0 +1,194 @@
+#ifndef YASM_STATICINTERVALTREE_H
+#define YASM_STATICINTERVALTREE_H
+///
+/// @file
+/// @brief Array-backed interval tree for a fixed set of intervals.
+///
+/// @license
+/// @license
+///  Copyright (C) 2026  Peter Johnson
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///  - Redistributions of source code must retain the above copyright
+///    notice, this list of conditions and the following disclaimer.
+///  - Redistributions in binary form must reproduce the above copyright
+///    notice, this list of conditions and the following disclaimer in the
+///    documentation and/or other materials provided with the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+/// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+/// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+/// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+/// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+/// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+/// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+/// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+/// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// @endlicense
+///
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+
+namespace yasm
+{
+
+/// Interval tree for a set of closed intervals that is fixed once built.
+/// Intervals are kept in a single array sorted by low endpoint; the array
+/// is walked as an implicit balanced binary tree (the middle element of
+/// each range is the root of that range), with each root also recording
+/// the largest high endpoint in its range.  Queries only touch
+/// contiguous memory and never allocate.
+///
+/// Usage: Insert() all intervals, Build(), then Enumerate() any number of
+/// times.  Inserting after Build() requires another Build().
+template <typename T>
+class StaticIntervalTree
+{
+public:
+    StaticIntervalTree() : m_built(true) {}
+
+    /// Add an interval.
+    /// @param low      low endpoint (inclusive)
+    /// @param high     high endpoint (inclusive)
+    /// @param data     data to pass to Enumerate() callbacks
+    void Insert(long low, long high, T data)
+    {
+        assert(low <= high && "invalid interval");
+        Node node = {low, high, high, data};
+        m_nodes.push_back(node);
+        m_built = false;
+    }
+
+    /// Build the tree from the inserted intervals.
+    void Build();
+
+    /// Call a function for each interval that overlaps the closed interval
+    /// [low, high], in order of increasing low endpoint.  Intervals with
+    /// the same low endpoint are visited in insertion order.
+    /// @param low      low endpoint (inclusive)
+    /// @param high     high endpoint (inclusive)
+    /// @param func     function (object) called with interval data
+    template <typename Func>
+    void Enumerate(long low, long high, Func func) const;
+
+    /// Get the number of intervals.
+    /// @return Number of intervals.
+    size_t size() const { return m_nodes.size(); }
+
+    /// Determine if the tree is empty.
+    /// @return True if there are no intervals.
+    bool empty() const { return m_nodes.empty(); }
+
+    /// Remove all intervals.
+    void clear() { m_nodes.clear(); m_built = true; }
+
+private:
+    struct Node
+    {
+        long low;
+        long high;
+        long max_high;  ///< maximum high in subtree rooted here
+        T data;
+
+        bool operator< (const Node& oth) const { return low < oth.low; }
+    };
+
+    long BuildMaxHigh(size_t begin, size_t end);
+
+    std::vector<Node> m_nodes;
+    bool m_built;
+};
+
+template <typename T>
+void
+StaticIntervalTree<T>::Build()
+{
+    std::stable_sort(m_nodes.begin(), m_nodes.end());
+    if (!m_nodes.empty())
+        BuildMaxHigh(0, m_nodes.size());
+    m_built = true;
+}
+
+template <typename T>
+long
+StaticIntervalTree<T>::BuildMaxHigh(size_t begin, size_t end)
+{
+    // Depth is logarithmic in the number of intervals, so recursion is fine.
+    size_t mid = begin + (end-begin)/2;
+    Node& node = m_nodes[mid];
+    long max_high = node.high;
+    if (begin < mid)
+        max_high = std::max(max_high, BuildMaxHigh(begin, mid));
+    if (mid+1 < end)
+        max_high = std::max(max_high, BuildMaxHigh(mid+1, end));
+    node.max_high = max_high;
+    return max_high;
+}
+
+template <typename T>
+template <typename Func>
+void
+StaticIntervalTree<T>::Enumerate(long low, long high, Func func) const
+{
+    assert(m_built && "interval tree not built");
+
+    // Explicit stack of [begin, end) ranges still to visit.  Ranges are
+    // pushed right-then-left so they are visited in sorted order.  Each
+    // level of descent leaves at most two ranges behind on the stack, so
+    // twice the maximum depth (plus one) suffices.
+    struct Range { size_t begin, end; };
+    Range stack[2*sizeof(size_t)*8+1];
+    size_t top = 0;
+
+    if (m_nodes.empty())
+        return;
+    Range all = {0, m_nodes.size()};
+    stack[top++] = all;
+
+    while (top > 0)
+    {
+        Range r = stack[--top];
+        size_t mid = r.begin + (r.end-r.begin)/2;
+        const Node& node = m_nodes[mid];
+
+        // Nothing in this range reaches the query.
+        if (node.max_high < low)
+            continue;
+
+        if (node.low <= high)
+        {
+            // Only nodes to the right of a node that starts within the query
+            // can possibly overlap; later nodes all start after node.low.
+            if (mid+1 < r.end)
+            {
+                Range right = {mid+1, r.end};
+                stack[top++] = right;
+            }
+            // Visit this node after the left range by pushing it as a
+            // single-element range whose left/right are empty.
+            if (r.begin < mid)
+            {
+                Range self = {mid, mid+1};
+                stack[top++] = self;
+                Range left = {r.begin, mid};
+                stack[top++] = left;
+            }
+            else if (node.high >= low)
+                func(node.data);
+        }
+        else if (r.begin < mid)
+        {
+            // This node and everything right of it start past the query.
+            Range left = {r.begin, mid};
+            stack[top++] = left;
+        }
+    }
+}
+
+} // namespace yasm
+
+#endif
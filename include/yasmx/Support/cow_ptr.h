@@ -0,0 +1,174 @@
+#ifndef YASM_COW_PTR_H
+#define YASM_COW_PTR_H
+///
+/// @file
+/// @brief Copy-on-write owning pointer.
+///
+/// @license
+///  Copyright (C) 2026  Peter Johnson
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///  - Redistributions of source code must retain the above copyright
+///    notice, this list of conditions and the following disclaimer.
+///  - Redistributions in binary form must reproduce the above copyright
+///    notice, this list of conditions and the following disclaimer in the
+///    documentation and/or other materials provided with the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+/// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+/// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+/// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+/// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+/// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+/// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+/// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+/// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+#include <cassert>
+#include <memory>           // for std::auto_ptr
+
+#include "llvm/System/Atomic.h"
+#include "yasmx/Support/scoped_ptr.h"   // for checked_delete
+
+
+namespace yasm
+{
+namespace util
+{
+
+/// Owning pointer whose copies share the pointed-to object until one of
+/// them asks for write access, at which point that copy gets its own clone
+/// (made with the copy constructor of T).  Copying is a pointer copy plus
+/// an atomic reference count increment, so copies of the same object may
+/// be used and destroyed from different threads; as with any object, a
+/// single cow_ptr must not be modified concurrently.
+///
+/// Once write access has been handed out through leak(), the returned
+/// pointer may be kept by the caller, so this copy stops sharing: later
+/// copies made from it get their own clone.
+template <class T> class cow_ptr
+{
+public:
+    typedef T element_type;
+
+    explicit cow_ptr(T* p = 0)
+        : m_ptr(p), m_refs(p ? new llvm::sys::cas_flag(1) : 0), m_leaked(false)
+    {}
+
+    explicit cow_ptr(std::auto_ptr<T> p)
+        : m_ptr(p.get()), m_refs(0), m_leaked(false)
+    {
+        if (m_ptr != 0)
+            m_refs = new llvm::sys::cas_flag(1);
+        p.release();
+    }
+
+    cow_ptr(const cow_ptr& oth) : m_ptr(0), m_refs(0), m_leaked(false)
+    {
+        if (oth.m_ptr == 0)
+            return;
+        if (oth.m_leaked)
+        {
+            std::auto_ptr<T> copy(new T(*oth.m_ptr));
+            m_refs = new llvm::sys::cas_flag(1);
+            m_ptr = copy.release();
+            return;
+        }
+        m_ptr = oth.m_ptr;
+        m_refs = oth.m_refs;
+        llvm::sys::AtomicIncrement(m_refs);
+    }
+
+    ~cow_ptr() { release(); }
+
+    cow_ptr& operator= (const cow_ptr& rhs)
+    {
+        if (m_ptr != rhs.m_ptr || rhs.m_leaked)
+            cow_ptr(rhs).swap(*this);
+        return *this;
+    }
+
+    /// Replace the pointed-to object, releasing this copy's reference to
+    /// the previous one.
+    void reset(T* p = 0)
+    {
+        assert(p == 0 || p != m_ptr); // catch self-reset errors
+        cow_ptr(p).swap(*this);
+    }
+
+    /// Get read-only access.
+    const T* get() const { return m_ptr; }
+    const T& operator*() const { assert(m_ptr != 0); return *m_ptr; }
+    const T* operator->() const { assert(m_ptr != 0); return m_ptr; }
+
+    /// Get write access, first cloning the object if it is shared.  The
+    /// returned pointer must not be used after this copy is next copied;
+    /// use leak() to get a pointer that may be kept.
+    T* get_mutable()
+    {
+        if (m_ptr == 0 || *m_refs == 1)
+            return m_ptr;
+        cow_ptr(new T(*m_ptr)).swap(*this);
+        return m_ptr;
+    }
+
+    /// Get write access that may be kept by the caller.  Like
+    /// get_mutable(), but the object is never shared again: later copies
+    /// clone it.
+    T* leak()
+    {
+        T* p = get_mutable();
+        m_leaked = (p != 0);
+        return p;
+    }
+
+    /// Determine if the object is shared with another copy.
+    bool shared() const { return m_ptr != 0 && *m_refs > 1; }
+
+    // implicit conversion to "bool"
+    typedef T* cow_ptr::*unspecified_bool_type;
+    operator unspecified_bool_type() const
+    {
+        return m_ptr == 0 ? 0 : &cow_ptr::m_ptr;
+    }
+
+    bool operator! () const { return m_ptr == 0; }
+
+    void swap(cow_ptr& oth)
+    {
+        T* ptr = oth.m_ptr;
+        oth.m_ptr = m_ptr;
+        m_ptr = ptr;
+        llvm::sys::cas_flag* refs = oth.m_refs;
+        oth.m_refs = m_refs;
+        m_refs = refs;
+        bool leaked = oth.m_leaked;
+        oth.m_leaked = m_leaked;
+        m_leaked = leaked;
+    }
+
+private:
+    void release()
+    {
+        if (m_ptr == 0 || llvm::sys::AtomicDecrement(m_refs) != 0)
+            return;
+        delete m_refs;
+        checked_delete(m_ptr);
+    }
+
+    T* m_ptr;
+    llvm::sys::cas_flag* m_refs;    ///< Shared count (NULL if m_ptr is NULL)
+    bool m_leaked;                  ///< Write access was handed out
+};
+
+template <class T> inline void swap(cow_ptr<T>& a, cow_ptr<T>& b)
+{
+    a.swap(b);
+}
+
+}} // namespace yasm::util
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef YASM_LINESCAN_H
+#define YASM_LINESCAN_H
+///
+/// @file
+/// @brief Physical line scanning.
+///
+/// @license
+///  Copyright (C) 2026  Peter Johnson
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///  - Redistributions of source code must retain the above copyright
+///    notice, this list of conditions and the following disclaimer.
+///  - Redistributions in binary form must reproduce the above copyright
+///    notice, this list of conditions and the following disclaimer in the
+///    documentation and/or other materials provided with the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+/// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+/// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+/// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+/// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+/// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+/// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+/// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+/// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+/// @endlicense
+///
+#include <vector>
+
+#include "yasmx/Config/export.h"
+
+
+namespace yasm
+{
+
+/// Line scanning implementations.
+enum LineScanKernel
+{
+    LINESCAN_AUTO = 0,  ///< Fastest kernel supported by the running CPU
+    LINESCAN_SCALAR,    ///< Portable byte-at-a-time scan
+    LINESCAN_SSE2,      ///< 16 bytes at a time (x86 SSE2)
+    LINESCAN_AVX2       ///< 32 bytes at a time (x86 AVX2)
+};
+
+/// Determine if a line scanning kernel can be used on the running CPU.
+/// @param kernel   kernel
+/// @return True if kernel is available.
+YASM_LIB_EXPORT
+bool isLineScanKernelSupported(LineScanKernel kernel);
+
+/// Get the kernel LINESCAN_AUTO resolves to on the running CPU.
+/// @return Kernel (never LINESCAN_AUTO).
+YASM_LIB_EXPORT
+LineScanKernel getBestLineScanKernel();
+
+/// Find the starting offsets of all physical lines after the first in a
+/// buffer.  A line ends with '\n' or '\r'; the pairs "\r\n" and "\n\r"
+/// are each treated as a single line ending.  Other characters (including
+/// 0) are part of the line.
+/// @param buf      buffer start
+/// @param size     buffer size
+/// @param offsets  vector to append line start offsets to
+/// @param kernel   implementation to use; unsupported kernels fall back
+///                 to LINESCAN_SCALAR
+YASM_LIB_EXPORT
+void ScanLineOffsets(const char* buf,
+                     unsigned long size,
+                     std::vector<unsigned>* offsets,
+                     LineScanKernel kernel = LINESCAN_AUTO);
+
+} // namespace yasm
+
+#endif
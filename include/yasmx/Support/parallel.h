@@ -0,0 +1,70 @@
+#ifndef YASM_PARALLEL_H
+#define YASM_PARALLEL_H
+///
+/// @file
+/// @brief Simple fork-join parallel loop.
+///
+/// @license
+///  Copyright (C) 2026  Peter Johnson
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+///  - Redistributions of source code must retain the above copyright
+///    notice, this list of conditions and the following disclaimer.
+///  - Redistributions in binary form must reproduce the above copyright
+///    notice, this list of conditions and the following disclaimer in the
+///    documentation and/or other materials provided with the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+/// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+/// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+/// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+/// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+/// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+/// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+/// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+/// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+/// @endlicense
+#include "yasmx/Config/export.h"
+#include "yasmx/Config/functional.h"
+
+
+namespace yasm
+{
+
+/// Determine if threads are available to ParallelFor().
+/// @return True if ParallelFor() can run work concurrently.
+YASM_LIB_EXPORT
+bool isParallelSupported();
+
+/// Get the number of processors available to run threads.
+/// @return Number of processors (at least 1).
+YASM_LIB_EXPORT
+unsigned int getNumProcessors();
+
+/// Call a function once for each index in [0, count), spreading the calls
+/// across up to jobs threads (including the calling thread).  Indices are
+/// handed out in increasing order, but calls may complete in any order.
+/// Returns once all calls have completed.  If jobs is 1 or less, or threads
+/// are not available, all calls are made in order on the calling thread.
+///
+/// If a call throws when running on multiple threads, no further calls
+/// are started, and once the running calls have completed the exception
+/// is rethrown on the calling thread.  Only the first exception is kept.
+/// std::bad_alloc and std::out_of_range are rethrown as the same type;
+/// any other exception is rethrown as a std::runtime_error with the
+/// same message.
+/// @param count    number of indices
+/// @param jobs     maximum number of concurrent threads
+/// @param func     function to call with each index
+YASM_LIB_EXPORT
+void ParallelFor(unsigned long count,
+                 unsigned int jobs,
+                 const TR1::function<void (unsigned long)>& func);
+
+} // namespace yasm
+
+#endif
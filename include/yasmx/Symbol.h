@@ -52,7 +52,7 @@ class YASM_LIB_EXPORT Symbol : public AssocDataContainer
     friend class Object;
 
 public:
-    /// Constructor.
+    /// Constructor.  The name is copied.
     explicit Symbol(llvm::StringRef name);
 
     /// Destructor.
@@ -217,6 +217,16 @@ private:
     Symbol(const Symbol&);                  // not implemented
     const Symbol& operator=(const Symbol&); // not implemented
 
+    /// Tag type for constructing a symbol with an interned name.
+    struct InternedName {};
+
+    /// Constructor for symbols owned by an Object.  The name is not copied;
+    /// it must outlive the symbol (e.g. be interned in the object).
+    Symbol(llvm::StringRef name, InternedName);
+
+    /// Change the name to one that outlives the symbol.
+    void setInternedName(llvm::StringRef name);
+
     enum Type
     {
         UNKNOWN,    ///< for unknown type (COMMON/EXTERN)
@@ -230,7 +240,8 @@ private:
 
     bool DefineCheck(SourceLocation source, Diagnostic& diags) const;
 
-    std::string m_name;
+    llvm::StringRef m_name;
+    bool m_owns_name;               ///< true if m_name was allocated by us
     Type m_type;
     int m_status;
     int m_visibility;
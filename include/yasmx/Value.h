@@ -32,11 +32,10 @@
 #include <algorithm>
 #include <memory>
 
-#include <boost/scoped_ptr.hpp>
-
 #include "yasmx/Basic/DiagnosticKinds.h"
 #include "yasmx/Basic/SourceLocation.h"
 #include "yasmx/Config/export.h"
+#include "yasmx/Support/cow_ptr.h"
 #include "yasmx/DebugDumper.h"
 #include "yasmx/IntNum.h"
 #include "yasmx/Location.h"
@@ -160,9 +159,12 @@ public:
     ///         true if value output.
     bool OutputBasic(NumericOutput& num_out, IntNum* outval, Diagnostic& diags);
 
-    /// Get the absolute portion of the value.
+    /// Get the absolute portion of the value.  The absolute portion is
+    /// shared between copies of a value; the non-const version makes this
+    /// value's copy private first and keeps it private, so later copies of
+    /// this value clone it.  Prefer the const version when only reading.
     /// @return Absolute expression, or NULL if there is no absolute portion.
-    Expr* getAbs() { return m_abs.get(); }
+    Expr* getAbs();
     const Expr* getAbs() const { return m_abs.get(); }
 
     /// Determine if the value has an absolute portion.
@@ -327,7 +329,8 @@ private:
     /// The absolute portion of the value.  May contain *differences* between
     /// symrecs but not standalone symrecs.  May be NULL if there is no
     /// absolute portion (e.g. the absolute portion is 0).
-    boost::scoped_ptr<Expr> m_abs;
+    /// Copies of a value share this until one of them modifies it.
+    util::cow_ptr<Expr> m_abs;
 
     /// The relative portion of the value.  This is the portion that may
     /// need to generate a relocation.  May be NULL if no relative portion.
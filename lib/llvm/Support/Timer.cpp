@@ -23,9 +23,6 @@
 #include "llvm/ADT/StringMap.h"
 using namespace llvm;
 
-// CreateInfoOutputFile - Return a file stream to print our output on.
-namespace llvm { extern raw_ostream *CreateInfoOutputFile(); }
-
 // getLibSupportInfoOutputFilename - This ugly hack is brought to you courtesy
 // of constructor/destructor ordering being unspecified by C++.  Basically the
 // problem is that a Statistic object gets destroyed, which ends up calling
@@ -121,21 +118,40 @@ Timer::~Timer() {
   TG->removeTimer(*this);
 }
 
+static bool TrackMemory = false;
+static size_t (*AllocCounter)() = 0;
+
+void llvm::EnableTimerMemoryTracking(size_t (*Counter)()) {
+  TrackMemory = true;
+  AllocCounter = Counter;
+}
+
+static inline bool isTrackingMemory() {
+  return TrackSpace || TrackMemory;
+}
+
 static inline size_t getMemUsage() {
-  if (!TrackSpace) return 0;
+  if (!isTrackingMemory()) return 0;
   return sys::Process::GetMallocUsage();
 }
 
+static inline size_t getCurrentAllocCount() {
+  if (!AllocCounter) return 0;
+  return AllocCounter();
+}
+
 TimeRecord TimeRecord::getCurrentTime(bool Start) {
   TimeRecord Result;
   sys::TimeValue now(0,0), user(0,0), sys(0,0);
   
   if (Start) {
     Result.MemUsed = getMemUsage();
+    Result.AllocCount = getCurrentAllocCount();
     sys::Process::GetTimeUsage(now, user, sys);
   } else {
     sys::Process::GetTimeUsage(now, user, sys);
     Result.MemUsed = getMemUsage();
+    Result.AllocCount = getCurrentAllocCount();
   }
 
   Result.WallTime   =  now.seconds() +  now.microseconds() / 1000000.0;
@@ -187,6 +203,30 @@ void TimeRecord::print(const TimeRecord &Total, raw_ostream &OS) const {
   
   if (Total.getMemUsed())
     OS << format("%9lld", (long long)getMemUsed()) << "  ";
+  if (Total.getAllocCount())
+    OS << format("%9lld", (long long)getAllocCount()) << "  ";
+}
+
+void TimeRecord::printJSON(raw_ostream &OS) const {
+  OS << "\"wall\": " << format("%.6f", getWallTime())
+     << ", \"user\": " << format("%.6f", getUserTime())
+     << ", \"sys\": " << format("%.6f", getSystemTime())
+     << ", \"mem\": " << (long long)getMemUsed()
+     << ", \"allocs\": " << (long long)getAllocCount();
+}
+
+static void printJSONString(StringRef Str, raw_ostream &OS) {
+  OS << '"';
+  for (StringRef::iterator I = Str.begin(), E = Str.end(); I != E; ++I) {
+    unsigned char C = *I;
+    if (C == '"' || C == '\\')
+      OS << '\\' << C;
+    else if (C < 0x20)
+      OS << format("\\u%04x", C);
+    else
+      OS << C;
+  }
+  OS << '"';
 }
 
 
@@ -348,6 +388,8 @@ void TimerGroup::PrintQueuedTimers(raw_ostream &OS) {
   OS << "   ---Wall Time---";
   if (Total.getMemUsed())
     OS << "  ---Mem---";
+  if (Total.getAllocCount())
+    OS << "  --Allocs--";
   OS << "  --- Name ---\n";
   
   // Loop through all of the timing data, printing it out.
@@ -359,17 +401,19 @@ void TimerGroup::PrintQueuedTimers(raw_ostream &OS) {
   
   Total.print(Total, OS);
   OS << "Total\n\n";
+  if (isTrackingMemory()) {
+    OS << "  Peak memory usage: "
+       << (unsigned long long)sys::Process::GetPeakMemoryUsage()
+       << " bytes\n\n";
+  }
   OS.flush();
   
   TimersToPrint.clear();
 }
 
-/// print - Print any started timers in this group and zero them.
-void TimerGroup::print(raw_ostream &OS) {
-  sys::SmartScopedLock<true> L(*TimerLock);
-
-  // See if any of our timers were started, if so add them to TimersToPrint and
-  // reset them.
+/// PrepareToPrint - Add any started timers to TimersToPrint and reset them.
+/// The caller must hold TimerLock.
+void TimerGroup::PrepareToPrint() {
   for (Timer *T = FirstTimer; T; T = T->Next) {
     if (!T->Started) continue;
     TimersToPrint.push_back(std::make_pair(T->Time, T->Name));
@@ -378,12 +422,63 @@ void TimerGroup::print(raw_ostream &OS) {
     T->Started = 0;
     T->Time = TimeRecord();
   }
+}
+
+/// print - Print any started timers in this group and zero them.
+void TimerGroup::print(raw_ostream &OS) {
+  sys::SmartScopedLock<true> L(*TimerLock);
+
+  PrepareToPrint();
 
   // If any timers were started, print the group.
   if (!TimersToPrint.empty())
     PrintQueuedTimers(OS);
 }
 
+/// printJSON - Print any started timers in this group as JSON and zero them.
+void TimerGroup::printJSON(raw_ostream &OS) {
+  sys::SmartScopedLock<true> L(*TimerLock);
+
+  PrepareToPrint();
+
+  // Keep the same (descending time) order as the text output.
+  std::sort(TimersToPrint.begin(), TimersToPrint.end());
+
+  TimeRecord Total;
+  for (unsigned i = 0, e = TimersToPrint.size(); i != e; ++i)
+    Total += TimersToPrint[i].first;
+
+  OS << "{\n  \"name\": ";
+  printJSONString(Name, OS);
+  OS << ",\n  \"timers\": [";
+  for (unsigned i = 0, e = TimersToPrint.size(); i != e; ++i) {
+    const std::pair<TimeRecord, std::string> &Entry = TimersToPrint[e-i-1];
+    OS << (i == 0 ? "\n" : ",\n") << "    {\"name\": ";
+    printJSONString(Entry.second, OS);
+    OS << ", ";
+    Entry.first.printJSON(OS);
+    OS << '}';
+  }
+  OS << "\n  ],\n  \"total\": {";
+  Total.printJSON(OS);
+  OS << "},\n  \"peak_rss\": "
+     << (unsigned long long)sys::Process::GetPeakMemoryUsage() << "\n}\n";
+  OS.flush();
+
+  TimersToPrint.clear();
+}
+
+/// takeRecords - Move any started timers in this group to Records and zero
+/// them.
+void TimerGroup::takeRecords(
+    std::vector<std::pair<TimeRecord, std::string> > &Records) {
+  sys::SmartScopedLock<true> L(*TimerLock);
+
+  PrepareToPrint();
+  Records.insert(Records.end(), TimersToPrint.begin(), TimersToPrint.end());
+  TimersToPrint.clear();
+}
+
 /// printAll - This static method prints all timers and clears them all out.
 void TimerGroup::printAll(raw_ostream &OS) {
   sys::SmartScopedLock<true> L(*TimerLock);
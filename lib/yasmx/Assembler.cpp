@@ -27,6 +27,7 @@
 #include "yasmx/Assembler.h"
 
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/System/Path.h"
 #include "yasmx/Basic/Diagnostic.h"
 #include "yasmx/Basic/SourceManager.h"
@@ -43,6 +44,24 @@
 
 using namespace yasm;
 
+class Assembler::Timers
+{
+public:
+    explicit Timers(llvm::TimerGroup& group) : m_group(group) {}
+
+    llvm::Timer* get(Phase phase, llvm::StringRef name)
+    {
+        llvm::Timer& timer = m_timers[phase];
+        if (!timer.isInitialized())
+            timer.init(name, m_group);
+        return &timer;
+    }
+
+private:
+    llvm::TimerGroup& m_group;
+    llvm::Timer m_timers[NUM_PHASES];
+};
+
 namespace {
 class NocaseEquals
 {
@@ -71,7 +90,10 @@ Assembler::Assembler(llvm::StringRef arch_keyword,
       m_dbgfmt(0),
       m_listfmt(0),
       m_object(0),
-      m_dump_time(dump_time)
+      m_dump_time(dump_time),
+      m_jobs(1),
+      m_optimize_level(Object::OPTIMIZE_FULL),
+      m_timers(0)
 {
     if (m_arch_module.get() == 0)
     {
@@ -87,7 +109,16 @@ Assembler::Assembler(llvm::StringRef arch_keyword,
         return;
     }
 
-    // Create architecture.
+    CreateArch();
+}
+
+Assembler::~Assembler()
+{
+}
+
+void
+Assembler::CreateArch()
+{
     m_arch.reset(m_arch_module->Create().release());
 
     // Get initial x86 BITS setting from object format
@@ -95,10 +126,50 @@ Assembler::Assembler(llvm::StringRef arch_keyword,
         m_arch->setVar("mode_bits",
                        m_objfmt_module->getDefaultX86ModeBits());
 
+    // Reapply settings that were already validated.
+    if (!m_machine.empty())
+        m_arch->setMachine(m_machine);
+    if (m_parser_module.get() != 0)
+        m_arch->setParser(m_parser_module->getKeyword());
+    for (std::vector<std::pair<std::string, unsigned long> >::const_iterator
+         i=m_arch_vars.begin(), end=m_arch_vars.end(); i != end; ++i)
+        m_arch->setVar(i->first, i->second);
 }
 
-Assembler::~Assembler()
+void
+Assembler::Reset()
 {
+    m_object.reset(0);
+    m_listfmt.reset(0);
+    m_dbgfmt.reset(0);
+    m_objfmt.reset(0);
+    m_parser.reset(0);
+    m_obj_filename.clear();
+    if (m_arch_module.get() != 0 && m_objfmt_module.get() != 0)
+        CreateArch();
+}
+
+bool
+Assembler::setArchVar(llvm::StringRef var, unsigned long val)
+{
+    if (!m_arch->setVar(var, val))
+        return false;
+    m_arch_vars.push_back(std::make_pair(var.str(), val));
+    return true;
+}
+
+void
+Assembler::setTimerGroup(llvm::TimerGroup* group)
+{
+    m_timers.reset(group ? new Timers(*group) : 0);
+}
+
+llvm::Timer*
+Assembler::getTimer(Phase phase, llvm::StringRef name)
+{
+    if (!m_timers)
+        return 0;
+    return m_timers->get(phase, name);
 }
 
 void
@@ -202,6 +273,8 @@ Assembler::InitObject(SourceManager& source_mgr, Diagnostic& diags)
     llvm::StringRef in_filename =
         source_mgr.getBuffer(source_mgr.getMainFileID())->getBufferIdentifier();
     llvm::StringRef parser_keyword = m_parser_module->getKeyword();
+    llvm::TimeRegion timer(getTimer(PHASE_INIT, "Initialize object ("+
+        m_objfmt_module->getKeyword().str()+")"));
 
     // determine the object filename if not specified
     if (m_obj_filename.empty())
@@ -241,6 +314,8 @@ Assembler::InitObject(SourceManager& source_mgr, Diagnostic& diags)
 
     // Create object
     m_object.reset(new Object(in_filename, m_obj_filename, m_arch.get()));
+    m_object->getOptions().OptimizeLevel = m_optimize_level;
+    m_object->getOptions().RecordStatements = (m_listfmt_module.get() != 0);
 
     // See if the object format supports such an object
     if (!m_objfmt_module->isOkObject(*m_object))
@@ -308,7 +383,11 @@ Assembler::Assemble(SourceManager& source_mgr,
     }
 
     // Parse!
-    m_parser->Parse(*m_object, dirs, diags);
+    {
+        llvm::TimeRegion timer(getTimer(PHASE_PARSE,
+                                        "Parse ("+parser_keyword.str()+")"));
+        m_parser->Parse(*m_object, dirs, diags);
+    }
 
     if (m_dump_time == Assembler::DUMP_AFTER_PARSE)
         m_object->Dump();
@@ -316,14 +395,20 @@ Assembler::Assemble(SourceManager& source_mgr,
         return false;
 
     // Finalize parse
-    m_object->Finalize(diags);
+    {
+        llvm::TimeRegion timer(getTimer(PHASE_FINALIZE, "Finalize"));
+        m_object->Finalize(diags);
+    }
     if (m_dump_time == Assembler::DUMP_AFTER_FINALIZE)
         m_object->Dump();
     if (diags.hasErrorOccurred())
         return false;
 
     // Optimize
-    m_object->Optimize(diags);
+    {
+        llvm::TimeRegion timer(getTimer(PHASE_OPTIMIZE, "Optimize"));
+        m_object->Optimize(diags, m_jobs);
+    }
 
     if (m_dump_time == Assembler::DUMP_AFTER_OPTIMIZE)
         m_object->Dump();
@@ -332,7 +417,11 @@ Assembler::Assemble(SourceManager& source_mgr,
         return false;
 
     // generate any debugging information
-    m_dbgfmt->Generate(*m_objfmt, source_mgr, diags);
+    {
+        llvm::TimeRegion timer(getTimer(PHASE_DEBUG, "Generate debug info ("+
+            m_dbgfmt_module->getKeyword().str()+")"));
+        m_dbgfmt->Generate(*m_objfmt, source_mgr, diags);
+    }
 
     return true;
 }
@@ -341,10 +430,14 @@ bool
 Assembler::Output(llvm::raw_fd_ostream& os, Diagnostic& diags)
 {
     // Write the object file
-    m_objfmt->Output(os,
-                     !m_dbgfmt_module->getKeyword().equals_lower("null"),
-                     *m_dbgfmt,
-                     diags);
+    {
+        llvm::TimeRegion timer(getTimer(PHASE_OUTPUT, "Output ("+
+            m_objfmt_module->getKeyword().str()+")"));
+        m_objfmt->Output(os,
+                         !m_dbgfmt_module->getKeyword().equals_lower("null"),
+                         *m_dbgfmt,
+                         diags);
+    }
 
     if (m_dump_time == DUMP_AFTER_OUTPUT)
         m_object->Dump();
@@ -354,3 +447,15 @@ Assembler::Output(llvm::raw_fd_ostream& os, Diagnostic& diags)
 
     return true;
 }
+
+bool
+Assembler::OutputList(llvm::raw_ostream& os,
+                      SourceManager& source_mgr,
+                      Diagnostic& diags)
+{
+    if (m_listfmt.get() == 0)
+        return false;
+
+    m_listfmt->Output(os, *m_object, source_mgr, diags);
+    return !diags.hasErrorOccurred();
+}
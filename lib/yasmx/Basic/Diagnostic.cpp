@@ -251,6 +251,17 @@ bool Diagnostic::popMappings() {
   return true;
 }
 
+void Diagnostic::inheritMappings(const Diagnostic &Other) {
+  DiagMappingsStack.back() = Other.DiagMappingsStack.back();
+  AllExtensionsSilenced = Other.AllExtensionsSilenced;
+  IgnoreAllWarnings = Other.IgnoreAllWarnings;
+  WarningsAsErrors = Other.WarningsAsErrors;
+  ErrorsAsFatal = Other.ErrorsAsFatal;
+  SuppressAllDiagnostics = Other.SuppressAllDiagnostics;
+  ShowOverloads = Other.ShowOverloads;
+  ExtBehavior = Other.ExtBehavior;
+}
+
 /// getCustomDiagID - Return an ID for a diagnostic with the specified message
 /// and level.  If this is the first request for this diagnosic, it is
 /// registered and created, otherwise the existing ID is returned.
@@ -0,0 +1,124 @@
+//===--- DiagnosticBuffer.cpp - Buffer and replay diagnostics -------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements a DiagnosticClient that records diagnostics so they
+//  can later be replayed into another Diagnostic.
+//
+//===----------------------------------------------------------------------===//
+
+#include "yasmx/Basic/DiagnosticBuffer.h"
+
+#include "yasmx/Basic/SourceManager.h"
+using namespace yasm;
+
+/// LocationOrder - Orders diagnostic groups by the location of their first
+/// diagnostic.  Invalid locations sort before everything else.
+class DiagnosticBuffer::LocationOrder {
+  const SourceManager &SM;
+public:
+  explicit LocationOrder(const SourceManager &sm) : SM(sm) {}
+
+  bool operator()(const Group &LHS, const Group &RHS) const {
+    SourceLocation L = LHS.front().Loc, R = RHS.front().Loc;
+    if (!R.isValid())
+      return false;
+    if (!L.isValid())
+      return true;
+    if (L == R)
+      return false;
+    return SM.isBeforeInTranslationUnit(L, R);
+  }
+};
+
+DiagnosticBuffer::DiagnosticBuffer() {
+}
+
+DiagnosticBuffer::~DiagnosticBuffer() {
+}
+
+void DiagnosticBuffer::HandleDiagnostic(Diagnostic::Level DiagLevel,
+                                        const DiagnosticInfo &Info) {
+  // Notes go with the diagnostic they follow; one that follows nothing
+  // starts its own group.
+  if (DiagLevel != Diagnostic::Note || Groups.empty())
+    Groups.push_back(Group());
+  Group &G = Groups.back();
+  G.push_back(Entry());
+  Entry &E = G.back();
+
+  E.Loc = Info.getLocation();
+  E.DiagID = Info.getID();
+  E.Level = DiagLevel;
+  if (E.DiagID >= diag::DIAG_UPPER_LIMIT)
+    E.CustomMessage = Info.getDiags()->getDescription(E.DiagID);
+
+  E.Args.resize(Info.getNumArgs());
+  for (unsigned i = 0, e = Info.getNumArgs(); i != e; ++i) {
+    Arg &A = E.Args[i];
+    A.Kind = Info.getArgKind(i);
+    A.Val = 0;
+    switch (A.Kind) {
+    case Diagnostic::ak_std_string:
+      A.Str = Info.getArgStdStr(i);
+      break;
+    case Diagnostic::ak_c_string: {
+      // The pointer may not outlive the report; keep a copy.
+      const char *S = Info.getArgCStr(i);
+      A.Kind = Diagnostic::ak_std_string;
+      A.Str = S ? S : "(null)";
+      break;
+    }
+    default:
+      A.Val = Info.getRawArg(i);
+      break;
+    }
+  }
+
+  for (unsigned i = 0, e = Info.getNumRanges(); i != e; ++i)
+    E.Ranges.push_back(Info.getRange(i));
+  for (unsigned i = 0, e = Info.getNumFixItHints(); i != e; ++i)
+    E.FixIts.push_back(Info.getFixItHint(i));
+}
+
+void DiagnosticBuffer::take(DiagnosticBuffer &Other) {
+  Groups.splice(Groups.end(), Other.Groups);
+}
+
+void DiagnosticBuffer::Replay(Diagnostic &Diags) {
+  if (Groups.empty())
+    return;
+
+  // std::list::sort is stable.
+  Groups.sort(LocationOrder(Diags.getSourceManager()));
+
+  for (Groups_t::const_iterator G = Groups.begin(), GE = Groups.end();
+       G != GE; ++G) {
+    for (Group::const_iterator E = G->begin(), EE = G->end(); E != EE; ++E) {
+      unsigned DiagID = E->DiagID;
+      if (DiagID >= diag::DIAG_UPPER_LIMIT)
+        DiagID = Diags.getCustomDiagID(E->Level, E->CustomMessage);
+
+      DiagnosticBuilder DB = Diags.Report(E->Loc, DiagID);
+      for (std::vector<Arg>::const_iterator A = E->Args.begin(),
+           AE = E->Args.end(); A != AE; ++A) {
+        if (A->Kind == Diagnostic::ak_std_string)
+          DB.AddString(A->Str);
+        else
+          DB.AddTaggedVal(A->Val, A->Kind);
+      }
+      for (std::vector<CharSourceRange>::const_iterator R = E->Ranges.begin(),
+           RE = E->Ranges.end(); R != RE; ++R)
+        DB.AddSourceRange(*R);
+      for (std::vector<FixItHint>::const_iterator F = E->FixIts.begin(),
+           FE = E->FixIts.end(); F != FE; ++F)
+        DB.AddFixItHint(*F);
+    }
+  }
+  Groups.clear();
+}
@@ -19,6 +19,7 @@
 #include "yasmx/Basic/Diagnostic.h"
 #include "yasmx/Basic/FileManager.h"
 #include "yasmx/Basic/SourceManagerInternals.h"
+#include "yasmx/Support/linescan.h"
 #include <algorithm>
 #include <string>
 #include <cstring>
@@ -73,8 +74,19 @@ const llvm::MemoryBuffer *ContentCache::getBuffer(Diagnostic &Diag,
   if (!Buffer.getPointer() && Entry) {
     std::string ErrorStr;
     struct stat FileInfo;
-    Buffer.setPointer(MemoryBuffer::getFile(Entry->getName(), &ErrorStr,
-                                            Entry->getSize(), &FileInfo));
+    const MemoryBuffer *External = 0;
+    if (ExternalFileContentSource *Source = SM.getExternalFileContentSource())
+      External = Source->getFileContents(Entry);
+    if (External) {
+      // The external source owns the buffer and has already checked it
+      // against the file entry.
+      Buffer.setPointer(External);
+      Buffer.setInt(DoNotFreeFlag);
+      FileInfo.st_size = Entry->getSize();
+      FileInfo.st_mtime = Entry->getModificationTime();
+    } else
+      Buffer.setPointer(MemoryBuffer::getFile(Entry->getName(), &ErrorStr,
+                                              Entry->getSize(), &FileInfo));
     
     // If we were unable to open the file, then we are in an inconsistent
     // situation where the content cache referenced a file which no longer
@@ -157,7 +169,7 @@ const llvm::MemoryBuffer *ContentCache::getBuffer(Diagnostic &Diag,
       if (BOM) {
         Diag.Report(FullSourceLoc(Loc, SM), diag::err_unsupported_bom)
           << BOM << Entry->getName();
-        Buffer.setInt(1);
+        Buffer.setInt(Buffer.getInt() | InvalidFlag);
       }
     }
   }
@@ -830,32 +842,11 @@ static void ComputeLineNumbers(Diagnostic &Diag, ContentCache *FI,
   // Line #1 starts at char 0.
   LineOffsets.push_back(0);
 
-  const unsigned char *Buf = (const unsigned char *)Buffer->getBufferStart();
-  const unsigned char *End = (const unsigned char *)Buffer->getBufferEnd();
-  unsigned Offs = 0;
-  while (1) {
-    // Skip over the contents of the line.
-    // TODO: Vectorize this?  This is very performance sensitive for programs
-    // with lots of diagnostics and in -E mode.
-    const unsigned char *NextBuf = (const unsigned char *)Buf;
-    while (*NextBuf != '\n' && *NextBuf != '\r' && *NextBuf != '\0')
-      ++NextBuf;
-    Offs += NextBuf-Buf;
-    Buf = NextBuf;
-
-    if (Buf[0] == '\n' || Buf[0] == '\r') {
-      // If this is \n\r or \r\n, skip both characters.
-      if ((Buf[1] == '\n' || Buf[1] == '\r') && Buf[0] != Buf[1])
-        ++Offs, ++Buf;
-      ++Offs, ++Buf;
-      LineOffsets.push_back(Offs);
-    } else {
-      // Otherwise, this is a null.  If end of file, exit.
-      if (Buf == End) break;
-      // Otherwise, skip the null.
-      ++Offs, ++Buf;
-    }
-  }
+  // Skip over the contents of each line; this is very performance sensitive
+  // for programs with lots of diagnostics and in -E mode, so use a
+  // vectorized scan where the CPU supports it.
+  ScanLineOffsets(Buffer->getBufferStart(), Buffer->getBufferSize(),
+                  &LineOffsets);
 
   // Copy the offsets into the FileInfo structure.
   FI->NumLines = LineOffsets.size();
@@ -1292,3 +1283,5 @@ void SourceManager::PrintStats() const {
 }
 
 ExternalSLocEntrySource::~ExternalSLocEntrySource() { }
+
+ExternalFileContentSource::~ExternalFileContentSource() { }
@@ -0,0 +1,161 @@
+///
+/// Borrowed data bytecode implementation
+///
+///  Copyright (C) 2026  Peter Johnson
+///
+/// Redistribution and use in source and binary forms, with or without
+/// modification, are permitted provided that the following conditions
+/// are met:
+/// 1. Redistributions of source code must retain the above copyright
+///    notice, this list of conditions and the following disclaimer.
+/// 2. Redistributions in binary form must reproduce the above copyright
+///    notice, this list of conditions and the following disclaimer in the
+///    documentation and/or other materials provided with the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+/// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+/// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+/// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+/// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+/// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+/// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+/// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+/// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+/// POSSIBILITY OF SUCH DAMAGE.
+///
+#include "yasmx/BytecodeContainer.h"
+
+#include <algorithm>
+
+#include "yasmx/Basic/Diagnostic.h"
+#include "yasmx/BytecodeOutput.h"
+#include "yasmx/Bytecode.h"
+#include "yasmx/Bytes.h"
+
+
+using namespace yasm;
+
+namespace {
+/// Bytecode whose tail is data owned by someone else (typically a section
+/// of an object file read through the source manager).  The data is only
+/// referenced, so building a section from a memory-mapped file neither
+/// copies nor touches its contents until they are actually used.
+class BorrowedBytecode : public Bytecode::Contents
+{
+public:
+    BorrowedBytecode(const unsigned char* data, unsigned long len);
+    ~BorrowedBytecode();
+
+    /// Finalizes the bytecode after parsing.
+    bool Finalize(Bytecode& bc, Diagnostic& diags);
+
+    /// Calculates the minimum size of a bytecode.
+    bool CalcLen(Bytecode& bc,
+                 /*@out@*/ unsigned long* len,
+                 const Bytecode::AddSpanFunc& add_span,
+                 Diagnostic& diags);
+
+    /// Convert a bytecode into its byte representation.
+    bool Output(Bytecode& bc, BytecodeOutput& bc_out);
+
+    const unsigned char* getTailData() const;
+
+    llvm::StringRef getType() const;
+
+    BorrowedBytecode* clone() const;
+
+#ifdef WITH_XML
+    /// Write an XML representation.  For debugging purposes.
+    pugi::xml_node Write(pugi::xml_node out) const;
+#endif // WITH_XML
+
+private:
+    const unsigned char* m_data;    ///< borrowed data
+    unsigned long m_len;            ///< length of data (in bytes)
+};
+} // anonymous namespace
+
+BorrowedBytecode::BorrowedBytecode(const unsigned char* data,
+                                   unsigned long len)
+    : m_data(data),
+      m_len(len)
+{
+}
+
+BorrowedBytecode::~BorrowedBytecode()
+{
+}
+
+bool
+BorrowedBytecode::Finalize(Bytecode& bc, Diagnostic& diags)
+{
+    return true;
+}
+
+bool
+BorrowedBytecode::CalcLen(Bytecode& bc,
+                          /*@out@*/ unsigned long* len,
+                          const Bytecode::AddSpanFunc& add_span,
+                          Diagnostic& diags)
+{
+    *len = m_len;
+    return true;
+}
+
+bool
+BorrowedBytecode::Output(Bytecode& bc, BytecodeOutput& bc_out)
+{
+    // Go through the scratch buffer a piece at a time so that large
+    // sections don't need a second full-size copy.
+    static const unsigned long CHUNK_SIZE = 64*1024;
+    for (unsigned long pos = 0; pos < m_len; pos += CHUNK_SIZE)
+    {
+        Bytes& bytes = bc_out.getScratch();
+        bytes.Write(m_data+pos, std::min(CHUNK_SIZE, m_len-pos));
+        bc_out.OutputBytes(bytes, bc.getSource());
+    }
+    return true;
+}
+
+const unsigned char*
+BorrowedBytecode::getTailData() const
+{
+    return m_data;
+}
+
+llvm::StringRef
+BorrowedBytecode::getType() const
+{
+    return "yasm::BorrowedBytecode";
+}
+
+BorrowedBytecode*
+BorrowedBytecode::clone() const
+{
+    return new BorrowedBytecode(m_data, m_len);
+}
+
+#ifdef WITH_XML
+pugi::xml_node
+BorrowedBytecode::Write(pugi::xml_node out) const
+{
+    pugi::xml_node root = out.append_child("Borrowed");
+    append_child(root, "Size", m_len);
+    return root;
+}
+#endif // WITH_XML
+
+Bytecode&
+yasm::AppendBorrowedData(BytecodeContainer& container,
+                         const unsigned char* data,
+                         unsigned long len,
+                         SourceLocation source)
+{
+    Bytecode& bc = container.FreshBytecode();
+    bc.Transform(Bytecode::Contents::Ptr(new BorrowedBytecode(data, len)));
+    bc.setSource(source);
+    Diagnostic nodiags(0);
+    bc.CalcLen(0, nodiags);     // length is already known
+    return bc;
+}
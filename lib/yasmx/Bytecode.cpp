@@ -79,6 +79,12 @@ Bytecode::Contents::getSpecial() const
     return SPECIAL_NONE;
 }
 
+const unsigned char*
+Bytecode::Contents::getTailData() const
+{
+    return 0;
+}
+
 Bytecode::Contents::Contents(const Contents& rhs)
 {
 }
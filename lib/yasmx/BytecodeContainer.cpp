@@ -26,6 +26,7 @@
 //
 #include "yasmx/BytecodeContainer.h"
 
+#include "llvm/Support/Allocator.h"
 #include "yasmx/Basic/Diagnostic.h"
 #include "yasmx/BytecodeOutput.h"
 #include "yasmx/Bytecode.h"
@@ -134,6 +135,7 @@ GapBytecode::Write(pugi::xml_node out) const
 
 BytecodeContainer::BytecodeContainer()
     : m_object(0),
+      m_fixed_arena(new llvm::BumpPtrAllocator),
       m_bcs_owner(m_bcs),
       m_last_gap(false)
 {
@@ -157,14 +159,19 @@ BytecodeContainer::AsSection() const
     return 0;
 }
 
+void
+BytecodeContainer::Adopt(Bytecode* bc)
+{
+    bc->m_container = this; // record parent
+    bc->m_fixed.setArena(m_fixed_arena.get());
+    m_bcs.push_back(bc);
+}
+
 void
 BytecodeContainer::AppendBytecode(std::auto_ptr<Bytecode> bc)
 {
     if (bc.get() != 0)
-    {
-        bc->m_container = this; // record parent
-        m_bcs.push_back(bc.release());
-    }
+        Adopt(bc.release());
     m_last_gap = false;
 }
 
@@ -187,8 +194,7 @@ Bytecode&
 BytecodeContainer::StartBytecode()
 {
     Bytecode* bc = new Bytecode;
-    bc->m_container = this; // record parent
-    m_bcs.push_back(bc);
+    Adopt(bc);
     m_last_gap = false;
     return *bc;
 }
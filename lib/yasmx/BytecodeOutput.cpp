@@ -26,6 +26,9 @@
 //
 #include "yasmx/BytecodeOutput.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "llvm/Support/raw_ostream.h"
 #include "yasmx/Basic/Diagnostic.h"
 
@@ -121,3 +124,48 @@ BytecodeStreamOutput::DoOutputBytes(const Bytes& bytes, SourceLocation source)
     // Output bytes to file
     m_os << bytes;
 }
+
+BytecodeMemoryOutput::~BytecodeMemoryOutput()
+{
+}
+
+void
+BytecodeMemoryOutput::DoOutputGap(unsigned long size, SourceLocation source)
+{
+    if (size == 0)
+        return;
+
+    // Warn that gaps are converted to 0 and write out the 0's.
+    Diag(source, diag::warn_uninit_zero);
+
+    if (!CheckRoom(size, source))
+        return;
+    std::memset(m_pos, 0, size);
+    m_pos += size;
+}
+
+void
+BytecodeMemoryOutput::DoOutputBytes(const Bytes& bytes, SourceLocation source)
+{
+    if (bytes.empty())
+        return;
+    if (!CheckRoom(bytes.size(), source))
+        return;
+    m_pos = std::copy(bytes.begin(), bytes.end(), m_pos);
+}
+
+bool
+BytecodeMemoryOutput::CheckRoom(unsigned long size, SourceLocation source)
+{
+    if (size <= getRemaining())
+        return true;
+
+    // Lengths disagree with the layout the buffer was sized from; drop
+    // the rest rather than write past the end.
+    if (!m_overflow)
+        Diag(source, diag::err_output_overflow)
+            << static_cast<unsigned int>(m_size);
+    m_overflow = true;
+    m_pos = m_end;
+    return false;
+}
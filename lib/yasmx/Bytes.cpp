@@ -27,9 +27,13 @@
 #include "yasmx/Bytes.h"
 
 #include <algorithm>
+#include <cstring>
 #include <iterator>
+#include <new>
+#include <stdexcept>
 
 #include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/raw_ostream.h"
 
 
@@ -44,22 +48,162 @@ yasm::operator<< (llvm::raw_ostream& os, const Bytes& bytes)
     return os;
 }
 
+Bytes::Bytes(const Bytes& oth)
+    : EndianState(oth)
+    , m_begin(m_inline)
+    , m_size(0)
+    , m_capacity(INLINE_SIZE)
+    , m_arena(0)
+    , m_heap(false)
+{
+    Write(oth.m_begin, oth.m_size);
+}
+
+Bytes&
+Bytes::operator= (const Bytes& rhs)
+{
+    if (this != &rhs)
+    {
+        setEndian(rhs);
+        clear();
+        Write(rhs.m_begin, rhs.m_size);
+    }
+    return *this;
+}
+
+Bytes::~Bytes()
+{
+    if (m_heap)
+        std::free(m_begin);
+}
+
 void
 Bytes::swap(Bytes& oth)
 {
-    base_vector::swap(*this);
-    EndianState::swap(*this);
+    EndianState::swap(oth);
+
+    // Only malloc'ed storage can be exchanged directly; inline storage
+    // lives in the object and arena storage must stay with its owner.
+    if (m_heap && oth.m_heap)
+    {
+        std::swap(m_begin, oth.m_begin);
+        std::swap(m_size, oth.m_size);
+        std::swap(m_capacity, oth.m_capacity);
+        return;
+    }
+
+    Bytes tmp;
+    tmp.Write(m_begin, m_size);
+    clear();
+    Write(oth.m_begin, oth.m_size);
+    oth.clear();
+    oth.Write(tmp.m_begin, tmp.m_size);
+}
+
+Bytes::reference
+Bytes::at(size_type n)
+{
+    if (n >= m_size)
+        throw std::out_of_range("Bytes::at");
+    return m_begin[n];
+}
+
+Bytes::const_reference
+Bytes::at(size_type n) const
+{
+    if (n >= m_size)
+        throw std::out_of_range("Bytes::at");
+    return m_begin[n];
+}
+
+void
+Bytes::resize(size_type n, value_type v)
+{
+    if (n > m_size)
+        InsertFill(m_size, n-m_size, v);
+    else
+        m_size = n;
+}
+
+Bytes::iterator
+Bytes::erase(iterator first, iterator last)
+{
+    std::memmove(first, last, end()-last);
+    m_size -= last-first;
+    return first;
+}
+
+unsigned char*
+Bytes::Allocate(size_type n, bool* heap)
+{
+    void* p;
+    if (m_arena)
+    {
+        p = m_arena->Allocate(n, 1);
+        *heap = false;
+    }
+    else
+    {
+        p = std::malloc(n);
+        *heap = true;
+    }
+    if (!p)
+        throw std::bad_alloc();
+    return static_cast<unsigned char*>(p);
+}
+
+void
+Bytes::Grow(size_type n)
+{
+    size_type newcap = m_capacity*2;
+    if (newcap < n)
+        newcap = n;
+    bool heap;
+    unsigned char* p = Allocate(newcap, &heap);
+    std::memcpy(p, m_begin, m_size);
+    if (m_heap)
+        std::free(m_begin);
+    m_begin = p;
+    m_capacity = newcap;
+    m_heap = heap;
+}
+
+unsigned char*
+Bytes::InsertSpace(size_type off, size_type n, unsigned char** old)
+{
+    *old = 0;
+    if (m_size+n <= m_capacity)
+    {
+        std::memmove(m_begin+off+n, m_begin+off, m_size-off);
+        m_size += n;
+        return m_begin+off;
+    }
+
+    size_type newcap = m_capacity*2;
+    if (newcap < m_size+n)
+        newcap = m_size+n;
+    bool heap;
+    unsigned char* p = Allocate(newcap, &heap);
+    std::memcpy(p, m_begin, off);
+    std::memcpy(p+off+n, m_begin+off, m_size-off);
+    if (m_heap)
+        *old = m_begin;
+    m_begin = p;
+    m_size += n;
+    m_capacity = newcap;
+    m_heap = heap;
+    return m_begin+off;
 }
 
 void
-Bytes::Write(size_type n, unsigned char v)
+Bytes::InsertFill(size_type off, size_type n, value_type v)
 {
     if (n == 0)
         return;
-    do {
-        push_back(v);
-        n--;
-    } while (n != 0);
+    unsigned char* old;
+    std::memset(InsertSpace(off, n, &old), v, n);
+    if (old)
+        std::free(old);
 }
 
 #ifdef WITH_XML
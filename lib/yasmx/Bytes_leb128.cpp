@@ -34,8 +34,6 @@
 
 using namespace yasm;
 
-static llvm::APInt staticbv(IntNum::BITVECT_NATIVE_SIZE, 0);
-
 static inline uint64_t
 Extract(const llvm::APInt& bv, unsigned int width, unsigned int lsb)
 {
@@ -54,7 +52,7 @@ yasm::WriteLEB128(Bytes& bytes, const IntNum& intn, bool sign)
         return 1;
     }
 
-    const llvm::APInt* bv = intn.getBV(&staticbv);
+    const llvm::APInt* bv = intn.getBV(IntNum::getScratchBV());
     int size;
     if (sign)
         size = bv->getMinSignedBits();
@@ -77,7 +75,7 @@ yasm::SizeLEB128(const IntNum& intn, bool sign)
     if (intn.isZero())
         return 1;
 
-    const llvm::APInt* bv = intn.getBV(&staticbv);
+    const llvm::APInt* bv = intn.getBV(IntNum::getScratchBV());
     if (sign)
         return (bv->getMinSignedBits()+6)/7;
     else
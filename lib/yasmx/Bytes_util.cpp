@@ -37,8 +37,6 @@
 
 using namespace yasm;
 
-static llvm::APInt staticbv(IntNum::BITVECT_NATIVE_SIZE, 0);
-
 void
 yasm::Write8(Bytes& bytes, const IntNum& intn)
 {
@@ -107,7 +105,7 @@ yasm::WriteN(Bytes& bytes, const IntNum& intn, int n)
     }
 
     // harder cases
-    const llvm::APInt* bv = intn.getBV(&staticbv);
+    const llvm::APInt* bv = intn.getBV(IntNum::getScratchBV());
     const uint64_t* words = bv->getRawData();
     unsigned int nwords = bv->getNumWords();
     llvm::APInt tmp;    // must be here so it stays in scope
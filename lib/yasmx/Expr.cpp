@@ -368,6 +368,21 @@ Expr::Cleanup()
     m_terms.erase(erasefrom, m_terms.end());
 }
 
+void
+Expr::Compact()
+{
+    // A fresh copy either fits in the inline storage or grows once from it
+    // (to at least double the inline size).  Only copy if that's smaller.
+    ExprTerms compact;
+    ExprTerms::size_type need = compact.capacity();
+    if (m_terms.size() > need)
+        need = std::max(2*need, m_terms.size());
+    if (need >= m_terms.capacity())
+        return;
+    compact.append(m_terms.begin(), m_terms.end());
+    compact.swap(m_terms);
+}
+
 void
 Expr::ReduceDepth(int pos, int delta)
 {
@@ -34,6 +34,7 @@
 #include "yasmx/Bytes.h"
 #include "yasmx/Expr.h"
 #include "yasmx/IntNum.h"
+#include "yasmx/Object.h"
 #include "yasmx/Value.h"
 
 
@@ -108,6 +109,12 @@ IncbinBytecode::Finalize(Bytecode& bc, Diagnostic& diags)
         return false;
     }
 
+    // The file is read directly rather than through the source manager,
+    // so let the object know about it for dependency tracking.
+    BytecodeContainer* container = bc.getContainer();
+    if (Object* object = container ? container->getObject() : 0)
+        object->AddDependency(m_filename);
+
     if (m_start)
     {
         Value val(0, Expr::Ptr(m_start->clone()));
@@ -33,32 +33,258 @@
 #include <cstring>
 #include <limits>
 
+#include "config.h"
+
 #include "llvm/ADT/SmallString.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/System/ThreadLocal.h"
 #include "yasmx/Basic/Diagnostic.h"
 
 
 using namespace yasm;
 
-/// Static bitvect used for conversions.
-static llvm::APInt conv_bv(IntNum::BITVECT_NATIVE_SIZE, 0);
+namespace {
+/// Bitvects used as intermediate storage for conversions and computation
+/// on bitvector values.  Each thread has its own set, so that separate
+/// assemblies can run in parallel in one process.  Small values never
+/// need them.
+struct ScratchBVs
+{
+    ScratchBVs()
+        : conv_bv(IntNum::BITVECT_NATIVE_SIZE, 0)
+        , result(IntNum::BITVECT_NATIVE_SIZE, 0)
+        , spare(IntNum::BITVECT_NATIVE_SIZE, 0)
+        , op1(IntNum::BITVECT_NATIVE_SIZE, 0)
+        , op2(IntNum::BITVECT_NATIVE_SIZE, 0)
+        , signext_bv(IntNum::BITVECT_NATIVE_SIZE, 0)
+        , user(IntNum::BITVECT_NATIVE_SIZE, 0)
+    {}
+
+    llvm::APInt conv_bv;        ///< conversions
+    llvm::APInt result;         ///< computation
+    llvm::APInt spare;
+    llvm::APInt op1;
+    llvm::APInt op2;
+    llvm::APInt signext_bv;     ///< sign extension
+    llvm::APInt user;           ///< IntNum::getScratchBV()
+};
+} // anonymous namespace
 
-/// Static bitvects used for computation.
-static llvm::APInt result(IntNum::BITVECT_NATIVE_SIZE, 0);
-static llvm::APInt spare(IntNum::BITVECT_NATIVE_SIZE, 0);
-static llvm::APInt op1static(IntNum::BITVECT_NATIVE_SIZE, 0);
-static llvm::APInt op2static(IntNum::BITVECT_NATIVE_SIZE, 0);
+static void
+DeleteScratch(void* scratch)
+{
+    delete static_cast<ScratchBVs*>(scratch);
+}
 
-/// Static bitvect used for sign extension.
-static llvm::APInt signext_bv(IntNum::BITVECT_NATIVE_SIZE, 0);
+// A thread's set is freed when that thread exits.
+static llvm::sys::ThreadLocal<ScratchBVs> scratch_bvs(DeleteScratch);
+
+static ScratchBVs&
+getScratch()
+{
+    ScratchBVs* scratch = scratch_bvs.get();
+    if (!scratch)
+    {
+        scratch = new ScratchBVs;
+        scratch_bvs.set(scratch);
+    }
+    return *scratch;
+}
 
 enum
 {
     SV_BITS = std::numeric_limits<IntNumData::SmallValue>::digits,
+    WV_BITS = 128,      // including sign
     LONG_BITS = std::numeric_limits<long>::digits,
     ULONG_BITS = std::numeric_limits<unsigned long>::digits
 };
 
+typedef IntNumData::WideValue WideValue;
+
+#ifdef HAVE_INT128
+__extension__ typedef __int128 Int128;
+__extension__ typedef unsigned __int128 UInt128;
+
+static inline Int128
+ToInt128(const WideValue& wv)
+{
+    UInt128 v = static_cast<uint64_t>(wv.hi);
+    return static_cast<Int128>((v << 64) | wv.lo);
+}
+
+static inline void
+FromInt128(WideValue* wv, Int128 v)
+{
+    wv->lo = static_cast<uint64_t>(v);
+    wv->hi = static_cast<int64_t>(v >> 64);
+}
+#endif
+
+static inline void
+SetWide(WideValue* wv, int64_t v)
+{
+    wv->lo = static_cast<uint64_t>(v);
+    wv->hi = v >> 63;
+}
+
+static inline bool
+isZeroWide(const WideValue& wv)
+{
+    return wv.lo == 0 && wv.hi == 0;
+}
+
+static inline bool
+isNegativeWide(const WideValue& wv)
+{
+    return wv.hi < 0;
+}
+
+static inline int
+CompareWide(const WideValue& lhs, const WideValue& rhs)
+{
+    if (lhs.hi != rhs.hi)
+        return (lhs.hi < rhs.hi) ? -1 : 1;
+    if (lhs.lo != rhs.lo)
+        return (lhs.lo < rhs.lo) ? -1 : 1;
+    return 0;
+}
+
+/// Number of bits needed to represent a wide value in two's complement,
+/// as APInt::getMinSignedBits().
+static unsigned int
+WideMinSignedBits(const WideValue& wv)
+{
+    uint64_t hi = static_cast<uint64_t>(wv.hi);
+    uint64_t lo = wv.lo;
+    if (isNegativeWide(wv))
+    {
+        hi = ~hi;
+        lo = ~lo;
+    }
+    if (hi != 0)
+        return 129 - llvm::CountLeadingZeros_64(hi);
+    return 65 - llvm::CountLeadingZeros_64(lo);
+}
+
+/// Arithmetic shift right by any amount.
+static void
+ShrWide(WideValue* wv, unsigned int n)
+{
+    int64_t sign = wv->hi >> 63;
+    if (n == 0)
+        return;
+    else if (n >= 128)
+    {
+        wv->lo = static_cast<uint64_t>(sign);
+        wv->hi = sign;
+    }
+    else if (n >= 64)
+    {
+        wv->lo = static_cast<uint64_t>(wv->hi >> (n-64));
+        wv->hi = sign;
+    }
+    else
+    {
+        wv->lo = (wv->lo >> n) | (static_cast<uint64_t>(wv->hi) << (64-n));
+        wv->hi >>= n;
+    }
+}
+
+/// Shift left.  Returns false (and leaves wv unchanged) if the result does
+/// not fit.
+static bool
+ShlWide(WideValue* wv, unsigned int n)
+{
+    if (n == 0 || isZeroWide(*wv))
+        return true;
+    if (WideMinSignedBits(*wv) + n > WV_BITS)
+        return false;
+    if (n >= 64)
+    {
+        wv->hi = static_cast<int64_t>(wv->lo << (n-64));
+        wv->lo = 0;
+    }
+    else
+    {
+        wv->hi = static_cast<int64_t>((static_cast<uint64_t>(wv->hi) << n) |
+                                      (wv->lo >> (64-n)));
+        wv->lo <<= n;
+    }
+    return true;
+}
+
+/// Add.  Returns false (and leaves lhs unchanged) on overflow.
+static bool
+AddWide(WideValue* lhs, const WideValue& rhs)
+{
+    uint64_t lo = lhs->lo + rhs.lo;
+    uint64_t hi = static_cast<uint64_t>(lhs->hi) +
+                  static_cast<uint64_t>(rhs.hi) + (lo < rhs.lo ? 1 : 0);
+    bool neg = static_cast<int64_t>(hi) < 0;
+    if (isNegativeWide(*lhs) == isNegativeWide(rhs) && neg != isNegativeWide(*lhs))
+        return false;
+    lhs->lo = lo;
+    lhs->hi = static_cast<int64_t>(hi);
+    return true;
+}
+
+/// Subtract.  Returns false (and leaves lhs unchanged) on overflow.
+static bool
+SubWide(WideValue* lhs, const WideValue& rhs)
+{
+    uint64_t lo = lhs->lo - rhs.lo;
+    uint64_t hi = static_cast<uint64_t>(lhs->hi) -
+                  static_cast<uint64_t>(rhs.hi) - (lhs->lo < rhs.lo ? 1 : 0);
+    bool neg = static_cast<int64_t>(hi) < 0;
+    if (isNegativeWide(*lhs) != isNegativeWide(rhs) && neg != isNegativeWide(*lhs))
+        return false;
+    lhs->lo = lo;
+    lhs->hi = static_cast<int64_t>(hi);
+    return true;
+}
+
+/// Multiply.  Returns false (and leaves lhs unchanged) if the product might
+/// not fit.
+static bool
+MulWide(WideValue* lhs, const WideValue& rhs)
+{
+    if (WideMinSignedBits(*lhs) + WideMinSignedBits(rhs) > WV_BITS)
+        return false;
+#ifdef HAVE_INT128
+    UInt128 product = static_cast<UInt128>(ToInt128(*lhs)) *
+                      static_cast<UInt128>(ToInt128(rhs));
+    FromInt128(lhs, static_cast<Int128>(product));
+#else
+    // The product fits, so the low 128 bits of the two's complement
+    // product are all that's needed: lo*lo in full, plus the low halves
+    // of the cross terms.
+    uint64_t a0 = lhs->lo & 0xffffffffUL, a1 = lhs->lo >> 32;
+    uint64_t b0 = rhs.lo & 0xffffffffUL, b1 = rhs.lo >> 32;
+    uint64_t p00 = a0*b0, p01 = a0*b1, p10 = a1*b0, p11 = a1*b1;
+    uint64_t mid = (p00 >> 32) + (p01 & 0xffffffffUL) + (p10 & 0xffffffffUL);
+    uint64_t hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+    hi += lhs->lo * static_cast<uint64_t>(rhs.hi);
+    hi += static_cast<uint64_t>(lhs->hi) * rhs.lo;
+    lhs->lo = (mid << 32) | (p00 & 0xffffffffUL);
+    lhs->hi = static_cast<int64_t>(hi);
+#endif
+    return true;
+}
+
+static void
+WideToBV(llvm::APInt* bv, const WideValue& wv)
+{
+    assert(bv->getBitWidth() == IntNum::BITVECT_NATIVE_SIZE &&
+           "bitvector not native size");
+    // APInt can't set its words in place without building a temporary.
+    uint64_t* words = const_cast<uint64_t*>(bv->getRawData());
+    words[0] = wv.lo;
+    words[1] = static_cast<uint64_t>(wv.hi);
+    for (unsigned int i=2; i<bv->getNumWords(); ++i)
+        words[i] = static_cast<uint64_t>(wv.hi >> 63);
+}
+
 bool
 yasm::isOkSize(const llvm::APInt& intn,
                unsigned int size,
@@ -87,15 +313,36 @@ yasm::isOkSize(const llvm::APInt& intn,
     return (intn_size <= (size-rshift));
 }
 
+llvm::APInt*
+IntNum::getScratchBV()
+{
+    return &getScratch().user;
+}
+
 void
 IntNum::setBV(const llvm::APInt& bv)
 {
-    if (bv.getMinSignedBits() <= SV_BITS)
+    unsigned int bits = bv.getMinSignedBits();
+    if (bits <= SV_BITS)
     {
-        if (m_type == INTNUM_BV)
-            delete m_val.bv;
-        m_type = INTNUM_SV;
-        m_val.sv = static_cast<SmallValue>(bv.getSExtValue());
+        // bv may be our own bitvector, so read it before set() frees it
+        set(static_cast<SmallValue>(bv.getSExtValue()));
+        return;
+    }
+    else if (bits <= WV_BITS)
+    {
+        const uint64_t* words = bv.getRawData();
+        unsigned int width = bv.getBitWidth();
+        WideValue wv;
+        wv.lo = words[0];
+        if (width <= 64)
+            wv.hi = bv.isNegative() ? -1 : 0;
+        else if (width < 128)
+            wv.hi = static_cast<int64_t>(words[1] << (128-width)) >>
+                    (128-width);
+        else
+            wv.hi = static_cast<int64_t>(words[1]);
+        setWV(wv);
         return;
     }
     else if (m_type == INTNUM_BV)
@@ -116,7 +363,9 @@ IntNum::getBV(llvm::APInt* bv) const
     if (m_type == INTNUM_BV)
         return m_val.bv;
 
-    if (m_val.sv >= 0)
+    if (m_type == INTNUM_WV)
+        WideToBV(bv, m_val.wv);
+    else if (m_val.sv >= 0)
         *bv = static_cast<USmallValue>(m_val.sv);
     else
     {
@@ -132,7 +381,9 @@ IntNum::getBV(llvm::APInt* bv)
     if (m_type == INTNUM_BV)
         return m_val.bv;
 
-    if (m_val.sv >= 0)
+    if (m_type == INTNUM_WV)
+        WideToBV(bv, m_val.wv);
+    else if (m_val.sv >= 0)
         *bv = static_cast<USmallValue>(m_val.sv);
     else
     {
@@ -142,6 +393,31 @@ IntNum::getBV(llvm::APInt* bv)
     return bv;
 }
 
+void
+IntNum::getWV(WideValue* wv) const
+{
+    assert(m_type != INTNUM_BV && "bitvector in wide value");
+    if (m_type == INTNUM_WV)
+        *wv = m_val.wv;
+    else
+        SetWide(wv, m_val.sv);
+}
+
+void
+IntNum::setWV(const WideValue& wv)
+{
+    // same test as setBV()
+    if (WideMinSignedBits(wv) <= SV_BITS)
+    {
+        set(static_cast<SmallValue>(static_cast<int64_t>(wv.lo)));
+        return;
+    }
+    if (m_type == INTNUM_BV)
+        delete m_val.bv;
+    m_type = INTNUM_WV;
+    m_val.wv = wv;
+}
+
 /// Return the value of the specified hex digit, or -1 if it's not valid.
 static unsigned int
 HexDigitValue(char ch)
@@ -203,15 +479,17 @@ IntNum::setStr(llvm::StringRef str, unsigned int radix)
     }
 
     // long case
+    ScratchBVs& scratch = getScratch();
+    llvm::APInt& conv_bv = scratch.conv_bv;
     conv_bv = 0;
 
     // Figure out if we can shift instead of multiply
     unsigned int shift =
         (radix == 16 ? 4 : radix == 8 ? 3 : radix == 2 ? 1 : 0);
 
-    llvm::APInt& radixval = op1static;
-    llvm::APInt& charval = op2static;
-    llvm::APInt& oldval = spare;
+    llvm::APInt& radixval = scratch.op1;
+    llvm::APInt& charval = scratch.op2;
+    llvm::APInt& oldval = scratch.spare;
 
     radixval = radix;
     oldval = 0;
@@ -260,7 +538,7 @@ IntNum::IntNum(const IntNum& rhs)
     if (rhs.m_type == INTNUM_BV)
         m_val.bv = new llvm::APInt(*rhs.m_val.bv);
     else
-        m_val.sv = rhs.m_val.sv;
+        m_val = rhs.m_val;
 }
 
 // Speedup function for non-bitvect calculations.
@@ -403,6 +681,157 @@ CalcSmallValue(bool* handled,
     return true;
 }
 
+// Speedup function for calculations on values of up to 128 bits, used
+// when CalcSmallValue() can't handle an operation.  Like CalcSmallValue(),
+// falls back to bitvect if this function does not set handled to true.
+static bool
+CalcWideValue(bool* handled,
+              Op::Op op,
+              WideValue* lhs,
+              const WideValue& rhs,
+              SourceLocation source,
+              Diagnostic* diags)
+{
+    *handled = false;
+    switch (op)
+    {
+        case Op::ADD:
+            if (!AddWide(lhs, rhs))
+                return true;
+            break;
+        case Op::SUB:
+            if (!SubWide(lhs, rhs))
+                return true;
+            break;
+        case Op::MUL:
+            if (!MulWide(lhs, rhs))
+                return true;
+            break;
+        case Op::DIV:
+        case Op::MOD:
+            // Unsigned at full bitvector width, so only the same as signed
+            // for non-negative values.
+            if (isNegativeWide(*lhs) || isNegativeWide(rhs))
+                return true;
+        case Op::SIGNDIV:
+        case Op::SIGNMOD:
+        {
+            if (isZeroWide(rhs))
+            {
+                assert(diags && "divide by zero");
+                diags->Report(source, diag::err_divide_by_zero);
+                return false;
+            }
+#ifdef HAVE_INT128
+            // avoid overflow of the most negative value divided by -1
+            if (rhs.hi == -1 && rhs.lo == ~static_cast<uint64_t>(0))
+                return true;
+            Int128 l = ToInt128(*lhs), r = ToInt128(rhs);
+            if (op == Op::DIV || op == Op::SIGNDIV)
+                FromInt128(lhs, l / r);
+            else
+                FromInt128(lhs, l % r);
+            break;
+#else
+            return true;
+#endif
+        }
+        case Op::NEG:
+        {
+            WideValue zero = {0, 0};
+            if (!SubWide(&zero, *lhs))
+                return true;
+            *lhs = zero;
+            break;
+        }
+        case Op::NOT:
+            lhs->lo = ~lhs->lo;
+            lhs->hi = ~lhs->hi;
+            break;
+        case Op::OR:
+            lhs->lo |= rhs.lo;
+            lhs->hi |= rhs.hi;
+            break;
+        case Op::AND:
+            lhs->lo &= rhs.lo;
+            lhs->hi &= rhs.hi;
+            break;
+        case Op::XOR:
+            lhs->lo ^= rhs.lo;
+            lhs->hi ^= rhs.hi;
+            break;
+        case Op::XNOR:
+            lhs->lo = ~(lhs->lo ^ rhs.lo);
+            lhs->hi = ~(lhs->hi ^ rhs.hi);
+            break;
+        case Op::NOR:
+            lhs->lo = ~(lhs->lo | rhs.lo);
+            lhs->hi = ~(lhs->hi | rhs.hi);
+            break;
+        case Op::SHL:
+        case Op::SHR:
+        {
+            // leave huge shift counts to the bitvector calculation
+            int64_t count = static_cast<int64_t>(rhs.lo);
+            if (rhs.hi != (count >> 63) || count < -WV_BITS*2 ||
+                count > WV_BITS*2)
+                return true;
+            if (op == Op::SHR)
+                count = -count;
+            if (count >= 0)
+            {
+                if (!ShlWide(lhs, static_cast<unsigned int>(count)))
+                    return true;
+            }
+            else
+                ShrWide(lhs, static_cast<unsigned int>(-count));
+            break;
+        }
+        case Op::LOR:
+            SetWide(lhs, !isZeroWide(*lhs) || !isZeroWide(rhs));
+            break;
+        case Op::LAND:
+            SetWide(lhs, !isZeroWide(*lhs) && !isZeroWide(rhs));
+            break;
+        case Op::LNOT:
+            SetWide(lhs, isZeroWide(*lhs));
+            break;
+        case Op::LXOR:
+            SetWide(lhs, !isZeroWide(*lhs) ^ !isZeroWide(rhs));
+            break;
+        case Op::LXNOR:
+            SetWide(lhs, !(!isZeroWide(*lhs) ^ !isZeroWide(rhs)));
+            break;
+        case Op::LNOR:
+            SetWide(lhs, !(!isZeroWide(*lhs) || !isZeroWide(rhs)));
+            break;
+        case Op::EQ:
+            SetWide(lhs, CompareWide(*lhs, rhs) == 0);
+            break;
+        case Op::LT:
+            SetWide(lhs, CompareWide(*lhs, rhs) < 0);
+            break;
+        case Op::GT:
+            SetWide(lhs, CompareWide(*lhs, rhs) > 0);
+            break;
+        case Op::LE:
+            SetWide(lhs, CompareWide(*lhs, rhs) <= 0);
+            break;
+        case Op::GE:
+            SetWide(lhs, CompareWide(*lhs, rhs) >= 0);
+            break;
+        case Op::NE:
+            SetWide(lhs, CompareWide(*lhs, rhs) != 0);
+            break;
+        case Op::IDENT:
+            break;
+        default:
+            return true;
+    }
+    *handled = true;
+    return true;
+}
+
 /*@-nullderef -nullpass -branchstate@*/
 bool
 IntNum::CalcImpl(Op::Op op,
@@ -423,12 +852,30 @@ IntNum::CalcImpl(Op::Op op,
             return true;
     }
 
+    if (m_type != INTNUM_BV && (!operand || operand->m_type != INTNUM_BV))
+    {
+        WideValue lhs, rhs = {0, 0};
+        getWV(&lhs);
+        if (operand)
+            operand->getWV(&rhs);
+        bool handled = false;
+        if (!CalcWideValue(&handled, op, &lhs, rhs, source, diags))
+            return false;
+        if (handled)
+        {
+            setWV(lhs);
+            return true;
+        }
+    }
+
     // Always do computations with in full bit vector.
     // Bit vector results must be calculated through intermediate storage.
-    const llvm::APInt* op1 = getBV(&op1static);
+    ScratchBVs& scratch = getScratch();
+    llvm::APInt& result = scratch.result;
+    const llvm::APInt* op1 = getBV(&scratch.op1);
     const llvm::APInt* op2 = 0;
     if (operand)
-        op2 = operand->getBV(&op2static);
+        op2 = operand->getBV(&scratch.op2);
 
     // A operation does a bitvector computation if result is allocated.
     switch (op)
@@ -604,11 +1051,37 @@ IntNum::CalcImpl(Op::Op op,
 void
 IntNum::SignExtend(unsigned int size)
 {
-    // For now, always implement with full bit vector.
-    llvm::APInt* bv = getBV(&signext_bv);
-    bv->trunc(size);
-    bv->sext(BITVECT_NATIVE_SIZE);
-    setBV(*bv);
+    assert(size > 0 && "can't sign extend from zero bits");
+    if (m_type != INTNUM_BV)
+    {
+        // Values of up to 128 bits are already sign extended from any
+        // larger size.
+        if (size >= WV_BITS)
+            return;
+        WideValue wv;
+        getWV(&wv);
+        if (size > 64)
+        {
+            unsigned int shift = WV_BITS - size;
+            wv.hi = static_cast<int64_t>(static_cast<uint64_t>(wv.hi) << shift)
+                    >> shift;
+        }
+        else
+        {
+            unsigned int shift = 64 - size;
+            SetWide(&wv, static_cast<int64_t>(wv.lo << shift) >> shift);
+        }
+        setWV(wv);
+        return;
+    }
+
+    // Otherwise implement with full bit vector.  Work on a copy, as
+    // truncating our own bitvector would leave it the wrong size.
+    llvm::APInt& bv = getScratch().signext_bv;
+    bv = *m_val.bv;
+    bv.trunc(size);
+    bv.sext(BITVECT_NATIVE_SIZE);
+    setBV(bv);
 }
 
 void
@@ -616,23 +1089,13 @@ IntNum::set(IntNum::USmallValue val)
 {
     if (val > static_cast<USmallValue>(std::numeric_limits<SmallValue>::max()))
     {
-        if (m_type == INTNUM_BV)
-            *m_val.bv = val;
-        else
-        {
-            m_val.bv = new llvm::APInt(BITVECT_NATIVE_SIZE, val);
-            m_type = INTNUM_BV;
-        }
+        WideValue wv;
+        wv.lo = val;
+        wv.hi = 0;
+        setWV(wv);
     }
     else
-    {
-        if (m_type == INTNUM_BV)
-        {
-            delete m_val.bv;
-            m_type = INTNUM_SV;
-        }
-        m_val.sv = static_cast<SmallValue>(val);
-    }
+        set(static_cast<SmallValue>(val));
 }
 
 int
@@ -647,6 +1110,15 @@ IntNum::getSign() const
         else
             return 1;
     }
+    else if (m_type == INTNUM_WV)
+    {
+        if (isNegativeWide(m_val.wv))
+            return -1;
+        else if (isZeroWide(m_val.wv))
+            return 0;
+        else
+            return 1;
+    }
     else if (m_val.bv->isNegative())
         return -1;
     else
@@ -663,6 +1135,15 @@ IntNum::getUInt() const
         return static_cast<unsigned long>(m_val.sv);
     }
 
+    if (m_type == INTNUM_WV)
+    {
+        if (isNegativeWide(m_val.wv))
+            return 0;
+        if (m_val.wv.hi != 0 || m_val.wv.lo > ULONG_MAX)
+            return ULONG_MAX;
+        return static_cast<unsigned long>(m_val.wv.lo);
+    }
+
     // Handle bigval
     if (m_val.bv->isNegative())
         return 0;
@@ -683,8 +1164,8 @@ IntNum::getInt() const
         return m_val.sv;
     }
 
-    // since it's a BV, it must be >0x7FFFFFFF or <0x80000000
-    if (m_val.bv->isNegative())
+    // since it's not a SV, it must be >0x7FFFFFFF or <0x80000000
+    if (m_type == INTNUM_WV ? isNegativeWide(m_val.wv) : m_val.bv->isNegative())
         return LONG_MIN;
     return LONG_MAX;
 }
@@ -749,7 +1230,31 @@ IntNum::isOkSize(unsigned int size, unsigned int rshift, int rangetype) const
                 return false;
         }
     }
-    return yasm::isOkSize(*getBV(&conv_bv), size, rshift, rangetype);
+
+    if (m_type == INTNUM_WV)
+    {
+        // Same as the bitvector check, without converting.
+        unsigned int min_signed = WideMinSignedBits(m_val.wv);
+        bool negative = isNegativeWide(m_val.wv);
+        unsigned int intn_size;
+        switch (rangetype)
+        {
+            case 0:
+                intn_size = negative ? BITVECT_NATIVE_SIZE : min_signed-1;
+                break;
+            case 1:
+                intn_size = min_signed;
+                break;
+            case 2:
+                intn_size = negative ? min_signed : min_signed-1;
+                break;
+            default:
+                assert(false && "invalid range type");
+                return false;
+        }
+        return (intn_size <= (size-rshift));
+    }
+    return yasm::isOkSize(*m_val.bv, size, rshift, rangetype);
 }
 
 bool
@@ -767,14 +1272,12 @@ IntNum::operator++()
     if (m_type == INTNUM_SV &&
         m_val.sv < std::numeric_limits<SmallValue>::max())
         ++m_val.sv;
+    else if (m_type == INTNUM_BV)
+        ++(*m_val.bv);
     else
     {
-        if (m_type == INTNUM_SV)
-        {
-            m_val.bv = getBV(new llvm::APInt(BITVECT_NATIVE_SIZE, 0));
-            m_type = INTNUM_BV;
-        }
-        ++(*m_val.bv);
+        IntNum one(1);
+        CalcImpl(Op::ADD, &one, SourceLocation(), 0);
     }
     return *this;
 }
@@ -785,14 +1288,12 @@ IntNum::operator--()
     if (m_type == INTNUM_SV &&
         m_val.sv > std::numeric_limits<SmallValue>::min())
         --m_val.sv;
+    else if (m_type == INTNUM_BV)
+        --(*m_val.bv);
     else
     {
-        if (m_type == INTNUM_SV)
-        {
-            m_val.bv = getBV(new llvm::APInt(BITVECT_NATIVE_SIZE, 0));
-            m_type = INTNUM_BV;
-        }
-        --(*m_val.bv);
+        IntNum one(1);
+        CalcImpl(Op::SUB, &one, SourceLocation(), 0);
     }
     return *this;
 }
@@ -809,8 +1310,17 @@ yasm::Compare(const IntNum& lhs, const IntNum& rhs)
         return 0;
     }
 
-    const llvm::APInt* op1 = lhs.getBV(&op1static);
-    const llvm::APInt* op2 = rhs.getBV(&op2static);
+    if (lhs.m_type != IntNum::INTNUM_BV && rhs.m_type != IntNum::INTNUM_BV)
+    {
+        WideValue lwv, rwv;
+        lhs.getWV(&lwv);
+        rhs.getWV(&rwv);
+        return CompareWide(lwv, rwv);
+    }
+
+    ScratchBVs& scratch = getScratch();
+    const llvm::APInt* op1 = lhs.getBV(&scratch.op1);
+    const llvm::APInt* op2 = rhs.getBV(&scratch.op2);
     if (op1->slt(*op2))
         return -1;
     if (op1->sgt(*op2))
@@ -824,8 +1334,17 @@ yasm::operator==(const IntNum& lhs, const IntNum& rhs)
     if (lhs.m_type == IntNum::INTNUM_SV && rhs.m_type == IntNum::INTNUM_SV)
         return lhs.m_val.sv == rhs.m_val.sv;
 
-    const llvm::APInt* op1 = lhs.getBV(&op1static);
-    const llvm::APInt* op2 = rhs.getBV(&op2static);
+    if (lhs.m_type != IntNum::INTNUM_BV && rhs.m_type != IntNum::INTNUM_BV)
+    {
+        WideValue lwv, rwv;
+        lhs.getWV(&lwv);
+        rhs.getWV(&rwv);
+        return CompareWide(lwv, rwv) == 0;
+    }
+
+    ScratchBVs& scratch = getScratch();
+    const llvm::APInt* op1 = lhs.getBV(&scratch.op1);
+    const llvm::APInt* op2 = rhs.getBV(&scratch.op2);
     return op1->eq(*op2);
 }
 
@@ -835,8 +1354,17 @@ yasm::operator<(const IntNum& lhs, const IntNum& rhs)
     if (lhs.m_type == IntNum::INTNUM_SV && rhs.m_type == IntNum::INTNUM_SV)
         return lhs.m_val.sv < rhs.m_val.sv;
 
-    const llvm::APInt* op1 = lhs.getBV(&op1static);
-    const llvm::APInt* op2 = rhs.getBV(&op2static);
+    if (lhs.m_type != IntNum::INTNUM_BV && rhs.m_type != IntNum::INTNUM_BV)
+    {
+        WideValue lwv, rwv;
+        lhs.getWV(&lwv);
+        rhs.getWV(&rwv);
+        return CompareWide(lwv, rwv) < 0;
+    }
+
+    ScratchBVs& scratch = getScratch();
+    const llvm::APInt* op1 = lhs.getBV(&scratch.op1);
+    const llvm::APInt* op2 = rhs.getBV(&scratch.op2);
     return op1->slt(*op2);
 }
 
@@ -846,8 +1374,17 @@ yasm::operator>(const IntNum& lhs, const IntNum& rhs)
     if (lhs.m_type == IntNum::INTNUM_SV && rhs.m_type == IntNum::INTNUM_SV)
         return lhs.m_val.sv > rhs.m_val.sv;
 
-    const llvm::APInt* op1 = lhs.getBV(&op1static);
-    const llvm::APInt* op2 = rhs.getBV(&op2static);
+    if (lhs.m_type != IntNum::INTNUM_BV && rhs.m_type != IntNum::INTNUM_BV)
+    {
+        WideValue lwv, rwv;
+        lhs.getWV(&lwv);
+        rhs.getWV(&rwv);
+        return CompareWide(lwv, rwv) > 0;
+    }
+
+    ScratchBVs& scratch = getScratch();
+    const llvm::APInt* op1 = lhs.getBV(&scratch.op1);
+    const llvm::APInt* op2 = rhs.getBV(&scratch.op2);
     return op1->sgt(*op2);
 }
 
@@ -856,24 +1393,18 @@ IntNum::getStr(llvm::SmallVectorImpl<char>& str,
                int base,
                bool lowercase) const
 {
-    if (m_type == INTNUM_BV)
+    if (m_type != INTNUM_SV)
     {
-        m_val.bv->toString(str, static_cast<unsigned>(base), true, lowercase);
+        getBV(&getScratch().conv_bv)->toString(str,
+            static_cast<unsigned>(base), true, lowercase);
         return;
     }
 
-    long v = m_val.sv;
-    if (v < 0)
-    {
-        v = -v;
-        str.push_back('-');
-    }
-
-    const char* fmt = "%ld";
+    const char* fmt = "%lu";
     switch (base)
     {
         case 8:     fmt = "%lo"; break;
-        case 10:    fmt = "%ld"; break;
+        case 10:    fmt = "%lu"; break;
         case 16:
             if (lowercase)
                 fmt = "%lx";
@@ -881,14 +1412,21 @@ IntNum::getStr(llvm::SmallVectorImpl<char>& str,
                 fmt = "%lX";
             break;
         default:
-            // fall back to bigval
-            getBV(&conv_bv)->toString(str, static_cast<unsigned>(base), true,
-                                      lowercase);
+            // fall back to bigval; it prints its own sign
+            getBV(&getScratch().conv_bv)->toString(str,
+                static_cast<unsigned>(base), true, lowercase);
             return;
     }
 
+    unsigned long v = static_cast<unsigned long>(m_val.sv);
+    if (m_val.sv < 0)
+    {
+        v = 0-v;
+        str.push_back('-');
+    }
+
     char s[40];
-    std::sprintf(s, fmt, m_val.sv);
+    std::sprintf(s, fmt, v);
     str.append(s, s+std::strlen(s));
 }
 
@@ -912,6 +1450,15 @@ IntNum::Extract(unsigned int width, unsigned int lsb) const
             rv &= ((1UL << width) - 1);
         return rv;
     }
+    else if (m_type == INTNUM_WV)
+    {
+        WideValue wv = m_val.wv;
+        ShrWide(&wv, lsb);
+        unsigned long rv = static_cast<unsigned long>(wv.lo);
+        if (width < ULONG_BITS)
+            rv &= ((1UL << width) - 1);
+        return rv;
+    }
     else
     {
         uint64_t v;
@@ -938,6 +1485,7 @@ IntNum::Print(llvm::raw_ostream& os,
               bool showbase,
               int bits) const
 {
+    llvm::APInt& conv_bv = getScratch().conv_bv;
     const llvm::APInt* bv = getBV(&conv_bv);
 
     if (bv->isNegative())
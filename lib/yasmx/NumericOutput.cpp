@@ -40,8 +40,6 @@
 
 using namespace yasm;
 
-static llvm::APInt staticbv(IntNum::BITVECT_NATIVE_SIZE, 0);
-
 NumericOutput::NumericOutput(Bytes& bytes)
     : m_bytes(bytes)
     , m_size(0)
@@ -176,7 +174,7 @@ NumericOutput::OutputInteger(const IntNum& intn)
 {
     // Handle bigval specially
     if (!intn.isInt())
-        return OutputInteger(*intn.getBV(&staticbv));
+        return OutputInteger(*intn.getBV(IntNum::getScratchBV()));
 
     int destsize = m_bytes.size();
 
@@ -29,15 +29,21 @@
 #include "yasmx/Object.h"
 
 #include <algorithm>
+#include <cstring>
 #include <memory>
 
 #include <boost/pool/pool.hpp>
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/Twine.h"
+#include "llvm/Support/Allocator.h"
 #include "yasmx/Basic/Diagnostic.h"
+#include "yasmx/Basic/DiagnosticBuffer.h"
 #include "yasmx/Config/functional.h"
+#include "yasmx/Support/parallel.h"
+#include "yasmx/Support/ptr_vector.h"
 #include "yasmx/Arch.h"
 #include "yasmx/Bytecode.h"
 #include "yasmx/Optimizer.h"
@@ -71,22 +77,28 @@ public:
         , special_sym_map(true)
         , m_sym_pool(sizeof(Symbol))
     {}
-    ~Impl() {}
-
-    Symbol* NewSymbol(llvm::StringRef name)
+    ~Impl()
     {
-        Symbol* sym = static_cast<Symbol*>(m_sym_pool.malloc());
-        new (sym) Symbol(name);
-        return sym;
+        std::for_each(m_unlisted.begin(), m_unlisted.end(), DestroySymbol);
     }
 
-    void DeleteSymbol(Symbol* sym)
+    static void DestroySymbol(Symbol* sym) { sym->~Symbol(); }
+
+    /// Get uninitialized storage for a symbol.  Memory is released all at
+    /// once when the pool is destroyed.
+    void* AllocSymbol() { return m_sym_pool.malloc(); }
+
+    /// Keep track of a symbol that's not in the ordered symbol list so it
+    /// gets destroyed along with the others.
+    void AddUnlisted(Symbol* sym) { m_unlisted.push_back(sym); }
+
+    /// Copy a symbol name into the name arena.
+    llvm::StringRef InternName(llvm::StringRef name)
     {
-        if (sym)
-        {
-            sym->~Symbol();
-            m_sym_pool.free(sym);
-        }
+        char* copy = static_cast<char*>(m_names.Allocate(name.size()+1, 1));
+        std::memcpy(copy, name.data(), name.size());
+        copy[name.size()] = '\0';
+        return llvm::StringRef(copy, name.size());
     }
 
     typedef hamt<llvm::StringRef, Symbol, SymGetName> SymbolTable;
@@ -101,8 +113,14 @@ public:
     llvm::StringMap<Section*> section_map;
 
 private:
-    /// Pool for symbols not in the symbol table.
+    /// Pool for all symbols (both in and out of the symbol table).
     boost::pool<> m_sym_pool;
+
+    /// Symbols not in Object::m_symbols (non-table and special symbols).
+    std::vector<Symbol*> m_unlisted;
+
+    /// Arena for symbol names.  The symbol tables key off of these.
+    llvm::BumpPtrAllocator m_names;
 };
 } // namespace yasm
 
@@ -113,14 +131,25 @@ Object::Object(llvm::StringRef src_filename,
       m_arch(arch),
       m_cur_section(0),
       m_sections_owner(m_sections),
-      m_symbols_owner(m_symbols),
+      m_extra_output(false),
+      m_num_statements(0),
       m_impl(new Impl(false))
 {
     m_options.DisableGlobalSubRelative = false;
+    m_options.OptimizeLevel = OPTIMIZE_FULL;
+    m_options.RecordStatements = false;
     m_config.ExecStack = false;
     m_config.NoExecStack = false;
 }
 
+void
+Object::AddStatement(SourceLocation source)
+{
+    if (!m_options.RecordStatements || !m_cur_section)
+        return;
+    m_cur_section->AddStatement(source, m_num_statements++);
+}
+
 void
 Object::setSourceFilename(llvm::StringRef src_filename)
 {
@@ -135,6 +164,10 @@ Object::setObjectFilename(llvm::StringRef obj_filename)
 
 Object::~Object()
 {
+    // Symbol memory belongs to the pool; just run the destructors.
+    for (symbol_iterator i=m_symbols.begin(), end=m_symbols.end();
+         i != end; ++i)
+        i->~Symbol();
 }
 
 void
@@ -179,26 +212,29 @@ Object::FindSymbol(llvm::StringRef name)
     return SymbolRef(m_impl->sym_map.Find(name));
 }
 
+Symbol*
+Object::NewSymbol(llvm::StringRef name)
+{
+    void* mem = m_impl->AllocSymbol();
+    return new (mem) Symbol(m_impl->InternName(name),
+                            Symbol::InternedName());
+}
+
 SymbolRef
 Object::getSymbol(llvm::StringRef name)
 {
-    // Don't use pool allocator for symbols in the symbol table.
-    // We have to maintain an ordered link list of all symbols in the symbol
-    // table, so it's easy enough to reuse that for deleting the symbols.
-    // The memory impact of keeping a second linked list (internal to the pool)
-    // seems to outweigh the moderate time savings of pool deletion.
-    std::auto_ptr<Symbol> sym(new Symbol(name));
-    Symbol* sym2 = m_impl->sym_map.Insert(sym.get());
-    if (sym2)
+    // Look up first so existing symbols don't cost an allocation.
+    if (Symbol* sym = m_impl->sym_map.Find(name))
     {
         ++num_exist_symbol;
-        return SymbolRef(sym2);
+        return SymbolRef(sym);
     }
 
     ++num_new_symbol;
-    sym2 = sym.get();
-    m_symbols.push_back(sym.release());
-    return SymbolRef(sym2);
+    Symbol* sym = NewSymbol(name);
+    m_impl->sym_map.Insert(sym);
+    m_symbols.push_back(sym);
+    return SymbolRef(sym);
 }
 
 SymbolRef
@@ -213,7 +249,7 @@ Object::getSymbol(Location loc)
 SymbolRef
 Object::AppendSymbol(llvm::StringRef name)
 {
-    Symbol* sym = new Symbol(name);
+    Symbol* sym = NewSymbol(name);
     m_symbols.push_back(sym);
     return SymbolRef(sym);
 }
@@ -221,7 +257,8 @@ Object::AppendSymbol(llvm::StringRef name)
 SymbolRef
 Object::AddNonTableSymbol(llvm::StringRef name)
 {
-    Symbol* sym = m_impl->NewSymbol(name);
+    Symbol* sym = NewSymbol(name);
+    m_impl->AddUnlisted(sym);
     return SymbolRef(sym);
 }
 
@@ -229,7 +266,7 @@ void
 Object::RenameSymbol(SymbolRef sym, llvm::StringRef name)
 {
     m_impl->sym_map.Remove(sym->getName());
-    sym->m_name = name;
+    sym->setInternedName(m_impl->InternName(name));
     m_impl->sym_map.Insert(sym);
 }
 
@@ -269,8 +306,9 @@ Object::FinalizeSymbols(Diagnostic& diags)
 SymbolRef
 Object::AddSpecialSymbol(llvm::StringRef name)
 {
-    Symbol* sym = m_impl->NewSymbol(name);
+    Symbol* sym = NewSymbol(name);
     m_impl->special_sym_map.Insert(sym);
+    m_impl->AddUnlisted(sym);
     return SymbolRef(sym);
 }
 
@@ -316,42 +354,113 @@ Object::UpdateBytecodeOffsets(Diagnostic& diags)
         sect->UpdateOffsets(diags);
 }
 
-void
-Object::Optimize(Diagnostic& diags)
+namespace {
+typedef std::vector<Section*> SectionList;
+
+/// Optimizer state for a single section when sections are optimized in
+/// parallel.  Diagnostics are buffered and replayed into the main
+/// Diagnostic between steps.
+class SectionOptimizer
 {
-    Optimizer opt(diags);
-    unsigned long bc_index = 0;
+public:
+    SectionOptimizer(Section& sect,
+                     unsigned long bc_index,
+                     Diagnostic& main_diags);
+    ~SectionOptimizer() {}
 
-    // Step 1a
-    for (section_iterator sect=m_sections.begin(), sectend=m_sections.end();
-         sect != sectend; ++sect)
-    {
-        unsigned long offset = 0;
+    Section& m_sect;
+    unsigned long m_bc_index;       // index of first bytecode
+    DiagnosticBuffer m_buffer;
+    Diagnostic m_diags;
+    Optimizer m_opt;
 
-        // Set the offset of the first (empty) bytecode.
-        sect->bytecodes_front().setIndex(bc_index++);
-        sect->bytecodes_front().setOffset(0);
+    // Group leader (lowest index section in group)
+    unsigned long m_leader;
 
-        // Iterate through the remainder, if any.
-        for (Section::bc_iterator bc=sect->bytecodes_begin(),
-             bcend=sect->bytecodes_end(); bc != bcend; ++bc)
-        {
-            bc->setIndex(bc_index++);
-            bc->setOffset(offset);
+    // Sections optimized by m_opt (only set on group leader)
+    SectionList m_group;
 
-            if (bc->CalcLen(TR1::bind(&Optimizer::AddSpan, &opt,
-                                      _1, _2, _3, _4, _5),
-                            diags))
-            {
-                if (bc->getSpecial() == Bytecode::Contents::SPECIAL_OFFSET)
-                    opt.AddOffsetSetter(*bc);
+private:
+    SectionOptimizer(const SectionOptimizer&);                  // not impl
+    const SectionOptimizer& operator=(const SectionOptimizer&); // not impl
+};
 
-                offset = bc->getNextOffset();
-            }
+typedef stdx::ptr_vector<SectionOptimizer> SectionOptimizers;
+} // anonymous namespace
+
+SectionOptimizer::SectionOptimizer(Section& sect,
+                                   unsigned long bc_index,
+                                   Diagnostic& main_diags)
+    : m_sect(sect),
+      m_bc_index(bc_index),
+      m_diags(&m_buffer),
+      m_opt(m_diags),
+      m_leader(0)
+{
+    // The source manager pointer is only stored here; workers never use
+    // it.  System header suppression, its only user, happens on replay.
+    m_diags.setSourceManager(&main_diags.getSourceManager());
+    m_diags.inheritMappings(main_diags);
+}
+
+/// Optimizer step 1a for a single section: set bytecode indexes, initial
+/// offsets, add spans and offset setters.
+static void
+CalcSectionLens(Section& sect,
+                unsigned long* bc_index,
+                Optimizer& opt,
+                Diagnostic& diags)
+{
+    unsigned long offset = 0;
+
+    // Set the offset of the first (empty) bytecode.
+    sect.bytecodes_front().setIndex((*bc_index)++);
+    sect.bytecodes_front().setOffset(0);
+
+    // Iterate through the remainder, if any.
+    for (Section::bc_iterator bc=sect.bytecodes_begin(),
+         bcend=sect.bytecodes_end(); bc != bcend; ++bc)
+    {
+        bc->setIndex((*bc_index)++);
+        bc->setOffset(offset);
+
+        if (bc->CalcLen(TR1::bind(&Optimizer::AddSpan, &opt,
+                                  _1, _2, _3, _4, _5),
+                        diags))
+        {
+            if (bc->getSpecial() == Bytecode::Contents::SPECIAL_OFFSET)
+                opt.AddOffsetSetter(*bc);
+
+            offset = bc->getNextOffset();
         }
     }
+}
 
-    if (diags.hasErrorOccurred())
+/// Maximum number of relaxation passes at Object::OPTIMIZE_BASIC before
+/// falling back to the full optimizer.
+static const unsigned int MAX_RELAX_PASSES = 16;
+
+static void
+UpdateOffsets(const SectionList& sects, Diagnostic& diags)
+{
+    for (SectionList::const_iterator sect=sects.begin(), end=sects.end();
+         sect != end; ++sect)
+        (*sect)->UpdateOffsets(diags);
+}
+
+/// Optimizer steps 1b through 3.
+/// @param opt      optimizer, after step 1a
+/// @param sects    sections containing the bytecodes of opt's spans
+/// @param level    optimization level (see Object::Options)
+/// @param diags    diagnostic reporting
+static void
+FinishOptimize(Optimizer& opt,
+               const SectionList& sects,
+               unsigned int level,
+               Diagnostic& diags)
+{
+    // Without spans, the offsets from step 1a are final.
+    if (!opt.hasSpans())
         return;
 
     // Step 1b
@@ -360,7 +469,7 @@ Object::Optimize(Diagnostic& diags)
         return;
 
     // Step 1c
-    UpdateBytecodeOffsets(diags);
+    UpdateOffsets(sects, diags);
     if (diags.hasErrorOccurred())
         return;
 
@@ -368,6 +477,24 @@ Object::Optimize(Diagnostic& diags)
     if (opt.Step1d())
         return;
 
+    // Bounded relaxation: expand everything over threshold and recompute
+    // all offsets, a few times over.  If that doesn't settle, finish with
+    // the full optimizer.
+    if (level == Object::OPTIMIZE_BASIC)
+    {
+        for (unsigned int pass=0; pass<MAX_RELAX_PASSES; ++pass)
+        {
+            opt.ExpandQueued();
+            if (diags.hasErrorOccurred())
+                return;
+            UpdateOffsets(sects, diags);
+            if (diags.hasErrorOccurred())
+                return;
+            if (opt.Step1d())
+                return;
+        }
+    }
+
     // Step 1e
     opt.Step1e();
     if (diags.hasErrorOccurred())
@@ -379,5 +506,157 @@ Object::Optimize(Diagnostic& diags)
         return;
 
     // Step 3
-    UpdateBytecodeOffsets(diags);
+    UpdateOffsets(sects, diags);
+}
+
+static void
+ParallelCalcLens(SectionOptimizers* sopts, unsigned long i)
+{
+    SectionOptimizer& sopt = (*sopts)[i];
+    unsigned long bc_index = sopt.m_bc_index;
+    CalcSectionLens(sopt.m_sect, &bc_index, sopt.m_opt, sopt.m_diags);
+}
+
+static void
+ParallelCreateTerms(SectionOptimizers* sopts, unsigned long i)
+{
+    (*sopts)[i].m_opt.CreateTerms();
+}
+
+static void
+ParallelFinish(SectionOptimizers* sopts,
+               const std::vector<unsigned long>* leaders,
+               unsigned int level,
+               unsigned long i)
+{
+    SectionOptimizer& sopt = (*sopts)[(*leaders)[i]];
+    FinishOptimize(sopt.m_opt, sopt.m_group, level, sopt.m_diags);
+}
+
+/// Replay buffered diagnostics of all sections into the main Diagnostic.
+/// @return True if an error occurred.
+static bool
+ReplayDiags(SectionOptimizers& sopts, Diagnostic& diags)
+{
+    DiagnosticBuffer all;
+    for (SectionOptimizers::iterator sopt=sopts.begin(), end=sopts.end();
+         sopt != end; ++sopt)
+        all.take(sopt->m_buffer);
+    all.Replay(diags);
+    return diags.hasErrorOccurred();
+}
+
+/// Find the group leader of a section (union-find with path halving).
+static unsigned long
+FindLeader(SectionOptimizers& sopts, unsigned long i)
+{
+    while (sopts[i].m_leader != i)
+    {
+        sopts[i].m_leader = sopts[sopts[i].m_leader].m_leader;
+        i = sopts[i].m_leader;
+    }
+    return i;
+}
+
+void
+Object::Optimize(Diagnostic& diags, unsigned int jobs)
+{
+    if (jobs > 1 && m_sections.size() > 1 && isParallelSupported())
+    {
+        OptimizeParallel(diags, jobs);
+        return;
+    }
+
+    Optimizer opt(diags);
+    unsigned long bc_index = 0;
+
+    // Step 1a
+    SectionList sects;
+    sects.reserve(m_sections.size());
+    for (section_iterator sect=m_sections.begin(), sectend=m_sections.end();
+         sect != sectend; ++sect)
+    {
+        CalcSectionLens(*sect, &bc_index, opt, diags);
+        sects.push_back(&(*sect));
+    }
+
+    if (diags.hasErrorOccurred())
+        return;
+
+    FinishOptimize(opt, sects, m_options.OptimizeLevel, diags);
+}
+
+void
+Object::OptimizeParallel(Diagnostic& diags, unsigned int jobs)
+{
+    // Bytecode indexes are global; number sections up front so each
+    // section can be indexed independently.
+    SectionOptimizers sopts;
+    sopts.reserve(m_sections.size());
+    llvm::DenseMap<const BytecodeContainer*, unsigned long> sect_index;
+    unsigned long bc_index = 0;
+    for (section_iterator sect=m_sections.begin(), sectend=m_sections.end();
+         sect != sectend; ++sect)
+    {
+        sect_index[&(*sect)] = sopts.size();
+        sopts.push_back(new SectionOptimizer(*sect, bc_index, diags));
+        sopts.back().m_leader = sopts.size()-1;
+        // CalcSectionLens() numbers the first bytecode twice.
+        bc_index += 1 + (sect->bytecodes_end() - sect->bytecodes_begin());
+    }
+
+    // Step 1a.  Bytecodes only look at their own section.
+    ParallelFor(sopts.size(), jobs,
+                TR1::bind(&ParallelCalcLens, &sopts, _1));
+    if (ReplayDiags(sopts, diags))
+        return;
+
+    // Split out span terms.  This reads offsets of other sections, so it
+    // can't be combined with step 1a.
+    ParallelFor(sopts.size(), jobs,
+                TR1::bind(&ParallelCreateTerms, &sopts, _1));
+    if (ReplayDiags(sopts, diags))
+        return;
+
+    // Spans can measure distances within other sections (e.g. a length
+    // computed from labels in another section), so they must be optimized
+    // together with that section.  Group linked sections.
+    Optimizer::Links links;
+    for (SectionOptimizers::iterator sopt=sopts.begin(), end=sopts.end();
+         sopt != end; ++sopt)
+        sopt->m_opt.getLinks(&links);
+    for (Optimizer::Links::iterator link=links.begin(), end=links.end();
+         link != end; ++link)
+    {
+        llvm::DenseMap<const BytecodeContainer*, unsigned long>::iterator
+            i = sect_index.find(link->first),
+            j = sect_index.find(link->second);
+        if (i == sect_index.end() || j == sect_index.end())
+            continue;
+        unsigned long a = FindLeader(sopts, i->second);
+        unsigned long b = FindLeader(sopts, j->second);
+        if (a < b)
+            sopts[b].m_leader = a;
+        else if (b < a)
+            sopts[a].m_leader = b;
+    }
+
+    // Merge the optimizers of each group into the optimizer of its first
+    // section, keeping section order.
+    std::vector<unsigned long> leaders;
+    for (unsigned long i=0, end=sopts.size(); i != end; ++i)
+    {
+        unsigned long leader = FindLeader(sopts, i);
+        if (leader == i)
+            leaders.push_back(i);
+        else
+            sopts[leader].m_opt.Merge(sopts[i].m_opt);
+        sopts[leader].m_group.push_back(&sopts[i].m_sect);
+    }
+
+    // Steps 1b through 3, one group at a time.
+    ParallelFor(leaders.size(), jobs,
+                TR1::bind(&ParallelFinish, &sopts, &leaders,
+                          m_options.OptimizeLevel, _1));
+    ReplayDiags(sopts, diags);
 }
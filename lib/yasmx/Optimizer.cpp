@@ -32,9 +32,9 @@
 #include <deque>
 #include <list>
 #include <memory>
+#include <utility>
 #include <vector>
 
-#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/Twine.h"
@@ -42,7 +42,7 @@
 #include "llvm/Support/raw_ostream.h"
 #include "yasmx/Basic/Diagnostic.h"
 #include "yasmx/Config/functional.h"
-#include "yasmx/Support/IntervalTree.h"
+#include "yasmx/Support/StaticIntervalTree.h"
 #include "yasmx/Bytecode.h"
 #include "yasmx/DebugDumper.h"
 #include "yasmx/Expr.h"
@@ -60,6 +60,7 @@ STATISTIC(num_offset_setters, "Number of offset setters");
 STATISTIC(num_recalc, "Number of span recalculations performed");
 STATISTIC(num_expansions, "Number of expansions performed");
 STATISTIC(num_initial_qb, "Number of spans on initial QB");
+STATISTIC(num_cycle_edges, "Number of span dependencies checked for cycles");
 
 using namespace yasm;
 
@@ -238,6 +239,7 @@ public:
 
     bool CreateTerms(Optimizer::Impl* optimize, Diagnostic& diags);
     bool RecalcNormal(Diagnostic& diags);
+    bool HasForwardTerms() const;
 
     std::string getName() const;
 #ifdef WITH_XML
@@ -270,13 +272,15 @@ private:
 
     enum { INACTIVE = 0, ACTIVE, ON_Q } m_active;
 
-    // Spans that led to this span.  Used only for
+    // Node number in the span dependency graph.  Used only for
     // checking for circular references (cycles) with id=0 spans.
-    typedef llvm::SmallPtrSet<Span*, 4> BacktraceSpans;
-    BacktraceSpans m_backtrace;
+    size_t m_cycle_node;
 
     // Index of first offset setter following this span's bytecode
     size_t m_os_index;
+
+    // Set once CreateTerms() has run successfully
+    bool m_have_terms;
 };
 } // anonymous namespace
 
@@ -287,8 +291,13 @@ public:
     Impl(Diagnostic& diags);
     ~Impl();
 
+    bool CreateTerms();
+    void getLinks(Links* links) const;
+    void Merge(Impl& other);
+
     void Step1b();
     bool Step1d();
+    void ExpandQueued();
     void Step1e();
     void Step2();
 
@@ -297,9 +306,11 @@ public:
 #endif // WITH_XML
 
     void ITreeAdd(Span& span, Span::Term& term);
-    void CheckCycle(IntervalTreeNode<Span::Term*> * node,
-                    Span& span);
-    void ExpandTerm(IntervalTreeNode<Span::Term*> * node, long len_diff);
+    void AddCycleEdge(Span::Term* term,
+                      const Span& span,
+                      std::vector<size_t>& edges);
+    void CheckCycles();
+    void ExpandTerm(Span::Term* term, long len_diff);
 
     Diagnostic& m_diags;
 
@@ -309,7 +320,7 @@ public:
     typedef std::deque<Span*> SpanQueue;
     SpanQueue m_QA, m_QB;
 
-    IntervalTree<Span::Term*> m_itree;
+    StaticIntervalTree<Span::Term*> m_itree;
     std::vector<OffsetSetter> m_offset_setters;
 };
 } // namespace yasm
@@ -365,7 +376,9 @@ Span::Span(Bytecode& bc,
       m_pos_thres(pos_thres),
       m_id(id),
       m_active(ACTIVE),
-      m_os_index(os_index)
+      m_cycle_node(0),
+      m_os_index(os_index),
+      m_have_terms(false)
 {
     ++num_spans;
 }
@@ -397,6 +410,9 @@ Span::AddTerm(unsigned int subst, Location loc, Location loc2)
 bool
 Span::CreateTerms(Optimizer::Impl* optimize, Diagnostic& diags)
 {
+    if (m_have_terms)
+        return true;
+
     // Split out sym-sym terms in absolute portion of dependent value
     if (m_depval.hasAbs())
     {
@@ -424,6 +440,7 @@ Span::CreateTerms(Optimizer::Impl* optimize, Diagnostic& diags)
             }
         }
     }
+    m_have_terms = true;
     return true;
 }
 
@@ -466,6 +483,24 @@ Span::RecalcNormal(Diagnostic& diags)
     return (m_new_val < m_neg_thres || m_new_val > m_pos_thres);
 }
 
+// Determine if any term covers this span's bytecode or a later one.
+// If no id<=0 span has such a term, every dependency between id<=0 spans
+// points forward in the bytecode order and no cycle is possible.
+bool
+Span::HasForwardTerms() const
+{
+    long index = static_cast<long>(m_bc.getIndex());
+    for (Terms::const_iterator i=m_span_terms.begin(), end=m_span_terms.end();
+         i != end; ++i)
+    {
+        if ((i->m_loc.bc && static_cast<long>(i->m_loc.bc->getIndex()) > index)
+            || (i->m_loc2.bc &&
+                static_cast<long>(i->m_loc2.bc->getIndex()) > index))
+            return true;
+    }
+    return false;
+}
+
 Span::~Span()
 {
 }
@@ -514,11 +549,6 @@ Span::Write(pugi::xml_node out) const
         case ON_Q:      root.append_attribute("active") = "queued"; break;
     }
 
-    pugi::xml_node backtrace = root.append_child("Backtrace");
-    for (BacktraceSpans::const_iterator i=m_backtrace.begin(),
-         end=m_backtrace.end(); i != end; ++i)
-        (*i)->WriteRef(backtrace);
-
     root.append_attribute("os_index") = static_cast<unsigned long>(m_os_index);
     return root;
 }
@@ -596,6 +626,61 @@ Optimizer::AddOffsetSetter(Bytecode& bc)
     m_impl->m_offset_setters.push_back(OffsetSetter());
 }
 
+bool
+Optimizer::Impl::CreateTerms()
+{
+    bool ok = true;
+    for (Spans::iterator spani=m_spans.begin(), endspan=m_spans.end();
+         spani != endspan; ++spani)
+    {
+        if (!(*spani)->CreateTerms(this, m_diags))
+            ok = false;
+    }
+    return ok;
+}
+
+void
+Optimizer::Impl::getLinks(Links* links) const
+{
+    for (Spans::const_iterator spani=m_spans.begin(), endspan=m_spans.end();
+         spani != endspan; ++spani)
+    {
+        const Span* span = *spani;
+        const BytecodeContainer* container = span->m_bc.getContainer();
+
+        // Both locations of a term are always in the same container.
+        for (Span::Terms::const_iterator term=span->m_span_terms.begin(),
+             endterm=span->m_span_terms.end(); term != endterm; ++term)
+        {
+            if (!term->m_loc.bc)
+                continue;
+            const BytecodeContainer* term_container =
+                term->m_loc.bc->getContainer();
+            if (term_container != container)
+                links->push_back(std::make_pair(container, term_container));
+        }
+    }
+}
+
+void
+Optimizer::Impl::Merge(Impl& other)
+{
+    // Span offset setter indexes are relative to the other vector.  The
+    // placeholder at the end of ours stays in place; it has no bytecode,
+    // so it stops offset setter iteration just like a section change.
+    size_t os_base = m_offset_setters.size();
+    for (Spans::iterator spani=other.m_spans.begin(),
+         endspan=other.m_spans.end(); spani != endspan; ++spani)
+        (*spani)->m_os_index += os_base;
+    m_spans.splice(m_spans.end(), other.m_spans);
+
+    m_offset_setters.insert(m_offset_setters.end(),
+                            other.m_offset_setters.begin(),
+                            other.m_offset_setters.end());
+    other.m_offset_setters.clear();
+    other.m_offset_setters.push_back(OffsetSetter());
+}
+
 void
 Optimizer::Impl::ITreeAdd(Span& span, Span::Term& term)
 {
@@ -631,35 +716,133 @@ Optimizer::Impl::ITreeAdd(Span& span, Span::Term& term)
 }
 
 void
-Optimizer::Impl::CheckCycle(IntervalTreeNode<Span::Term*> * node, Span& span)
+Optimizer::Impl::AddCycleEdge(Span::Term* term,
+                              const Span& span,
+                              std::vector<size_t>& edges)
 {
-    Span::Term* term = node->getData();
     Span* depspan = term->m_span;
 
-    // Only check for cycles in id=0 spans
-    if (depspan->m_id > 0)
+    // Only check for cycles in id=0 spans.  Self-references are caught
+    // by Span::CreateTerms().
+    if (depspan->m_id > 0 || depspan == &span)
         return;
 
-    // Check for a circular reference by looking to see if this dependent
-    // span is in our backtrace.
-    if (span.m_backtrace.count(depspan))
+    edges.push_back(depspan->m_cycle_node);
+    ++num_cycle_edges;
+}
+
+// Find circular references between id<=0 spans.  There's an edge from
+// span S to span D if D has a term whose interval covers S's bytecode,
+// i.e. a change in the length of S changes the value of D.  Every
+// strongly connected component of more than one span is a cycle; it is
+// reported once, at the last of its spans.  Uses an iterative form of
+// Tarjan's algorithm, as dependency chains can be very long.
+void
+Optimizer::Impl::CheckCycles()
+{
+    std::vector<Span*> nodes;
+    bool forward = false;
+    for (Spans::iterator spani=m_spans.begin(), endspan=m_spans.end();
+         spani != endspan; ++spani)
     {
-        m_diags.Report(span.m_bc.getSource(),
-                       diag::err_optimizer_circular_reference);
+        Span* span = *spani;
+        if (span->m_id > 0)
+            continue;
+        span->m_cycle_node = nodes.size();
+        nodes.push_back(span);
+        if (!forward && span->HasForwardTerms())
+            forward = true;
+    }
+    if (!forward)
         return;
+
+    // Build adjacency lists
+    size_t num_nodes = nodes.size();
+    std::vector<size_t> edge_begin;
+    std::vector<size_t> edges;
+    edge_begin.reserve(num_nodes+1);
+    for (size_t n=0; n<num_nodes; ++n)
+    {
+        long index = static_cast<long>(nodes[n]->m_bc.getIndex());
+        edge_begin.push_back(edges.size());
+        m_itree.Enumerate(index, index,
+                          TR1::bind(&Optimizer::Impl::AddCycleEdge, this, _1,
+                                    TR1::cref(*nodes[n]), TR1::ref(edges)));
     }
+    edge_begin.push_back(edges.size());
+
+    const size_t UNVISITED = ~static_cast<size_t>(0);
+    std::vector<size_t> visit_index(num_nodes, UNVISITED);
+    std::vector<size_t> lowlink(num_nodes, 0);
+    std::vector<bool> on_stack(num_nodes, false);
+    std::vector<size_t> scc_stack;
+    // (node, next edge) pairs standing in for the recursive calls
+    std::vector<std::pair<size_t, size_t> > call_stack;
+    size_t next_index = 0;
+
+    for (size_t root=0; root<num_nodes; ++root)
+    {
+        if (visit_index[root] != UNVISITED)
+            continue;
+
+        visit_index[root] = lowlink[root] = next_index++;
+        scc_stack.push_back(root);
+        on_stack[root] = true;
+        call_stack.push_back(std::make_pair(root, edge_begin[root]));
+
+        while (!call_stack.empty())
+        {
+            size_t v = call_stack.back().first;
+            size_t e = call_stack.back().second;
+            if (e < edge_begin[v+1])
+            {
+                ++call_stack.back().second;
+                size_t w = edges[e];
+                if (visit_index[w] == UNVISITED)
+                {
+                    visit_index[w] = lowlink[w] = next_index++;
+                    scc_stack.push_back(w);
+                    on_stack[w] = true;
+                    call_stack.push_back(std::make_pair(w, edge_begin[w]));
+                }
+                else if (on_stack[w])
+                    lowlink[v] = std::min(lowlink[v], visit_index[w]);
+                continue;
+            }
+
+            // All edges of v visited
+            call_stack.pop_back();
+            if (!call_stack.empty())
+            {
+                size_t u = call_stack.back().first;
+                lowlink[u] = std::min(lowlink[u], lowlink[v]);
+            }
+            if (lowlink[v] != visit_index[v])
+                continue;
 
-    // Add our complete backtrace and ourselves to backtrace of dependent
-    // span.
-    depspan->m_backtrace.insert(span.m_backtrace.begin(),
-                                span.m_backtrace.end());
-    depspan->m_backtrace.insert(&span);
+            // v is the root of a strongly connected component; pop it
+            size_t last = v;
+            size_t count = 0;
+            size_t w;
+            do
+            {
+                w = scc_stack.back();
+                scc_stack.pop_back();
+                on_stack[w] = false;
+                last = std::max(last, w);
+                ++count;
+            } while (w != v);
+
+            if (count > 1)
+                m_diags.Report(nodes[last]->m_bc.getSource(),
+                               diag::err_optimizer_circular_reference);
+        }
+    }
 }
 
 void
-Optimizer::Impl::ExpandTerm(IntervalTreeNode<Span::Term*> * node, long len_diff)
+Optimizer::Impl::ExpandTerm(Span::Term* term, long len_diff)
 {
-    Span::Term* term = node->getData();
     Span* span = term->m_span;
     long precbc_index, precbc2_index;
 
@@ -788,6 +971,52 @@ Optimizer::Impl::Step1d()
     return m_QB.empty();
 }
 
+void
+Optimizer::Impl::ExpandQueued()
+{
+    while (!m_QB.empty())
+    {
+        Span* span = m_QB.front();
+        m_QB.pop_front();
+        span->m_active = Span::ACTIVE;  // no longer in Q
+
+        ++num_expansions;
+
+        bool still_depend = false;
+        if (!span->m_bc.Expand(span->m_id, span->m_cur_val, span->m_new_val,
+                               &still_depend, &span->m_neg_thres,
+                               &span->m_pos_thres, m_diags))
+            continue;   // error
+        if (!still_depend)
+        {
+            span->m_active = Span::INACTIVE;
+            continue;
+        }
+
+        // another threshold, keep active
+        for (Span::Terms::iterator term=span->m_span_terms.begin(),
+             endterm=span->m_span_terms.end(); term != endterm; ++term)
+            term->m_cur_val = term->m_new_val;
+        DEBUG(llvm::errs() << "updated " << span->getName()
+              << " curval from " << span->m_cur_val << " to "
+              << span->m_new_val << '\n');
+        span->m_cur_val = span->m_new_val;
+    }
+
+    // Drop finished spans so later passes don't recalculate them.
+    Spans::iterator spani = m_spans.begin();
+    while (spani != m_spans.end())
+    {
+        if ((*spani)->m_active == Span::INACTIVE)
+        {
+            delete *spani;
+            spani = m_spans.erase(spani);
+        }
+        else
+            ++spani;
+    }
+}
+
 void
 Optimizer::Impl::Step1e()
 {
@@ -812,19 +1041,10 @@ Optimizer::Impl::Step1e()
              endterm=span->m_span_terms.end(); term != endterm; ++term)
             ITreeAdd(*span, *term);
     }
+    m_itree.Build();
 
     // Look for cycles in times expansion (span.id==0)
-    for (Spans::iterator spani=m_spans.begin(), endspan=m_spans.end();
-         spani != endspan; ++spani)
-    {
-        Span* span = *spani;
-        if (span->m_id > 0)
-            continue;
-        m_itree.Enumerate(static_cast<long>(span->m_bc.getIndex()),
-                          static_cast<long>(span->m_bc.getIndex()),
-                          TR1::bind(&Optimizer::Impl::CheckCycle, this, _1,
-                                    TR1::ref(*span)));
-    }
+    CheckCycles();
 }
 
 void
@@ -957,6 +1177,24 @@ Optimizer::~Optimizer()
 {
 }
 
+bool
+Optimizer::CreateTerms()
+{
+    return m_impl->CreateTerms();
+}
+
+void
+Optimizer::getLinks(Links* links) const
+{
+    m_impl->getLinks(links);
+}
+
+void
+Optimizer::Merge(Optimizer& oth)
+{
+    m_impl->Merge(*oth.m_impl);
+}
+
 void
 Optimizer::Step1b()
 {
@@ -969,6 +1207,18 @@ Optimizer::Step1d()
     return m_impl->Step1d();
 }
 
+void
+Optimizer::ExpandQueued()
+{
+    m_impl->ExpandQueued();
+}
+
+bool
+Optimizer::hasSpans() const
+{
+    return !m_impl->m_spans.empty();
+}
+
 void
 Optimizer::Step1e()
 {
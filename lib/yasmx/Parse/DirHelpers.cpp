@@ -36,8 +36,6 @@
 
 using namespace yasm;
 
-static llvm::APInt staticbv(IntNum::BITVECT_NATIVE_SIZE, 0);
-
 namespace yasm
 {
 
@@ -143,7 +141,7 @@ yasm::DirIntNumPower2(NameValue& nv,
         return;
     }
 
-    if (!e->getIntNum().getBV(&staticbv)->isPowerOf2())
+    if (!e->getIntNum().getBV(IntNum::getScratchBV())->isPowerOf2())
     {
         diags.Report(nv.getNameSource(), diag::err_value_power2)
             << nv.getValueRange();
@@ -56,6 +56,8 @@ HeaderSearch::HeaderSearch(FileManager &FM) : FileMgr(FM)
 {
   SystemDirIdx = 0;
   NoCurDirSearch = false;
+  TokCache = 0;
+  MissedFiles = 0;
 
 #if 0
   ExternalLookup = 0;
@@ -111,7 +113,7 @@ const FileEntry *DirectoryLookup::LookupFile(llvm::StringRef Filename,
   TmpDir += getDir()->getName();
   TmpDir.push_back('/');
   TmpDir.append(Filename.begin(), Filename.end());
-  return HS.getFileMgr().getFile(TmpDir.begin(), TmpDir.end());
+  return HS.getFile(TmpDir.str());
 }
 
 
@@ -140,7 +142,7 @@ HeaderSearch::LookupFile(llvm::StringRef Filename,
     if (FromDir) return 0;
 
     // Otherwise, just return the file.
-    return FileMgr.getFile(Filename);
+    return getFile(Filename);
   }
 
   // Step #0, unless disabled, check to see if the file is in the #includer's
@@ -155,7 +157,7 @@ HeaderSearch::LookupFile(llvm::StringRef Filename,
     TmpDir += CurFileEnt->getDir()->getName();
     TmpDir.push_back('/');
     TmpDir.append(Filename.begin(), Filename.end());
-    if (const FileEntry *FE = FileMgr.getFile(TmpDir.str())) {
+    if (const FileEntry *FE = getFile(TmpDir.str())) {
       // Leave CurDir unset.
       return FE;
     }
@@ -209,6 +211,26 @@ HeaderSearch::LookupFile(llvm::StringRef Filename,
   return 0;
 }
 
+void HeaderSearch::AddUserSearchPaths(const std::vector<std::string> &Dirs)
+{
+  for (std::vector<std::string>::const_iterator i = Dirs.begin(),
+       e = Dirs.end(); i != e; ++i) {
+    if (const DirectoryEntry *DE = FileMgr.getDirectory(*i))
+      SearchDirs.push_back(DirectoryLookup(DE, true));
+    else if (MissedFiles)
+      MissedFiles->push_back(*i);
+  }
+  SystemDirIdx = SearchDirs.size();
+}
+
+const FileEntry *HeaderSearch::getFile(llvm::StringRef Path)
+{
+  const FileEntry *FE = FileMgr.getFile(Path);
+  if (!FE && MissedFiles)
+    MissedFiles->push_back(Path.str());
+  return FE;
+}
+
 //===----------------------------------------------------------------------===//
 // File Info Management.
 //===----------------------------------------------------------------------===//
@@ -35,6 +35,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "yasmx/Basic/Diagnostic.h"
 #include "yasmx/Parse/Preprocessor.h"
+#include "yasmx/Parse/TokenCache.h"
 
 
 using namespace yasm;
@@ -63,6 +64,9 @@ Lexer::InitLexer(const char* start, const char* ptr, const char* end)
     // expansion).  It is used to quickly lex the tokens of the buffer, e.g.
     // when handling a "%if 0" block or otherwise skipping over tokens.
     m_lexing_raw_mode = false;
+
+    // Not recording tokens for the token cache.
+    m_recorder = 0;
 }
 
 Lexer::Lexer(FileID fid,
@@ -102,6 +106,7 @@ Lexer::Lexer(FileID fid,
 
 Lexer::~Lexer()
 {
+    delete m_recorder;
 }
 
 #if 0
@@ -148,6 +153,9 @@ Lexer::getSourceLocation(const char* loc, unsigned int tok_len) const
 DiagnosticBuilder
 Lexer::Diag(const char* loc, unsigned diag_id) const
 {
+    // Replayed tokens wouldn't report this again.
+    if (m_recorder)
+        m_recorder->Discard();
     return m_preproc->Diag(getSourceLocation(loc), diag_id);
 }
 
@@ -16,6 +16,7 @@
 #include "yasmx/Basic/SourceManager.h"
 #include "yasmx/Parse/HeaderSearch.h"
 #include "yasmx/Parse/Preprocessor.h"
+#include "yasmx/Parse/TokenCache.h"
 
 using namespace yasm;
 
@@ -72,9 +73,43 @@ Preprocessor::EnterSourceFile(FileID FID,
         return;
     }
 
+    // Replay or record included files with the token cache.  Main files
+    // usually change too often to be worth caching.
+    TokenCache* Cache = m_header_info.getTokenCache();
+    const FileEntry* File = m_source_mgr.getFileEntryForID(FID);
+    llvm::StringRef CacheName = getTokenCacheName();
+    if (Cache && File && !CacheName.empty() &&
+        (IsFileLexer() || !m_include_macro_stack.empty()))
+    {
+        if (const TokenFile* Toks = Cache->Lookup(*File, CacheName))
+        {
+            EnterSourceFileWithLexer(new CachedLexer(FID, InputFile, *this,
+                                                     *Toks),
+                                     CurDir);
+            return;
+        }
+        Lexer* L = CreateLexer(FID, InputFile);
+        L->m_recorder = Cache->StartRecording(*File, CacheName);
+        EnterSourceFileWithLexer(L, CurDir);
+        return;
+    }
+
     EnterSourceFileWithLexer(CreateLexer(FID, InputFile), CurDir);
 }
 
+/// RecordingLex - Lex a token from the current file lexer and record it for
+/// the token cache.  If the lexer hits the end of its file, the token comes
+/// from another lexer (which records it itself, if needed).
+void
+Preprocessor::RecordingLex(Token* Result)
+{
+    Lexer* L = m_cur_lexer.get();
+    TokenRecorder* Recorder = L->m_recorder;
+    L->Lex(Result);
+    if (m_cur_lexer.get() == L)
+        Recorder->Record(*Result, L->m_file_loc);
+}
+
 void Preprocessor::EnterSourceFileWithLexer(Lexer* lexer,
                                             const DirectoryLookup* cur_dir)
 {
@@ -101,7 +136,8 @@ void
 Preprocessor::EnterTokenStream(const Token* toks,
                                unsigned int num_toks,
                                bool disable_macro_expansion,
-                               bool owns_tokens)
+                               bool owns_tokens,
+                               unsigned long repeat_count)
 {
     // Save our current state.
     PushIncludeMacroStack();
@@ -112,13 +148,14 @@ Preprocessor::EnterTokenStream(const Token* toks,
     {
         m_cur_token_lexer.reset(new TokenLexer(toks, num_toks,
                                                disable_macro_expansion,
-                                               owns_tokens, *this));
+                                               owns_tokens, *this,
+                                               repeat_count));
     }
     else
     {
         m_cur_token_lexer.reset(m_token_lexer_cache[--m_num_cached_token_lexers]);
         m_cur_token_lexer->Init(toks, num_toks, disable_macro_expansion,
-                                owns_tokens);
+                                owns_tokens, repeat_count);
     }
 }
 
@@ -131,6 +168,10 @@ Preprocessor::HandleEndOfFile(Token* Result, bool isEndOfMacro)
     assert(!m_cur_token_lexer &&
            "Ending a file when currently in a macro!");
 
+    // The whole file has been lexed; store its tokens in the token cache.
+    if (m_cur_lexer && m_cur_lexer->m_recorder)
+        m_cur_lexer->m_recorder->Write();
+
     // If this is a #include'd file, pop it off the include stack and continue
     // lexing the #includer file.
     if (!m_include_macro_stack.empty())
@@ -100,6 +100,12 @@ Preprocessor::RegisterBuiltinMacros()
 {
 }
 
+llvm::StringRef
+Preprocessor::getTokenCacheName() const
+{
+    return llvm::StringRef();
+}
+
 std::string
 Preprocessor::getSpelling(const Token& tok) const
 {
@@ -0,0 +1,368 @@
+//
+// Pre-tokenized include file cache
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include "yasmx/Parse/TokenCache.h"
+
+#include <cstring>
+
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/System/Path.h"
+#include "yasmx/Basic/FileManager.h"
+#include "yasmx/Parse/IdentifierTable.h"
+#include "yasmx/Parse/Preprocessor.h"
+
+
+using namespace yasm;
+
+namespace {
+/// Token file header.  The file is written in host byte order; a file
+/// written on a host with a different byte order fails the byte order
+/// check and is simply replaced.
+///
+/// The header is followed by num_tokens TokenFile::Entry structures,
+/// num_idents (offset, length) pairs of uint32_t into the names, and
+/// names_size bytes of identifier names.
+struct Header
+{
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t num_tokens;
+    uint32_t num_idents;
+    uint32_t names_size;
+    uint64_t source_size;
+};
+} // anonymous namespace
+
+/// Bump the version when the format or any lexer's token kinds change.
+static const char TOKEN_MAGIC[8] = {'y','a','s','m','t','o','k','1'};
+static const uint32_t TOKEN_BYTE_ORDER = 0x01020304;
+
+TokenFile::TokenFile(llvm::MemoryBuffer* buf)
+    : m_buf(buf)
+{
+}
+
+TokenFile::~TokenFile()
+{
+    delete m_buf;
+}
+
+TokenFile*
+TokenFile::Create(llvm::MemoryBuffer* buf, uint64_t source_size)
+{
+    llvm::OwningPtr<TokenFile> toks(new TokenFile(buf));
+
+    const char* start = buf->getBufferStart();
+    uint64_t size = buf->getBufferSize();
+    if (size < sizeof(Header) ||
+        reinterpret_cast<uintptr_t>(start) % sizeof(uint32_t) != 0)
+        return 0;
+
+    Header hdr;
+    std::memcpy(&hdr, start, sizeof(hdr));
+    if (std::memcmp(hdr.magic, TOKEN_MAGIC, sizeof(TOKEN_MAGIC)) != 0 ||
+        hdr.byte_order != TOKEN_BYTE_ORDER || hdr.source_size != source_size)
+        return 0;
+
+    uint64_t idents_start = sizeof(Header) +
+        static_cast<uint64_t>(hdr.num_tokens) * sizeof(Entry);
+    uint64_t names_start = idents_start +
+        static_cast<uint64_t>(hdr.num_idents) * 2 * sizeof(uint32_t);
+    if (names_start + hdr.names_size != size)
+        return 0;
+
+    toks->m_tokens = reinterpret_cast<const Entry*>(start + sizeof(Header));
+    toks->m_idents = reinterpret_cast<const uint32_t*>(start + idents_start);
+    toks->m_names = start + names_start;
+    toks->m_num_tokens = hdr.num_tokens;
+    toks->m_num_idents = hdr.num_idents;
+
+    // Check everything up front so replaying never reads out of bounds.
+    for (unsigned int i=0; i<toks->m_num_idents; ++i)
+    {
+        uint64_t end = static_cast<uint64_t>(toks->m_idents[2*i]) +
+                       toks->m_idents[2*i+1];
+        if (end > hdr.names_size)
+            return 0;
+    }
+    for (unsigned int i=0; i<toks->m_num_tokens; ++i)
+    {
+        const Entry& tok = toks->m_tokens[i];
+        if (static_cast<uint64_t>(tok.offset) + tok.length > source_size ||
+            (tok.ident != NO_IDENT && tok.ident >= toks->m_num_idents))
+            return 0;
+    }
+    return toks.take();
+}
+
+llvm::StringRef
+TokenFile::getIdentifier(unsigned int i) const
+{
+    return llvm::StringRef(m_names + m_idents[2*i], m_idents[2*i+1]);
+}
+
+TokenRecorder::TokenRecorder(llvm::StringRef path, uint64_t source_size)
+    : m_path(path)
+    , m_source_size(source_size)
+    , m_discarded(source_size > 0xffffffffU)
+{
+}
+
+TokenRecorder::~TokenRecorder()
+{
+}
+
+void
+TokenRecorder::Record(const Token& tok, SourceLocation file_loc)
+{
+    TokenFile::Entry entry;
+    entry.offset = tok.getLocation().getRawEncoding() -
+                   file_loc.getRawEncoding();
+    entry.length = tok.getLength();
+    entry.kind = static_cast<uint16_t>(tok.getKind());
+    entry.flags = static_cast<uint8_t>(tok.getFlags());
+    entry.unused = 0;
+    entry.ident = TokenFile::NO_IDENT;
+    if (const IdentifierInfo* ii = tok.getIdentifierInfo())
+    {
+        std::pair<llvm::DenseMap<const IdentifierInfo*, uint32_t>::iterator,
+                  bool> ins = m_ident_index.insert(
+                      std::make_pair(ii, static_cast<uint32_t>(
+                          m_idents.size())));
+        if (ins.second)
+            m_idents.push_back(ii);
+        entry.ident = ins.first->second;
+    }
+    m_tokens.push_back(entry);
+}
+
+void
+TokenRecorder::Write()
+{
+    if (m_discarded)
+        return;
+
+    Header hdr;
+    std::memcpy(hdr.magic, TOKEN_MAGIC, sizeof(TOKEN_MAGIC));
+    hdr.byte_order = TOKEN_BYTE_ORDER;
+    hdr.num_tokens = static_cast<uint32_t>(m_tokens.size());
+    hdr.num_idents = static_cast<uint32_t>(m_idents.size());
+    hdr.names_size = 0;
+    hdr.source_size = m_source_size;
+
+    std::vector<uint32_t> idents;
+    idents.reserve(2*m_idents.size());
+    for (std::vector<const IdentifierInfo*>::const_iterator
+         i=m_idents.begin(), end=m_idents.end(); i != end; ++i)
+    {
+        idents.push_back(hdr.names_size);
+        idents.push_back((*i)->getLength());
+        hdr.names_size += (*i)->getLength();
+    }
+
+    // The cache is only an optimization, so failing to write it isn't
+    // an error.
+    std::string err;
+    llvm::sys::Path dir(m_path);
+    dir.eraseComponent();
+    if (dir.createDirectoryOnDisk(true, &err))
+        return;
+
+    // Write to a temporary file, then atomically move it into place.
+    llvm::sys::Path tmp(m_path + ".tmp");
+    if (tmp.makeUnique(false, &err))
+        return;
+    {
+        llvm::raw_fd_ostream os(tmp.c_str(), err,
+                                llvm::raw_fd_ostream::F_Binary);
+        if (!err.empty())
+            return;
+        os.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+        if (!m_tokens.empty())
+            os.write(reinterpret_cast<const char*>(&m_tokens[0]),
+                     m_tokens.size() * sizeof(TokenFile::Entry));
+        if (!idents.empty())
+            os.write(reinterpret_cast<const char*>(&idents[0]),
+                     idents.size() * sizeof(uint32_t));
+        for (std::vector<const IdentifierInfo*>::const_iterator
+             i=m_idents.begin(), end=m_idents.end(); i != end; ++i)
+            os << (*i)->getName();
+        os.close();
+        if (os.has_error())
+        {
+            os.clear_error();
+            tmp.eraseFromDisk();
+            return;
+        }
+    }
+
+    if (tmp.renamePathOnDisk(llvm::sys::Path(m_path), &err))
+        tmp.eraseFromDisk();
+}
+
+TokenCache::TokenCache(llvm::StringRef dir)
+{
+    // Keep working if the current directory changes (e.g. server mode).
+    llvm::sys::Path path(dir);
+    if (!path.isAbsolute())
+    {
+        path = llvm::sys::Path::GetCurrentDirectory();
+        path.appendComponent(dir);
+    }
+    m_dir = path.str();
+    AddKey(llvm::StringRef(TOKEN_MAGIC, sizeof(TOKEN_MAGIC)));
+}
+
+TokenCache::~TokenCache()
+{
+    for (llvm::StringMap<TokenFile*>::iterator i=m_files.begin(),
+         end=m_files.end(); i != end; ++i)
+        delete i->getValue();
+}
+
+void
+TokenCache::AddKey(llvm::StringRef data)
+{
+    m_key.Update(reinterpret_cast<const unsigned char*>(data.data()),
+                 static_cast<unsigned long>(data.size()));
+    // separate from the next piece of data
+    static const unsigned char sep = 0;
+    m_key.Update(&sep, 1);
+}
+
+std::string
+TokenCache::getPath(const FileEntry& file, llvm::StringRef lexer) const
+{
+    llvm::sys::Path source(file.getName());
+    if (!source.isAbsolute())
+    {
+        source = llvm::sys::Path::GetCurrentDirectory();
+        source.appendComponent(file.getName());
+    }
+
+    std::string key;
+    llvm::raw_string_ostream oss(key);
+    oss << lexer << '\0' << source.str() << '\0'
+        << static_cast<unsigned long long>(file.getDevice()) << ' '
+        << static_cast<unsigned long long>(file.getInode()) << ' '
+        << static_cast<unsigned long long>(file.getSize()) << ' '
+        << static_cast<long long>(file.getModificationTime());
+    oss.flush();
+
+    MD5 md5 = m_key;
+    md5.Update(reinterpret_cast<const unsigned char*>(key.data()),
+               static_cast<unsigned long>(key.size()));
+    unsigned char digest[16];
+    md5.Final(digest);
+
+    static const char hexdig[] = "0123456789abcdef";
+    std::string name;
+    name.reserve(36);
+    for (int i=0; i<16; ++i)
+    {
+        name += hexdig[digest[i] >> 4];
+        name += hexdig[digest[i] & 0xf];
+    }
+    name += ".tok";
+
+    llvm::sys::Path path(m_dir);
+    path.appendComponent(name);
+    return path.str();
+}
+
+const TokenFile*
+TokenCache::Lookup(const FileEntry& file, llvm::StringRef lexer)
+{
+    std::string path = getPath(file, lexer);
+    llvm::StringMap<TokenFile*>::iterator i = m_files.find(path);
+    if (i != m_files.end())
+        return i->getValue();
+
+    llvm::MemoryBuffer* buf = llvm::MemoryBuffer::getFile(path);
+    if (!buf)
+        return 0;
+    TokenFile* toks = TokenFile::Create(buf, file.getSize());
+    if (!toks)
+        return 0;
+    m_files[path] = toks;
+    return toks;
+}
+
+TokenRecorder*
+TokenCache::StartRecording(const FileEntry& file, llvm::StringRef lexer)
+{
+    return new TokenRecorder(getPath(file, lexer), file.getSize());
+}
+
+CachedLexer::CachedLexer(FileID fid,
+                         const llvm::MemoryBuffer* input_buffer,
+                         Preprocessor& pp,
+                         const TokenFile& toks)
+    : Lexer(fid, input_buffer, pp)
+    , m_toks(toks)
+    , m_next(0)
+    , m_idents(toks.getNumIdentifiers(), 0)
+{
+}
+
+CachedLexer::~CachedLexer()
+{
+}
+
+void
+CachedLexer::LexTokenInternal(Token* result)
+{
+    if (m_next == m_toks.getNumTokens())
+    {
+        // Read the PP instance variable into an automatic variable, because
+        // LexEndOfFile will often delete 'this'.
+        Preprocessor* PPCache = m_preproc;
+        if (LexEndOfFile(result, m_buf_end))
+            return;   // Got a token to return.
+        return PPCache->Lex(result);
+    }
+
+    const TokenFile::Entry& tok = m_toks.getToken(m_next++);
+    const char* tok_start = m_buf_start + tok.offset;
+
+    // Lex() set StartOfLine from our own state; use the recorded flags.
+    result->clearFlag(Token::StartOfLine);
+    result->setFlag(static_cast<Token::TokenFlags>(tok.flags));
+    m_buf_ptr = tok_start;
+    FormTokenWithChars(result, tok_start + tok.length, tok.kind);
+
+    if (result->isLiteral())
+        result->setLiteralData(tok_start);
+    else if (tok.ident != TokenFile::NO_IDENT)
+    {
+        IdentifierInfo*& ii = m_idents[tok.ident];
+        if (!ii)
+            ii = m_preproc->getIdentifierInfo(m_toks.getIdentifier(tok.ident));
+        result->setIdentifierInfo(ii);
+    }
+}
@@ -72,6 +72,13 @@ Section::AddReloc(std::auto_ptr<Reloc> reloc)
     m_relocs.push_back(reloc.release());
 }
 
+void
+Section::AddStatement(SourceLocation source, unsigned long index)
+{
+    Statement stmt = { getEndLoc(), source, index };
+    m_statements.push_back(stmt);
+}
+
 #ifdef WITH_XML
 pugi::xml_node
 Section::Write(pugi::xml_node out) const
@@ -24,13 +24,59 @@
 /// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 /// POSSIBILITY OF SUCH DAMAGE.
 
+#define DEBUG_TYPE "StringTable"
+
 #include "yasmx/StringTable.h"
 
+#include <algorithm>
+#include <cassert>
+
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Support/raw_ostream.h"
 
 
+STATISTIC(num_strings_reused, "Number of duplicate strings reused");
+STATISTIC(num_strings_tail_merged, "Number of strings tail-merged");
+
 using namespace yasm;
 
+namespace {
+struct MergeEntry
+{
+    llvm::StringMapEntry<unsigned long>* entry;
+    const MergeEntry* host;     // longer string containing this one as a tail
+    unsigned long new_offset;
+};
+
+// Orders by reversed string contents, with longer strings ahead of their
+// tail substrings, so every tail immediately follows a string containing it.
+struct TailOrder
+{
+    bool operator() (const MergeEntry* lhs, const MergeEntry* rhs) const
+    {
+        llvm::StringRef a = lhs->entry->getKey();
+        llvm::StringRef b = rhs->entry->getKey();
+        size_t i = a.size(), j = b.size();
+        while (i > 0 && j > 0)
+        {
+            --i; --j;
+            unsigned char ca = a[i], cb = b[j];
+            if (ca != cb)
+                return ca < cb;
+        }
+        return i > j;
+    }
+};
+
+struct OldOffsetOrder
+{
+    bool operator() (const MergeEntry* lhs, const MergeEntry* rhs) const
+    {
+        return lhs->entry->getValue() < rhs->entry->getValue();
+    }
+};
+} // anonymous namespace
+
 StringTable::StringTable(unsigned long first_index)
     : m_first_index(first_index)
 {
@@ -44,12 +90,101 @@ StringTable::~StringTable()
 unsigned long
 StringTable::getIndex(llvm::StringRef str)
 {
+    if (str.empty())
+        return m_first_index;   // leading 0 byte
+
+    llvm::StringMapEntry<unsigned long>& entry =
+        m_offsets.GetOrCreateValue(str, 0);
+    if (entry.getValue() != 0)
+    {
+        ++num_strings_reused;
+        return m_first_index+entry.getValue();
+    }
+
     unsigned long end = m_storage.size();
     m_storage.insert(m_storage.end(), str.begin(), str.end());
     m_storage.push_back('\0');
+    entry.setValue(end);
     return m_first_index+end;
 }
 
+void
+StringTable::MergeTails()
+{
+    std::vector<MergeEntry> entries;
+    entries.reserve(m_offsets.size());
+    for (llvm::StringMap<unsigned long>::iterator i=m_offsets.begin(),
+         end=m_offsets.end(); i != end; ++i)
+    {
+        MergeEntry e = {&*i, 0, 0};
+        entries.push_back(e);
+    }
+
+    std::vector<MergeEntry*> order;
+    order.reserve(entries.size());
+    for (std::vector<MergeEntry>::iterator i=entries.begin(),
+         end=entries.end(); i != end; ++i)
+        order.push_back(&*i);
+
+    // Find the host string for each tail substring.
+    std::sort(order.begin(), order.end(), TailOrder());
+    const MergeEntry* host = 0;
+    for (std::vector<MergeEntry*>::iterator i=order.begin(), end=order.end();
+         i != end; ++i)
+    {
+        if (host && host->entry->getKey().endswith((*i)->entry->getKey()))
+        {
+            (*i)->host = host;
+            ++num_strings_tail_merged;
+        }
+        else
+            host = *i;
+    }
+
+    // Rebuild storage with host strings in their original order.
+    std::sort(order.begin(), order.end(), OldOffsetOrder());
+    std::vector<char> storage;
+    storage.reserve(m_storage.size());
+    storage.push_back('\0');
+    for (std::vector<MergeEntry*>::iterator i=order.begin(), end=order.end();
+         i != end; ++i)
+    {
+        if ((*i)->host)
+            continue;
+        llvm::StringRef str = (*i)->entry->getKey();
+        (*i)->new_offset = storage.size();
+        storage.insert(storage.end(), str.begin(), str.end());
+        storage.push_back('\0');
+    }
+    m_storage.swap(storage);
+
+    // Record old to new offsets and update the lookup table.
+    m_remap.clear();
+    m_remap.reserve(order.size()+1);
+    m_remap.push_back(std::make_pair(0UL, 0UL));
+    for (std::vector<MergeEntry*>::iterator i=order.begin(), end=order.end();
+         i != end; ++i)
+    {
+        MergeEntry* e = *i;
+        if (e->host)
+            e->new_offset = e->host->new_offset +
+                e->host->entry->getKeyLength() - e->entry->getKeyLength();
+        m_remap.push_back(std::make_pair(e->entry->getValue(), e->new_offset));
+        e->entry->setValue(e->new_offset);
+    }
+}
+
+unsigned long
+StringTable::getMergedIndex(unsigned long index) const
+{
+    std::pair<unsigned long, unsigned long> key(index-m_first_index, 0);
+    std::vector<std::pair<unsigned long, unsigned long> >::const_iterator i =
+        std::lower_bound(m_remap.begin(), m_remap.end(), key);
+    assert(i != m_remap.end() && i->first == key.first &&
+           "index not issued before MergeTails");
+    return m_first_index+i->second;
+}
+
 llvm::StringRef
 StringTable::getString(unsigned long index) const
 {
@@ -67,4 +202,6 @@ StringTable::Read(const unsigned char* buf, unsigned long size)
 {
     m_storage.clear();
     m_storage.insert(m_storage.end(), buf, buf+size);
+    m_offsets.clear();
+    m_remap.clear();
 }
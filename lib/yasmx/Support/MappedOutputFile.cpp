@@ -0,0 +1,148 @@
+//
+// Memory-mapped output file
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include "yasmx/Support/MappedOutputFile.h"
+
+#include "llvm/Config/config.h"
+#include "llvm/Support/raw_ostream.h"
+
+#if defined(LLVM_ON_WIN32)
+#define YASM_MAPPED_WIN32 1
+#include <windows.h>
+#include <io.h>
+#elif defined(HAVE_SYS_MMAN_H) && defined(HAVE_UNISTD_H)
+#define YASM_MAPPED_POSIX 1
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+
+using namespace yasm;
+
+MappedOutputFile::MappedOutputFile(llvm::raw_fd_ostream& os)
+    : m_os(os), m_data(0), m_size(0), m_mapped(false), m_handle(0)
+{
+}
+
+MappedOutputFile::~MappedOutputFile()
+{
+    Unmap();
+}
+
+bool
+MappedOutputFile::Map(unsigned long size)
+{
+    Unmap();
+
+    // Nothing to map; let the caller use the stream.
+    if (size == 0)
+        return false;
+
+    // Anything already buffered must reach the file before it's resized.
+    m_os.flush();
+    if (m_os.has_error())
+        return false;
+
+    int fd = m_os.getFD();
+#if defined(YASM_MAPPED_POSIX)
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+        return false;
+    if (static_cast<unsigned long>(static_cast<off_t>(size)) != size ||
+        ftruncate(fd, static_cast<off_t>(size)) != 0)
+        return false;
+    // The file now has its final size, so a caller falling back to the
+    // stream after any failure below still produces the same file.
+#if defined(HAVE_POSIX_FALLOCATE)
+    // Reserve the blocks up front; running out of space while writing
+    // through the mapping would raise SIGBUS instead of an error.
+    int err = posix_fallocate(fd, 0, static_cast<off_t>(size));
+    if (err != 0 && err != EINVAL && err != EOPNOTSUPP)
+        return false;
+#endif
+    void* data = mmap(0, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED)
+        return false;
+    m_data = static_cast<unsigned char*>(data);
+#elif defined(YASM_MAPPED_WIN32)
+    HANDLE file = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+    if (file == INVALID_HANDLE_VALUE || GetFileType(file) != FILE_TYPE_DISK)
+        return false;
+    // Creating the mapping extends the file to the mapping size.
+    HANDLE mapping = CreateFileMapping(file, 0, PAGE_READWRITE, 0,
+                                       static_cast<DWORD>(size), 0);
+    if (mapping == 0)
+        return false;
+    void* data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+    if (data == 0)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+    m_handle = mapping;
+    m_data = static_cast<unsigned char*>(data);
+#else
+    return false;
+#endif
+    m_size = size;
+    m_mapped = true;
+    return true;
+}
+
+bool
+MappedOutputFile::Unmap()
+{
+    if (!m_mapped)
+        return true;
+
+    bool ok = true;
+#if defined(YASM_MAPPED_POSIX)
+    // Schedule write-back; as with write(), this doesn't wait for the disk.
+    if (msync(m_data, m_size, MS_ASYNC) != 0)
+        ok = false;
+    if (munmap(m_data, m_size) != 0)
+        ok = false;
+#elif defined(YASM_MAPPED_WIN32)
+    if (!FlushViewOfFile(m_data, 0))
+        ok = false;
+    if (!UnmapViewOfFile(m_data))
+        ok = false;
+    CloseHandle(static_cast<HANDLE>(m_handle));
+    m_handle = 0;
+#endif
+    m_os.seek(m_size);
+    if (m_os.has_error())
+        ok = false;
+
+    m_data = 0;
+    m_size = 0;
+    m_mapped = false;
+    return ok;
+}
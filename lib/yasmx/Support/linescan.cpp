@@ -0,0 +1,265 @@
+//
+// Physical line scanning
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include "yasmx/Support/linescan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || __GNUC__ > 4 || \
+     (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+// GCC-compatible compilers that support per-function target attributes
+// and __builtin_cpu_supports.
+#define YASM_LINESCAN_GNUC 1
+#include <immintrin.h>
+#define LINESCAN_TARGET(x) __attribute__((target(x)))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define YASM_LINESCAN_MSVC 1
+#include <intrin.h>
+#include <emmintrin.h>
+#if _MSC_VER >= 1800
+#include <immintrin.h>
+#define YASM_LINESCAN_MSVC_AVX2 1
+#endif
+#define LINESCAN_TARGET(x)
+#endif
+
+
+using namespace yasm;
+
+static inline bool
+isNewline(unsigned char c)
+{
+    return c == '\n' || c == '\r';
+}
+
+/// Scan [pos, size) a byte at a time.
+static void
+ScanScalar(const unsigned char* buf,
+           unsigned long pos,
+           unsigned long size,
+           std::vector<unsigned>* offsets)
+{
+    for (; pos < size; ++pos)
+    {
+        unsigned char c = buf[pos];
+        if (!isNewline(c))
+            continue;
+        // If this is \n\r or \r\n, skip both characters.
+        if (pos+1 < size && isNewline(buf[pos+1]) && buf[pos+1] != c)
+            ++pos;
+        offsets->push_back(static_cast<unsigned>(pos+1));
+    }
+}
+
+#if defined(YASM_LINESCAN_GNUC) || defined(YASM_LINESCAN_MSVC)
+static inline unsigned int
+CountTrailingZeros(unsigned int mask)
+{
+#ifdef YASM_LINESCAN_GNUC
+    return __builtin_ctz(mask);
+#else
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#endif
+}
+
+/// Record the line endings for a block starting at pos with bit n of mask
+/// set for each newline character at pos+n.
+/// @param next     first offset not consumed by a previous line ending;
+///                 updated to the offset after the last line ending
+static inline void
+ScanMask(const unsigned char* buf,
+         unsigned long pos,
+         unsigned long size,
+         unsigned int mask,
+         unsigned long* next,
+         std::vector<unsigned>* offsets)
+{
+    while (mask != 0)
+    {
+        unsigned long i = pos + CountTrailingZeros(mask);
+        mask &= mask - 1;
+        if (i < *next)
+            continue;   // second character of a \r\n or \n\r pair
+        unsigned char c = buf[i];
+        if (i+1 < size && isNewline(buf[i+1]) && buf[i+1] != c)
+            ++i;
+        *next = i+1;
+        offsets->push_back(static_cast<unsigned>(*next));
+    }
+}
+
+LINESCAN_TARGET("sse2")
+static void
+ScanSSE2(const unsigned char* buf,
+         unsigned long size,
+         std::vector<unsigned>* offsets)
+{
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    unsigned long pos = 0, next = 0;
+    for (; pos+16 <= size; pos += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf+pos));
+        __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr));
+        unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(m));
+        if (mask != 0)
+            ScanMask(buf, pos, size, mask, &next, offsets);
+    }
+    ScanScalar(buf, pos > next ? pos : next, size, offsets);
+}
+
+#if defined(YASM_LINESCAN_GNUC) || defined(YASM_LINESCAN_MSVC_AVX2)
+#define YASM_LINESCAN_AVX2 1
+LINESCAN_TARGET("avx2")
+static void
+ScanAVX2(const unsigned char* buf,
+         unsigned long size,
+         std::vector<unsigned>* offsets)
+{
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    unsigned long pos = 0, next = 0;
+    for (; pos+32 <= size; pos += 32)
+    {
+        __m256i v =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buf+pos));
+        __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v, lf),
+                                    _mm256_cmpeq_epi8(v, cr));
+        unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(m));
+        if (mask != 0)
+            ScanMask(buf, pos, size, mask, &next, offsets);
+    }
+    ScanScalar(buf, pos > next ? pos : next, size, offsets);
+}
+#endif
+#endif
+
+static bool
+CPUHasSSE2()
+{
+#if defined(YASM_LINESCAN_GNUC)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#elif defined(YASM_LINESCAN_MSVC)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1<<26)) != 0;
+#else
+    return false;
+#endif
+}
+
+static bool
+CPUHasAVX2()
+{
+#if defined(YASM_LINESCAN_GNUC)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#elif defined(YASM_LINESCAN_MSVC_AVX2)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    // Require OS support for saving the YMM registers.
+    __cpuid(info, 1);
+    if ((info[2] & (1<<27)) == 0 || (_xgetbv(0) & 6) != 6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1<<5)) != 0;
+#else
+    return false;
+#endif
+}
+
+bool
+yasm::isLineScanKernelSupported(LineScanKernel kernel)
+{
+    switch (kernel)
+    {
+        case LINESCAN_AUTO:
+        case LINESCAN_SCALAR:
+            return true;
+        case LINESCAN_SSE2:
+            return CPUHasSSE2();
+        case LINESCAN_AVX2:
+#ifdef YASM_LINESCAN_AVX2
+            return CPUHasAVX2();
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+static LineScanKernel
+DetectBestKernel()
+{
+    if (isLineScanKernelSupported(LINESCAN_AVX2))
+        return LINESCAN_AVX2;
+    if (isLineScanKernelSupported(LINESCAN_SSE2))
+        return LINESCAN_SSE2;
+    return LINESCAN_SCALAR;
+}
+
+LineScanKernel
+yasm::getBestLineScanKernel()
+{
+    // Detected once; the compiler guards the initialization against
+    // concurrent first calls.
+    static const LineScanKernel best = DetectBestKernel();
+    return best;
+}
+
+void
+yasm::ScanLineOffsets(const char* buf,
+                      unsigned long size,
+                      std::vector<unsigned>* offsets,
+                      LineScanKernel kernel)
+{
+    const unsigned char* ubuf = reinterpret_cast<const unsigned char*>(buf);
+    if (kernel == LINESCAN_AUTO)
+        kernel = getBestLineScanKernel();
+    else if (!isLineScanKernelSupported(kernel))
+        kernel = LINESCAN_SCALAR;
+
+    switch (kernel)
+    {
+#if defined(YASM_LINESCAN_GNUC) || defined(YASM_LINESCAN_MSVC)
+        case LINESCAN_SSE2:
+            ScanSSE2(ubuf, size, offsets);
+            return;
+#endif
+#ifdef YASM_LINESCAN_AVX2
+        case LINESCAN_AVX2:
+            ScanAVX2(ubuf, size, offsets);
+            return;
+#endif
+        default:
+            ScanScalar(ubuf, 0, size, offsets);
+            return;
+    }
+}
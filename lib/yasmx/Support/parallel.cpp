@@ -0,0 +1,238 @@
+//
+// Simple fork-join parallel loop
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include "yasmx/Support/parallel.h"
+
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "llvm/Config/config.h"
+#include "llvm/System/Atomic.h"
+#include "llvm/System/Threading.h"
+
+#if defined(ENABLE_THREADS) && ENABLE_THREADS != 0
+#if defined(LLVM_ON_WIN32)
+#define YASM_PARALLEL_WIN32 1
+#include <windows.h>
+#include <process.h>
+#elif defined(HAVE_PTHREAD_H)
+#define YASM_PARALLEL_PTHREAD 1
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#endif
+
+
+using namespace yasm;
+
+namespace {
+// Kind of exception thrown by a call, to be rethrown by the calling thread.
+enum Failure
+{
+    FAIL_NONE,
+    FAIL_BAD_ALLOC,
+    FAIL_OUT_OF_RANGE,
+    FAIL_OTHER
+};
+
+// Shared by all threads running a single ParallelFor() call.
+struct LoopState
+{
+    const TR1::function<void (unsigned long)>* func;
+    llvm::sys::cas_flag count;
+    volatile llvm::sys::cas_flag next;
+
+    // Set by the first call to throw; only that thread writes the rest.
+    volatile llvm::sys::cas_flag failed;
+    Failure failure;
+    std::string what;
+};
+} // anonymous namespace
+
+static void
+RecordFailure(LoopState* state, Failure failure, const char* what)
+{
+    if (llvm::sys::CompareAndSwap(&state->failed, 1, 0) != 0)
+        return;     // only the first failure is kept
+    state->failure = failure;
+    state->what = what;
+}
+
+static void
+RunLoop(LoopState* state)
+{
+    // Stop handing out work once a call has failed.
+    while (!state->failed)
+    {
+        // AtomicIncrement returns the incremented value.
+        llvm::sys::cas_flag i = llvm::sys::AtomicIncrement(&state->next) - 1;
+        if (i >= state->count)
+            break;
+
+        // An exception must not escape a thread, so catch it here and let
+        // the calling thread rethrow it once all threads have finished.
+        try
+        {
+            (*state->func)(i);
+        }
+        catch (std::bad_alloc&)
+        {
+            RecordFailure(state, FAIL_BAD_ALLOC, "");
+        }
+        catch (std::out_of_range& err)
+        {
+            RecordFailure(state, FAIL_OUT_OF_RANGE, err.what());
+        }
+        catch (std::exception& err)
+        {
+            RecordFailure(state, FAIL_OTHER, err.what());
+        }
+        catch (...)
+        {
+            RecordFailure(state, FAIL_OTHER, "unknown exception");
+        }
+    }
+}
+
+#if defined(YASM_PARALLEL_PTHREAD)
+static void*
+ThreadMain(void* arg)
+{
+    RunLoop(static_cast<LoopState*>(arg));
+    return 0;
+}
+#elif defined(YASM_PARALLEL_WIN32)
+static unsigned __stdcall
+ThreadMain(void* arg)
+{
+    RunLoop(static_cast<LoopState*>(arg));
+    return 0;
+}
+#endif
+
+bool
+yasm::isParallelSupported()
+{
+#if defined(YASM_PARALLEL_PTHREAD) || defined(YASM_PARALLEL_WIN32)
+    return true;
+#else
+    return false;
+#endif
+}
+
+unsigned int
+yasm::getNumProcessors()
+{
+    long n = 1;
+#if defined(YASM_PARALLEL_PTHREAD) && defined(_SC_NPROCESSORS_ONLN)
+    n = sysconf(_SC_NPROCESSORS_ONLN);
+#elif defined(YASM_PARALLEL_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    n = static_cast<long>(info.dwNumberOfProcessors);
+#endif
+    return n < 1 ? 1 : static_cast<unsigned int>(n);
+}
+
+void
+yasm::ParallelFor(unsigned long count,
+                  unsigned int jobs,
+                  const TR1::function<void (unsigned long)>& func)
+{
+    if (jobs > count)
+        jobs = static_cast<unsigned int>(count);
+
+    if (jobs <= 1 || !isParallelSupported())
+    {
+        for (unsigned long i=0; i<count; ++i)
+            func(i);
+        return;
+    }
+
+    // Make LLVM's statistics and managed statics lock.
+    if (!llvm::llvm_is_multithreaded())
+        llvm::llvm_start_multithreaded();
+
+    LoopState state;
+    state.func = &func;
+    state.count = static_cast<llvm::sys::cas_flag>(count);
+    state.next = 0;
+    state.failed = 0;
+    state.failure = FAIL_NONE;
+
+    // The calling thread is one of the workers.  If a thread cannot be
+    // started, the remaining threads simply pick up its share of the work.
+#if defined(YASM_PARALLEL_PTHREAD)
+    std::vector<pthread_t> threads;
+    threads.reserve(jobs-1);
+    for (unsigned int i=1; i<jobs; ++i)
+    {
+        pthread_t thread;
+        if (pthread_create(&thread, 0, ThreadMain, &state) != 0)
+            break;
+        threads.push_back(thread);
+    }
+
+    RunLoop(&state);
+
+    for (std::vector<pthread_t>::iterator i=threads.begin(),
+         end=threads.end(); i != end; ++i)
+        pthread_join(*i, 0);
+#elif defined(YASM_PARALLEL_WIN32)
+    std::vector<HANDLE> threads;
+    threads.reserve(jobs-1);
+    for (unsigned int i=1; i<jobs; ++i)
+    {
+        uintptr_t thread = _beginthreadex(0, 0, ThreadMain, &state, 0, 0);
+        if (thread == 0)
+            break;
+        threads.push_back(reinterpret_cast<HANDLE>(thread));
+    }
+
+    RunLoop(&state);
+
+    for (std::vector<HANDLE>::iterator i=threads.begin(), end=threads.end();
+         i != end; ++i)
+    {
+        WaitForSingleObject(*i, INFINITE);
+        CloseHandle(*i);
+    }
+#endif
+
+    switch (state.failure)
+    {
+        case FAIL_NONE:
+            break;
+        case FAIL_BAD_ALLOC:
+            throw std::bad_alloc();
+        case FAIL_OUT_OF_RANGE:
+            throw std::out_of_range(state.what);
+        case FAIL_OTHER:
+            throw std::runtime_error(state.what);
+    }
+}
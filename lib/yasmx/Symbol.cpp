@@ -26,6 +26,8 @@
 //
 #include "yasmx/Symbol.h"
 
+#include <cstring>
+
 #include "yasmx/Basic/Diagnostic.h"
 #include "yasmx/Expr.h"
 
@@ -33,7 +35,21 @@
 using namespace yasm;
 
 Symbol::Symbol(llvm::StringRef name)
+    : m_owns_name(true),
+      m_type(UNKNOWN),
+      m_status(NOSTATUS),
+      m_visibility(LOCAL),
+      m_equ(0)
+{
+    char* copy = new char[name.size()+1];
+    std::memcpy(copy, name.data(), name.size());
+    copy[name.size()] = '\0';
+    m_name = llvm::StringRef(copy, name.size());
+}
+
+Symbol::Symbol(llvm::StringRef name, InternedName)
     : m_name(name),
+      m_owns_name(false),
       m_type(UNKNOWN),
       m_status(NOSTATUS),
       m_visibility(LOCAL),
@@ -43,6 +59,17 @@ Symbol::Symbol(llvm::StringRef name)
 
 Symbol::~Symbol()
 {
+    if (m_owns_name)
+        delete [] m_name.data();
+}
+
+void
+Symbol::setInternedName(llvm::StringRef name)
+{
+    if (m_owns_name)
+        delete [] m_name.data();
+    m_name = name;
+    m_owns_name = false;
 }
 
 bool
@@ -190,7 +217,7 @@ pugi::xml_node
 Symbol::Write(pugi::xml_node out) const
 {
     pugi::xml_node root = out.append_child("Symbol");
-    root.append_attribute("id") = m_name.c_str();
+    root.append_attribute("id") = m_name.str().c_str();
     append_child(root, "Name", m_name);
     pugi::xml_attribute type = root.append_attribute("type");
     switch (m_type)
@@ -125,7 +125,7 @@ Value::Value(unsigned int size, SymbolRef sym)
 }
 
 Value::Value(const Value& oth)
-    : m_abs(0),
+    : m_abs(oth.m_abs),
       m_rel(oth.m_rel),
       m_wrt(oth.m_wrt),
       m_sub(oth.m_sub),
@@ -144,8 +144,6 @@ Value::Value(const Value& oth)
       m_sign(oth.m_sign),
       m_size(oth.m_size)
 {
-    if (oth.m_abs)
-        m_abs.reset(oth.m_abs->clone());
 }
 
 Value::~Value()
@@ -261,10 +259,7 @@ Value::operator= (const Value& rhs)
 {
     if (this != &rhs)
     {
-        if (rhs.m_abs)
-            m_abs.reset(rhs.m_abs->clone());
-        else
-            m_abs.reset(0);
+        m_abs = rhs.m_abs;
         m_rel = rhs.m_rel;
         m_wrt = rhs.m_wrt;
         m_sub = rhs.m_sub;
@@ -315,7 +310,7 @@ Value::SubRelative(Object* object, Location sub)
         {
             if (!m_abs)
                 m_abs.reset(new Expr());
-            *m_abs += SUB(m_rel, sub);
+            *m_abs.get_mutable() += SUB(m_rel, sub);
             m_rel = SymbolRef(0);
         }
         else
@@ -647,23 +642,26 @@ Value::Finalize(Diagnostic& diags, unsigned int err_too_complex)
         return true;
     }
 
-    if (!ExpandEqu(*m_abs))
+    // Finalization rewrites the expression, so unshare it first.
+    Expr& abs = *m_abs.get_mutable();
+
+    if (!ExpandEqu(abs))
     {
         diags.Report(m_source.getBegin(), diag::err_equ_circular_reference);
         return false;
     }
-    m_abs->Simplify(diags, false);
+    abs.Simplify(diags, false);
 
     // Strip top-level AND masking to an all-1s mask the same size
     // of the value size.  This allows forced avoidance of overflow warnings.
-    if (m_abs->isOp(Op::AND))
+    if (abs.isOp(Op::AND))
     {
         // Calculate 1<<size - 1 value
         IntNum mask = 1;
         mask <<= m_size;
         mask -= 1;
 
-        ExprTerms& terms = m_abs->getTerms();
+        ExprTerms& terms = abs.getTerms();
 
         // See if any top-level terms match mask and remove them.
         bool found = false;
@@ -688,40 +686,45 @@ Value::Finalize(Diagnostic& diags, unsigned int err_too_complex)
         if (found)
         {
             m_no_warn = true;
-            m_abs->MakeIdent(diags);
+            abs.MakeIdent(diags);
         }
     }
 
     // Handle trivial (IDENT) cases immediately
-    if (m_abs->isIntNum())
+    if (abs.isIntNum())
     {
-        if (m_abs->getIntNum().isZero())
+        if (abs.getIntNum().isZero())
             m_abs.reset(0);
         return true;
     }
-    else if (m_abs->isSymbol())
+    else if (abs.isSymbol())
     {
-        m_rel = m_abs->getSymbol();
+        m_rel = abs.getSymbol();
         m_abs.reset(0);
         return true;
     }
 
     int pos = -1;
-    if (!FinalizeScan(*m_abs, true, &pos))
+    if (!FinalizeScan(abs, true, &pos))
     {
         diags.Report(m_source.getBegin(), err_too_complex);
         return false;
     }
 
-    m_abs->Simplify(diags, false);
+    abs.Simplify(diags, false);
 
     // Simplify 0 in abs to NULL
-    if (m_abs->isIntNum())
+    if (abs.isIntNum())
     {
-        if (m_abs->getIntNum().isZero())
+        if (abs.getIntNum().isZero())
             m_abs.reset(0);
+        return true;
     }
 
+    // The finalized expression lives as long as the value; don't hold on to
+    // capacity left over from simplification.
+    abs.Compact();
+
     return true;
 }
 
@@ -771,13 +774,19 @@ Value::getIntNum(IntNum* out, bool calc_bc_dist, Diagnostic& diags)
     return true;
 }
 
+Expr*
+Value::getAbs()
+{
+    return m_abs.leak();
+}
+
 void
 Value::AddAbs(const IntNum& delta)
 {
     if (m_abs.get() == 0)
         m_abs.reset(new Expr(delta));
     else
-        *m_abs += delta;
+        *m_abs.get_mutable() += delta;
 }
 
 void
@@ -786,7 +795,7 @@ Value::AddAbs(const Expr& delta)
     if (m_abs.get() == 0)
         m_abs.reset(delta.clone());
     else
-        *m_abs += delta;
+        *m_abs.get_mutable() += delta;
 }
 
 bool
@@ -28,6 +28,7 @@
 //
 #include <bitset>
 
+#include "llvm/ADT/StringMap.h"
 #include "yasmx/Config/export.h"
 #include "yasmx/Arch.h"
 
@@ -45,6 +46,7 @@ class Object;
 namespace arch
 {
 
+struct X86InsnInfo;
 class X86RegisterGroup;
 
 class YASM_STD_EXPORT X86RegTmod
@@ -190,6 +192,13 @@ public:
 
     unsigned int getModeBits() const { return m_mode_bits; }
 
+    /// Instruction match memo table, used by X86Insn to skip operand
+    /// matching for instruction shapes that have been seen before.  Maps
+    /// a key built from the instruction group, modes, and operand shapes
+    /// to the matching instruction form.
+    typedef llvm::StringMap<const X86InsnInfo*> MatchCache;
+    MatchCache& getMatchCache() const { return m_match_cache; }
+
     static const char* getName()
     { return "x86 (IA-32 and derivatives), AMD64"; }
     static const char* getKeyword() { return "x86"; }
@@ -218,6 +227,8 @@ private:
     bool m_force_strict;
     bool m_default_rel;
     NopFormat m_nop;
+
+    mutable MatchCache m_match_cache;
 };
 
 }} // namespace yasm::arch
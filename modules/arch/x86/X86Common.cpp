@@ -28,8 +28,11 @@
 
 #include "llvm/ADT/Twine.h"
 #include "yasmx/Basic/Diagnostic.h"
+#include "yasmx/BytecodeContainer.h"
+#include "yasmx/Bytecode.h"
 #include "yasmx/Bytes.h"
 #include "yasmx/Bytes_util.h"
+#include "yasmx/Object.h"
 
 #include "X86Prefix.h"
 #include "X86Register.h"
@@ -173,3 +176,12 @@ X86Common::ToBytes(Bytes& bytes, const X86SegmentRegister* segreg) const
     if (m_lockrep_pre != 0)
         Write8(bytes, m_lockrep_pre);
 }
+
+bool
+yasm::arch::isSpanOptimized(const Bytecode& bc)
+{
+    const BytecodeContainer* container = bc.getContainer();
+    const Object* object = container ? container->getObject() : 0;
+    return !object ||
+        object->getOptions().OptimizeLevel != Object::OPTIMIZE_NONE;
+}
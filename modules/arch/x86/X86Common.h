@@ -35,6 +35,9 @@
 
 namespace yasm
 {
+
+class Bytecode;
+
 namespace arch
 {
 
@@ -63,6 +66,13 @@ public:
     unsigned char m_mode_bits;
 };
 
+/// Determine whether span-dependent instruction forms of a bytecode should
+/// start short and be optimized, or should use their long form up front
+/// (object optimization level of Object::OPTIMIZE_NONE).
+/// @param bc       bytecode
+/// @return True if spans should be used.
+YASM_STD_EXPORT bool isSpanOptimized(const Bytecode& bc);
+
 }} // namespace yasm::arch
 
 #endif
@@ -96,6 +96,12 @@ public:
 private:
     X86General(const X86General& rhs);
 
+    /// Change a byte displacement to word-sized.
+    void WidenDisp();
+
+    /// Change a sign-extended byte immediate form to the word-sized form.
+    void WidenImm();
+
     X86Common m_common;
     X86Opcode m_opcode;
 
@@ -306,9 +312,13 @@ X86General::CalcLen(Bytecode& bc,
         if (m_ea->m_disp.getSize() == 0 && m_ea->m_need_nonzero_len)
         {
             // Handle unknown case, default to byte-sized and set as
-            // critical expression.
+            // critical expression.  Without optimization, just use the
+            // word-sized form.
             m_ea->m_disp.setSize(8);
-            add_span(bc, 1, m_ea->m_disp, -128, 127);
+            if (isSpanOptimized(bc))
+                add_span(bc, 1, m_ea->m_disp, -128, 127);
+            else
+                WidenDisp();
         }
         ilen += m_ea->m_disp.getSize()/8;
 
@@ -334,9 +344,15 @@ X86General::CalcLen(Bytecode& bc,
             if (!m_imm->getIntNum(&num, false, diags))
             {
                 // Unknown; default to byte form and set as critical
-                // expression.
-                immlen = 8;
-                add_span(bc, 2, *m_imm, -128, 127);
+                // expression.  Without optimization, just use the
+                // word-sized form.
+                if (isSpanOptimized(bc))
+                {
+                    immlen = 8;
+                    add_span(bc, 2, *m_imm, -128, 127);
+                }
+                else
+                    WidenImm();
             }
             else
             {
@@ -417,12 +433,9 @@ X86General::Expand(Bytecode& bc,
         // Change displacement length into word-sized
         if (m_ea->m_disp.getSize() == 8)
         {
-            unsigned int size = (m_common.m_addrsize == 16) ? 16 : 32;
-            m_ea->m_disp.setSize(size);
-            m_ea->m_modrm &= ~0300;
-            m_ea->m_modrm |= 0200;
+            WidenDisp();
             (*len)--;
-            (*len) += size/8;
+            (*len) += m_ea->m_disp.getSize()/8;
         }
     }
 
@@ -434,9 +447,7 @@ X86General::Expand(Bytecode& bc,
             (*len) -= m_opcode.getLen();
             (*len) += m_imm->getSize()/8;
 
-            // Change to the word-sized opcode
-            m_opcode.MakeAlt1();
-            m_postop = X86_POSTOP_NONE;
+            WidenImm();
         }
     }
 
@@ -444,6 +455,22 @@ X86General::Expand(Bytecode& bc,
     return true;
 }
 
+void
+X86General::WidenDisp()
+{
+    unsigned int size = (m_common.m_addrsize == 16) ? 16 : 32;
+    m_ea->m_disp.setSize(size);
+    m_ea->m_modrm &= ~0300;
+    m_ea->m_modrm |= 0200;
+}
+
+void
+X86General::WidenImm()
+{
+    m_opcode.MakeAlt1();
+    m_postop = X86_POSTOP_NONE;
+}
+
 static void
 GeneralToBytes(Bytes& bytes,
                const X86Common& common,
@@ -538,23 +565,26 @@ X86General::Output(Bytecode& bc, BytecodeOutput& bc_out)
     // Displacement (if required)
     if (m_ea != 0 && m_ea->m_need_disp)
     {
-        unsigned int disp_len = m_ea->m_disp.getSize()/8;
+        // Adjust a copy of the displacement so that output can be repeated
+        // (e.g. for the list file).
+        Value disp = m_ea->m_disp;
+        unsigned int disp_len = disp.getSize()/8;
 
-        m_ea->m_disp.setInsnStart(pos);
-        if (m_ea->m_disp.isIPRelative())
+        disp.setInsnStart(pos);
+        if (disp.isIPRelative())
         {
             // Adjust relative displacement to end of bytecode
-            m_ea->m_disp.AddAbs(-static_cast<long>(pos+disp_len+imm_len));
+            disp.AddAbs(-static_cast<long>(pos+disp_len+imm_len));
             // Distance to end of instruction is the immediate length
-            m_ea->m_disp.setNextInsn(imm_len);
+            disp.setNextInsn(imm_len);
         }
         Location loc = {&bc, bc.getFixedLen()+pos};
         pos += disp_len;
         bytes.resize(0);
         bytes.resize(disp_len);
         NumericOutput num_out(bytes);
-        m_ea->m_disp.ConfigureOutput(&num_out);
-        if (!bc_out.OutputValue(m_ea->m_disp, loc, num_out))
+        disp.ConfigureOutput(&num_out);
+        if (!bc_out.OutputValue(disp, loc, num_out))
             return false;
     }
 
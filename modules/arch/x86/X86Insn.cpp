@@ -33,6 +33,7 @@
 #include <cstring>
 #include <string>
 
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/Support/raw_ostream.h"
@@ -61,6 +62,8 @@
 STATISTIC(num_groups_scanned, "Total number of instruction groups scanned");
 STATISTIC(num_jmp_groups_scanned, "Total number of jump groups scanned");
 STATISTIC(num_empty_insn, "Number of empty instructions created");
+STATISTIC(num_match_cache_hits, "Number of instruction match cache hits");
+STATISTIC(num_match_cache_misses, "Number of instruction match cache misses");
 
 using namespace yasm;
 using namespace yasm::arch;
@@ -151,6 +154,94 @@ enum X86OperandType
     OPT_MemDX = 27
 };
 
+// Coarse operand classes, used to quickly reject instruction forms before
+// doing a full MatchOperand().  Registers are classed by size, as register
+// sizes must match exactly unless the size check is bypassed.  These and the
+// tables below must match gen_x86_insn.py, which keys the dispatch index on
+// them.
+enum X86OperandClass
+{
+    OPC_Imm = 1<<0,     // immediate
+    OPC_Mem = 1<<1,     // memory
+    OPC_Reg8 = 1<<2,    // 8-bit general purpose register
+    OPC_Reg16 = 1<<3,   // 16-bit general purpose register
+    OPC_Reg32 = 1<<4,   // 32-bit general purpose register
+    OPC_Reg64 = 1<<5,   // 64-bit general purpose register
+    OPC_FPUReg = 1<<6,  // FPU register
+    OPC_MMXReg = 1<<7,  // MMX register
+    OPC_XMMReg = 1<<8,  // XMM register
+    OPC_YMMReg = 1<<9,  // YMM register
+    OPC_SegReg = 1<<10, // segment register
+    OPC_CRReg = 1<<11,  // CR register
+    OPC_DRReg = 1<<12,  // DR register
+    OPC_TRReg = 1<<13,  // TR register
+
+    OPC_Reg = OPC_Reg8|OPC_Reg16|OPC_Reg32|OPC_Reg64|OPC_FPUReg,
+    OPC_SIMDReg = OPC_MMXReg|OPC_XMMReg|OPC_YMMReg,
+    OPC_SizedReg = OPC_Reg|OPC_SIMDReg,
+    OPC_AnyReg = OPC_SizedReg|OPC_CRReg|OPC_DRReg|OPC_TRReg,
+    OPC_Any = 0xffff
+};
+
+// Operand classes accepted by each X86OperandType.  Each entry must be a
+// superset of what MatchOperand() accepts for that type.
+static const unsigned short operand_type_classes[] =
+{
+    OPC_Imm,                // OPT_Imm
+    OPC_Reg,                // OPT_Reg
+    OPC_Mem,                // OPT_Mem
+    OPC_Reg|OPC_Mem,        // OPT_RM
+    OPC_SIMDReg,            // OPT_SIMDReg
+    OPC_SIMDReg|OPC_Mem,    // OPT_SIMDRM
+    OPC_SegReg,             // OPT_SegReg
+    OPC_CRReg,              // OPT_CRReg
+    OPC_DRReg,              // OPT_DRReg
+    OPC_TRReg,              // OPT_TRReg
+    OPC_FPUReg,             // OPT_ST0
+    OPC_AnyReg,             // OPT_Areg
+    OPC_AnyReg,             // OPT_Creg
+    OPC_AnyReg,             // OPT_Dreg
+    OPC_SegReg,             // OPT_CS
+    OPC_SegReg,             // OPT_DS
+    OPC_SegReg,             // OPT_ES
+    OPC_SegReg,             // OPT_FS
+    OPC_SegReg,             // OPT_GS
+    OPC_SegReg,             // OPT_SS
+    OPC_CRReg,              // OPT_CR4
+    OPC_Mem,                // OPT_MemOffs
+    OPC_Imm,                // OPT_Imm1
+    OPC_Imm,                // OPT_ImmNotSegOff
+    OPC_XMMReg,             // OPT_XMM0
+    OPC_Mem,                // OPT_MemrAX
+    OPC_Mem,                // OPT_MemEAX
+    OPC_Mem                 // OPT_MemDX
+};
+
+// Sized register classes that can match each X86OperandSize.
+static const unsigned short operand_size_classes[] =
+{
+    OPC_SizedReg,           // OPS_Any
+    OPC_Reg8,               // OPS_8
+    OPC_Reg16,              // OPS_16
+    OPC_Reg32,              // OPS_32
+    OPC_Reg64|OPC_MMXReg,   // OPS_64
+    OPC_FPUReg,             // OPS_80
+    OPC_XMMReg,             // OPS_128
+    OPC_YMMReg,             // OPS_256
+    OPC_SizedReg            // OPS_BITS
+};
+
+// Dispatch index key dimensions; must match gen_x86_insn.py.
+enum
+{
+    DISPATCH_MAX_OPERANDS = 5,
+    DISPATCH_NUM_BUCKETS = (DISPATCH_MAX_OPERANDS+1)*8,
+    DISPATCH_NUM_CLASSES = 14,
+    DISPATCH_NO_OPERAND = 15,
+    DISPATCH_OTHER_REG = 3,
+    DISPATCH_ANY_KEY = 0xFFFF
+};
+
 enum X86OperandSize
 {
     // any size acceptable/no size spec acceptable (dep. on strict)
@@ -875,8 +966,6 @@ bool
 X86Insn::MatchInfo(const X86InsnInfo& info, const unsigned int* size_lookup,
                    int bypass) const
 {
-    ++num_groups_scanned;
-
     // Match CPU
     if (m_mode_bits != 64 && (info.misc_flags & ONLY_64))
         return false;
@@ -961,17 +1050,275 @@ X86Insn::MatchInfo(const X86InsnInfo& info, const unsigned int* size_lookup,
 #endif
 }
 
+static unsigned int
+OperandClass(const Operand& op)
+{
+    switch (op.getType())
+    {
+        case Operand::REG:
+        {
+            const X86Register* reg =
+                static_cast<const X86Register*>(op.getReg());
+            unsigned int sized = (op.getSize() != 0) ? OPC_SizedReg : 0;
+            switch (reg->getType())
+            {
+                case X86Register::REG8:
+                case X86Register::REG8X:    return sized | OPC_Reg8;
+                case X86Register::REG16:    return sized | OPC_Reg16;
+                case X86Register::REG32:    return sized | OPC_Reg32;
+                case X86Register::REG64:    return sized | OPC_Reg64;
+                case X86Register::FPUREG:   return sized | OPC_FPUReg;
+                case X86Register::MMXREG:   return sized | OPC_MMXReg;
+                case X86Register::XMMREG:   return sized | OPC_XMMReg;
+                case X86Register::YMMREG:   return sized | OPC_YMMReg;
+                case X86Register::CRREG:    return OPC_CRReg;
+                case X86Register::DRREG:    return OPC_DRReg;
+                case X86Register::TRREG:    return OPC_TRReg;
+                default:                    return OPC_Any;
+            }
+        }
+        case Operand::SEGREG:
+            return OPC_SegReg;
+        case Operand::MEMORY:
+            return OPC_Mem;
+        case Operand::IMM:
+            return OPC_Imm;
+        default:
+            return OPC_Any;
+    }
+}
+
+// Index of the single class bit set in classes, or -1 if there is not
+// exactly one.
+static inline int
+ClassIndex(unsigned int classes)
+{
+    if (classes == 0 || (classes & (classes-1)) != 0)
+        return -1;
+    int index = 0;
+    while ((classes & 1) == 0)
+    {
+        classes >>= 1;
+        ++index;
+    }
+    return index;
+}
+
+static inline unsigned int
+InfoOperandClass(const X86InfoOperand& info_op)
+{
+    unsigned int classes = operand_type_classes[info_op.type];
+    return (classes & ~OPC_SizedReg)
+        | (classes & operand_size_classes[info_op.size]);
+}
+
+bool
+X86Insn::MatchClasses(const X86InsnInfo& info,
+                      const unsigned short* classes) const
+{
+    const X86InfoOperand* info_ops = &insn_operands[info.operands_index];
+    unsigned int num = info.num_operands;
+
+    // Classes are in source order; reverse as MatchInfo() does.
+    if (m_parser == X86Arch::PARSER_GAS && !(info.gas_flags & GAS_NO_REV))
+    {
+        for (unsigned int i=0; i<num; ++i)
+        {
+            if ((classes[num-1-i] & InfoOperandClass(info_ops[i])) == 0)
+                return false;
+        }
+    }
+    else
+    {
+        for (unsigned int i=0; i<num; ++i)
+        {
+            if ((classes[i] & InfoOperandClass(info_ops[i])) == 0)
+                return false;
+        }
+    }
+    return true;
+}
+
 const X86InsnInfo*
 X86Insn::FindMatch(const unsigned int* size_lookup, int bypass) const
 {
-    // Just do a simple linear search through the info array for a match.
-    // First match wins.
-    const X86InsnInfo* info =
-        std::find_if(&m_group[0], &m_group[m_num_info],
-                     TR1::bind(&X86Insn::MatchInfo, this, _1, size_lookup,
-                               bypass));
-    if (info == &m_group[m_num_info])
+    unsigned int num_operands = m_operands.size();
+    if (num_operands > DISPATCH_MAX_OPERANDS)
         return 0;
+
+    unsigned short classes[DISPATCH_MAX_OPERANDS];
+    for (unsigned int i=0; i<num_operands; ++i)
+    {
+        classes[i] = OperandClass(m_operands[i]);
+        // Bypasses 4-6 skip the register size check on operand 1-3.
+        if (bypass >= 4 && bypass <= 6 &&
+            static_cast<unsigned int>(bypass-4) == i &&
+            (classes[i] & OPC_SizedReg))
+            classes[i] |= OPC_SizedReg;
+    }
+
+    // Without a dispatch index, just do a linear search through the info
+    // array for a match.  First match wins.
+    if (!m_dispatch)
+    {
+        for (const X86InsnInfo* info = &m_group[0];
+             info != &m_group[m_num_info]; ++info)
+        {
+            ++num_groups_scanned;
+            if (info->num_operands == num_operands &&
+                MatchClasses(*info, classes) &&
+                MatchInfo(*info, size_lookup, bypass))
+                return info;
+        }
+        return 0;
+    }
+
+    // The dispatch index lists, in group order, the forms that pass the
+    // operand count, mode, parser, and AVX checks for this instruction,
+    // further keyed by GAS suffix and the classes and general purpose
+    // register numbers of the first two operands.  Operands that could be
+    // in more than one class use the list of all forms in the bucket.
+    unsigned int bucket = num_operands << 3;
+    if (m_mode_bits == 64)
+        bucket |= 1<<2;
+    if (m_parser == X86Arch::PARSER_GAS)
+        bucket |= 1<<1;
+    if (m_misc_flags & ONLY_AVX)
+        bucket |= 1<<0;
+
+    unsigned int key = 0;
+    if (m_parser == X86Arch::PARSER_GAS)
+    {
+        int suffix = ClassIndex(m_suffix & SUF_MASK);
+        if (suffix < 0)
+            key = DISPATCH_ANY_KEY;
+        else
+            key = suffix << 12;
+    }
+    for (unsigned int i=0; i<2 && key != DISPATCH_ANY_KEY; ++i)
+    {
+        int cls = DISPATCH_NO_OPERAND;
+        unsigned int regnum = DISPATCH_OTHER_REG;
+        if (i < num_operands)
+        {
+            cls = ClassIndex(classes[i]);
+            if (cls >= 0 &&
+                (classes[i] & (OPC_Reg8|OPC_Reg16|OPC_Reg32|OPC_Reg64)))
+            {
+                const X86Register* reg =
+                    static_cast<const X86Register*>(m_operands[i].getReg());
+                if (reg->getNum() < DISPATCH_OTHER_REG)
+                    regnum = reg->getNum();
+            }
+        }
+        if (cls < 0)
+            key = DISPATCH_ANY_KEY;
+        else
+            key |= ((cls << 2) | regnum) << (6-6*i);
+    }
+
+    const unsigned short* table = &m_dispatch[m_dispatch[bucket]];
+    unsigned int num_keys = table[0];
+    const unsigned short* keys = &table[1];
+    const unsigned short* found =
+        std::lower_bound(keys, keys+num_keys, key);
+    if (found == keys+num_keys || *found != key)
+        return 0;
+    unsigned int n = found-keys;
+
+    for (const unsigned short* i = &m_dispatch[keys[num_keys+n]],
+         *end = &m_dispatch[keys[2*num_keys+n]]; i != end; ++i)
+    {
+        ++num_groups_scanned;
+        const X86InsnInfo& info = m_group[*i];
+        if (MatchClasses(info, classes) &&
+            MatchInfo(info, size_lookup, bypass))
+            return &info;
+    }
+    return 0;
+}
+
+template <typename T>
+static inline void
+AppendKey(llvm::SmallVectorImpl<char>& key, const T& val)
+{
+    const char* p = reinterpret_cast<const char*>(&val);
+    key.append(p, p+sizeof(T));
+}
+
+// Builds the match cache key for the instruction: everything MatchInfo()
+// looks at for a bypass 0 match.  Only register, segment register, and
+// immediate operands are cached, as for them the match depends only on a
+// few operand properties; memory operands would need the whole effective
+// address in the key.
+bool
+X86Insn::getMatchKey(llvm::SmallVectorImpl<char>& key) const
+{
+    AppendKey(key, m_group);
+    unsigned long cpu_lo = (m_active_cpu & X86Arch::CpuMask(0xffffffffUL))
+        .to_ulong();
+    unsigned long cpu_hi = (m_active_cpu >> 32).to_ulong();
+    AppendKey(key, cpu_lo);
+    AppendKey(key, cpu_hi);
+    unsigned int modes = m_mode_bits | (m_suffix << 8) | (m_misc_flags << 17)
+        | (m_parser << 22);
+    AppendKey(key, modes);
+
+    for (Operands::const_iterator op = m_operands.begin(),
+         end = m_operands.end(); op != end; ++op)
+    {
+        const void* id;
+        unsigned int flags = op->getType();
+        switch (op->getType())
+        {
+            case Operand::REG:
+                id = op->getReg();
+                break;
+            case Operand::SEGREG:
+                id = op->getSegReg();
+                break;
+            case Operand::IMM:
+            {
+                const Expr* imm = op->getImm();
+                id = 0;
+                if (imm->isIntNum() && imm->getIntNum().isPos1())
+                    flags |= 1<<4;
+                if (op->getSeg() != 0)
+                    flags |= 1<<5;
+                break;
+            }
+            default:
+                return false;
+        }
+        AppendKey(key, id);
+        AppendKey(key, op->getTargetMod());
+        AppendKey(key, flags | (op->getSize() << 8));
+    }
+    return true;
+}
+
+// Same as FindMatch(size_lookup, 0), but remembers the matching form of
+// register and immediate operand instruction shapes in the architecture's
+// match cache, so repeated shapes skip matching entirely.
+const X86InsnInfo*
+X86Insn::FindMatchCached(const unsigned int* size_lookup) const
+{
+    llvm::SmallString<128> key;
+    if (!getMatchKey(key))
+        return FindMatch(size_lookup, 0);
+
+    X86Arch::MatchCache& cache = m_arch.getMatchCache();
+    X86Arch::MatchCache::iterator i = cache.find(key.str());
+    if (i != cache.end())
+    {
+        ++num_match_cache_hits;
+        return i->getValue();
+    }
+
+    ++num_match_cache_misses;
+    const X86InsnInfo* info = FindMatch(size_lookup, 0);
+    if (info)
+        cache[key.str()] = info;
     return info;
 }
 
@@ -1088,7 +1435,7 @@ X86Insn::DoAppend(BytecodeContainer& container,
         }
     }
 
-    const X86InsnInfo* info = FindMatch(size_lookup, 0);
+    const X86InsnInfo* info = FindMatchCached(size_lookup);
 
     if (!info)
     {
@@ -1782,6 +2129,9 @@ struct InsnPrefixParseData
     unsigned int cpu0:6;
     unsigned int cpu1:6;
     unsigned int cpu2:6;
+
+    // For instruction, dispatch index into group (NULL if none).
+    const unsigned short* dispatch;
 };
 
 // Pull in all parse data
@@ -1940,6 +2290,7 @@ X86Arch::ParseCheckInsnPrefix(llvm::StringRef id,
 inline
 X86Insn::X86Insn(const X86Arch& arch,
                  const X86InsnInfo* group,
+                 const unsigned short* dispatch,
                  const X86Arch::CpuMask& active_cpu,
                  unsigned char mod_data0,
                  unsigned char mod_data1,
@@ -1953,6 +2304,7 @@ X86Insn::X86Insn(const X86Arch& arch,
                  bool default_rel)
     : m_arch(arch),
       m_group(group),
+      m_dispatch(dispatch),
       m_active_cpu(active_cpu),
       m_num_info(num_info),
       m_mode_bits(mode_bits),
@@ -2013,6 +2365,7 @@ X86Arch::CreateEmptyInsn() const
     return std::auto_ptr<Insn>(new X86Insn(
         *this,
         empty_insn,
+        0,
         m_active_cpu,
         0,
         0,
@@ -2035,6 +2388,7 @@ X86Arch::CreateInsn(const Arch::InsnInfo* info) const
     return std::auto_ptr<Insn>(new X86Insn(
         *this,
         static_cast<const X86InsnInfo*>(pdata->struc),
+        pdata->dispatch,
         m_active_cpu,
         pdata->mod_data0,
         pdata->mod_data1,
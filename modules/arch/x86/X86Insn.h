@@ -31,6 +31,8 @@
 
 #include "X86Arch.h"
 
+namespace llvm { template <typename T> class SmallVectorImpl; }
+
 namespace yasm
 {
 
@@ -48,6 +50,7 @@ class YASM_STD_EXPORT X86Insn : public Insn
 public:
     X86Insn(const X86Arch& arch,
             const X86InsnInfo* group,
+            /*@null@*/ const unsigned short* dispatch,
             const X86Arch::CpuMask& active_cpu,
             unsigned char mod_data0,
             unsigned char mod_data1,
@@ -92,6 +95,10 @@ private:
 
     const X86InsnInfo* FindMatch(const unsigned int* size_lookup, int bypass)
         const;
+    const X86InsnInfo* FindMatchCached(const unsigned int* size_lookup) const;
+    bool getMatchKey(llvm::SmallVectorImpl<char>& key) const;
+    bool MatchClasses(const X86InsnInfo& info,
+                      const unsigned short* classes) const;
     bool MatchInfo(const X86InsnInfo& info,
                    const unsigned int* size_lookup,
                    int bypass) const;
@@ -110,6 +117,10 @@ private:
     // instruction parse group - NULL if empty instruction (just prefixes)
     /*@null@*/ const X86InsnInfo* m_group;
 
+    // dispatch index into instruction parse group, generated for large
+    // groups by gen_x86_insn.py - NULL to scan the whole group
+    /*@null@*/ const unsigned short* m_dispatch;
+
     // CPU feature flags enabled at the time of parsing the instruction
     X86Arch::CpuMask m_active_cpu;
 
@@ -150,6 +150,11 @@ X86Jmp::Finalize(Bytecode& bc, Diagnostic& diags)
         // this function anyway).
         m_op_sel = X86_JMP_NEAR;
     }
+    else if (!isSpanOptimized(bc))
+    {
+        // Not optimizing; use near jump rather than creating a span.
+        m_op_sel = X86_JMP_NEAR;
+    }
     else
     {
         // Default to short jump
@@ -235,21 +240,25 @@ X86Jmp::Output(Bytecode& bc, BytecodeOutput& bc_out)
     unsigned long pos = bytes.size();
     bc_out.OutputBytes(bytes, bc.getSource());
 
+    // Adjust a copy of the target so that output can be repeated (e.g. for
+    // the list file).
+    Value target = m_target;
+
     // Adjust relative displacement to end of instruction
-    m_target.AddAbs(-static_cast<long>(pos+size));
-    m_target.setSize(size*8);
+    target.AddAbs(-static_cast<long>(pos+size));
+    target.setSize(size*8);
 
     // Distance from displacement to end of instruction is always 0.
-    m_target.setInsnStart(pos);
-    m_target.setNextInsn(0);
+    target.setInsnStart(pos);
+    target.setNextInsn(0);
 
     // Output displacement
     Location loc = {&bc, bc.getFixedLen()+bytes.size()};
     bytes.resize(0);
     bytes.resize(size);
     NumericOutput num_out(bytes);
-    m_target.ConfigureOutput(&num_out);
-    if (!bc_out.OutputValue(m_target, loc, num_out))
+    target.ConfigureOutput(&num_out);
+    if (!bc_out.OutputValue(target, loc, num_out))
         return false;
     return true;
 }
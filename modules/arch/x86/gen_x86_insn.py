@@ -486,6 +486,11 @@ class Insn(object):
         # Ensure modifiers is at least 3 long
         mods_str.extend(["0", "0", "0"])
 
+        if has_dispatch(self.groupname):
+            dispatch_str = "%s_dispatch" % self.groupname
+        else:
+            dispatch_str = "0"
+
         return ",\t".join(["%s_insn" % self.groupname,
                            "%d" % len(groups[self.groupname]),
                            suffix_str,
@@ -495,7 +500,8 @@ class Insn(object):
                            "|".join(self.misc_flags or []) or "0",
                            cpus_str[0],
                            cpus_str[1],
-                           cpus_str[2]])
+                           cpus_str[2],
+                           dispatch_str])
 
 insns = {}
 def add_insn(name, groupname, **kwargs):
@@ -523,6 +529,7 @@ class Prefix(object):
                            self.only64 and "ONLY_64" or "0",
                            "0",
                            "0",
+                           "0",
                            "0"])
 
 gas_insns = {}
@@ -610,6 +617,207 @@ def output_gas_insns(f):
 def output_nasm_insns(f):
     output_insns(f, "Nasm", nasm_insns)
 
+# Groups with at least this many forms get a dispatch index.
+DISPATCH_MIN_FORMS = 4
+
+# Dispatch index key dimensions; must match X86Insn::FindMatch().
+DISPATCH_MAX_OPERANDS = 5
+DISPATCH_NUM_BUCKETS = (DISPATCH_MAX_OPERANDS+1)*8
+DISPATCH_NUM_CLASSES = 14
+DISPATCH_NO_OPERAND = 15
+DISPATCH_ANY_KEY = 0xFFFF
+
+# Coarse operand classes; must match X86OperandClass in X86Insn.cpp.
+OPC_Imm, OPC_Mem, OPC_Reg8, OPC_Reg16, OPC_Reg32, OPC_Reg64, OPC_FPUReg, \
+    OPC_MMXReg, OPC_XMMReg, OPC_YMMReg, OPC_SegReg, OPC_CRReg, OPC_DRReg, \
+    OPC_TRReg = [1<<x for x in range(DISPATCH_NUM_CLASSES)]
+OPC_Reg = OPC_Reg8|OPC_Reg16|OPC_Reg32|OPC_Reg64|OPC_FPUReg
+OPC_SIMDReg = OPC_MMXReg|OPC_XMMReg|OPC_YMMReg
+OPC_SizedReg = OPC_Reg|OPC_SIMDReg
+OPC_AnyReg = OPC_SizedReg|OPC_CRReg|OPC_DRReg|OPC_TRReg
+
+operand_type_classes = {
+    "Imm": OPC_Imm,
+    "Reg": OPC_Reg,
+    "Mem": OPC_Mem,
+    "RM": OPC_Reg|OPC_Mem,
+    "SIMDReg": OPC_SIMDReg,
+    "SIMDRM": OPC_SIMDReg|OPC_Mem,
+    "SegReg": OPC_SegReg,
+    "CRReg": OPC_CRReg,
+    "DRReg": OPC_DRReg,
+    "TRReg": OPC_TRReg,
+    "ST0": OPC_FPUReg,
+    "Areg": OPC_AnyReg,
+    "Creg": OPC_AnyReg,
+    "Dreg": OPC_AnyReg,
+    "CS": OPC_SegReg,
+    "DS": OPC_SegReg,
+    "ES": OPC_SegReg,
+    "FS": OPC_SegReg,
+    "GS": OPC_SegReg,
+    "SS": OPC_SegReg,
+    "CR4": OPC_CRReg,
+    "MemOffs": OPC_Mem,
+    "Imm1": OPC_Imm,
+    "ImmNotSegOff": OPC_Imm,
+    "XMM0": OPC_XMMReg,
+    "MemrAX": OPC_Mem,
+    "MemEAX": OPC_Mem,
+    "MemDX": OPC_Mem,
+}
+
+operand_size_classes = {
+    "Any": OPC_SizedReg,
+    8: OPC_Reg8,
+    16: OPC_Reg16,
+    32: OPC_Reg32,
+    64: OPC_Reg64|OPC_MMXReg,
+    80: OPC_FPUReg,
+    128: OPC_XMMReg,
+    256: OPC_YMMReg,
+    "BITS": OPC_SizedReg,
+}
+
+# GAS suffixes, in SUF_* bit order.
+DISPATCH_SUFFIXES = ["Z", "B", "W", "L", "Q", "S"]
+
+# General purpose register numbers in the key; registers past DX, and all
+# other operands, are DISPATCH_OTHER_REG.
+DISPATCH_OTHER_REG = 3
+OPC_GPReg = OPC_Reg8|OPC_Reg16|OPC_Reg32|OPC_Reg64
+fixed_reg_nums = {"Areg": 0, "Creg": 1, "Dreg": 2}
+
+def has_dispatch(groupname):
+    return len(groups[groupname]) >= DISPATCH_MIN_FORMS
+
+def dispatch_bucket_matches(form, bucket):
+    """Determine if a form can match an instruction in the given bucket.
+    This mirrors the non-operand checks in X86Insn::MatchInfo()."""
+    num_operands, mode64, gas, avx = \
+        bucket >> 3, (bucket >> 2) & 1, (bucket >> 1) & 1, bucket & 1
+    if len(form.operands) != num_operands:
+        return False
+    if mode64 and "NOT_64" in form.misc_flags:
+        return False
+    if not mode64 and "ONLY_64" in form.misc_flags:
+        return False
+    if gas and form.gas_illegal:
+        return False
+    if not gas and form.gas_only:
+        return False
+    if avx and "NOT_AVX" in form.misc_flags:
+        return False
+    if not avx and "ONLY_AVX" in form.misc_flags:
+        return False
+    return True
+
+def form_operand(form, gas, i):
+    """Form operand matched against source operand i; mirrors the operand
+    reversal in MatchClasses()."""
+    if i >= len(form.operands):
+        return None
+    if gas and not form.gas_no_rev:
+        i = len(form.operands)-1-i
+    return form.operands[i]
+
+def form_operand_matches(op, cls, regnum):
+    """Determine if a form operand can match a source operand with the
+    given class and register number; mirrors InfoOperandClass() and the
+    fixed register checks in MatchOperand()."""
+    if op is None:
+        return cls == DISPATCH_NO_OPERAND
+    if cls == DISPATCH_NO_OPERAND:
+        return False
+    classes = operand_type_classes[op.type]
+    classes = (classes & ~OPC_SizedReg) | \
+        (classes & operand_size_classes[op.size])
+    if not classes & (1<<cls):
+        return False
+    if op.type in fixed_reg_nums and (1<<cls) & OPC_GPReg:
+        return regnum == fixed_reg_nums[op.type]
+    return True
+
+def dispatch_keys(gas):
+    """Generate all (key, suffix, class, regnum, class, regnum) tuples."""
+    classes = list(range(DISPATCH_NUM_CLASSES)) + [DISPATCH_NO_OPERAND]
+    operands = []
+    for cls in classes:
+        if (1<<cls) & OPC_GPReg:
+            operands.extend((cls, r) for r in range(DISPATCH_OTHER_REG+1))
+        else:
+            operands.append((cls, DISPATCH_OTHER_REG))
+    for s, suffix in enumerate(gas and DISPATCH_SUFFIXES or [None]):
+        for c0, r0 in operands:
+            for c1, r1 in operands:
+                key = (s<<12)|(c0<<8)|(r0<<6)|(c1<<2)|r1
+                yield key, suffix, c0, r0, c1, r1
+
+def output_dispatch(f, name):
+    """Output the dispatch index for a group.  The first
+    DISPATCH_NUM_BUCKETS entries are offsets (from the start of the
+    array) of each bucket's key table.  A key table is a count n, n sorted
+    keys, then the n start and n end offsets of each key's candidate list.
+    Keys combine the GAS suffix with the classes and general purpose
+    register numbers of the first two source operands; DISPATCH_ANY_KEY lists every form in the bucket.  Candidate
+    lists contain form indices in group order, so first-match-wins
+    semantics are preserved."""
+    forms = groups[name]
+
+    tables = []
+    for bucket in range(DISPATCH_NUM_BUCKETS):
+        gas = (bucket >> 1) & 1
+        bucket_forms = [i for i, form in enumerate(forms)
+                        if dispatch_bucket_matches(form, bucket)]
+        if not bucket_forms:
+            tables.append([])
+            continue
+        table = []
+        for key, suffix, c0, r0, c1, r1 in dispatch_keys(gas):
+            cands = [i for i in bucket_forms
+                     if (not gas or (forms[i].suffixes and
+                                     suffix in forms[i].suffixes))
+                     and form_operand_matches(form_operand(forms[i], gas, 0),
+                                              c0, r0)
+                     and form_operand_matches(form_operand(forms[i], gas, 1),
+                                              c1, r1)]
+            if cands:
+                table.append((key, cands))
+        table.append((DISPATCH_ANY_KEY, bucket_forms))
+        tables.append(table)
+
+    # Lay out key tables (sharing identical ones), then candidate lists
+    # (sharing identical ones).
+    entries = [0]*DISPATCH_NUM_BUCKETS
+    table_offsets = {}
+    list_offsets = {}
+    pending = []
+    for bucket, table in enumerate(tables):
+        tkey = tuple((k, tuple(c)) for k, c in table)
+        if tkey not in table_offsets:
+            table_offsets[tkey] = len(entries)
+            entries.append(len(table))
+            entries.extend(k for k, c in table)
+            pending.append((len(entries), [c for k, c in table]))
+            entries.extend([0]*(2*len(table)))
+        entries[bucket] = table_offsets[tkey]
+    for pos, lists in pending:
+        for j, cands in enumerate(lists):
+            ckey = tuple(cands)
+            if ckey not in list_offsets:
+                list_offsets[ckey] = len(entries)
+                entries.extend(cands)
+            entries[pos+j] = list_offsets[ckey]
+            entries[pos+len(lists)+j] = list_offsets[ckey]+len(cands)
+    if len(entries) > 0xFFFF:
+        raise ValueError("dispatch index for %s too large" % name)
+
+    lprint("static const unsigned short %s_dispatch[] = {" % name, file=f)
+    entries = ["%d" % x for x in entries]
+    for i in range(0, len(entries), 12):
+        lprint("    " + ", ".join(entries[i:i+12]) + ",", file=f)
+    lprint("};\n", file=f)
+
 def output_groups(f):
     # Merge all operand lists into single list
     # Sort by number of operands to shorten output
@@ -646,6 +854,8 @@ def output_groups(f):
         lprint("   ", end='', file=f)
         lprint(",\n    ".join(str(x) for x in groups[name]), file=f)
         lprint("};\n", file=f)
+        if has_dispatch(name):
+            output_dispatch(f, name)
 
     # Output prefixes
     for name in sorted(prefixes):
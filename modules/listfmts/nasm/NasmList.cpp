@@ -0,0 +1,649 @@
+//
+// NASM-style list format
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include "NasmList.h"
+
+#include <algorithm>
+#include <cstring>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include "yasmx/Basic/Diagnostic.h"
+#include "yasmx/Basic/SourceManager.h"
+#include "yasmx/Support/ptr_vector.h"
+#include "yasmx/Support/registry.h"
+#include "yasmx/Arch.h"
+#include "yasmx/Bytecode.h"
+#include "yasmx/BytecodeOutput.h"
+#include "yasmx/Bytes.h"
+#include "yasmx/IntNum.h"
+#include "yasmx/Location.h"
+#include "yasmx/NumericOutput.h"
+#include "yasmx/Object.h"
+#include "yasmx/Section.h"
+#include "yasmx/Value.h"
+
+
+using namespace yasm;
+using namespace yasm::listfmt;
+
+namespace {
+
+/// Width of the output column; longer output continues on following rows.
+const std::string::size_type HEX_WIDTH = 18;
+
+/// Writes list rows.  Each source line gets one row per HEX_WIDTH
+/// characters of output; only the first row shows the source text.
+class ListWriter
+{
+public:
+    ListWriter(llvm::raw_ostream& os)
+        : m_os(os), m_line(0), m_level(0), m_has_text(false), m_offset(0)
+    {}
+
+    /// Start a new line, finishing the previous one.
+    /// @param line     line number
+    /// @param level    include nesting level
+    /// @param has_text if false, the line has already been shown, so only
+    ///                 output is listed
+    /// @param text     source text
+    void StartLine(unsigned long line,
+                   unsigned int level,
+                   bool has_text,
+                   llvm::StringRef text);
+
+    /// Add output to the current line.
+    /// @param hex      output text (hex digits or a marker)
+    /// @param offset   section offset of the output
+    void Add(llvm::StringRef hex, unsigned long offset);
+
+    /// Finish the current line.
+    void EndLine()
+    {
+        if (!m_hex.empty() || m_has_text)
+            FlushRow(false);
+    }
+
+private:
+    void FlushRow(bool cont);
+
+    llvm::raw_ostream& m_os;
+    unsigned long m_line;
+    unsigned int m_level;
+    bool m_has_text;
+    llvm::StringRef m_text;
+    unsigned long m_offset;     ///< offset of first output in m_hex
+    std::string m_hex;
+};
+
+/// Source file being listed.
+struct ListFile
+{
+    FileID fid;
+    const char* start;      ///< start of buffer
+    const char* pos;        ///< start of next line to list
+    const char* end;        ///< end of buffer
+    unsigned long line;     ///< line number of pos
+};
+
+/// Lists source lines in order, following includes.
+class SourceLister
+{
+public:
+    SourceLister(SourceManager& smgr, ListWriter& writer);
+
+    /// Start the line of a statement.  Lists the source lines before it
+    /// that have not been listed yet.
+    /// @param source   statement source location
+    void StartStatement(SourceLocation source);
+
+    /// List the remaining lines of all open files.
+    void Finish();
+
+private:
+    void Open(FileID fid);
+    void Close();
+
+    /// Get the next line of a file.
+    /// @param f        file
+    /// @return Line text (without line ending).
+    llvm::StringRef TakeLine(ListFile& f);
+
+    /// List all lines of a file before the line containing a location.
+    /// @param level    include nesting level of the file
+    /// @param ptr      location in file buffer
+    void ListBefore(unsigned int level, const char* ptr);
+
+    SourceManager& m_smgr;
+    ListWriter& m_writer;
+
+    /// Open files, from the main file down to the innermost include.
+    std::vector<ListFile> m_files;
+
+    /// Scratch include chain of a statement, innermost first.
+    std::vector<std::pair<FileID, unsigned int> > m_chain;
+};
+
+/// A run of captured section output.
+struct Piece
+{
+    enum Kind
+    {
+        DATA,           ///< bytes
+        RELOC,          ///< bytes of a relocated value
+        GAP             ///< uninitialized space
+    };
+    Kind kind;
+    unsigned long offset;   ///< section offset
+    unsigned long size;     ///< size in bytes
+    unsigned long data;     ///< index of first byte in data (DATA, RELOC)
+};
+
+/// Lists the output of a section, one statement at a time.  Bytecodes are
+/// output on demand, so only one bytecode's output is held at a time.
+class SectionLister : public BytecodeOutput
+{
+public:
+    SectionLister(Section& sect, Diagnostic& diags);
+    ~SectionLister();
+
+    /// Get the next statement to list.
+    /// @return Statement, or NULL if all statements have been listed.
+    const Section::Statement* getStatement() const
+    {
+        if (m_stmt == m_sect.getStatements().size())
+            return 0;
+        return &m_sect.getStatements()[m_stmt];
+    }
+
+    /// List the output of the next statement and advance to the following
+    /// one.  Output before the first statement is listed with the first
+    /// statement, and output after the last with the last.
+    /// @param writer   list writer
+    void ListStatement(ListWriter& writer);
+
+    // BytecodeOutput overrides
+    bool ConvertValueToBytes(Value& value,
+                             Location loc,
+                             NumericOutput& num_out);
+
+protected:
+    void DoOutputGap(unsigned long size, SourceLocation source);
+    void DoOutputBytes(const Bytes& bytes, SourceLocation source);
+
+private:
+    /// Replace the captured output with that of the next bytecode.
+    /// @return False if there are no more bytecodes.
+    bool NextBytecode();
+
+    void AddPiece(Piece::Kind kind,
+                  unsigned long offset,
+                  unsigned long size,
+                  const unsigned char* data);
+
+    Section& m_sect;
+    const Arch& m_arch;
+    Section::Statements::size_type m_stmt;  ///< next statement
+
+    Section::bc_iterator m_bc;              ///< next bytecode to output
+    Section::bc_iterator m_bc_end;
+    unsigned long m_bc_offset;              ///< offset of output bytecode
+
+    /// Captured output of the current bytecode.
+    std::vector<Piece> m_pieces;
+    Bytes m_data;
+    std::vector<Piece>::size_type m_piece;  ///< next piece to list
+    unsigned long m_piece_pos;              ///< bytes of it already listed
+
+    /// Relocated values converted since the last output, as
+    /// (offset, size) pairs.
+    std::vector<std::pair<unsigned long, unsigned long> > m_relocs;
+};
+
+/// Orders section listers by their next statement (earliest first).
+struct LaterStatement
+{
+    bool operator() (const SectionLister* lhs, const SectionLister* rhs) const
+    {
+        return lhs->getStatement()->index > rhs->getStatement()->index;
+    }
+};
+
+} // anonymous namespace
+
+static const char hexdigits[] = "0123456789ABCDEF";
+
+void
+ListWriter::StartLine(unsigned long line,
+                      unsigned int level,
+                      bool has_text,
+                      llvm::StringRef text)
+{
+    EndLine();
+    m_line = line;
+    m_level = level;
+    m_has_text = has_text;
+    m_text = text;
+}
+
+void
+ListWriter::Add(llvm::StringRef hex, unsigned long offset)
+{
+    if (!m_hex.empty() && m_hex.size() + hex.size() > HEX_WIDTH)
+        FlushRow(true);
+    if (m_hex.empty())
+        m_offset = offset;
+    m_hex.append(hex.data(), hex.size());
+}
+
+void
+ListWriter::FlushRow(bool cont)
+{
+    m_os << llvm::format("%6lu ", m_line);
+    if (!m_hex.empty())
+    {
+        m_os << llvm::format("%08lX ", m_offset) << m_hex;
+        if (cont)
+            m_os << '-';
+    }
+
+    if (m_has_text)
+    {
+        // Pad the output column.
+        std::string::size_type width = m_hex.size() + (cont ? 1 : 0);
+        if (m_hex.empty())
+            m_os.indent(HEX_WIDTH + 9);
+        else if (width < HEX_WIDTH)
+            m_os.indent(static_cast<unsigned int>(HEX_WIDTH - width));
+
+        if (m_level > 0)
+            m_os << llvm::format("%s<%u>", m_level < 10 ? " " : "", m_level);
+        else
+            m_os << "    ";
+        m_os << ' ' << m_text;
+    }
+    m_os << '\n';
+
+    m_hex.clear();
+    m_has_text = false;
+}
+
+SourceLister::SourceLister(SourceManager& smgr, ListWriter& writer)
+    : m_smgr(smgr),
+      m_writer(writer)
+{
+    Open(smgr.getMainFileID());
+}
+
+void
+SourceLister::Open(FileID fid)
+{
+    llvm::StringRef data = m_smgr.getBufferData(fid);
+    ListFile f = { fid, data.begin(), data.begin(), data.end(), 1 };
+    m_files.push_back(f);
+}
+
+void
+SourceLister::Close()
+{
+    ListFile& f = m_files.back();
+    unsigned int level = static_cast<unsigned int>(m_files.size() - 1);
+    while (f.pos < f.end)
+    {
+        unsigned long line = f.line;
+        m_writer.StartLine(line, level, true, TakeLine(f));
+    }
+    m_files.pop_back();
+}
+
+llvm::StringRef
+SourceLister::TakeLine(ListFile& f)
+{
+    const char* eol = static_cast<const char*>(
+        std::memchr(f.pos, '\n', static_cast<size_t>(f.end - f.pos)));
+    const char* next = eol ? eol+1 : f.end;
+    if (!eol)
+        eol = f.end;
+    if (eol != f.pos && eol[-1] == '\r')
+        --eol;
+
+    llvm::StringRef text(f.pos, static_cast<size_t>(eol - f.pos));
+    f.pos = next;
+    ++f.line;
+    return text;
+}
+
+void
+SourceLister::ListBefore(unsigned int level, const char* ptr)
+{
+    ListFile& f = m_files[level];
+    while (f.pos < f.end)
+    {
+        const char* eol = static_cast<const char*>(
+            std::memchr(f.pos, '\n', static_cast<size_t>(f.end - f.pos)));
+        if (!eol || ptr <= eol)
+            break;
+        unsigned long line = f.line;
+        m_writer.StartLine(line, level, true, TakeLine(f));
+    }
+}
+
+void
+SourceLister::StartStatement(SourceLocation source)
+{
+    if (source.isInvalid())
+    {
+        // List as more output of the current line.
+        const ListFile& f = m_files.back();
+        m_writer.StartLine(f.line > 1 ? f.line-1 : 1,
+                           static_cast<unsigned int>(m_files.size() - 1),
+                           false, llvm::StringRef());
+        return;
+    }
+
+    // Find the chain of includes leading to the statement.
+    m_chain.clear();
+    SourceLocation loc = m_smgr.getInstantiationLoc(source);
+    for (;;)
+    {
+        std::pair<FileID, unsigned int> decomp = m_smgr.getDecomposedLoc(loc);
+        m_chain.push_back(decomp);
+        loc = m_smgr.getSLocEntry(decomp.first).getFile().getIncludeLoc();
+        if (loc.isInvalid())
+            break;
+        loc = m_smgr.getInstantiationLoc(loc);
+    }
+
+    // Close files that are no longer part of the chain.
+    std::vector<ListFile>::size_type depth = m_chain.size(), common = 0;
+    while (common < m_files.size() && common < depth &&
+           m_files[common].fid == m_chain[depth-1-common].first)
+        ++common;
+    while (m_files.size() > common)
+        Close();
+
+    // List lines down the chain; an including line is listed before the
+    // lines of the file it includes.
+    for (std::vector<ListFile>::size_type i=0; i<depth; ++i)
+    {
+        const std::pair<FileID, unsigned int>& decomp = m_chain[depth-1-i];
+        if (i == m_files.size())
+            Open(decomp.first);
+        unsigned int level = static_cast<unsigned int>(i);
+        const char* ptr = m_files[i].start + decomp.second;
+        ListBefore(level, ptr);
+
+        ListFile& f = m_files[i];
+        bool listed = (f.pos > ptr || f.pos == f.end);
+        unsigned long line = listed ? f.line-1 : f.line;
+        if (i+1 < depth)
+        {
+            if (!listed)
+                m_writer.StartLine(line, level, true, TakeLine(f));
+        }
+        else if (listed)
+            m_writer.StartLine(line, level, false, llvm::StringRef());
+        else
+            m_writer.StartLine(line, level, true, TakeLine(f));
+    }
+}
+
+void
+SourceLister::Finish()
+{
+    m_writer.EndLine();
+    while (!m_files.empty())
+        Close();
+    m_writer.EndLine();
+}
+
+SectionLister::SectionLister(Section& sect, Diagnostic& diags)
+    : BytecodeOutput(diags),
+      m_sect(sect),
+      m_arch(*sect.getObject()->getArch()),
+      m_stmt(0),
+      m_bc(sect.bytecodes_begin()),
+      m_bc_end(sect.bytecodes_end()),
+      m_bc_offset(0),
+      m_piece(0),
+      m_piece_pos(0)
+{
+}
+
+SectionLister::~SectionLister()
+{
+}
+
+bool
+SectionLister::NextBytecode()
+{
+    if (m_bc == m_bc_end)
+        return false;
+
+    m_pieces.clear();
+    m_data.resize(0);
+    m_relocs.clear();
+    m_piece = 0;
+    m_piece_pos = 0;
+
+    Bytecode& bc = *m_bc++;
+    m_bc_offset = bc.getOffset();
+    ResetNumOutput();
+    bc.Output(*this);
+    return true;
+}
+
+void
+SectionLister::ListStatement(ListWriter& writer)
+{
+    unsigned long end = ~0UL;
+    ++m_stmt;
+    if (const Section::Statement* next = getStatement())
+        end = next->loc.getOffset();
+
+    char buf[32];
+    for (;;)
+    {
+        if (m_piece == m_pieces.size())
+        {
+            if (!NextBytecode())
+                break;
+            continue;
+        }
+
+        const Piece& piece = m_pieces[m_piece];
+        unsigned long pos = piece.offset + m_piece_pos;
+        if (pos >= end)
+            break;
+        unsigned long avail = std::min(piece.size - m_piece_pos, end - pos);
+
+        if (piece.kind == Piece::GAP)
+        {
+            std::string res;
+            llvm::raw_string_ostream oss(res);
+            oss << "<res " << llvm::format("%08lX", avail) << '>';
+            writer.Add(oss.str(), pos);
+        }
+        else if (piece.kind == Piece::RELOC && m_piece_pos == 0 &&
+                 avail == piece.size && piece.size*2+2 <= HEX_WIDTH)
+        {
+            std::string::size_type n = 0;
+            buf[n++] = '(';
+            for (unsigned long i=0; i<piece.size; ++i)
+            {
+                unsigned char byte = m_data[piece.data+i];
+                buf[n++] = hexdigits[byte >> 4];
+                buf[n++] = hexdigits[byte & 0xF];
+            }
+            buf[n++] = ')';
+            writer.Add(llvm::StringRef(buf, n), pos);
+        }
+        else
+        {
+            for (unsigned long i=0; i<avail; ++i)
+            {
+                unsigned char byte = m_data[piece.data+m_piece_pos+i];
+                buf[0] = hexdigits[byte >> 4];
+                buf[1] = hexdigits[byte & 0xF];
+                writer.Add(llvm::StringRef(buf, 2), pos+i);
+            }
+        }
+
+        m_piece_pos += avail;
+        if (m_piece_pos == piece.size)
+        {
+            ++m_piece;
+            m_piece_pos = 0;
+        }
+    }
+}
+
+bool
+SectionLister::ConvertValueToBytes(Value& value,
+                                   Location loc,
+                                   NumericOutput& num_out)
+{
+    m_arch.setEndian(num_out.getBytes());
+
+    IntNum intn(0);
+    if (value.OutputBasic(num_out, &intn, getDiagnostics()))
+        return true;
+
+    // Relocated value; list the absolute portion and mark it.
+    num_out.OutputInteger(intn);
+    m_relocs.push_back(std::make_pair(loc.getOffset(),
+        static_cast<unsigned long>(num_out.getBytes().size())));
+    return true;
+}
+
+void
+SectionLister::AddPiece(Piece::Kind kind,
+                        unsigned long offset,
+                        unsigned long size,
+                        const unsigned char* data)
+{
+    if (size == 0)
+        return;
+    // Merge runs of gaps (e.g. from "resb 64") into a single piece.
+    if (kind == Piece::GAP && m_pieces.size() > m_piece)
+    {
+        Piece& last = m_pieces.back();
+        if (last.kind == Piece::GAP && last.offset + last.size == offset)
+        {
+            last.size += size;
+            return;
+        }
+    }
+    Piece piece = { kind, offset, size, m_data.size() };
+    m_pieces.push_back(piece);
+    if (data)
+        m_data.insert(m_data.end(), data, data+size);
+}
+
+void
+SectionLister::DoOutputGap(unsigned long size, SourceLocation source)
+{
+    AddPiece(Piece::GAP, m_bc_offset + getNumOutput(), size, 0);
+    m_relocs.clear();
+}
+
+void
+SectionLister::DoOutputBytes(const Bytes& bytes, SourceLocation source)
+{
+    unsigned long start = m_bc_offset + getNumOutput();
+    unsigned long end = start + bytes.size();
+    unsigned long pos = start;
+    const unsigned char* data = bytes.empty() ? 0 : &bytes[0];
+
+    // Split out the relocated values within these bytes.  Values converted
+    // without being output here (or with an inexact location) are ignored.
+    for (std::vector<std::pair<unsigned long, unsigned long> >::const_iterator
+         i=m_relocs.begin(), iend=m_relocs.end(); i != iend; ++i)
+    {
+        if (i->first < pos || i->first + i->second > end)
+            continue;
+        AddPiece(Piece::DATA, pos, i->first - pos, data + (pos - start));
+        AddPiece(Piece::RELOC, i->first, i->second,
+                 data + (i->first - start));
+        pos = i->first + i->second;
+    }
+    AddPiece(Piece::DATA, pos, end - pos, data + (pos - start));
+    m_relocs.clear();
+}
+
+NasmList::~NasmList()
+{
+}
+
+void
+NasmList::Output(llvm::raw_ostream& os,
+                 Object& object,
+                 SourceManager& smgr,
+                 Diagnostic& diags)
+{
+    // Bytecodes are output again to list them; any problems were already
+    // reported when the object file was output.
+    Diagnostic quiet;
+    quiet.setSuppressAllDiagnostics();
+
+    // Merge the statements of all sections back into source order.
+    stdx::ptr_vector<SectionLister> sects;
+    stdx::ptr_vector_owner<SectionLister> sects_owner(sects);
+    std::priority_queue<SectionLister*, std::vector<SectionLister*>,
+                        LaterStatement> queue;
+    for (Object::section_iterator i=object.sections_begin(),
+         end=object.sections_end(); i != end; ++i)
+    {
+        if (i->getStatements().empty())
+            continue;
+        sects.push_back(new SectionLister(*i, quiet));
+        queue.push(&sects.back());
+    }
+
+    ListWriter writer(os);
+    SourceLister source(smgr, writer);
+    while (!queue.empty())
+    {
+        SectionLister* sect = queue.top();
+        queue.pop();
+        source.StartStatement(sect->getStatement()->source);
+        sect->ListStatement(writer);
+        if (sect->getStatement())
+            queue.push(sect);
+    }
+    source.Finish();
+}
+
+void
+yasm_listfmt_nasm_DoRegister()
+{
+    RegisterModule<ListFormatModule,
+                   ListFormatModuleImpl<NasmList> >("nasm");
+}
@@ -0,0 +1,64 @@
+#ifndef YASM_NASMLIST_H
+#define YASM_NASMLIST_H
+//
+// NASM-style list format
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include "yasmx/Config/export.h"
+#include "yasmx/ListFormat.h"
+
+
+namespace yasm
+{
+namespace listfmt
+{
+
+/// NASM-style list format.  Each source line is listed with its line
+/// number, the offset of its output within its section, and the output
+/// bytes.  Relocated values are shown in parentheses, with the absolute
+/// portion filled in, and uninitialized space as "<res size>".
+///
+/// The listing is written in source order while walking the bytecodes of
+/// every section alongside the source buffers, so it takes time linear in
+/// the size of the source and output and only holds the output of one
+/// bytecode per section in memory.
+class YASM_STD_EXPORT NasmList : public ListFormat
+{
+public:
+    NasmList(const ListFormatModule& module) : ListFormat(module) {}
+    ~NasmList();
+
+    static llvm::StringRef getName() { return "NASM-style list format"; }
+    static llvm::StringRef getKeyword() { return "nasm"; }
+
+    void Output(llvm::raw_ostream& os,
+                Object& object,
+                SourceManager& smgr,
+                Diagnostic& diags);
+};
+
+}} // namespace yasm::listfmt
+
+#endif
@@ -208,54 +208,75 @@ BinMapOutput::OutputSectionsDetail()
     InnerSectionsDetail(m_groups);
 }
 
-static unsigned long
-CountSymbols(const Object& object, const Section* sect)
-{
-    unsigned long count = 0;
-
-    for (Object::const_symbol_iterator sym = object.symbols_begin(),
-         end = object.symbols_end(); sym != end; ++sym)
-    {
-        Location loc;
-        // TODO: autodetect wider size
-        if ((sect == 0 && sym->getEqu()) ||
-            (sym->getLabel(&loc) && loc.bc->getContainer() == sect))
-            count++;
-    }
-
-    return count;
-}
-
 void
-BinMapOutput::OutputSymbols(const Section* sect)
+BinMapOutput::IndexSymbols()
 {
+    // Sort the symbols into EQUs and the labels of each section in a single
+    // pass over the symbol table, so each section's list can be output
+    // without looking at any other symbols.
+    m_equs.clear();
+    m_labels.clear();
+    m_label_index.clear();
+
     for (Object::const_symbol_iterator sym = m_object.symbols_begin(),
          end = m_object.symbols_end(); sym != end; ++sym)
     {
-        const std::string& name = sym->getName();
         const Expr* equ;
         Location loc;
 
-        if (sect == 0 && (equ = sym->getEqu()))
+        if ((equ = sym->getEqu()))
         {
             std::auto_ptr<Expr> realequ(equ->clone());
             realequ->Simplify(m_diags);
             BinSimplify(*realequ);
             realequ->Simplify(m_diags);
-            OutputIntNum(realequ->getIntNum());
-            m_os << "  " << name << '\n';
+
+            m_equs.push_back(MapSymbol());
+            m_equs.back().value = realequ->getIntNum();
+            m_equs.back().name = sym->getName();
+        }
+        else if (sym->getLabel(&loc))
+        {
+            const Section* sect = loc.bc->getContainer()->AsSection();
+            if (!sect)
+                continue;
+
+            std::pair<llvm::DenseMap<const Section*, unsigned long>::iterator,
+                      bool> idx = m_label_index.insert(
+                          std::make_pair(sect, m_labels.size()));
+            if (idx.second)
+                m_labels.push_back(MapSymbols());
+
+            MapSymbols& labels = m_labels[idx.first->second];
+            labels.push_back(MapSymbol());
+            labels.back().value = loc.getOffset();
+            labels.back().name = sym->getName();
+        }
+    }
+}
+
+void
+BinMapOutput::OutputSymbols(const Section* sect, const MapSymbols& syms)
+{
+    for (MapSymbols::const_iterator sym = syms.begin(), end = syms.end();
+         sym != end; ++sym)
+    {
+        if (sect == 0)
+        {
+            OutputIntNum(sym->value);
+            m_os << "  " << sym->name << '\n';
         }
-        else if (sym->getLabel(&loc) && loc.bc->getContainer() == sect)
+        else
         {
             // Real address
-            OutputIntNum(sect->getLMA() + loc.getOffset());
+            OutputIntNum(sect->getLMA() + sym->value);
             m_os << "  ";
 
             // Virtual address
-            OutputIntNum(sect->getVMA() + loc.getOffset());
+            OutputIntNum(sect->getVMA() + sym->value);
 
             // Name
-            m_os << "  " << name << '\n';
+            m_os << "  " << sym->name << '\n';
         }
     }
 }
@@ -266,7 +287,9 @@ BinMapOutput::InnerSectionsSymbols(const BinGroups& groups)
     for (BinGroups::const_iterator group = groups.begin(), end=groups.end();
          group != end; ++group)
     {
-        if (CountSymbols(m_object, &group->m_section) > 0)
+        llvm::DenseMap<const Section*, unsigned long>::const_iterator idx =
+            m_label_index.find(&group->m_section);
+        if (idx != m_label_index.end())
         {
             llvm::StringRef name = group->m_section.getName();
             m_os << "---- Section " << name << ' ';
@@ -277,7 +300,7 @@ BinMapOutput::InnerSectionsSymbols(const BinGroups& groups)
             m_os << llvm::format("%-*s", m_bytes*2+2, (const char*)"Real");
             m_os << llvm::format("%-*s", m_bytes*2+2, (const char*)"Virtual");
             m_os << "Name\n";
-            OutputSymbols(&group->m_section);
+            OutputSymbols(&group->m_section, m_labels[idx->second]);
             m_os << "\n\n";
         }
 
@@ -294,12 +317,10 @@ BinMapOutput::OutputSectionsSymbols()
         m_os << '-';
     m_os << "\n\n";
 
-    // We do two passes for EQU and each section; the first pass
-    // determines the byte width to use for the value and whether any
-    // symbols are present, the second pass actually outputs the text.
+    IndexSymbols();
 
     // EQUs
-    if (CountSymbols(m_object, 0) > 0)
+    if (!m_equs.empty())
     {
         m_os << "---- No Section ";
         for (int i=0; i<63; ++i)
@@ -307,7 +328,7 @@ BinMapOutput::OutputSectionsSymbols()
         m_os << "\n\n";
         m_os << llvm::format("%-*s", m_bytes*2+2, (const char*)"Value");
         m_os << "Name\n";
-        OutputSymbols(0);
+        OutputSymbols(0, m_equs);
         m_os << "\n\n";
     }
 
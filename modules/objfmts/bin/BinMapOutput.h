@@ -26,7 +26,13 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 //
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringRef.h"
 #include "yasmx/Config/export.h"
+#include "yasmx/IntNum.h"
+
 #include "BinLink.h"
 
 
@@ -36,8 +42,8 @@ namespace yasm
 {
 
 class Diagnostic;
-class IntNum;
 class Object;
+class Section;
 
 namespace objfmt
 {
@@ -59,10 +65,20 @@ public:
     void OutputSectionsSymbols();
 
 private:
+    /// A symbol to list in the map, with its value (EQUs) or offset within
+    /// its section (labels).
+    struct MapSymbol
+    {
+        IntNum value;
+        llvm::StringRef name;
+    };
+    typedef std::vector<MapSymbol> MapSymbols;
+
     void OutputIntNum(const IntNum& intn);
     void InnerSectionsSummary(const BinGroups& groups);
     void InnerSectionsDetail(const BinGroups& groups);
-    void OutputSymbols(const Section* sect);
+    void IndexSymbols();
+    void OutputSymbols(const Section* sect, const MapSymbols& syms);
     void InnerSectionsSymbols(const BinGroups& groups);
 
     // address width
@@ -73,6 +89,11 @@ private:
     const IntNum& m_origin;     // origin
     const BinGroups& m_groups;  // section groups
     Diagnostic& m_diags;        // diagnostic reporting
+
+    // Symbols to list, in symbol table order, built by IndexSymbols().
+    MapSymbols m_equs;                  // EQUs with simplified values
+    std::vector<MapSymbols> m_labels;   // labels of each section
+    llvm::DenseMap<const Section*, unsigned long> m_label_index;
 };
 
 }} // namespace yasm::objfmt
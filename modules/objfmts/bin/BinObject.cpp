@@ -26,6 +26,9 @@
 //
 #include "BinObject.h"
 
+#include <cassert>
+#include <vector>
+
 #include "llvm/ADT/Twine.h"
 #include "llvm/Support/raw_ostream.h"
 #include "yasmx/Basic/Diagnostic.h"
@@ -34,6 +37,7 @@
 #include "yasmx/Parse/DirHelpers.h"
 #include "yasmx/Parse/NameValue.h"
 #include "yasmx/Support/bitcount.h"
+#include "yasmx/Support/MappedOutputFile.h"
 #include "yasmx/Support/registry.h"
 #include "yasmx/Arch.h"
 #include "yasmx/BytecodeOutput.h"
@@ -88,6 +92,8 @@ BinObject::OutputMap(const IntNum& origin,
         return;
     }
 
+    m_object.setExtraOutput();
+
     BinMapOutput out(os, m_object, origin, groups, diags);
     out.OutputHeader();
     out.OutputOrigin();
@@ -102,14 +108,69 @@ BinObject::OutputMap(const IntNum& origin,
         out.OutputSectionsSymbols();
 }
 
+// Convert a value to bytes.  Binary objects need to resolve against the
+// object, not against the section.
+static bool
+ConvertBinValue(Value& value,
+                Object& object,
+                BytecodeOutput& bc_out,
+                NumericOutput& num_out)
+{
+    Diagnostic& diags = bc_out.getDiagnostics();
+
+    if (value.isRelative())
+    {
+        Location label_loc;
+        IntNum ssymval;
+        Expr syme;
+        SymbolRef rel = value.getRelative();
+
+        if (rel->isAbsoluteSymbol())
+            syme = Expr(0);
+        else if (rel->getLabel(&label_loc) && label_loc.bc->getContainer())
+            syme = Expr(rel);
+        else if (getBinSSymValue(*rel, &ssymval))
+            syme = Expr(ssymval);
+        else
+            goto done;
+
+        // Handle PC-relative
+        if (value.getSubLocation(&label_loc) && label_loc.bc->getContainer())
+            syme -= label_loc;
+
+        // Add into absolute portion
+        value.AddAbs(syme);
+        value.ClearRelative();
+    }
+done:
+    // Simplify absolute portion of value, transforming symrecs
+    if (Expr* abs = value.getAbs())
+    {
+        BinSimplify(*abs);
+        abs->Simplify(diags);
+    }
+
+    // Output
+    IntNum intn;
+    object.getArch()->setEndian(num_out.getBytes());
+    if (value.OutputBasic(num_out, &intn, diags))
+        return true;
+
+    // Couldn't output, assume it contains an external reference.
+    diags.Report(value.getSource().getBegin(), diag::err_bin_extern_ref);
+    return false;
+}
+
 namespace {
+// Writes sections through the output stream, seeking to each section's
+// file offset.
 class BinOutput : public BytecodeStreamOutput
 {
 public:
     BinOutput(llvm::raw_fd_ostream& os, Object& object, Diagnostic& diags);
     ~BinOutput();
 
-    void OutputSection(Section& sect, const IntNum& origin);
+    void OutputSection(Section& sect, unsigned long file_start);
 
     // OutputBytecode overrides
     bool ConvertValueToBytes(Value& value,
@@ -119,7 +180,24 @@ public:
 private:
     Object& m_object;
     llvm::raw_fd_ostream& m_fd_os;
-    BytecodeNoOutput m_no_output;
+};
+
+// Writes sections directly into a memory-mapped output file.
+class BinMemoryOutput : public BytecodeMemoryOutput
+{
+public:
+    BinMemoryOutput(Object& object, Diagnostic& diags);
+    ~BinMemoryOutput();
+
+    void OutputSection(Section& sect, unsigned char* buf, unsigned long size);
+
+    // OutputBytecode overrides
+    bool ConvertValueToBytes(Value& value,
+                             Location loc,
+                             NumericOutput& num_out);
+
+private:
+    Object& m_object;
 };
 } // anonymous namespace
 
@@ -128,8 +206,7 @@ BinOutput::BinOutput(llvm::raw_fd_ostream& os,
                      Diagnostic& diags)
     : BytecodeStreamOutput(os, diags),
       m_object(object),
-      m_fd_os(os),
-      m_no_output(diags)
+      m_fd_os(os)
 {
 }
 
@@ -138,44 +215,19 @@ BinOutput::~BinOutput()
 }
 
 void
-BinOutput::OutputSection(Section& sect, const IntNum& origin)
+BinOutput::OutputSection(Section& sect, unsigned long file_start)
 {
-    BytecodeOutput* outputter;
-
-    if (sect.isBSS())
+    m_fd_os.seek(file_start);
+    if (m_os.has_error())
     {
-        outputter = &m_no_output;
-    }
-    else
-    {
-        IntNum file_start = sect.getLMA();
-        file_start -= origin;
-        if (file_start.getSign() < 0)
-        {
-            Diag(SourceLocation(), diag::err_section_before_origin)
-                << sect.getName();
-            return;
-        }
-        if (!file_start.isOkSize(sizeof(unsigned long)*8, 0, 0))
-        {
-            Diag(SourceLocation(), diag::err_start_too_large)
-                << sect.getName();
-            return;
-        }
-        m_fd_os.seek(file_start.getUInt());
-        if (m_os.has_error())
-        {
-            Diag(SourceLocation(), diag::err_file_output_seek);
-            return;
-        }
-
-        outputter = this;
+        Diag(SourceLocation(), diag::err_file_output_seek);
+        return;
     }
 
     for (Section::bc_iterator i=sect.bytecodes_begin(),
          end=sect.bytecodes_end(); i != end; ++i)
     {
-        i->Output(*outputter);
+        i->Output(*this);
     }
 }
 
@@ -184,48 +236,100 @@ BinOutput::ConvertValueToBytes(Value& value,
                                Location loc,
                                NumericOutput& num_out)
 {
-    // Binary objects we need to resolve against object, not against section.
-    if (value.isRelative())
-    {
-        Location label_loc;
-        IntNum ssymval;
-        Expr syme;
-        SymbolRef rel = value.getRelative();
+    return ConvertBinValue(value, m_object, *this, num_out);
+}
 
-        if (rel->isAbsoluteSymbol())
-            syme = Expr(0);
-        else if (rel->getLabel(&label_loc) && label_loc.bc->getContainer())
-            syme = Expr(rel);
-        else if (getBinSSymValue(*rel, &ssymval))
-            syme = Expr(ssymval);
-        else
-            goto done;
+BinMemoryOutput::BinMemoryOutput(Object& object, Diagnostic& diags)
+    : BytecodeMemoryOutput(diags),
+      m_object(object)
+{
+}
 
-        // Handle PC-relative
-        if (value.getSubLocation(&label_loc) && label_loc.bc->getContainer())
-            syme -= label_loc;
+BinMemoryOutput::~BinMemoryOutput()
+{
+}
 
-        // Add into absolute portion
-        value.AddAbs(syme);
-        value.ClearRelative();
+void
+BinMemoryOutput::OutputSection(Section& sect,
+                               unsigned char* buf,
+                               unsigned long size)
+{
+    setBuffer(buf, size);
+    for (Section::bc_iterator i=sect.bytecodes_begin(),
+         end=sect.bytecodes_end(); i != end; ++i)
+    {
+        i->Output(*this);
     }
-done:
-    // Simplify absolute portion of value, transforming symrecs
-    if (Expr* abs = value.getAbs())
+}
+
+bool
+BinMemoryOutput::ConvertValueToBytes(Value& value,
+                                     Location loc,
+                                     NumericOutput& num_out)
+{
+    return ConvertBinValue(value, m_object, *this, num_out);
+}
+
+// Output BSS sections only for diagnostic purposes.
+static void
+OutputBSSSection(Section& sect, Diagnostic& diags)
+{
+    BytecodeNoOutput no_output(diags);
+    for (Section::bc_iterator i=sect.bytecodes_begin(),
+         end=sect.bytecodes_end(); i != end; ++i)
     {
-        BinSimplify(*abs);
-        abs->Simplify(getDiagnostics());
+        i->Output(no_output);
     }
+}
 
-    // Output
-    IntNum intn;
-    m_object.getArch()->setEndian(num_out.getBytes());
-    if (value.OutputBasic(num_out, &intn, getDiagnostics()))
-        return true;
+// Calculate the file offset of each section's contents and the total
+// file size.  BSS sections take no file space and get offset 0.
+static bool
+CalcFileLayout(Object& object,
+               const IntNum& origin,
+               std::vector<unsigned long>* offsets,
+               unsigned long* file_size,
+               Diagnostic& diags)
+{
+    bool ok = true;
+    *file_size = 0;
+    offsets->clear();
+    offsets->reserve(object.getNumSections());
 
-    // Couldn't output, assume it contains an external reference.
-    Diag(value.getSource().getBegin(), diag::err_bin_extern_ref);
-    return false;
+    for (Object::section_iterator i=object.sections_begin(),
+         end=object.sections_end(); i != end; ++i)
+    {
+        offsets->push_back(0);
+        if (i->isBSS())
+            continue;
+
+        IntNum file_start = i->getLMA();
+        file_start -= origin;
+        if (file_start.getSign() < 0)
+        {
+            diags.Report(SourceLocation(), diag::err_section_before_origin)
+                << i->getName();
+            ok = false;
+            continue;
+        }
+
+        BinSection* bsd = i->getAssocData<BinSection>();
+        assert(bsd && bsd->has_length);
+        IntNum file_end = file_start;
+        file_end += bsd->length;
+        if (!file_end.isOkSize(sizeof(unsigned long)*8, 0, 0))
+        {
+            diags.Report(SourceLocation(), diag::err_start_too_large)
+                << i->getName();
+            ok = false;
+            continue;
+        }
+
+        offsets->back() = file_start.getUInt();
+        if (!bsd->length.isZero() && file_end.getUInt() > *file_size)
+            *file_size = file_end.getUInt();
+    }
+    return ok;
 }
 
 static void
@@ -297,12 +401,45 @@ BinObject::Output(llvm::raw_fd_ostream& os,
     if (!link.CheckLMAOverlap())
         return;
 
-    // Output sections
+    // Lay out the file up front so it can be written in place.
+    std::vector<unsigned long> offsets;
+    unsigned long file_size;
+    if (!CalcFileLayout(m_object, origin, &offsets, &file_size, diags))
+        return;
+
+    // Output sections, directly into the mapped file if possible, otherwise
+    // through the stream.
+    MappedOutputFile mapped(os);
+    if (mapped.Map(file_size))
+    {
+        BinMemoryOutput out(m_object, diags);
+        std::vector<unsigned long>::const_iterator off = offsets.begin();
+        for (Object::section_iterator i=m_object.sections_begin(),
+             end=m_object.sections_end(); i != end; ++i, ++off)
+        {
+            if (i->isBSS())
+            {
+                OutputBSSSection(*i, diags);
+                continue;
+            }
+            BinSection* bsd = i->getAssocData<BinSection>();
+            out.OutputSection(*i, mapped.getData() + *off,
+                              bsd->length.getUInt());
+        }
+        if (!mapped.Unmap())
+            diags.Report(SourceLocation(), diag::err_file_output_write);
+        return;
+    }
+
     BinOutput out(os, m_object, diags);
+    std::vector<unsigned long>::const_iterator off = offsets.begin();
     for (Object::section_iterator i=m_object.sections_begin(),
-         end=m_object.sections_end(); i != end; ++i)
+         end=m_object.sections_end(); i != end; ++i, ++off)
     {
-        out.OutputSection(*i, origin);
+        if (i->isBSS())
+            OutputBSSSection(*i, diags);
+        else
+            out.OutputSection(*i, *off);
     }
 }
 
@@ -51,6 +51,7 @@
 #include "yasmx/Parse/DirHelpers.h"
 #include "yasmx/Parse/NameValue.h"
 #include "yasmx/Support/bitcount.h"
+#include "yasmx/Support/MappedOutputFile.h"
 #include "yasmx/Support/registry.h"
 #include "yasmx/Support/scoped_array.h"
 #include "yasmx/Arch.h"
@@ -732,61 +733,19 @@ ElfObject::FinalizeSymbol(Symbol& sym,
         elfsym->setName(strtab.getIndex(sym.getName()));
 }
 
-namespace {
-class ElfOutput : public BytecodeStreamOutput
-{
-public:
-    ElfOutput(llvm::raw_fd_ostream& os,
-              ElfObject& objfmt,
-              Object& object,
-              Diagnostic& diags);
-    ~ElfOutput();
-
-    void OutputGroup(ElfGroup& group);
-    void OutputSection(Section& sect, StringTable& shstrtab);
-
-    // OutputBytecode overrides
-    bool ConvertValueToBytes(Value& value,
-                             Location loc,
-                             NumericOutput& num_out);
-    bool ConvertSymbolToBytes(SymbolRef sym,
-                              Location loc,
-                              NumericOutput& num_out);
-
-private:
-    ElfObject& m_objfmt;
-    Object& m_object;
-    llvm::raw_fd_ostream& m_fd_os;
-    BytecodeNoOutput m_no_output;
-    SymbolRef m_GOT_sym;
-};
-} // anonymous namespace
-
-ElfOutput::ElfOutput(llvm::raw_fd_ostream& os,
-                     ElfObject& objfmt,
-                     Object& object,
-                     Diagnostic& diags)
-    : BytecodeStreamOutput(os, diags)
-    , m_objfmt(objfmt)
-    , m_object(object)
-    , m_fd_os(os)
-    , m_no_output(diags)
-    , m_GOT_sym(object.FindSymbol("_GLOBAL_OFFSET_TABLE_"))
-{
-}
-
-ElfOutput::~ElfOutput()
-{
-}
-
-bool
-ElfOutput::ConvertSymbolToBytes(SymbolRef sym,
-                                Location loc,
-                                NumericOutput& num_out)
+// Convert a symbol reference to bytes, adding a relocation against it.
+static void
+ConvertElfSymbol(SymbolRef sym,
+                 Location loc,
+                 NumericOutput& num_out,
+                 ElfObject& objfmt,
+                 Object& object,
+                 SymbolRef GOT_sym,
+                 BytecodeOutput& bc_out)
 {
     std::auto_ptr<ElfReloc> reloc =
-        m_objfmt.m_machine->MakeReloc(sym, loc.getOffset());
-    if (reloc->setRel(false, m_GOT_sym, num_out.getSize(), false))
+        objfmt.m_machine->MakeReloc(sym, loc.getOffset());
+    if (reloc->setRel(false, GOT_sym, num_out.getSize(), false))
     {
         // allocate .rel[a] sections on a need-basis
         Section* sect = loc.bc->getContainer()->AsSection();
@@ -794,23 +753,27 @@ ElfOutput::ConvertSymbolToBytes(SymbolRef sym,
     }
     else
     {
-        Diag(num_out.getSource(), diag::err_reloc_invalid_size);
+        bc_out.Diag(num_out.getSource(), diag::err_reloc_invalid_size);
     }
 
-    m_object.getArch()->setEndian(num_out.getBytes());
+    object.getArch()->setEndian(num_out.getBytes());
     num_out.OutputInteger(0);
-    return true;
 }
 
-bool
-ElfOutput::ConvertValueToBytes(Value& value,
-                               Location loc,
-                               NumericOutput& num_out)
+// Convert a value to bytes, adding a relocation if it's relative.
+static bool
+ConvertElfValue(Value& value,
+                Location loc,
+                NumericOutput& num_out,
+                ElfObject& objfmt,
+                Object& object,
+                SymbolRef GOT_sym,
+                BytecodeOutput& bc_out)
 {
-    m_object.getArch()->setEndian(num_out.getBytes());
+    object.getArch()->setEndian(num_out.getBytes());
 
     IntNum intn(0);
-    if (value.OutputBasic(num_out, &intn, getDiagnostics()))
+    if (value.OutputBasic(num_out, &intn, bc_out.getDiagnostics()))
         return true;
 
     if (value.isRelative())
@@ -819,14 +782,15 @@ ElfOutput::ConvertValueToBytes(Value& value,
         if (value.isSegOf() || value.isSectionRelative() ||
             value.getRShift() > 0 || value.getShift() > 0)
         {
-            Diag(value.getSource().getBegin(), diag::err_reloc_too_complex);
+            bc_out.Diag(value.getSource().getBegin(),
+                        diag::err_reloc_too_complex);
             return false;
         }
 
         SymbolRef sym = value.getRelative();
         SymbolRef wrt = value.getWRT();
 
-        if (wrt && wrt == m_objfmt.m_dotdotsym)
+        if (wrt && wrt == objfmt.m_dotdotsym)
             wrt = SymbolRef(0);
         else if (wrt && isWRTElfSymRelative(*wrt))
             ;
@@ -861,34 +825,36 @@ ElfOutput::ConvertValueToBytes(Value& value,
         }
         else if (value.hasSubRelative())
         {
-            Diag(value.getSource().getBegin(), diag::err_reloc_too_complex);
+            bc_out.Diag(value.getSource().getBegin(),
+                        diag::err_reloc_too_complex);
             return false;
         }
 
         // Create relocation
         Section* sect = loc.bc->getContainer()->AsSection();
         std::auto_ptr<ElfReloc> reloc =
-            m_objfmt.m_machine->MakeReloc(sym, loc.getOffset());
+            objfmt.m_machine->MakeReloc(sym, loc.getOffset());
         if (wrt)
         {
             if (!reloc->setWrt(wrt, value.getSize()))
             {
-                Diag(value.getSource().getBegin(), diag::err_invalid_wrt);
+                bc_out.Diag(value.getSource().getBegin(),
+                            diag::err_invalid_wrt);
             }
         }
         else
         {
-            if (!reloc->setRel(pc_rel, m_GOT_sym, value.getSize(),
+            if (!reloc->setRel(pc_rel, GOT_sym, value.getSize(),
                                value.isSigned()))
             {
-                Diag(value.getSource().getBegin(),
-                     diag::err_reloc_invalid_size);
+                bc_out.Diag(value.getSource().getBegin(),
+                            diag::err_reloc_invalid_size);
             }
         }
 
         if (reloc->isValid())
         {
-            reloc->HandleAddend(&intn, m_objfmt.m_config, value.getInsnStart());
+            reloc->HandleAddend(&intn, objfmt.m_config, value.getInsnStart());
             sect->AddReloc(std::auto_ptr<Reloc>(reloc.release()));
         }
     }
@@ -897,91 +863,45 @@ ElfOutput::ConvertValueToBytes(Value& value,
     return true;
 }
 
-void
-ElfOutput::OutputGroup(ElfGroup& group)
+// Generate the contents of a group section.
+static void
+BuildGroupContents(ElfGroup& group, ElfConfig& config, Bytes& bytes)
 {
-    uint64_t pos = m_os.tell();
-    if (m_os.has_error())
-    {
-        Diag(SourceLocation(), diag::err_file_output_position);
-        return;
-    }
-
-    m_fd_os.seek(group.elfsect->setFileOffset(pos));
-    if (m_os.has_error())
-    {
-        Diag(SourceLocation(), diag::err_file_output_seek);
-        return;
-    }
-
-    Bytes& scratch = getScratch();
-    m_objfmt.m_config.setEndian(scratch);
-
-    // sort and uniquify sections before output
-    std::sort(group.sects.begin(), group.sects.end());
-    std::vector<Section*>::iterator it =
-        std::unique(group.sects.begin(), group.sects.end());
-    group.sects.resize(it - group.sects.begin());
+    config.setEndian(bytes);
 
-    Write32(scratch, group.flags);
+    Write32(bytes, group.flags);
     for (std::vector<Section*>::const_iterator i=group.sects.begin(),
          end=group.sects.end(); i != end; ++i)
     {
         ElfSection* elfsect = (*i)->getAssocData<ElfSection>();
         assert(elfsect != 0);
-        Write32(scratch, elfsect->getIndex());
+        Write32(bytes, elfsect->getIndex());
     }
-
-    group.elfsect->setSize(scratch.size());
-    OutputBytes(scratch, SourceLocation());
 }
 
-void
-ElfOutput::OutputSection(Section& sect, StringTable& shstrtab)
+// Output the bytecodes of a user section and name it and its relocation
+// section.  The caller positions the output.
+static void
+OutputSectionContents(Section& sect,
+                      ElfObject& objfmt,
+                      StringTable& shstrtab,
+                      BytecodeOutput& outputter,
+                      Diagnostic& diags)
 {
-    BytecodeOutput* outputter = this;
-
     ElfSection* elfsect = sect.getAssocData<ElfSection>();
     assert(elfsect != 0);
 
-    if (elfsect->getAlign() == 0)
-        elfsect->setAlign(sect.getAlign());
-
     elfsect->setName(shstrtab.getIndex(sect.getName()));
 
-    uint64_t pos;
-    if (sect.isBSS())
-    {
-        // Don't output BSS sections.
-        outputter = &m_no_output;
-        pos = 0;    // position = 0 because it's not in the file
-    }
-    else
-    {
-        pos = m_os.tell();
-        if (m_os.has_error())
-        {
-            Diag(SourceLocation(), diag::err_file_output_position);
-            return;
-        }
-
-        m_fd_os.seek(elfsect->setFileOffset(pos));
-        if (m_os.has_error())
-        {
-            Diag(SourceLocation(), diag::err_file_output_seek);
-            return;
-        }
-    }
-
     // Output bytecodes
     for (Section::bc_iterator i=sect.bytecodes_begin(),
          end=sect.bytecodes_end(); i != end; ++i)
     {
-        if (i->Output(*outputter))
+        if (i->Output(outputter))
             elfsect->AddSize(i->getTotalLen());
     }
 
-    if (getDiagnostics().hasErrorOccurred())
+    if (diags.hasErrorOccurred())
         return;
 
     // Sanity check final section size
@@ -996,10 +916,241 @@ ElfOutput::OutputSection(Section& sect, StringTable& shstrtab)
         return;
 
     // name the relocation section .rel[a].foo
-    std::string relname = m_objfmt.m_config.getRelocSectionName(sect.getName());
+    std::string relname = objfmt.m_config.getRelocSectionName(sect.getName());
     elfsect->setRelName(shstrtab.getIndex(relname));
 }
 
+namespace {
+class ElfOutput : public BytecodeStreamOutput
+{
+public:
+    ElfOutput(llvm::raw_fd_ostream& os,
+              ElfObject& objfmt,
+              Object& object,
+              Diagnostic& diags);
+    ~ElfOutput();
+
+    void OutputGroup(ElfGroup& group);
+    void OutputSection(Section& sect, StringTable& shstrtab);
+
+    // OutputBytecode overrides
+    bool ConvertValueToBytes(Value& value,
+                             Location loc,
+                             NumericOutput& num_out);
+    bool ConvertSymbolToBytes(SymbolRef sym,
+                              Location loc,
+                              NumericOutput& num_out);
+
+private:
+    ElfObject& m_objfmt;
+    Object& m_object;
+    llvm::raw_fd_ostream& m_fd_os;
+    BytecodeNoOutput m_no_output;
+    SymbolRef m_GOT_sym;
+};
+
+// Writes group and user sections directly into a memory-mapped output
+// file.
+class ElfMemoryOutput : public BytecodeMemoryOutput
+{
+public:
+    ElfMemoryOutput(ElfObject& objfmt, Object& object, Diagnostic& diags);
+    ~ElfMemoryOutput();
+
+    void OutputGroup(ElfGroup& group, unsigned char* file);
+    void OutputSection(Section& sect,
+                       StringTable& shstrtab,
+                       unsigned char* file);
+
+    // OutputBytecode overrides
+    bool ConvertValueToBytes(Value& value,
+                             Location loc,
+                             NumericOutput& num_out);
+    bool ConvertSymbolToBytes(SymbolRef sym,
+                              Location loc,
+                              NumericOutput& num_out);
+
+private:
+    ElfObject& m_objfmt;
+    Object& m_object;
+    BytecodeNoOutput m_no_output;
+    SymbolRef m_GOT_sym;
+};
+} // anonymous namespace
+
+ElfOutput::ElfOutput(llvm::raw_fd_ostream& os,
+                     ElfObject& objfmt,
+                     Object& object,
+                     Diagnostic& diags)
+    : BytecodeStreamOutput(os, diags)
+    , m_objfmt(objfmt)
+    , m_object(object)
+    , m_fd_os(os)
+    , m_no_output(diags)
+    , m_GOT_sym(object.FindSymbol("_GLOBAL_OFFSET_TABLE_"))
+{
+}
+
+ElfOutput::~ElfOutput()
+{
+}
+
+bool
+ElfOutput::ConvertSymbolToBytes(SymbolRef sym,
+                                Location loc,
+                                NumericOutput& num_out)
+{
+    ConvertElfSymbol(sym, loc, num_out, m_objfmt, m_object, m_GOT_sym, *this);
+    return true;
+}
+
+bool
+ElfOutput::ConvertValueToBytes(Value& value,
+                               Location loc,
+                               NumericOutput& num_out)
+{
+    return ConvertElfValue(value, loc, num_out, m_objfmt, m_object,
+                           m_GOT_sym, *this);
+}
+
+void
+ElfOutput::OutputGroup(ElfGroup& group)
+{
+    m_fd_os.seek(group.elfsect->getFileOffset());
+    if (m_os.has_error())
+    {
+        Diag(SourceLocation(), diag::err_file_output_seek);
+        return;
+    }
+
+    Bytes& scratch = getScratch();
+    BuildGroupContents(group, m_objfmt.m_config, scratch);
+    OutputBytes(scratch, SourceLocation());
+}
+
+void
+ElfOutput::OutputSection(Section& sect, StringTable& shstrtab)
+{
+    if (sect.isBSS())
+    {
+        // Don't output BSS sections.
+        OutputSectionContents(sect, m_objfmt, shstrtab, m_no_output,
+                              getDiagnostics());
+        return;
+    }
+
+    m_fd_os.seek(sect.getAssocData<ElfSection>()->getFileOffset());
+    if (m_os.has_error())
+    {
+        Diag(SourceLocation(), diag::err_file_output_seek);
+        return;
+    }
+
+    OutputSectionContents(sect, m_objfmt, shstrtab, *this, getDiagnostics());
+}
+
+ElfMemoryOutput::ElfMemoryOutput(ElfObject& objfmt,
+                                 Object& object,
+                                 Diagnostic& diags)
+    : BytecodeMemoryOutput(diags)
+    , m_objfmt(objfmt)
+    , m_object(object)
+    , m_no_output(diags)
+    , m_GOT_sym(object.FindSymbol("_GLOBAL_OFFSET_TABLE_"))
+{
+}
+
+ElfMemoryOutput::~ElfMemoryOutput()
+{
+}
+
+bool
+ElfMemoryOutput::ConvertSymbolToBytes(SymbolRef sym,
+                                      Location loc,
+                                      NumericOutput& num_out)
+{
+    ConvertElfSymbol(sym, loc, num_out, m_objfmt, m_object, m_GOT_sym, *this);
+    return true;
+}
+
+bool
+ElfMemoryOutput::ConvertValueToBytes(Value& value,
+                                     Location loc,
+                                     NumericOutput& num_out)
+{
+    return ConvertElfValue(value, loc, num_out, m_objfmt, m_object,
+                           m_GOT_sym, *this);
+}
+
+void
+ElfMemoryOutput::OutputGroup(ElfGroup& group, unsigned char* file)
+{
+    Bytes& scratch = getScratch();
+    BuildGroupContents(group, m_objfmt.m_config, scratch);
+    setBuffer(file + group.elfsect->getFileOffset(), scratch.size());
+    OutputBytes(scratch, SourceLocation());
+}
+
+void
+ElfMemoryOutput::OutputSection(Section& sect,
+                               StringTable& shstrtab,
+                               unsigned char* file)
+{
+    if (sect.isBSS())
+    {
+        // Don't output BSS sections.
+        OutputSectionContents(sect, m_objfmt, shstrtab, m_no_output,
+                              getDiagnostics());
+        return;
+    }
+
+    setBuffer(file + sect.getAssocData<ElfSection>()->getFileOffset(),
+              sect.bytecodes_back().getNextOffset());
+    OutputSectionContents(sect, m_objfmt, shstrtab, *this, getDiagnostics());
+}
+
+// Calculate the file offsets of the group and user section contents, which
+// follow the ELF header.  Their sizes are known once the object has been
+// optimized.  Returns the end of the section contents.
+static unsigned long
+LayoutSections(ElfObject& objfmt, Object& object)
+{
+    unsigned long pos = objfmt.m_config.getProgramHeaderSize();
+
+    for (ElfObject::Groups::iterator i=objfmt.m_groups.begin(),
+         end=objfmt.m_groups.end(); i != end; ++i)
+    {
+        ElfGroup& group = *i;
+
+        // sort and uniquify sections before output
+        std::sort(group.sects.begin(), group.sects.end());
+        std::vector<Section*>::iterator it =
+            std::unique(group.sects.begin(), group.sects.end());
+        group.sects.resize(it - group.sects.begin());
+
+        unsigned long size = 4 * (1 + group.sects.size());
+        group.elfsect->setSize(size);
+        pos = group.elfsect->setFileOffset(pos) + size;
+    }
+
+    for (Object::section_iterator i=object.sections_begin(),
+         end=object.sections_end(); i != end; ++i)
+    {
+        ElfSection* elfsect = i->getAssocData<ElfSection>();
+        assert(elfsect != 0);
+
+        if (elfsect->getAlign() == 0)
+            elfsect->setAlign(i->getAlign());
+
+        // BSS sections aren't in the file
+        if (i->isBSS())
+            continue;
+        pos = elfsect->setFileOffset(pos);
+        pos += i->bytecodes_back().getNextOffset();
+    }
+    return pos;
+}
+
 static unsigned long
 ElfAlignOutput(llvm::raw_fd_ostream& os, unsigned int align, Diagnostic& diags)
 {
@@ -1192,18 +1343,36 @@ ElfObject::Output(llvm::raw_fd_ostream& os,
         elfsect->setIndex(m_config.secthead_count++);
     }
 
-    // Output group sections.
-    for (Groups::iterator i=m_groups.begin(), end=m_groups.end(); i != end; ++i)
-    {
-        out.OutputGroup(*i);
+    // Output group and user sections, directly into the mapped file if
+    // possible, otherwise through the stream.  Assign names as we go
+    // (including relocation section names).  The tables that follow depend
+    // on the relocations generated here, so they're written through the
+    // stream afterwards.
+    unsigned long sections_end = LayoutSections(*this, m_object);
+    MappedOutputFile mapped(os);
+    if (mapped.Map(sections_end))
+    {
+        ElfMemoryOutput mem_out(*this, m_object, diags);
+        for (Groups::iterator i=m_groups.begin(), end=m_groups.end();
+             i != end; ++i)
+            mem_out.OutputGroup(*i, mapped.getData());
+        for (Object::section_iterator i=m_object.sections_begin(),
+             end=m_object.sections_end(); i != end; ++i)
+            mem_out.OutputSection(*i, shstrtab, mapped.getData());
+        if (!mapped.Unmap())
+        {
+            diags.Report(SourceLocation(), diag::err_file_output_write);
+            return;
+        }
     }
-
-    // Output user sections.
-    // Assign indices and names as we go (including relocation section names).
-    for (Object::section_iterator i=m_object.sections_begin(),
-         end=m_object.sections_end(); i != end; ++i)
+    else
     {
-        out.OutputSection(*i, shstrtab);
+        for (Groups::iterator i=m_groups.begin(), end=m_groups.end();
+             i != end; ++i)
+            out.OutputGroup(*i);
+        for (Object::section_iterator i=m_object.sections_begin(),
+             end=m_object.sections_end(); i != end; ++i)
+            out.OutputSection(*i, shstrtab);
     }
 
     // Go through relocations and force referenced symbols into symbol table,
@@ -1255,6 +1424,39 @@ ElfObject::Output(llvm::raw_fd_ostream& os,
     ElfStringIndex strtab_name = shstrtab.getIndex(".strtab");
     ElfStringIndex symtab_name = shstrtab.getIndex(".symtab");
 
+    // All names are now known; share storage between names that are tails
+    // of other names (e.g. ".text" in ".rela.text") and update the indexes
+    // already given out.
+    shstrtab.MergeTails();
+    strtab.MergeTails();
+
+    shstrtab_name = shstrtab.getMergedIndex(shstrtab_name);
+    strtab_name = shstrtab.getMergedIndex(strtab_name);
+    symtab_name = shstrtab.getMergedIndex(symtab_name);
+
+    for (Groups::iterator i=m_groups.begin(), end=m_groups.end(); i != end; ++i)
+    {
+        ElfSection* elfsect = i->elfsect.get();
+        elfsect->setName(shstrtab.getMergedIndex(elfsect->getName()));
+    }
+
+    for (Object::section_iterator i=m_object.sections_begin(),
+         end=m_object.sections_end(); i != end; ++i)
+    {
+        ElfSection* elfsect = i->getAssocData<ElfSection>();
+        assert(elfsect != 0);
+        elfsect->setName(shstrtab.getMergedIndex(elfsect->getName()));
+        elfsect->setRelName(shstrtab.getMergedIndex(elfsect->getRelName()));
+    }
+
+    for (Object::symbol_iterator i=m_object.symbols_begin(),
+         end=m_object.symbols_end(); i != end; ++i)
+    {
+        ElfSymbol* elfsym = i->getAssocData<ElfSymbol>();
+        if (elfsym && elfsym->isInTable())
+            elfsym->setName(strtab.getMergedIndex(elfsym->getName()));
+    }
+
     // section header string table (.shstrtab)
     offset = ElfAlignOutput(os, align, diags);
     size = shstrtab.getSize();
@@ -285,7 +285,8 @@ ElfSection::LoadSectionData(Section& sect,
         return false;
     }
 
-    sect.bytecodes_front().getFixed().Write(inbuf.Read(size), size);
+    // Reference the data in place rather than copying it
+    AppendBorrowedData(sect, inbuf.Read(size), size, SourceLocation());
     return true;
 }
 
@@ -107,6 +107,7 @@ public:
 
     void setRelIndex(ElfSectionIndex sectidx) { m_rel_index = sectidx; }
     void setRelName(ElfStringIndex nameidx) { m_rel_name_index = nameidx; }
+    ElfStringIndex getRelName() const { return m_rel_name_index; }
 
     void setEntSize(ElfSize size) { m_entsize = size; }
     ElfSize getEntSize() const { return m_entsize; }
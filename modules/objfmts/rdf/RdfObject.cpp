@@ -748,7 +748,8 @@ RdfObject::Read(SourceManager& sm, Diagnostic& diags)
                     << section->getName();
                 return false;
             }
-            section->bytecodes_front().getFixed().Write(inbuf.Read(size), size);
+            AppendBorrowedData(*section, inbuf.Read(size), size,
+                               SourceLocation());
         }
 
         // Create symbol for section start (used for relocations)
@@ -44,6 +44,7 @@
 #include "yasmx/Location_util.h"
 #include "yasmx/Object.h"
 #include "yasmx/Section.h"
+#include "yasmx/StringTable.h"
 #include "yasmx/Symbol.h"
 
 #include "XdfReloc.h"
@@ -99,7 +100,7 @@ public:
     void OutputSection(Section& sect);
     void OutputSymbol(const Symbol& sym,
                       bool all_syms,
-                      unsigned long* strtab_offset);
+                      StringTable& strtab);
 
     // OutputBytecode overrides
     bool ConvertValueToBytes(Value& value,
@@ -237,7 +238,7 @@ XdfOutput::OutputSection(Section& sect)
 void
 XdfOutput::OutputSymbol(const Symbol& sym,
                         bool all_syms,
-                        unsigned long* strtab_offset)
+                        StringTable& strtab)
 {
     int vis = sym.getVisibility();
 
@@ -295,12 +296,10 @@ XdfOutput::OutputSymbol(const Symbol& sym,
 
     Write32(scratch, scnum);        // section number
     Write32(scratch, value);        // value
-    Write32(scratch, *strtab_offset);
+    Write32(scratch, strtab.getIndex(sym.getName()));
     Write32(scratch, flags);        // flags
     assert(scratch.size() == SYMBOL_SIZE);
     m_os << scratch;
-
-    *strtab_offset += static_cast<unsigned long>(sym.getName().size()+1);
 }
 
 void
@@ -357,21 +356,27 @@ XdfObject::Output(llvm::raw_fd_ostream& os,
     unsigned long strtab_offset =
         FILEHEAD_SIZE + SECTHEAD_SIZE*scnum + SYMBOL_SIZE*symtab_count;
 
-    // Output symbol table
+    // Build string table before the symbol table so that symbol names can
+    // share storage with names they are tail substrings of.
+    StringTable strtab(strtab_offset);
     for (Object::const_symbol_iterator sym = m_object.symbols_begin(),
          end = m_object.symbols_end(); sym != end; ++sym)
     {
-        out.OutputSymbol(*sym, all_syms, &strtab_offset);
+        if (all_syms || sym->getVisibility() != Symbol::LOCAL)
+            strtab.getIndex(sym->getName());
     }
+    strtab.MergeTails();
 
-    // Output string table
+    // Output symbol table
     for (Object::const_symbol_iterator sym = m_object.symbols_begin(),
          end = m_object.symbols_end(); sym != end; ++sym)
     {
-        if (all_syms || sym->getVisibility() != Symbol::LOCAL)
-            os << sym->getName() << '\0';
+        out.OutputSymbol(*sym, all_syms, strtab);
     }
 
+    // Output string table
+    strtab.Write(os);
+
     // Output section data/relocs
     for (Object::section_iterator i=m_object.sections_begin(),
          end=m_object.sections_end(); i != end; ++i)
@@ -394,7 +399,7 @@ XdfObject::Output(llvm::raw_fd_ostream& os,
     Write32(scratch, scnum);            // number of sects
     Write32(scratch, symtab_count);     // number of symtabs
     // size of sect headers + symbol table + strings
-    Write32(scratch, strtab_offset-FILEHEAD_SIZE);
+    Write32(scratch, strtab_offset+strtab.getSize()-FILEHEAD_SIZE);
     assert(scratch.size() == FILEHEAD_SIZE);
     os << scratch;
 
@@ -549,8 +554,8 @@ XdfObject::Read(SourceManager& sm, Diagnostic& diags)
                 return false;
             }
 
-            section->bytecodes_front().getFixed().Write(inbuf.Read(xsect->size),
-                                                        xsect->size);
+            AppendBorrowedData(*section, inbuf.Read(xsect->size), xsect->size,
+                               SourceLocation());
         }
 
         // Associate section data with section
@@ -532,12 +532,14 @@ GasParser::ParseDirRept(unsigned int param, SourceLocation source)
             return false;
         }
         tokens.push_back(m_token);
-        ConsumeToken();
-    }
-    Token* alloc_tokens = new Token[count*tokens.size()];
-    for (unsigned long i=0; i<count; ++i)
-        std::copy(tokens.begin(), tokens.end(), &alloc_tokens[i*tokens.size()]);
-    m_preproc.EnterTokenStream(alloc_tokens, count*tokens.size(), false, true);
+        ConsumeAnyToken();
+    }
+    // Save a single copy of the body and let the token lexer replay it.
+    // Nested .rept blocks are expanded as they are reached on each pass.
+    Token* alloc_tokens = new Token[tokens.size()];
+    std::copy(tokens.begin(), tokens.end(), alloc_tokens);
+    m_preproc.EnterTokenStream(alloc_tokens, tokens.size(), false, true,
+                               count);
     ConsumeToken(); // consume the .endr and get the first repeated token
     return true;
 }
@@ -2576,6 +2578,7 @@ GasParser::DoParse()
             ConsumeToken();
         else
         {
+            m_object->AddStatement(m_token.getLocation());
             bool result = ParseLine();
             if (result && !m_token.isEndOfStatement())
                 Diag(m_token, diag::err_eol_junk);
@@ -102,3 +102,9 @@ GasPreproc::CreateLexer(FileID fid, const llvm::MemoryBuffer* input_buffer)
 {
     return new GasLexer(fid, input_buffer, *this);
 }
+
+llvm::StringRef
+GasPreproc::getTokenCacheName() const
+{
+    return "gas";
+}
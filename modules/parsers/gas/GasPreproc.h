@@ -55,6 +55,7 @@ protected:
     virtual void RegisterBuiltinMacros();
     virtual Lexer* CreateLexer(FileID fid,
                                const llvm::MemoryBuffer* input_buffer);
+    virtual llvm::StringRef getTokenCacheName() const;
 
 private:
 };
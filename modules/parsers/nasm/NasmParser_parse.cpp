@@ -373,6 +373,8 @@ NasmParser::DoParse()
             ConsumeToken();
         else
         {
+            if (m_abspos.isEmpty())
+                m_object->AddStatement(m_token.getLocation());
             ParseLine();
             SkipUntil(NasmToken::eol);
         }
@@ -1596,7 +1598,7 @@ NasmParser::ParseSymbol(IdentifierInfo* ii, bool* local)
     if (!islocal)
     {
         // just a normal label
-        SymbolRef sym = m_object->getSymbol(name);
+        SymbolRef sym = m_object->getSymbol(llvm::StringRef(name, len));
         ii->setSymbol(sym);    // cache it
         return sym;
     }
@@ -1607,7 +1609,7 @@ NasmParser::ParseSymbol(IdentifierInfo* ii, bool* local)
         // check for non-local ..@label
         if (len > 3 && name[2] == '@')
         {
-            SymbolRef sym = m_object->getSymbol(name);
+            SymbolRef sym = m_object->getSymbol(llvm::StringRef(name, len));
             ii->setSymbol(sym);    // cache it
             return sym;
         }
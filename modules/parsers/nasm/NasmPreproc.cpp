@@ -79,3 +79,9 @@ NasmPreproc::CreateLexer(FileID fid, const llvm::MemoryBuffer* input_buffer)
 {
     return new NasmLexer(fid, input_buffer, *this);
 }
+
+llvm::StringRef
+NasmPreproc::getTokenCacheName() const
+{
+    return "nasm";
+}
@@ -53,6 +53,7 @@ protected:
     virtual void RegisterBuiltinMacros();
     virtual Lexer* CreateLexer(FileID fid,
                                const llvm::MemoryBuffer* input_buffer);
+    virtual llvm::StringRef getTokenCacheName() const;
 
 private:
     /// Identifiers for builtin macros and other builtins.
@@ -0,0 +1,13 @@
+# [yasm -f bin -p gas -O0]
+# Alignment and .org still resolve when jumps are emitted in long form.
+.code32
+top:
+jmp fwd				# out: e9 1b 00 00 00
+.align 8			# out: 8d 76 00
+mid:
+movl $mid, %eax			# out: b8 08 00 00 00
+.org 0x20, 0x90			# out: 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90 90
+fwd:
+jz top				# out: 0f 84 da ff ff ff
+.p2align 4, 0xcc		# out: cc cc cc cc cc cc cc cc cc cc
+.byte 1				# out: 01
@@ -0,0 +1,9 @@
+; [yasm -f bin -O0]
+[bits 32]
+top:
+jmp fwd				; out: e9 12 00 00 00
+jmp top				; out: e9 f6 ff ff ff
+add eax, fwd-top		; out: 05 17 00 00 00
+mov eax, [ebx+fwd-top]		; out: 8b 83 17 00 00 00
+push byte 1			; out: 6a 01
+fwd:
@@ -0,0 +1,13 @@
+; [yasm -f bin -O1]
+; The backward jmp doesn't fit in short form, and growing it pushes the
+; first jmp out of short range in turn; -O1 must settle on the same forms
+; as the full optimizer.
+[bits 32]
+top:
+jmp fwd
+jz mid
+times 123 nop
+mid:
+jmp top
+fwd:
+jz top
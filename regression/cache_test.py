@@ -0,0 +1,208 @@
+#! /usr/bin/env python
+# Object file cache (--cache-dir) tests
+#
+#  Copyright (C) 2026  Peter Johnson
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+#
+# Each test assembles a small gas source into a one or two byte bin file.
+# A cache hit is detected by overwriting the object stored in the cache
+# entry with a marker byte: if the next run outputs the marker, the entry
+# was used.
+#
+import os
+import shutil
+import subprocess
+import sys
+
+try:
+    import fcntl
+except ImportError:
+    fcntl = None
+
+def lprint(*args, **kwargs):
+    sep = kwargs.pop("sep", ' ')
+    end = kwargs.pop("end", '\n')
+    file = kwargs.pop("file", sys.stdout)
+    file.write(sep.join(args))
+    file.write(end)
+
+yasmexe = None
+MARKER = b"\xee"
+
+class TestFailure(Exception):
+    pass
+
+class Workspace(object):
+    def __init__(self, path):
+        self.path = path
+        if os.path.exists(path):
+            shutil.rmtree(path)
+        os.makedirs(path)
+        self.cache = os.path.join(path, "cache")
+
+    def write(self, name, text):
+        fullpath = os.path.join(self.path, name)
+        if not os.path.isdir(os.path.dirname(fullpath)):
+            os.makedirs(os.path.dirname(fullpath))
+        f = open(fullpath, "w")
+        f.write(text)
+        f.close()
+
+    def assemble(self, args=[], env={}):
+        """Assemble main.s to main.bin and return the output."""
+        cmd = [yasmexe, "-f", "bin", "-p", "gas", "--cache-dir=cache"]
+        cmd.extend(args)
+        cmd.extend(["-o", "main.bin", "main.s"])
+        runenv = os.environ.copy()
+        runenv.pop("YASM_TEST_SUITE", None)
+        runenv.update(env)
+        proc = subprocess.Popen(cmd, cwd=self.path, env=runenv,
+                                stdout=subprocess.PIPE,
+                                stderr=subprocess.PIPE)
+        (stdoutdata, stderrdata) = proc.communicate()
+        if proc.returncode != 0 or stderrdata:
+            raise TestFailure("%s failed: %r" % (" ".join(cmd), stderrdata))
+        f = open(os.path.join(self.path, "main.bin"), "rb")
+        data = f.read()
+        f.close()
+        return data
+
+    def entries(self):
+        if not os.path.isdir(self.cache):
+            return []
+        return [os.path.join(self.cache, name)
+                for name in sorted(os.listdir(self.cache))
+                if "." not in name]
+
+    def mark_entries(self):
+        """Replace the object in every cache entry with marker bytes."""
+        entries = self.entries()
+        if not entries:
+            raise TestFailure("no cache entry was stored")
+        for entry in entries:
+            f = open(entry, "rb")
+            data = f.read()
+            f.close()
+            start = data.rindex(b"object ")
+            size = int(data[start+7:data.index(b"\n", start)])
+            f = open(entry, "wb")
+            f.write(data[:len(data)-size] + MARKER*size)
+            f.close()
+
+def expect(what, actual, expected):
+    if actual != expected:
+        raise TestFailure("%s: got %r, expected %r" % (what, actual, expected))
+
+def test_hit(ws):
+    ws.write("main.s", ".byte 1\n")
+    expect("first run", ws.assemble(), b"\x01")
+    ws.mark_entries()
+    expect("second run", ws.assemble(), MARKER)
+
+def test_include_changed(ws):
+    ws.write("main.s", '.include "inc.s"\n')
+    ws.write("inc.s", ".byte 1\n")
+    expect("first run", ws.assemble(), b"\x01")
+    ws.mark_entries()
+    ws.write("inc.s", ".byte 2\n")
+    expect("after change", ws.assemble(), b"\x02")
+
+def test_include_shadowed(ws):
+    # inc.s is found in the second search directory; creating one in the
+    # first must invalidate the entry.
+    ws.write("main.s", '.include "inc.s"\n')
+    ws.write("b/inc.s", ".byte 1\n")
+    args = ["-Ia", "-Ib"]
+    os.makedirs(os.path.join(ws.path, "a"))
+    expect("first run", ws.assemble(args), b"\x01")
+    ws.mark_entries()
+    expect("unchanged", ws.assemble(args), MARKER)
+    ws.write("a/inc.s", ".byte 3\n")
+    expect("shadowed", ws.assemble(args), b"\x03")
+
+def test_environment(ws):
+    ws.write("main.s", ".byte 1\n")
+    expect("first run", ws.assemble(), b"\x01")
+    ws.mark_entries()
+    env = {"YASM_TEST_SUITE": "1"}
+    expect("with YASM_TEST_SUITE", ws.assemble(env=env), b"\x01")
+    expect("without YASM_TEST_SUITE", ws.assemble(), MARKER)
+
+def test_leftover_lock(ws):
+    # A lock file left by a crashed process doesn't prevent storing.
+    ws.write("main.s", ".byte 1\n")
+    ws.assemble()
+    entry = ws.entries()[0]
+    os.remove(entry)
+    open(entry + ".lock", "w").close()
+    ws.assemble()
+    expect("entries", ws.entries(), [entry])
+    expect("lock removed", os.path.exists(entry + ".lock"), False)
+
+def test_held_lock(ws):
+    # An entry locked by another process is left alone.
+    if fcntl is None:
+        return
+    ws.write("main.s", ".byte 1\n")
+    ws.assemble()
+    entry = ws.entries()[0]
+    os.remove(entry)
+    lock = open(entry + ".lock", "w")
+    fcntl.flock(lock.fileno(), fcntl.LOCK_EX | fcntl.LOCK_NB)
+    try:
+        ws.assemble()
+        expect("entries", ws.entries(), [])
+    finally:
+        lock.close()
+
+def run_all(outdir):
+    tests = [test_hit, test_include_changed, test_include_shadowed,
+             test_environment, test_leftover_lock, test_held_lock]
+    failed = []
+    for test in tests:
+        name = test.__name__[5:]
+        lprint("[ RUN      ] cache/%s" % name)
+        try:
+            test(Workspace(os.path.join(outdir, "cache_test", name)))
+        except TestFailure:
+            lprint("[     FAIL ] cache/%s: %s" % (name, sys.exc_info()[1]))
+            failed.append(name)
+            continue
+        lprint("[       OK ] cache/%s" % name)
+    lprint("[  PASSED  ] %d tests." % (len(tests)-len(failed)))
+    if failed:
+        lprint("[  FAILED  ] %d tests." % len(failed))
+        return False
+    return True
+
+if __name__ == "__main__":
+    if len(sys.argv) != 3:
+        lprint("Usage: cache_test.py <path to output directory>",
+               file=sys.stderr)
+        lprint("    <path to yasm executable>", file=sys.stderr)
+        sys.exit(2)
+    yasmexe = os.path.abspath(sys.argv[2])
+    if run_all(sys.argv[1]):
+        sys.exit(0)
+    else:
+        sys.exit(1)
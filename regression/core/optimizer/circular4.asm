@@ -0,0 +1,10 @@
+; [fail]
+a1:
+times b2-b1+1 db 0
+a2:
+b1:
+times c2-c1+1 db 0
+b2:
+c1:
+times a2-a1+1 db 0
+c2:
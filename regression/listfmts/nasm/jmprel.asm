@@ -0,0 +1,11 @@
+; Relative jumps in the list file must match the object file.
+start:
+nop
+nop
+jmp start
+jz fwd
+fwd:
+jmp far_away
+times 128 db 0
+far_away:
+jz start
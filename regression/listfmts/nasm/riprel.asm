@@ -0,0 +1,6 @@
+; RIP-relative displacements in the list file must match the object file.
+[bits 64]
+lea rax, [rel foo]		; out: 48 8d 05 0a 00 00 00
+mov dword [rel foo], 5		; out: c7 05 00 00 00 00 05 00 00 00
+foo:
+nop				; out: 90
@@ -0,0 +1,4 @@
+# [yasm -f bin -p gas -Iincpath]
+# incpath.inc is only found through the -I directory.
+.include "incpath.inc"	# out: 01
+.byte 2			# out: 02
@@ -0,0 +1,17 @@
+# Repeat blocks are replayed from a single saved copy of the body.
+.rept 3
+.byte 1, 2			# out: 01 02 01 02 01 02
+.endr
+.rept 0
+.byte 0xff
+.endr
+.rept 2
+.byte 3				# out: 03
+.rept 2
+.byte 4				# out: 04 04
+.endr
+.byte 5				# out: 05 03 04 04 05
+.endr
+.rept 1
+.byte 6				# out: 06
+.endr
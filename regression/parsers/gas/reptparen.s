@@ -0,0 +1,8 @@
+# Parentheses and other punctuation in a .rept body are saved and
+# replayed like any other token.
+.rept 3
+.byte (1+2)			# out: 03 03 03
+.endr
+.rept 2
+.byte ((4)), (5*(1+1))		# out: 04 0a 04 0a
+.endr
@@ -63,6 +63,12 @@ class Test(object):
         self.basefn = os.path.splitext("_".join(path_splitall(self.name)))[0]
         self.outfn = self.basefn + ".out"
         self.ewfn = self.basefn + ".ew"
+        self.lstfn = self.basefn + ".lst"
+
+        # If there's a .lst file, the list file is checked against it.
+        self.goldenlst = os.path.splitext(self.fullpath)[0] + ".lst"
+        if not os.path.exists(self.goldenlst):
+            self.goldenlst = None
 
         # Read the input file in its entirety.  We use this for various things.
         f = open(self.fullpath)
@@ -111,6 +117,35 @@ class Test(object):
 
         return match
 
+    def compare_lst(self):
+        """Check list file."""
+        f = open(self.goldenlst)
+        try:
+            golden = [l.rstrip() for l in f.readlines()]
+        finally:
+            f.close()
+
+        f = open(os.path.join(outdir, self.lstfn))
+        try:
+            result = [l.rstrip() for l in f.readlines()]
+        finally:
+            f.close()
+
+        match = True
+        if len(golden) != len(result):
+            lprint("%s: list file length %d lines (expected %d)"
+                    % (self.lstfn, len(result), len(golden)))
+            match = False
+        for i, (o, g) in enumerate(zip(result, golden)):
+            if o != g:
+                lprint("%s:%d: mismatch on list line" % (self.lstfn, i+1))
+                lprint(" Expected: %s" % g)
+                lprint(" Actual: %s" % o)
+                match = False
+                break
+
+        return match
+
     def compare_out(self):
         """Check output file."""
         # If there's a .hex file, use it; otherwise scan the input file
@@ -225,6 +260,8 @@ class Test(object):
 
         # Specify the output filename as we pipe the input.
         yasmargs.extend(["-o", os.path.join(outdir, self.outfn)])
+        if self.goldenlst is not None:
+            yasmargs.extend(["-l", os.path.join(outdir, self.lstfn)])
 
         # We pipe the input, so append "-" to the command line for stdin input.
         yasmargs.append("-")
@@ -233,10 +270,13 @@ class Test(object):
         start = time.time()
         env = os.environ.copy()
         env["YASM_TEST_SUITE"] = "1"
+        # Run in the test's directory so relative paths in options (e.g.
+        # -I) refer to the regression tree.
         proc = subprocess.Popen(yasmargs, bufsize=4096,
                                 executable=(ygasoverride and ygasexe or yasmexe),
                                 stdin=subprocess.PIPE, stdout=subprocess.PIPE,
-                                stderr=subprocess.PIPE, env=env)
+                                stderr=subprocess.PIPE, env=env,
+                                cwd=os.path.dirname(self.fullpath))
         (stdoutdata, stderrdata) = proc.communicate(self.inputfile)
         end = time.time()
 
@@ -266,6 +306,11 @@ class Test(object):
                 if not match:
                     ok = False
 
+                if self.goldenlst is not None:
+                    match = self.compare_lst()
+                    if not match:
+                        ok = False
+
         # Summarize test result
         if ok:
             result = "      OK"
@@ -319,9 +364,9 @@ if __name__ == "__main__":
         lprint("    <path to yasm executable>", file=sys.stderr)
         lprint("    <path to ygas executable>", file=sys.stderr)
         sys.exit(2)
-    outdir = sys.argv[2]
-    yasmexe = sys.argv[3]
-    ygasexe = sys.argv[4]
+    outdir = os.path.abspath(sys.argv[2])
+    yasmexe = os.path.abspath(sys.argv[3])
+    ygasexe = os.path.abspath(sys.argv[4])
     all_ok = run_all(sys.argv[1])
     if all_ok:
         sys.exit(0)
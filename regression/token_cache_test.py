@@ -0,0 +1,230 @@
+#! /usr/bin/env python
+# Token cache (--token-cache) tests
+#
+#  Copyright (C) 2026  Peter Johnson
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+#
+# Each test assembles a gas source including inc.s into a bin file.  Only
+# included files go into the token cache.  A cache hit is detected by
+# swapping the source offsets of the two numbers in the stored tokens: if
+# the next run outputs them in swapped order, the tokens were replayed.
+#
+import os
+import shutil
+import struct
+import subprocess
+import sys
+
+def lprint(*args, **kwargs):
+    sep = kwargs.pop("sep", ' ')
+    end = kwargs.pop("end", '\n')
+    file = kwargs.pop("file", sys.stdout)
+    file.write(sep.join(args))
+    file.write(end)
+
+yasmexe = None
+
+# Token file layout; must match TokenCache.cpp.
+HEADER = struct.Struct("=8sIIIIQ")
+ENTRY = struct.Struct("=IIHBBI")
+
+class TestFailure(Exception):
+    pass
+
+class Workspace(object):
+    def __init__(self, path):
+        self.path = path
+        if os.path.exists(path):
+            shutil.rmtree(path)
+        os.makedirs(path)
+        self.cache = os.path.join(path, "tok")
+
+    def write(self, name, text):
+        f = open(os.path.join(self.path, name), "w")
+        f.write(text)
+        f.close()
+
+    def run(self, args=[]):
+        """Assemble main.s to main.bin; return the output and stderr."""
+        cmd = [yasmexe, "-p", "gas", "--token-cache=tok"]
+        cmd.extend(args)
+        cmd.extend(["-o", "main.bin", "main.s"])
+        env = os.environ.copy()
+        env.pop("YASM_TEST_SUITE", None)
+        proc = subprocess.Popen(cmd, cwd=self.path, env=env,
+                                stdout=subprocess.PIPE,
+                                stderr=subprocess.PIPE)
+        (stdoutdata, stderrdata) = proc.communicate()
+        if proc.returncode != 0:
+            raise TestFailure("%s failed: %r" % (" ".join(cmd), stderrdata))
+        f = open(os.path.join(self.path, "main.bin"), "rb")
+        data = f.read()
+        f.close()
+        return (data, stderrdata)
+
+    def assemble(self, args=[]):
+        (data, stderrdata) = self.run(args)
+        if stderrdata:
+            raise TestFailure("unexpected diagnostics: %r" % stderrdata)
+        return data
+
+    def entries(self):
+        if not os.path.isdir(self.cache):
+            return []
+        return [os.path.join(self.cache, name)
+                for name in sorted(os.listdir(self.cache))
+                if name.endswith(".tok")]
+
+    def entry(self):
+        entries = self.entries()
+        if len(entries) != 1:
+            raise TestFailure("expected one token file, found %d"
+                              % len(entries))
+        f = open(entries[0], "rb")
+        data = bytearray(f.read())
+        f.close()
+        return (entries[0], data)
+
+    def swap_numbers(self, source):
+        """Swap the source offsets of the two number tokens in the stored
+        tokens of source, which must contain exactly two one-digit
+        numbers."""
+        (path, data) = self.entry()
+        num_tokens = HEADER.unpack_from(bytes(data))[2]
+        numbers = []
+        for i in range(num_tokens):
+            pos = HEADER.size + i*ENTRY.size
+            (offset, length) = ENTRY.unpack_from(bytes(data), pos)[:2]
+            if length == 1 and source[offset].isdigit():
+                numbers.append(pos)
+        if len(numbers) != 2:
+            raise TestFailure("expected two number tokens, found %d"
+                              % len(numbers))
+        (first, second) = [data[pos:pos+4] for pos in numbers]
+        data[numbers[0]:numbers[0]+4] = second
+        data[numbers[1]:numbers[1]+4] = first
+        f = open(path, "wb")
+        f.write(data)
+        f.close()
+
+def expect(what, actual, expected):
+    if actual != expected:
+        raise TestFailure("%s: got %r, expected %r" % (what, actual, expected))
+
+INC = ".byte 1\n.byte 2\n"
+
+def test_hit(ws):
+    ws.write("main.s", '.include "inc.s"\n')
+    ws.write("inc.s", INC)
+    expect("first run", ws.assemble(["-f", "bin"]), b"\x01\x02")
+    ws.swap_numbers(INC)
+    expect("second run", ws.assemble(["-f", "bin"]), b"\x02\x01")
+
+def test_identical(ws):
+    # Cold and warm runs give the same object, with the identifiers,
+    # strings and comments in the include replayed from the cache.
+    ws.write("main.s", '.include "inc.s"\n.text\ncall func\n')
+    ws.write("inc.s", '# comment\n.globl func\n.data\nmsg: .ascii "hi"\n'
+             '.text\nfunc: movl msg, %eax\n/* block */ ret\n')
+    cold = ws.assemble(["-f", "elf32"])
+    ws.entry()
+    warm = ws.assemble(["-f", "elf32"])
+    expect("warm object", warm, cold)
+
+def test_include_changed(ws):
+    ws.write("main.s", '.include "inc.s"\n')
+    ws.write("inc.s", INC)
+    expect("first run", ws.assemble(["-f", "bin"]), b"\x01\x02")
+    ws.swap_numbers(INC)
+    ws.write("inc.s", ".byte 3\n.byte 4, 5\n")
+    expect("after change", ws.assemble(["-f", "bin"]), b"\x03\x04\x05")
+
+def test_truncated(ws):
+    ws.write("main.s", '.include "inc.s"\n')
+    ws.write("inc.s", INC)
+    ws.assemble(["-f", "bin"])
+    (path, data) = ws.entry()
+    f = open(path, "wb")
+    f.write(data[:len(data)-1])
+    f.close()
+    expect("truncated", ws.assemble(["-f", "bin"]), b"\x01\x02")
+    expect("rewritten", ws.entry(), (path, data))
+
+def test_corrupt(ws):
+    # A token pointing past the end of the source is rejected up front.
+    ws.write("main.s", '.include "inc.s"\n')
+    ws.write("inc.s", INC)
+    ws.assemble(["-f", "bin"])
+    (path, data) = ws.entry()
+    bad = bytearray(data)
+    bad[HEADER.size:HEADER.size+4] = struct.pack("=I", len(INC))
+    f = open(path, "wb")
+    f.write(bad)
+    f.close()
+    expect("corrupt", ws.assemble(["-f", "bin"]), b"\x01\x02")
+    expect("rewritten", ws.entry(), (path, data))
+
+def test_lexer_diagnostic(ws):
+    # Replayed tokens wouldn't repeat the warning, so the include isn't
+    # cached.
+    ws.write("main.s", '.include "inc.s"\n')
+    ws.write("inc.s", "/* a /* b */\n.byte 1\n")
+    for run in ["first run", "second run"]:
+        (data, stderrdata) = ws.run(["-f", "bin"])
+        expect(run, data, b"\x01")
+        if b"within block comment" not in stderrdata:
+            raise TestFailure("%s: no warning: %r" % (run, stderrdata))
+        expect("token files", ws.entries(), [])
+
+def run_all(outdir):
+    tests = [test_hit, test_identical, test_include_changed, test_truncated,
+             test_corrupt, test_lexer_diagnostic]
+    failed = []
+    for test in tests:
+        name = test.__name__[5:]
+        lprint("[ RUN      ] token_cache/%s" % name)
+        try:
+            test(Workspace(os.path.join(outdir, "token_cache_test", name)))
+        except TestFailure:
+            lprint("[     FAIL ] token_cache/%s: %s"
+                   % (name, sys.exc_info()[1]))
+            failed.append(name)
+            continue
+        lprint("[       OK ] token_cache/%s" % name)
+    lprint("[  PASSED  ] %d tests." % (len(tests)-len(failed)))
+    if failed:
+        lprint("[  FAILED  ] %d tests." % len(failed))
+        return False
+    return True
+
+if __name__ == "__main__":
+    if len(sys.argv) != 3:
+        lprint("Usage: token_cache_test.py <path to output directory>",
+               file=sys.stderr)
+        lprint("    <path to yasm executable>", file=sys.stderr)
+        sys.exit(2)
+    yasmexe = os.path.abspath(sys.argv[2])
+    if run_all(sys.argv[1]):
+        sys.exit(0)
+    else:
+        sys.exit(1)
@@ -0,0 +1,179 @@
+//
+// IntNum calculation microbenchmark
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include "yasmx/IntNum.h"
+#include "yasmx/Op.h"
+
+
+using namespace yasm;
+
+namespace {
+/// Operand width classes: values that fit in a long, values that fit in
+/// 128 bits, and values that need the full bitvector.
+enum Width { SMALL, WIDE, BIG, NUM_WIDTHS };
+
+const char* const width_names[NUM_WIDTHS] = {"small", "wide", "big"};
+const unsigned int width_bits[NUM_WIDTHS] = {30, 120, 200};
+
+const struct
+{
+    Op::Op op;
+    const char* name;
+} ops[] =
+{
+    {Op::ADD, "ADD"},
+    {Op::SUB, "SUB"},
+    {Op::MUL, "MUL"},
+    {Op::DIV, "DIV"},
+    {Op::SIGNDIV, "SIGNDIV"},
+    {Op::MOD, "MOD"},
+    {Op::SIGNMOD, "SIGNMOD"},
+    {Op::NEG, "NEG"},
+    {Op::NOT, "NOT"},
+    {Op::OR, "OR"},
+    {Op::AND, "AND"},
+    {Op::XOR, "XOR"},
+    {Op::XNOR, "XNOR"},
+    {Op::NOR, "NOR"},
+    {Op::SHL, "SHL"},
+    {Op::SHR, "SHR"},
+    {Op::LOR, "LOR"},
+    {Op::LAND, "LAND"},
+    {Op::LNOT, "LNOT"},
+    {Op::LXOR, "LXOR"},
+    {Op::LXNOR, "LXNOR"},
+    {Op::LNOR, "LNOR"},
+    {Op::EQ, "EQ"},
+    {Op::LT, "LT"},
+    {Op::GT, "GT"},
+    {Op::LE, "LE"},
+    {Op::GE, "GE"},
+    {Op::NE, "NE"},
+    {Op::IDENT, "IDENT"}
+};
+
+const unsigned int NUM_OPERANDS = 256;
+} // anonymous namespace
+
+// Random nonzero value of up to bits bits, with a random sign.
+static IntNum
+RandomValue(unsigned int bits)
+{
+    static const char hexdigits[] = "0123456789abcdef";
+    std::string str;
+    for (unsigned int i=0; i<bits/4; ++i)
+        str.push_back(hexdigits[std::rand() % 16]);
+    str[0] = hexdigits[1 + std::rand() % 7];
+    IntNum val;
+    val.setStr(str, 16);
+    if (std::rand() % 2)
+        val.CalcAssert(Op::NEG);
+    return val;
+}
+
+static void
+GenerateOperands(std::vector<IntNum>* lhs,
+                 std::vector<IntNum>* rhs,
+                 Op::Op op,
+                 Width width)
+{
+    std::srand(1);
+    for (unsigned int i=0; i<NUM_OPERANDS; ++i)
+    {
+        lhs->push_back(RandomValue(width_bits[width]));
+        if (op == Op::SHL || op == Op::SHR)
+            rhs->push_back(IntNum(std::rand() % 48));
+        else if (op == Op::MUL)
+        {
+            // keep products in the same width class
+            rhs->push_back(RandomValue(width == SMALL ? 16 : 4));
+        }
+        else
+            rhs->push_back(RandomValue(width_bits[width]));
+    }
+}
+
+// Time iterations passes of op over all operands, in nanoseconds per
+// operation.
+static double
+Run(Op::Op op, Width width, int iterations)
+{
+    std::vector<IntNum> lhs, rhs;
+    GenerateOperands(&lhs, &rhs, op, width);
+    bool unary = (op != Op::IDENT && isUnary(op));
+
+    std::clock_t start = std::clock();
+    for (int i=0; i<iterations; ++i)
+    {
+        for (unsigned int j=0; j<NUM_OPERANDS; ++j)
+        {
+            IntNum acc(lhs[j]);
+            if (unary)
+                acc.CalcAssert(op);
+            else
+                acc.CalcAssert(op, rhs[j]);
+        }
+    }
+    double secs = static_cast<double>(std::clock()-start) / CLOCKS_PER_SEC;
+    return secs * 1e9 / (static_cast<double>(iterations) * NUM_OPERANDS);
+}
+
+int
+main(int argc, char* argv[])
+{
+    int iterations = 2000;
+    if (argc > 1)
+        iterations = std::atoi(argv[1]);
+    if (iterations <= 0)
+    {
+        llvm::errs() << "usage: " << argv[0] << " [iterations]\n";
+        return EXIT_FAILURE;
+    }
+
+    llvm::outs() << "op      ";
+    for (int w=0; w<NUM_WIDTHS; ++w)
+        llvm::outs() << llvm::format(" %10s", width_names[w]);
+    llvm::outs() << "  (ns/op)\n";
+
+    for (unsigned int i=0; i<sizeof(ops)/sizeof(ops[0]); ++i)
+    {
+        llvm::outs() << llvm::format("%-8s", ops[i].name);
+        for (int w=0; w<NUM_WIDTHS; ++w)
+        {
+            double ns = Run(ops[i].op, static_cast<Width>(w), iterations);
+            llvm::outs() << llvm::format(" %10.1f", ns);
+        }
+        llvm::outs() << '\n';
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+//
+// Line scanning microbenchmark
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include "yasmx/Support/linescan.h"
+
+
+using namespace yasm;
+
+// Build a buffer of random source-like lines with a mix of line endings.
+static void
+GenerateInput(std::string* buf, unsigned long size)
+{
+    static const char* const endings[] = {"\n", "\n", "\n", "\r\n", "\r"};
+    buf->reserve(size+80);
+    std::srand(1);
+    while (buf->size() < size)
+    {
+        int len = std::rand() % 80;
+        for (int i=0; i<len; ++i)
+            buf->push_back(static_cast<char>(' ' + std::rand() % 95));
+        buf->append(endings[std::rand() % 5]);
+    }
+}
+
+static double
+Run(const std::string& buf, LineScanKernel kernel, int iterations,
+    std::vector<unsigned>* offsets)
+{
+    std::clock_t start = std::clock();
+    for (int i=0; i<iterations; ++i)
+    {
+        offsets->clear();
+        ScanLineOffsets(buf.data(), buf.size(), offsets, kernel);
+    }
+    return static_cast<double>(std::clock()-start) / CLOCKS_PER_SEC;
+}
+
+int
+main(int argc, char* argv[])
+{
+    unsigned long megabytes = 64;
+    int iterations = 5;
+    if (argc > 1)
+        megabytes = std::strtoul(argv[1], 0, 10);
+    if (argc > 2)
+        iterations = std::atoi(argv[2]);
+    if (megabytes == 0 || iterations <= 0)
+    {
+        llvm::errs() << "usage: " << argv[0] << " [megabytes [iterations]]\n";
+        return EXIT_FAILURE;
+    }
+
+    std::string buf;
+    GenerateInput(&buf, megabytes*1024*1024);
+
+    static const struct
+    {
+        LineScanKernel kernel;
+        const char* name;
+    } kernels[] =
+    {
+        {LINESCAN_SCALAR, "scalar"},
+        {LINESCAN_SSE2, "sse2"},
+        {LINESCAN_AVX2, "avx2"}
+    };
+
+    std::vector<unsigned> reference, offsets;
+    int status = EXIT_SUCCESS;
+    for (unsigned int i=0; i<sizeof(kernels)/sizeof(kernels[0]); ++i)
+    {
+        llvm::outs() << kernels[i].name << ": ";
+        if (!isLineScanKernelSupported(kernels[i].kernel))
+        {
+            llvm::outs() << "not supported\n";
+            continue;
+        }
+        double secs = Run(buf, kernels[i].kernel, iterations, &offsets);
+        double mbps = (secs > 0) ? (megabytes*iterations/secs) : 0;
+        llvm::outs() << offsets.size() << " lines, ";
+        llvm::outs() << llvm::format("%.3f s, %.1f MB/s", secs, mbps);
+        if (reference.empty())
+            reference = offsets;
+        else if (offsets != reference)
+        {
+            llvm::outs() << " MISMATCH";
+            status = EXIT_FAILURE;
+        }
+        llvm::outs() << '\n';
+    }
+    return status;
+}
@@ -0,0 +1,453 @@
+//
+// Assembler benchmark suite
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "yasmx/Basic/Diagnostic.h"
+#include "yasmx/Basic/FileManager.h"
+#include "yasmx/Basic/SourceManager.h"
+#include "yasmx/Parse/HeaderSearch.h"
+#include "yasmx/System/plugin.h"
+#include "yasmx/Assembler.h"
+
+#include "frontends/DiagnosticOptions.h"
+#include "frontends/TextDiagnosticPrinter.h"
+#include "frontends/TimeReport.h"
+
+
+namespace cl = llvm::cl;
+
+static cl::list<std::string> bench_names(cl::Positional,
+    cl::desc("[benchmark...]"));
+static cl::opt<std::string> baseline_filename("baseline",
+    cl::desc("Compare results against baseline file"),
+    cl::value_desc("file"));
+static cl::opt<std::string> write_baseline("write-baseline",
+    cl::desc("Write results to baseline file"),
+    cl::value_desc("file"));
+static cl::opt<unsigned int> tolerance("tolerance",
+    cl::desc("Allowed increase over baseline, in percent (default 10)"),
+    cl::init(10));
+static cl::opt<unsigned int> scale("scale",
+    cl::desc("Input size multiplier (default 1)"),
+    cl::init(1));
+static cl::opt<unsigned int> iterations("iterations",
+    cl::desc("Runs per benchmark; the fastest is kept (default 3)"),
+    cl::init(3));
+static cl::opt<std::string> obj_filename("o",
+    cl::desc("Scratch object file"),
+    cl::value_desc("filename"),
+    cl::init("yasm-bench.tmp"));
+static cl::opt<bool> list_benchmarks("list",
+    cl::desc("List benchmarks and exit"));
+
+// Times below this are too noisy to call a regression.
+static const double MIN_TIME_DELTA = 0.005;
+
+//
+// Input generators.  Each writes n "units" of source; the unit counts
+// in the benchmark table are chosen so every input takes a similar time
+// to assemble.
+//
+
+// Forward and backward short/near jumps at varying distances, so the
+// optimizer has many spans to expand.
+static void
+GenJumps(llvm::raw_ostream& os, unsigned long n)
+{
+    os << "[bits 32]\n";
+    for (unsigned long i=0; i<n; ++i)
+    {
+        os << "L" << i << ":\n";
+        os << "    cmp eax, " << (i % 200) << '\n';
+        os << "    jne L" << (i * 7919 % n) << '\n';
+        os << "    jmp L" << ((i + 1 + i % 50) % n) << '\n';
+        if (i % 3 == 0)
+            os << "    times " << (i % 97) << " nop\n";
+    }
+}
+
+// VEX-encoded SIMD with register and memory operands.
+static void
+GenAvx(llvm::raw_ostream& os, unsigned long n)
+{
+    os << "[bits 64]\n";
+    for (unsigned long i=0; i<n; ++i)
+    {
+        unsigned int r = i % 16;
+        os << "    vmovaps ymm" << r << ", [rsi+rcx*4+" << (i % 64)*32 << "]\n";
+        os << "    vaddps ymm" << r << ", ymm" << (r+1) % 16 << ", ymm"
+           << (r+2) % 16 << '\n';
+        os << "    vmulps xmm" << r << ", xmm" << (r+3) % 16
+           << ", [rdi+" << (i % 16)*16 << "]\n";
+        os << "    vxorps ymm" << (r+4) % 16 << ", ymm" << (r+4) % 16
+           << ", ymm" << (r+4) % 16 << '\n';
+        os << "    vshufps xmm" << r << ", xmm" << (r+5) % 16 << ", xmm"
+           << (r+6) % 16 << ", " << (i % 256) << '\n';
+        os << "    vmovaps [rdx+" << (i % 64)*32 << "], ymm" << r << '\n';
+    }
+}
+
+// Data directives with times prefixes and alignment.
+static void
+GenData(llvm::raw_ostream& os, unsigned long n)
+{
+    for (unsigned long i=0; i<n; ++i)
+    {
+        os << "    times " << (i % 37) << " db " << (i % 256) << '\n';
+        os << "[align " << (1 << (i % 5)) << "]\n";
+        os << "    dd " << i << ", " << i*3 << '\n';
+        os << "    times " << (i % 5) << " dw " << (i % 65536) << '\n';
+        os << "    dq " << i*i << '\n';
+    }
+}
+
+// Large GAS .rept blocks.
+static void
+GenRept(llvm::raw_ostream& os, unsigned long n)
+{
+    os << ".text\n";
+    for (unsigned long i=0; i<n; ++i)
+    {
+        os << ".rept " << (50 + i % 50) << '\n';
+        os << "    addl $" << i << ", %eax\n";
+        os << "    movl %eax, " << (i % 128)*4 << "(%esp)\n";
+        os << "    .byte " << (i % 256) << ", 0\n";
+        os << ".endr\n";
+    }
+}
+
+// GAS symbol assignments and the expressions using them.  (GAS macros
+// are not supported yet, so this stands in for macro-heavy input.)
+static void
+GenExprs(llvm::raw_ostream& os, unsigned long n)
+{
+    os << ".text\n";
+    for (unsigned long i=0; i<n; ++i)
+    {
+        os << ".set c" << i << ", " << i << " * 4 + " << (i % 7) << '\n';
+        if (i > 0)
+            os << "    addl $(c" << i << " - c" << (i / 2) << ") & 0xff, "
+               << "%eax\n";
+        os << "    movl c" << (i / 3) << "+" << (i % 64) << "(%esp), %ebx\n";
+        os << "    .long c" << i << " << 2, (c" << i << " >> 1) | 1\n";
+    }
+}
+
+// Many global and external symbols and the relocations referencing them.
+static void
+GenSymbols(llvm::raw_ostream& os, unsigned long n)
+{
+    os << "[bits 64]\n";
+    for (unsigned long i=0; i<n; ++i)
+        os << "[global sym" << i << "]\n[extern ext" << i << "]\n";
+    os << "[section .text]\n";
+    for (unsigned long i=0; i<n; ++i)
+    {
+        os << "sym" << i << ":\n";
+        os << "    call ext" << i << '\n';
+        os << "    mov rax, [rel ext" << (i * 31 % n) << "]\n";
+        os << "    lea rbx, [rel sym" << (i * 17 % n) << "]\n";
+    }
+    os << "[section .data]\n";
+    for (unsigned long i=0; i<n; ++i)
+        os << "    dq sym" << i << ", ext" << i << '\n';
+}
+
+namespace {
+struct Benchmark
+{
+    const char* name;
+    const char* parser;
+    const char* objfmt;
+    void (*generate)(llvm::raw_ostream& os, unsigned long n);
+    unsigned long units;
+};
+
+/// Best time and allocation count of a phase.
+struct PhaseResult
+{
+    PhaseResult() : time(-1), allocs(0) {}
+    double time;
+    long allocs;
+};
+
+// (benchmark, phase) -> result
+typedef std::map<std::pair<std::string, std::string>, PhaseResult> Results;
+} // anonymous namespace
+
+static const Benchmark benchmarks[] =
+{
+    {"jumps",   "nasm", "bin",   GenJumps,   20000},
+    {"avx",     "nasm", "elf64", GenAvx,     10000},
+    {"data",    "nasm", "bin",   GenData,    20000},
+    {"rept",    "gas",  "elf32", GenRept,    500},
+    {"exprs",   "gas",  "elf32", GenExprs,   10000},
+    {"symbols", "nasm", "elf64", GenSymbols, 10000},
+};
+
+static bool
+RunOnce(const Benchmark& bench,
+        const std::string& source,
+        yasm::Diagnostic& diags,
+        Results& results)
+{
+    llvm::TimerGroup timers("Benchmark");
+    std::vector<std::pair<llvm::TimeRecord, std::string> > records;
+    bool ok = false;
+    {
+        yasm::SourceManager source_mgr(diags);
+        diags.setSourceManager(&source_mgr);
+        yasm::FileManager file_mgr;
+        yasm::HeaderSearch headers(file_mgr);
+
+        yasm::Assembler assembler("x86", bench.objfmt, diags);
+        assembler.setObjectFilename(obj_filename);
+        assembler.setTimerGroup(&timers);
+        assembler.setParser(bench.parser, diags);
+        source_mgr.createMainFileIDForMemBuffer(
+            llvm::MemoryBuffer::getMemBufferCopy(source, bench.name));
+
+        if (!diags.hasFatalErrorOccurred() &&
+            assembler.InitObject(source_mgr, diags) &&
+            assembler.Assemble(source_mgr, file_mgr, diags, headers))
+        {
+            std::string err;
+            llvm::raw_fd_ostream out(obj_filename.c_str(), err,
+                                     llvm::raw_fd_ostream::F_Binary);
+            if (!err.empty())
+            {
+                diags.Report(yasm::SourceLocation(),
+                             yasm::diag::err_cannot_open_file)
+                    << obj_filename << err;
+            }
+            else
+                ok = assembler.Output(out, diags);
+        }
+        // Take the times before the assembler's timers are destroyed,
+        // which would print them.
+        timers.takeRecords(records);
+        diags.setSourceManager(0);
+    }
+    if (!ok)
+        return false;
+
+    for (std::vector<std::pair<llvm::TimeRecord, std::string> >::iterator
+         i=records.begin(), end=records.end(); i != end; ++i)
+    {
+        PhaseResult& result =
+            results[std::make_pair(std::string(bench.name), i->second)];
+        double time = i->first.getWallTime();
+        if (result.time < 0 || time < result.time)
+            result.time = time;
+        // Allocation counts don't vary from run to run.
+        result.allocs = static_cast<long>(i->first.getAllocCount());
+    }
+    return true;
+}
+
+static bool
+ReadBaseline(const std::string& filename, Results& baseline)
+{
+    std::string err;
+    llvm::OwningPtr<llvm::MemoryBuffer> buf(
+        llvm::MemoryBuffer::getFile(filename.c_str(), &err));
+    if (!buf)
+    {
+        llvm::errs() << "yasm-bench: cannot read baseline '" << filename
+                     << "': " << err << '\n';
+        return false;
+    }
+
+    // Each line is: benchmark TAB phase TAB seconds TAB allocations
+    llvm::StringRef rest = buf->getBuffer();
+    while (!rest.empty())
+    {
+        std::pair<llvm::StringRef, llvm::StringRef> line = rest.split('\n');
+        rest = line.second;
+        if (line.first.empty() || line.first[0] == '#')
+            continue;
+        llvm::SmallVector<llvm::StringRef, 4> fields;
+        line.first.split(fields, "\t");
+        if (fields.size() != 4)
+            continue;
+        PhaseResult& result =
+            baseline[std::make_pair(fields[0].str(), fields[1].str())];
+        result.time = std::strtod(fields[2].str().c_str(), 0);
+        result.allocs = std::strtol(fields[3].str().c_str(), 0, 10);
+    }
+    return true;
+}
+
+static bool
+WriteBaseline(const std::string& filename, const Results& results)
+{
+    std::string err;
+    llvm::raw_fd_ostream os(filename.c_str(), err);
+    if (!err.empty())
+    {
+        llvm::errs() << "yasm-bench: cannot write baseline '" << filename
+                     << "': " << err << '\n';
+        return false;
+    }
+    os << "# yasm-bench baseline (scale " << scale << ")\n";
+    for (Results::const_iterator i=results.begin(), end=results.end();
+         i != end; ++i)
+    {
+        os << i->first.first << '\t' << i->first.second << '\t'
+           << llvm::format("%.6f", i->second.time) << '\t'
+           << i->second.allocs << '\n';
+    }
+    return true;
+}
+
+// Compare results against the baseline, printing a table.  Returns false
+// if anything regressed by more than the tolerance.
+static bool
+Report(const Results& results, const Results* baseline)
+{
+    bool ok = true;
+    double limit = 1.0 + tolerance / 100.0;
+    for (Results::const_iterator i=results.begin(), end=results.end();
+         i != end; ++i)
+    {
+        const PhaseResult& cur = i->second;
+        llvm::outs() << llvm::format("%-8s %-32s", i->first.first.c_str(),
+                                     i->first.second.c_str())
+                     << llvm::format(" %9.4f s %10ld allocs",
+                                     cur.time, cur.allocs);
+        Results::const_iterator base;
+        if (baseline && (base = baseline->find(i->first)) != baseline->end())
+        {
+            const PhaseResult& old = base->second;
+            double pct = old.time > 0 ? (cur.time/old.time - 1.0)*100.0 : 0;
+            llvm::outs() << llvm::format("  %+6.1f%%", pct);
+            if ((cur.time > old.time*limit &&
+                 cur.time - old.time > MIN_TIME_DELTA) ||
+                cur.allocs > old.allocs*limit)
+            {
+                llvm::outs() << "  REGRESSION";
+                ok = false;
+            }
+        }
+        llvm::outs() << '\n';
+    }
+    return ok;
+}
+
+int
+main(int argc, char* argv[])
+{
+    llvm::llvm_shutdown_obj llvm_manager(false);
+
+    cl::ParseCommandLineOptions(argc, argv,
+        "yasm benchmark suite\n\n"
+        "  Assembles synthetic inputs and reports the time and number of\n"
+        "  heap allocations of each assembler phase.\n");
+
+    const unsigned int num_benchmarks = sizeof(benchmarks)/sizeof(benchmarks[0]);
+    if (list_benchmarks)
+    {
+        for (unsigned int i=0; i<num_benchmarks; ++i)
+            llvm::outs() << benchmarks[i].name << " (" << benchmarks[i].parser
+                         << ", " << benchmarks[i].objfmt << ")\n";
+        return EXIT_SUCCESS;
+    }
+
+    if (scale == 0 || iterations == 0)
+    {
+        llvm::errs() << "yasm-bench: scale and iterations must be nonzero\n";
+        return EXIT_FAILURE;
+    }
+
+    Results baseline;
+    if (!baseline_filename.empty() && !ReadBaseline(baseline_filename, baseline))
+        return EXIT_FAILURE;
+
+    yasm::DiagnosticOptions diag_opts;
+    diag_opts.ShowOptionNames = 1;
+    yasm::TextDiagnosticPrinter diag_printer(llvm::errs(), diag_opts);
+    diag_printer.setPrefix("yasm-bench");
+    yasm::Diagnostic diags(&diag_printer);
+
+    if (!yasm::LoadStandardPlugins())
+    {
+        diags.Report(yasm::diag::fatal_standard_modules);
+        return EXIT_FAILURE;
+    }
+
+    yasm::EnableAllocationCounting();
+
+    Results results;
+    int status = EXIT_SUCCESS;
+    for (unsigned int i=0; i<num_benchmarks; ++i)
+    {
+        const Benchmark& bench = benchmarks[i];
+        if (!bench_names.empty() &&
+            std::find(bench_names.begin(), bench_names.end(), bench.name)
+                == bench_names.end())
+            continue;
+
+        std::string source;
+        {
+            llvm::raw_string_ostream os(source);
+            bench.generate(os, bench.units * scale);
+        }
+
+        for (unsigned int iter=0; iter<iterations; ++iter)
+        {
+            if (!RunOnce(bench, source, diags, results))
+            {
+                llvm::errs() << "yasm-bench: " << bench.name
+                             << ": assembly failed\n";
+                status = EXIT_FAILURE;
+                break;
+            }
+        }
+    }
+    std::remove(obj_filename.c_str());
+
+    if (!Report(results, baseline_filename.empty() ? 0 : &baseline))
+        status = EXIT_FAILURE;
+    if (!write_baseline.empty() && !WriteBaseline(write_baseline, results))
+        status = EXIT_FAILURE;
+    return status;
+}
@@ -0,0 +1,127 @@
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include <gtest/gtest.h>
+
+#include "llvm/Support/Allocator.h"
+#include "yasmx/Bytes.h"
+
+using namespace yasm;
+
+TEST(BytesTest, Inline)
+{
+    Bytes bytes;
+    EXPECT_TRUE(bytes.empty());
+    EXPECT_EQ(static_cast<Bytes::size_type>(Bytes::INLINE_SIZE),
+              bytes.capacity());
+    for (int i=0; i<Bytes::INLINE_SIZE; ++i)
+        bytes.push_back(i);
+    EXPECT_EQ(static_cast<Bytes::size_type>(Bytes::INLINE_SIZE),
+              bytes.capacity());
+    for (int i=0; i<Bytes::INLINE_SIZE; ++i)
+        EXPECT_EQ(i, bytes[i]);
+}
+
+TEST(BytesTest, Grow)
+{
+    Bytes bytes;
+    for (int i=0; i<1000; ++i)
+        bytes.push_back(static_cast<unsigned char>(i));
+    ASSERT_EQ(1000U, bytes.size());
+    for (int i=0; i<1000; ++i)
+        EXPECT_EQ(static_cast<unsigned char>(i), bytes[i]);
+}
+
+TEST(BytesTest, Arena)
+{
+    llvm::BumpPtrAllocator arena;
+    Bytes bytes;
+    bytes.setArena(&arena);
+    bytes.Write(100, 0x55);
+    bytes.insert(bytes.begin(), 3U, 0xaa);
+    ASSERT_EQ(103U, bytes.size());
+    EXPECT_EQ(0xaa, bytes[2]);
+    EXPECT_EQ(0x55, bytes[3]);
+    EXPECT_EQ(0x55, bytes.back());
+
+    // Swap with heap storage must not transfer arena storage.
+    Bytes other;
+    other.Write(50, 0x11);
+    other.swap(bytes);
+    ASSERT_EQ(103U, other.size());
+    ASSERT_EQ(50U, bytes.size());
+    EXPECT_EQ(0xaa, other[0]);
+    EXPECT_EQ(0x11, bytes[49]);
+}
+
+TEST(BytesTest, InsertIntegers)
+{
+    Bytes bytes;
+    bytes.insert(bytes.end(), 4, 7);    // both int: count and value
+    ASSERT_EQ(4U, bytes.size());
+    EXPECT_EQ(7, bytes[3]);
+}
+
+TEST(BytesTest, InsertSelf)
+{
+    Bytes bytes;
+    for (int i=0; i<Bytes::INLINE_SIZE; ++i)
+        bytes.push_back(i);
+    // Forces reallocation while reading from the old storage.
+    bytes.insert(bytes.end(), bytes.begin(), bytes.end());
+    ASSERT_EQ(2U*Bytes::INLINE_SIZE, bytes.size());
+    for (int i=0; i<Bytes::INLINE_SIZE; ++i)
+        EXPECT_EQ(i, bytes[i+Bytes::INLINE_SIZE]);
+}
+
+TEST(BytesTest, EraseResize)
+{
+    static const unsigned char data[] = {1, 2, 3, 4, 5};
+    Bytes bytes(data, data+5);
+    bytes.erase(bytes.begin()+1, bytes.begin()+3);
+    ASSERT_EQ(3U, bytes.size());
+    EXPECT_EQ(1, bytes[0]);
+    EXPECT_EQ(4, bytes[1]);
+    EXPECT_EQ(5, bytes[2]);
+    bytes.resize(6);
+    ASSERT_EQ(6U, bytes.size());
+    EXPECT_EQ(0, bytes[5]);
+    bytes.resize(1);
+    ASSERT_EQ(1U, bytes.size());
+    EXPECT_THROW(bytes.at(1), std::out_of_range);
+}
+
+TEST(BytesTest, Copy)
+{
+    Bytes bytes;
+    bytes.setBigEndian();
+    bytes.Write(40, 0x99);
+    Bytes copy(bytes);
+    EXPECT_TRUE(copy.isBigEndian());
+    ASSERT_EQ(40U, copy.size());
+    EXPECT_EQ(0x99, copy[39]);
+    Bytes assigned;
+    assigned = copy;
+    ASSERT_EQ(40U, assigned.size());
+}
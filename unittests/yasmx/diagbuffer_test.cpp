@@ -0,0 +1,134 @@
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <string>
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "yasmx/Basic/Diagnostic.h"
+#include "yasmx/Basic/DiagnosticBuffer.h"
+#include "yasmx/Basic/SourceManager.h"
+
+#include "unittests/diag_mock.h"
+
+using ::testing::InSequence;
+using namespace yasm;
+using namespace yasmunit;
+
+class DiagnosticBufferTest : public ::testing::Test
+{
+protected:
+    MockDiagnosticString m_mock_client;
+    Diagnostic m_diags;
+    SourceManager m_smgr;
+    SourceLocation m_start;
+
+    DiagnosticBuffer m_buffer;
+    Diagnostic m_worker;
+
+    DiagnosticBufferTest()
+        : m_diags(&m_mock_client)
+        , m_smgr(m_diags)
+        , m_worker(&m_buffer)
+    {
+        m_diags.setSourceManager(&m_smgr);
+        m_worker.setSourceManager(&m_smgr);
+        FileID fid = m_smgr.createMainFileIDForMemBuffer(
+            llvm::MemoryBuffer::getMemBuffer("line 1\nline 2\nline 3\n"));
+        m_start = m_smgr.getLocForStartOfFile(fid);
+    }
+
+    SourceLocation getLoc(int offset)
+    {
+        return m_start.getFileLocWithOffset(offset);
+    }
+};
+
+TEST_F(DiagnosticBufferTest, ReplayInSourceOrder)
+{
+    m_worker.Report(getLoc(14), diag::err_file_open) << "c";
+    m_worker.Report(getLoc(2), diag::note_matching) << "(";
+    m_worker.Report(getLoc(0), diag::err_file_open) << std::string("a");
+    m_worker.Report(getLoc(7), diag::warn_unknown_warning_option) << "b";
+    EXPECT_TRUE(m_worker.hasErrorOccurred());
+    EXPECT_FALSE(m_diags.hasErrorOccurred());
+
+    {
+        InSequence s;
+        EXPECT_CALL(m_mock_client,
+                    DiagString(llvm::StringRef("error: could not open file 'a'")));
+        EXPECT_CALL(m_mock_client,
+                    DiagString(llvm::StringRef("warning: unknown warning option 'b'")));
+        EXPECT_CALL(m_mock_client,
+                    DiagString(llvm::StringRef("error: could not open file 'c'")));
+        EXPECT_CALL(m_mock_client, DiagString(llvm::StringRef("note: to match this '('")));
+    }
+    m_buffer.Replay(m_diags);
+    EXPECT_TRUE(m_buffer.empty());
+    EXPECT_TRUE(m_diags.hasErrorOccurred());
+}
+
+TEST_F(DiagnosticBufferTest, ReplayMapsWithDestination)
+{
+    m_worker.Report(getLoc(0), diag::warn_unknown_warning_option) << "a";
+
+    // Warnings are classified by the destination.
+    m_diags.setWarningsAsErrors(true);
+    EXPECT_CALL(m_mock_client,
+                DiagString(llvm::StringRef("error: unknown warning option 'a'")));
+    m_buffer.Replay(m_diags);
+    EXPECT_TRUE(m_diags.hasErrorOccurred());
+}
+
+TEST_F(DiagnosticBufferTest, Take)
+{
+    DiagnosticBuffer all;
+    m_worker.Report(getLoc(7), diag::err_file_open) << "b";
+    all.take(m_buffer);
+    EXPECT_TRUE(m_buffer.empty());
+
+    m_worker.Report(getLoc(0), diag::err_file_open) << "a";
+    all.take(m_buffer);
+
+    {
+        InSequence s;
+        EXPECT_CALL(m_mock_client,
+                    DiagString(llvm::StringRef("error: could not open file 'a'")));
+        EXPECT_CALL(m_mock_client,
+                    DiagString(llvm::StringRef("error: could not open file 'b'")));
+    }
+    all.Replay(m_diags);
+}
+
+TEST_F(DiagnosticBufferTest, CustomDiag)
+{
+    m_worker.Report(getLoc(0),
+                    m_worker.getCustomDiagID(Diagnostic::Error, "custom %0"))
+        << 5;
+    EXPECT_CALL(m_mock_client, DiagString(llvm::StringRef("error: custom 5")));
+    m_buffer.Replay(m_diags);
+}
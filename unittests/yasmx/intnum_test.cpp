@@ -24,6 +24,7 @@
 //
 #include <gtest/gtest.h>
 
+#include <climits>
 #include <cstdio>
 
 #include "llvm/Support/raw_ostream.h"
@@ -159,6 +160,79 @@ TEST(IntNumOperatorOverloadTest, IncDec)
     ASSERT_EQ(5, x.getInt());
 }
 
+TEST(IntNumWideTest, Arithmetic)
+{
+    // Values of up to 128 bits are calculated inline; check results near
+    // and past the 128-bit boundary.
+    IntNum x = 1; x <<= 126;
+    EXPECT_EQ("80000000000000000000000000000000", (x+x).getStr(16));
+    EXPECT_EQ("7fffffffffffffffffffffffffffffff", (x+x-1).getStr(16));
+    EXPECT_EQ("-80000000000000000000000000000000", (-x-x).getStr(16));
+
+    x = 1; x <<= 64;
+    IntNum y = 1; y <<= 63;
+    EXPECT_EQ("80000000000000000000000000000000", (x*y).getStr(16));
+    EXPECT_EQ("-80000000000000000000000000000000", (-x*y).getStr(16));
+    EXPECT_EQ("100000000000000000000000000000000", (x*x).getStr(16));
+
+    x = 1; x <<= 100;
+    y = -x;
+    y.CalcAssert(Op::SIGNDIV, 3);
+    EXPECT_EQ("-5555555555555555555555555", y.getStr(16));
+    y = -x;
+    y.CalcAssert(Op::SIGNMOD, 3);
+    EXPECT_EQ(-1, y.getInt());
+
+    EXPECT_EQ(2, (x>>99).getInt());
+    EXPECT_EQ(-1, (-x>>200).getInt());
+    y = 1; y <<= 64; --y; y <<= 64;
+    EXPECT_EQ("ffffffffffffffff0000000000000000", y.getStr(16));
+}
+
+TEST(IntNumWideTest, Compare)
+{
+    IntNum x = 1; x <<= 100;
+    IntNum y = 1; y <<= 64;
+    EXPECT_TRUE(x > y);
+    EXPECT_TRUE(-x < -y);
+    EXPECT_TRUE(x == y*(IntNum(1)<<36));
+    EXPECT_TRUE(x != y);
+}
+
+TEST(IntNumWideTest, Conversion)
+{
+    IntNum x = 1; x <<= 100;
+    EXPECT_EQ(ULONG_MAX, x.getUInt());
+    EXPECT_EQ(LONG_MAX, x.getInt());
+    EXPECT_EQ(LONG_MIN, (-x).getInt());
+    EXPECT_EQ(1, x.getSign());
+    EXPECT_EQ(-1, (-x).getSign());
+
+    x = 0xAB; x <<= 96;
+    EXPECT_EQ(0xABUL, x.Extract(8, 96));
+    EXPECT_EQ(0xAUL, x.Extract(8, 100));
+
+    x = 1; x <<= 99;
+    x.SignExtend(100);
+    EXPECT_EQ("-8000000000000000000000000", x.getStr(16));
+
+    x = 1; x <<= 127;
+    --x;
+    EXPECT_EQ("7fffffffffffffffffffffffffffffff", x.getStr(16));
+    ++x;
+    EXPECT_EQ("80000000000000000000000000000000", x.getStr(16));
+}
+
+TEST(IntNumGetStrTest, OtherBase)
+{
+    EXPECT_EQ("101", IntNum(5L).getStr(2));
+    EXPECT_EQ("-101", IntNum(-5L).getStr(2));
+    EXPECT_EQ("0", IntNum(0L).getStr(2));
+
+    IntNum x = -1; x <<= 100;
+    EXPECT_EQ("-1" + std::string(100, '0'), x.getStr(2));
+}
+
 class IntNumStreamOutputTest : public ::testing::TestWithParam<long> {};
 
 
@@ -469,6 +543,32 @@ TEST(IntNumOkSizeTest, Boundary64)
     EXPECT_FALSE(intn.isOkSize(64, 0, 2));
 }
 
+TEST(IntNumOkSizeTest, Boundary128)
+{
+    // 128-bit boundary conditions (signed and unsigned)
+    IntNum intn = 1; intn <<= 127; intn = -intn;
+    EXPECT_TRUE( intn.isOkSize(128, 0, 1));
+    EXPECT_TRUE( intn.isOkSize(128, 0, 2));
+
+    --intn;
+    EXPECT_FALSE(intn.isOkSize(128, 0, 1));
+    EXPECT_FALSE(intn.isOkSize(128, 0, 2));
+
+    intn = 1; intn <<= 127; --intn;
+    EXPECT_TRUE( intn.isOkSize(128, 0, 1));
+
+    intn = 1; intn <<= 127;
+    EXPECT_FALSE(intn.isOkSize(128, 0, 1));
+
+    intn = 1; intn <<= 128; --intn;
+    EXPECT_TRUE( intn.isOkSize(128, 0, 0));
+    EXPECT_TRUE( intn.isOkSize(128, 0, 2));
+
+    intn = 1; intn <<= 128;
+    EXPECT_FALSE(intn.isOkSize(128, 0, 0));
+    EXPECT_FALSE(intn.isOkSize(128, 0, 2));
+}
+
 TEST(IntNumOkSizeTest, RightShift)
 {
     // with rshift
@@ -0,0 +1,94 @@
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "yasmx/Support/linescan.h"
+
+using namespace yasm;
+
+namespace {
+std::vector<unsigned>
+Scan(const std::string& str, LineScanKernel kernel)
+{
+    std::vector<unsigned> offsets;
+    ScanLineOffsets(str.data(), str.size(), &offsets, kernel);
+    return offsets;
+}
+
+class LineScanTest : public ::testing::TestWithParam<LineScanKernel>
+{
+protected:
+    void SetUp()
+    {
+        if (!isLineScanKernelSupported(GetParam()))
+            m_kernel = LINESCAN_SCALAR;
+        else
+            m_kernel = GetParam();
+    }
+
+    LineScanKernel m_kernel;
+};
+} // anonymous namespace
+
+TEST_P(LineScanTest, Pairs)
+{
+    std::vector<unsigned> offsets = Scan("a\nb\r\nc\n\rd\r\re\n\nf", m_kernel);
+    unsigned expected[] = {2, 5, 8, 10, 11, 13, 14};
+    ASSERT_EQ(sizeof(expected)/sizeof(expected[0]), offsets.size());
+    for (unsigned i=0; i<offsets.size(); ++i)
+        EXPECT_EQ(expected[i], offsets[i]);
+}
+
+TEST_P(LineScanTest, Nulls)
+{
+    std::string str("a\0b\n\0\rc", 7);
+    std::vector<unsigned> offsets = Scan(str, m_kernel);
+    ASSERT_EQ(2U, offsets.size());
+    EXPECT_EQ(4U, offsets[0]);
+    EXPECT_EQ(6U, offsets[1]);
+}
+
+// Compare against the scalar kernel with line endings at every position,
+// including pairs split across vector blocks.
+TEST_P(LineScanTest, MatchesScalar)
+{
+    static const char chars[] = "ab\n\r\0";
+    std::srand(1);
+    for (int len=0; len<200; ++len)
+    {
+        std::string str;
+        for (int i=0; i<len; ++i)
+            str += chars[std::rand() % 5];
+        EXPECT_EQ(Scan(str, LINESCAN_SCALAR), Scan(str, m_kernel)) << len;
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(LineScanKernels, LineScanTest,
+                        ::testing::Values(LINESCAN_AUTO, LINESCAN_SCALAR,
+                                          LINESCAN_SSE2, LINESCAN_AVX2));
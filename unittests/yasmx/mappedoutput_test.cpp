@@ -0,0 +1,135 @@
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "llvm/Support/raw_ostream.h"
+#include "yasmx/Basic/Diagnostic.h"
+#include "yasmx/Basic/DiagnosticBuffer.h"
+#include "yasmx/Basic/SourceManager.h"
+#include "yasmx/Support/MappedOutputFile.h"
+#include "yasmx/BytecodeOutput.h"
+#include "yasmx/Bytes.h"
+
+using namespace yasm;
+
+namespace {
+const char* tmpname = "mappedoutput_test.tmp";
+
+std::string
+ReadFile(const char* filename)
+{
+    std::string contents;
+    std::FILE* f = std::fopen(filename, "rb");
+    if (!f)
+        return contents;
+    int ch;
+    while ((ch = std::fgetc(f)) != EOF)
+        contents.push_back(static_cast<char>(ch));
+    std::fclose(f);
+    return contents;
+}
+
+class TestMemoryOutput : public BytecodeMemoryOutput
+{
+public:
+    TestMemoryOutput(Diagnostic& diags) : BytecodeMemoryOutput(diags) {}
+    bool ConvertValueToBytes(Value& value,
+                             Location loc,
+                             NumericOutput& num_out)
+    { return false; }
+};
+} // anonymous namespace
+
+TEST(MappedOutputFileTest, WriteInPlace)
+{
+    {
+        std::string err;
+        llvm::raw_fd_ostream os(tmpname, err, llvm::raw_fd_ostream::F_Binary);
+        ASSERT_TRUE(err.empty());
+
+        MappedOutputFile mapped(os);
+        if (!mapped.Map(8))
+        {
+            std::remove(tmpname);
+            return;     // mapping not supported here; nothing to test
+        }
+        ASSERT_EQ(8UL, mapped.getSize());
+        std::memcpy(mapped.getData(), "ab", 2);
+        std::memcpy(mapped.getData() + 6, "yz", 2);
+        EXPECT_TRUE(mapped.Unmap());
+        EXPECT_EQ(0, mapped.getData());
+
+        // Stream is positioned at the end of the mapped contents.
+        os << "!";
+    }
+    std::string contents = ReadFile(tmpname);
+    std::remove(tmpname);
+    EXPECT_EQ(std::string("ab\0\0\0\0yz!", 9), contents);
+}
+
+TEST(MappedOutputFileTest, EmptyNotMapped)
+{
+    {
+        std::string err;
+        llvm::raw_fd_ostream os(tmpname, err, llvm::raw_fd_ostream::F_Binary);
+        ASSERT_TRUE(err.empty());
+
+        MappedOutputFile mapped(os);
+        EXPECT_FALSE(mapped.Map(0));
+        EXPECT_EQ(0, mapped.getData());
+    }
+    std::remove(tmpname);
+}
+
+TEST(BytecodeMemoryOutputTest, OverflowReported)
+{
+    DiagnosticBuffer buffer;
+    Diagnostic diags(&buffer);
+    SourceManager smgr(diags);
+    diags.setSourceManager(&smgr);
+    unsigned char buf[6];
+    std::memset(buf, 0xff, sizeof(buf));
+
+    TestMemoryOutput out(diags);
+    out.setBuffer(buf, 4);
+    Bytes bytes;
+    bytes.push_back(1);
+    bytes.push_back(2);
+    bytes.push_back(3);
+    out.OutputBytes(bytes, SourceLocation());
+    EXPECT_FALSE(diags.hasErrorOccurred());
+    EXPECT_EQ(1UL, out.getRemaining());
+
+    // Doesn't fit: nothing is written and an error is reported.
+    out.OutputBytes(bytes, SourceLocation());
+    EXPECT_TRUE(diags.hasErrorOccurred());
+    EXPECT_EQ(0UL, out.getRemaining());
+    EXPECT_EQ(0xff, buf[3]);
+    EXPECT_EQ(0xff, buf[4]);
+}
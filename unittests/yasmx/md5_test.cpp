@@ -0,0 +1,96 @@
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include "yasmx/Support/MD5.h"
+
+using namespace yasm;
+
+namespace {
+std::string
+Digest(MD5& md5)
+{
+    static const char hexdig[] = "0123456789abcdef";
+    unsigned char digest[16];
+    md5.Final(digest);
+    std::string s;
+    for (int i=0; i<16; ++i)
+    {
+        s += hexdig[digest[i] >> 4];
+        s += hexdig[digest[i] & 0xf];
+    }
+    return s;
+}
+
+std::string
+DigestOf(const char* str)
+{
+    MD5 md5;
+    md5.Update(reinterpret_cast<const unsigned char*>(str),
+               static_cast<unsigned long>(std::strlen(str)));
+    return Digest(md5);
+}
+} // anonymous namespace
+
+// Test suite from RFC 1321.
+TEST(MD5Test, RFC1321)
+{
+    EXPECT_EQ("d41d8cd98f00b204e9800998ecf8427e", DigestOf(""));
+    EXPECT_EQ("0cc175b9c0f1b6a831c399e269772661", DigestOf("a"));
+    EXPECT_EQ("900150983cd24fb0d6963f7d28e17f72", DigestOf("abc"));
+    EXPECT_EQ("f96b697d7cb7938d525a2f31aaf161d0", DigestOf("message digest"));
+    EXPECT_EQ("c3fcd3d76192e4007dfb496cca67e13b",
+              DigestOf("abcdefghijklmnopqrstuvwxyz"));
+    EXPECT_EQ("d174ab98d277d9f5a5611c2c9f419d9f",
+              DigestOf("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
+                       "0123456789"));
+    EXPECT_EQ("57edf4a22be3c955ac49da2e2107b67a",
+              DigestOf("1234567890123456789012345678901234567890"
+                       "1234567890123456789012345678901234567890"));
+}
+
+// Feeding a message in pieces gives the same digest as all at once.
+TEST(MD5Test, Incremental)
+{
+    const char* msg = "1234567890123456789012345678901234567890"
+                      "1234567890123456789012345678901234567890";
+    MD5 md5;
+    for (const char* p = msg; *p; p += 7)
+    {
+        unsigned long len = static_cast<unsigned long>(std::strlen(p));
+        md5.Update(reinterpret_cast<const unsigned char*>(p),
+                   len < 7 ? len : 7);
+        if (len < 7)
+            break;
+    }
+    EXPECT_EQ("57edf4a22be3c955ac49da2e2107b67a", Digest(md5));
+
+    // and the object can be reused after Init()
+    md5.Init();
+    EXPECT_EQ("d41d8cd98f00b204e9800998ecf8427e", Digest(md5));
+}
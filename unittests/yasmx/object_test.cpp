@@ -0,0 +1,80 @@
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "yasmx/Object.h"
+#include "yasmx/Symbol.h"
+#include "yasmx/SymbolRef.h"
+
+using namespace yasm;
+
+TEST(ObjectSymbolTest, GetSymbolReusesExisting)
+{
+    Object object("x", "y", 0);
+    SymbolRef a = object.getSymbol("a");
+    SymbolRef b = object.getSymbol("b");
+    EXPECT_NE(a, b);
+    EXPECT_EQ(a, object.getSymbol("a"));
+    EXPECT_EQ(a, object.FindSymbol("a"));
+    EXPECT_EQ(2, object.symbols_end() - object.symbols_begin());
+}
+
+TEST(ObjectSymbolTest, NameOutlivesCaller)
+{
+    Object object("x", "y", 0);
+    SymbolRef sym;
+    {
+        std::string name("label");
+        sym = object.getSymbol(name);
+        name = "clobbered";
+    }
+    EXPECT_EQ("label", sym->getName());
+    EXPECT_EQ(sym, object.FindSymbol("label"));
+}
+
+TEST(ObjectSymbolTest, Rename)
+{
+    Object object("x", "y", 0);
+    SymbolRef sym = object.getSymbol("old");
+    {
+        std::string name("new");
+        object.RenameSymbol(sym, name);
+        name = "xxx";
+    }
+    EXPECT_EQ("new", sym->getName());
+    EXPECT_EQ(sym, object.FindSymbol("new"));
+    EXPECT_FALSE(object.FindSymbol("old"));
+}
+
+TEST(ObjectSymbolTest, NonTableSymbols)
+{
+    Object object("x", "y", 0);
+    SymbolRef sym = object.AddNonTableSymbol("local");
+    EXPECT_EQ("local", sym->getName());
+    EXPECT_FALSE(object.FindSymbol("local"));
+    EXPECT_EQ(0, object.symbols_end() - object.symbols_begin());
+}
@@ -0,0 +1,120 @@
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "yasmx/Config/functional.h"
+#include "yasmx/Support/parallel.h"
+
+using namespace yasm;
+
+namespace {
+void
+Count(std::vector<unsigned int>* counts, unsigned long i)
+{
+    ++(*counts)[i];
+}
+
+void
+Order(std::vector<unsigned long>* order, unsigned long i)
+{
+    order->push_back(i);
+}
+
+void
+ThrowAt(unsigned long bad, unsigned long i)
+{
+    if (i == bad)
+        throw std::out_of_range("bad index");
+}
+
+void
+ThrowInt(unsigned long i)
+{
+    if (i == 3)
+        throw 5;
+}
+} // anonymous namespace
+
+TEST(ParallelForTest, EachIndexOnce)
+{
+    for (unsigned int jobs=1; jobs<=8; ++jobs)
+    {
+        std::vector<unsigned int> counts(1000);
+        ParallelFor(counts.size(), jobs, TR1::bind(&Count, &counts, _1));
+        for (unsigned long i=0; i<counts.size(); ++i)
+            ASSERT_EQ(1U, counts[i]) << "jobs=" << jobs << " i=" << i;
+    }
+}
+
+TEST(ParallelForTest, Empty)
+{
+    std::vector<unsigned int> counts;
+    ParallelFor(0, 4, TR1::bind(&Count, &counts, _1));
+}
+
+TEST(ParallelForTest, SerialInOrder)
+{
+    std::vector<unsigned long> order;
+    ParallelFor(5, 1, TR1::bind(&Order, &order, _1));
+    ASSERT_EQ(5U, order.size());
+    for (unsigned long i=0; i<order.size(); ++i)
+        EXPECT_EQ(i, order[i]);
+}
+
+TEST(ParallelForTest, ExceptionRethrown)
+{
+    for (unsigned int jobs=1; jobs<=8; ++jobs)
+    {
+        bool caught = false;
+        try
+        {
+            ParallelFor(100, jobs, TR1::bind(&ThrowAt, 37, _1));
+        }
+        catch (std::out_of_range& err)
+        {
+            caught = true;
+            EXPECT_EQ(std::string("bad index"), err.what());
+        }
+        EXPECT_TRUE(caught) << "jobs=" << jobs;
+    }
+}
+
+TEST(ParallelForTest, UnknownExceptionRethrown)
+{
+    bool caught = false;
+    try
+    {
+        ParallelFor(100, 4, &ThrowInt);
+    }
+    catch (std::runtime_error&)
+    {
+        caught = true;
+    }
+    EXPECT_TRUE(caught);
+}
@@ -0,0 +1,168 @@
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/System/Path.h"
+#include "yasmx/Basic/Diagnostic.h"
+#include "yasmx/Basic/DiagnosticBuffer.h"
+#include "yasmx/Basic/FileManager.h"
+#include "yasmx/Basic/SourceManager.h"
+#include "yasmx/Config/functional.h"
+#include "yasmx/Parse/HeaderSearch.h"
+#include "yasmx/Support/parallel.h"
+#include "yasmx/System/plugin.h"
+#include "yasmx/Assembler.h"
+
+using namespace yasm;
+
+namespace {
+// Source for job i.  The data values need more than 64 bits in
+// intermediate results, so IntNum computes them with bitvectors.
+std::string
+MakeSource(unsigned long i)
+{
+    std::string source;
+    llvm::raw_string_ostream os(source);
+    os << "[bits 64]\n";
+    for (unsigned long j=0; j<200; ++j)
+    {
+        unsigned long k = i*200+j;
+        os << "dq (0x123456789abcdef012345 * " << (k % 61 + 1) << ") >> 32\n";
+        os << "dq (0xfedcba9876543210fedcba98 / " << (k % 97 + 3)
+           << ") >> 40\n";
+        os << "dq -0x1000000000000000000000 >> " << (k % 13 + 60) << '\n';
+        os << "mov rax, " << k << '\n';
+        os << "l" << j << ": jmp l" << (j/2) << '\n';
+    }
+    return os.str();
+}
+
+struct Job
+{
+    std::string source;
+    std::string filename;
+    std::string output;
+    bool ok;
+};
+
+void
+RunJob(std::vector<Job>* jobs, unsigned long i)
+{
+    Job& job = (*jobs)[i];
+    job.ok = false;
+    job.output.clear();
+
+    DiagnosticBuffer diag_buf;
+    Diagnostic diags(&diag_buf);
+    SourceManager source_mgr(diags);
+    diags.setSourceManager(&source_mgr);
+    FileManager file_mgr;
+    HeaderSearch headers(file_mgr);
+
+    {
+        Assembler assembler("x86", "bin", diags);
+        assembler.setObjectFilename(job.filename);
+        if (!assembler.setParser("nasm", diags))
+            return;
+        source_mgr.createMainFileIDForMemBuffer(
+            llvm::MemoryBuffer::getMemBufferCopy(job.source, "job"));
+        if (!assembler.InitObject(source_mgr, diags) ||
+            !assembler.Assemble(source_mgr, file_mgr, diags, headers))
+            return;
+
+        std::string err;
+        llvm::raw_fd_ostream os(job.filename.c_str(), err,
+                                llvm::raw_fd_ostream::F_Binary);
+        if (!err.empty() || !assembler.Output(os, diags))
+            return;
+    }
+
+    llvm::OwningPtr<llvm::MemoryBuffer> buf(
+        llvm::MemoryBuffer::getFile(job.filename.c_str()));
+    if (!buf)
+        return;
+    job.output = buf->getBuffer();
+    job.ok = !diags.hasErrorOccurred();
+}
+} // anonymous namespace
+
+// Separate assemblies running in different threads of one process must
+// not interfere with each other.
+TEST(ReentrancyTest, ConcurrentAssemblies)
+{
+    ASSERT_TRUE(LoadStandardPlugins());
+
+    std::string err;
+    llvm::sys::Path dir = llvm::sys::Path::GetTemporaryDirectory(&err);
+    ASSERT_TRUE(err.empty()) << err;
+
+    const unsigned long NUM_JOBS = 32;
+    std::vector<Job> jobs(NUM_JOBS);
+    for (unsigned long i=0; i<NUM_JOBS; ++i)
+    {
+        llvm::sys::Path path(dir);
+        path.appendComponent("job" + llvm::utostr(i) + ".bin");
+        jobs[i].source = MakeSource(i);
+        jobs[i].filename = path.str();
+    }
+
+    // Assemble concurrently before anything else has run, so that lazily
+    // initialized state (such as function-local statics) is first created
+    // by several threads at once.
+    const int NUM_ROUNDS = 4;
+    std::vector<Job> results[NUM_ROUNDS];
+    for (int round=0; round<NUM_ROUNDS; ++round)
+    {
+        ParallelFor(NUM_JOBS, 8, TR1::bind(&RunJob, &jobs, _1));
+        results[round] = jobs;
+    }
+
+    // Reference results, assembled one at a time.
+    for (unsigned long i=0; i<NUM_JOBS; ++i)
+    {
+        RunJob(&jobs, i);
+        ASSERT_TRUE(jobs[i].ok) << "job " << i;
+    }
+
+    for (int round=0; round<NUM_ROUNDS; ++round)
+    {
+        for (unsigned long i=0; i<NUM_JOBS; ++i)
+        {
+            EXPECT_TRUE(results[round][i].ok)
+                << "round " << round << " job " << i;
+            EXPECT_EQ(jobs[i].output, results[round][i].output)
+                << "round " << round << " job " << i;
+        }
+    }
+
+    dir.eraseFromDisk(true);
+}
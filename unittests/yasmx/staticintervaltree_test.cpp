@@ -0,0 +1,123 @@
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "yasmx/Config/functional.h"
+#include "yasmx/Support/StaticIntervalTree.h"
+
+using namespace yasm;
+
+namespace {
+struct Interval
+{
+    long low, high;
+};
+
+void
+Collect(std::vector<int>* out, int data)
+{
+    out->push_back(data);
+}
+} // anonymous namespace
+
+TEST(StaticIntervalTreeTest, Empty)
+{
+    StaticIntervalTree<int> tree;
+    tree.Build();
+    std::vector<int> found;
+    tree.Enumerate(0, 100, TR1::bind(&Collect, &found, _1));
+    EXPECT_TRUE(found.empty());
+}
+
+TEST(StaticIntervalTreeTest, SortedOrder)
+{
+    StaticIntervalTree<int> tree;
+    tree.Insert(5, 10, 0);
+    tree.Insert(0, 3, 1);
+    tree.Insert(2, 7, 2);
+    tree.Insert(2, 2, 3);
+    tree.Insert(8, 8, 4);
+    tree.Build();
+
+    std::vector<int> found;
+    tree.Enumerate(2, 2, TR1::bind(&Collect, &found, _1));
+    ASSERT_EQ(3U, found.size());
+    EXPECT_EQ(1, found[0]);
+    EXPECT_EQ(2, found[1]);     // same low as 3, inserted first
+    EXPECT_EQ(3, found[2]);
+
+    found.clear();
+    tree.Enumerate(8, 8, TR1::bind(&Collect, &found, _1));
+    ASSERT_EQ(2U, found.size());
+    EXPECT_EQ(0, found[0]);
+    EXPECT_EQ(4, found[1]);
+
+    found.clear();
+    tree.Enumerate(11, 20, TR1::bind(&Collect, &found, _1));
+    EXPECT_TRUE(found.empty());
+}
+
+TEST(StaticIntervalTreeTest, MatchesBruteForce)
+{
+    std::srand(1);
+    std::vector<Interval> intervals;
+    StaticIntervalTree<int> tree;
+    for (int i=0; i<2000; ++i)
+    {
+        long low = std::rand() % 1000;
+        long high = low + std::rand() % 50;
+        Interval iv = {low, high};
+        intervals.push_back(iv);
+        tree.Insert(low, high, i);
+    }
+    tree.Build();
+    ASSERT_EQ(intervals.size(), tree.size());
+
+    for (long point=-1; point<=1051; ++point)
+    {
+        std::vector<int> found;
+        tree.Enumerate(point, point, TR1::bind(&Collect, &found, _1));
+
+        std::vector<bool> seen(intervals.size());
+        for (std::vector<int>::iterator i=found.begin(), end=found.end();
+             i != end; ++i)
+        {
+            ASSERT_FALSE(seen[*i]) << "duplicate " << *i;
+            seen[*i] = true;
+            if (i != found.begin())
+                EXPECT_LE(intervals[*(i-1)].low, intervals[*i].low);
+        }
+        for (size_t i=0; i<intervals.size(); ++i)
+        {
+            bool overlaps =
+                intervals[i].low <= point && intervals[i].high >= point;
+            EXPECT_EQ(overlaps, seen[i]) << "point " << point
+                                         << " interval " << i;
+        }
+    }
+}
@@ -0,0 +1,107 @@
+//
+//  Copyright (C) 2026  Peter Johnson
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND OTHER CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR OTHER CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+#include <gtest/gtest.h>
+
+#include "llvm/Support/raw_ostream.h"
+#include "yasmx/StringTable.h"
+
+using namespace yasm;
+
+TEST(StringTableTest, Duplicates)
+{
+    StringTable strtab;
+    EXPECT_EQ(0UL, strtab.getIndex(""));
+    unsigned long foo = strtab.getIndex("foo");
+    unsigned long bar = strtab.getIndex("bar");
+    EXPECT_EQ(1UL, foo);
+    EXPECT_EQ(5UL, bar);
+    EXPECT_EQ(foo, strtab.getIndex("foo"));
+    EXPECT_EQ(bar, strtab.getIndex("bar"));
+    EXPECT_EQ(9UL, strtab.getSize());
+    EXPECT_EQ("foo", strtab.getString(foo));
+}
+
+TEST(StringTableTest, FirstIndex)
+{
+    StringTable strtab(4);
+    EXPECT_EQ(4UL, strtab.getIndex(""));
+    EXPECT_EQ(5UL, strtab.getIndex("foo"));
+    EXPECT_EQ(5UL, strtab.getIndex("foo"));
+    EXPECT_EQ("foo", strtab.getString(5));
+}
+
+TEST(StringTableTest, MergeTails)
+{
+    StringTable strtab(4);
+    unsigned long text = strtab.getIndex(".text");
+    unsigned long data = strtab.getIndex(".data");
+    unsigned long rela_text = strtab.getIndex(".rela.text");
+    unsigned long xt = strtab.getIndex("xt");
+    unsigned long a_text = strtab.getIndex("a.text");
+    strtab.MergeTails();
+
+    // Only ".data" and ".rela.text" need their own storage.
+    EXPECT_EQ(1UL+6+11, strtab.getSize());
+    EXPECT_EQ(4UL, strtab.getMergedIndex(4));
+
+    text = strtab.getMergedIndex(text);
+    data = strtab.getMergedIndex(data);
+    rela_text = strtab.getMergedIndex(rela_text);
+    xt = strtab.getMergedIndex(xt);
+    a_text = strtab.getMergedIndex(a_text);
+
+    EXPECT_EQ(".text", strtab.getString(text));
+    EXPECT_EQ(".data", strtab.getString(data));
+    EXPECT_EQ(".rela.text", strtab.getString(rela_text));
+    EXPECT_EQ("xt", strtab.getString(xt));
+    EXPECT_EQ("a.text", strtab.getString(a_text));
+
+    // Host strings keep their original order.
+    EXPECT_EQ(5UL, data);
+    EXPECT_EQ(11UL, rela_text);
+    EXPECT_EQ(rela_text+5, text);
+    EXPECT_EQ(rela_text+4, a_text);
+
+    // Lookups after merging return merged indexes.
+    EXPECT_EQ(text, strtab.getIndex(".text"));
+    unsigned long bss = strtab.getIndex(".bss");
+    EXPECT_EQ(4UL+1+6+11, bss);
+    EXPECT_EQ(".bss", strtab.getString(bss));
+}
+
+TEST(StringTableTest, Write)
+{
+    StringTable strtab;
+    strtab.getIndex("ab");
+    strtab.getIndex("b");
+    strtab.getIndex("ab");
+    strtab.MergeTails();
+
+    std::string str;
+    llvm::raw_string_ostream os(str);
+    strtab.Write(os);
+    os.flush();
+    EXPECT_EQ(std::string("\0ab\0", 4), str);
+}
@@ -456,6 +456,55 @@ TEST_F(ValueTest, AddAbsExpr)
     EXPECT_EQ(14, v.getAbs()->getIntNum().getInt());
 }
 
+TEST_F(ValueTest, CopySharesAbs)
+{
+    MockDiagnosticId mock_client;
+    Diagnostic diags(&mock_client);
+    SourceManager smgr(diags);
+    diags.setSourceManager(&smgr);
+
+    Value v(4, Expr::Ptr(new Expr(ADD(sym1, 2))));
+    const Value& cv = v;
+    const Expr* orig = cv.getAbs();
+
+    // Copies share the absolute portion until one of them modifies it.
+    Value copy(v);
+    const Value& ccopy = copy;
+    EXPECT_EQ(orig, ccopy.getAbs());
+    Value assigned(8);
+    assigned = v;
+    EXPECT_EQ(orig, static_cast<const Value&>(assigned).getAbs());
+
+    copy.AddAbs(3);
+    copy.getAbs()->Simplify(diags);
+    EXPECT_NE(orig, ccopy.getAbs());
+    EXPECT_EQ(orig, cv.getAbs());
+    EXPECT_EQ(orig, static_cast<const Value&>(assigned).getAbs());
+    EXPECT_EQ("sym1+2", String::Format(*cv.getAbs()));
+    EXPECT_EQ("sym1+5", String::Format(*ccopy.getAbs()));
+
+    // Once the other copies are gone, the original is modified in place.
+    assigned.Clear();
+    EXPECT_EQ(orig, v.getAbs());
+}
+
+TEST_F(ValueTest, GetAbsNotShared)
+{
+    Value v(4, Expr::Ptr(new Expr(ADD(sym1, 2))));
+
+    // A kept mutable pointer must not reach copies made afterwards.
+    Expr* abs = v.getAbs();
+    Value copy(v);
+    const Value& ccopy = copy;
+    EXPECT_NE(abs, ccopy.getAbs());
+    *abs += IntNum(3);
+    EXPECT_EQ("sym1+2", String::Format(*ccopy.getAbs()));
+
+    Value assigned(8);
+    assigned = v;
+    EXPECT_NE(abs, static_cast<const Value&>(assigned).getAbs());
+}
+
 TEST_F(ValueTest, isRelative)
 {
     Value v1(4);